@@ -0,0 +1,68 @@
+#include "../include/xos/types.h"
+#include "../include/xos/stdio.h"
+#include "../include/xos/stdlib.h"
+#include "../include/xos/syscall.h"
+#include "../include/xos/fs.h"
+#include "../include/xos/stat.h"
+#include "../include/xos/device.h"
+#include "../include/xos/vdso.h"
+
+// 顺序读吞吐量测试：以大块顺序读取文件，统计每秒读取的字节数，
+// 文件块已经在缓存中时测到的是缓存速度，开机后第一次读取才反映磁盘速度；
+// 参数是块设备（如 /dev/hda）时直接读设备，不经过缓存，
+// 用户内存不能 DMA，IDE 磁盘这时总是使用 PIO，测到的就是 PIO 吞吐量
+
+#define CHUNK_SIZE 0x10000 // 每次读取的字节数
+
+static char buf[CHUNK_SIZE];
+
+// 系统启动以来的毫秒数
+static u32 now_ms()
+{
+    vdso_data_t *data = VDSO_DATA;
+    return data->jiffies * data->jiffy;
+}
+
+int main(int argc, char const *argv[])
+{
+    if (argc < 2)
+    {
+        printf("usage: diskbench file|device\n");
+        return EOF;
+    }
+
+    fd_t fd = open((char *)argv[1], O_RDONLY, 0);
+    if (fd < EOK)
+    {
+        printf("diskbench: open %s failed\n", argv[1]);
+        return EOF;
+    }
+
+    // 块设备不检查越界，最多读到设备末尾
+    u32 limit = 0xffffffff;
+    stat_t statbuf;
+    if (fstat(fd, &statbuf) == EOK && ISBLK(statbuf.mode))
+    {
+        u32 count = ioctl(fd, DEV_CMD_SECTOR_COUNT, 0);
+        int size = ioctl(fd, DEV_CMD_SECTOR_SIZE, 0);
+        if (size > 0 && size <= CHUNK_SIZE)
+            limit = (count / (CHUNK_SIZE / size)) * CHUNK_SIZE;
+    }
+
+    u32 total = 0;
+    u32 start = now_ms();
+    while (total < limit)
+    {
+        int len = read(fd, buf, CHUNK_SIZE);
+        if (len <= 0)
+            break;
+        total += len;
+    }
+    u32 elapsed = now_ms() - start;
+    close(fd);
+
+    if (!elapsed)
+        elapsed = 1;
+    printf("read %u bytes in %u ms, %u KB/s\n", total, elapsed, (total / elapsed) * 1000 / 1024);
+    return 0;
+}
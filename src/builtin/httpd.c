@@ -3,9 +3,11 @@
 #include "../include/xos/syscall.h"
 #include "../include/xos/string.h"
 #include "../include/xos/fs.h"
+#include "../include/xos/stat.h"
 #include "../include/xos/net.h"
 
 #define BUFLEN 2048
+#define MAX_EVENTS 8 // 一次取回的就绪事件数量
 
 static char rx_buf[BUFLEN];
 
@@ -19,13 +21,106 @@ char response[] = "HTTP/1.1 200 OK\r\n"
                   "<h1 style='color:#e03997;'><center>hello onix!!!</center></h1>"
                   "</body></html>";
 
+char not_found[] = "HTTP/1.1 404 Not Found\r\n"
+                   "Content-Length: 0\r\n"
+                   "\r\n";
+
+static char header[128];
+
+// 路径中是否含有上级目录
+static bool has_dotdot(char *path)
+{
+    for (char *ptr = path; *ptr; ptr++)
+    {
+        if (ptr[0] == '.' && ptr[1] == '.')
+            return true;
+    }
+    return false;
+}
+
+// 从磁盘发送静态文件，文件内容由 sendfile 直接从文件块缓冲发送
+static void serve_file(fd_t client, char *path)
+{
+    fd_t fd = -1;
+    stat_t statbuf;
+
+    // 不允许访问上级目录
+    if (has_dotdot(path))
+        goto failure;
+
+    fd = open(path, O_RDONLY, 0);
+    if (fd < EOK)
+        goto failure;
+    if (fstat(fd, &statbuf) < EOK || !ISFILE(statbuf.mode))
+        goto failure;
+
+    // 文件可能比发送窗口大，发送期间使用阻塞方式
+    fcntl(client, F_SETFL, 0);
+
+    int len = sprintf(header,
+                      "HTTP/1.1 200 OK\r\n"
+                      "Content-Length: %d\r\n"
+                      "\r\n",
+                      statbuf.size);
+    send(client, header, len, 0);
+
+    int ret = sendfile(client, fd, NULL, statbuf.size);
+    printf("send file %s %d bytes\n", path, ret);
+    close(fd);
+    return;
+
+failure:
+    if (fd >= EOK)
+        close(fd);
+    send(client, not_found, sizeof(not_found) - 1, 0);
+}
+
+// 处理一个可读的客户端，请求处理完成或出错后关闭连接
+static void serve_client(fd_t epfd, fd_t client, u32 events)
+{
+    int ret = -1;
+    if (events & EPOLLIN)
+        ret = recv(client, rx_buf, BUFLEN - 1, 0);
+
+    // 客户端为非阻塞方式，数据还没有到达则继续等待
+    if (ret == -EAGAIN && !(events & (EPOLLERR | EPOLLHUP)))
+        return;
+
+    if (ret > 0)
+    {
+        rx_buf[ret] = 0;
+        printf("client %d received %d bytes: \n--------------------\n", client, ret);
+        printf(rx_buf);
+
+        if (!memcmp(rx_buf, "GET / ", 6))
+        {
+            send(client, response, sizeof(response), 0);
+        }
+        else if (!memcmp(rx_buf, "GET /", 5))
+        {
+            // 取出请求的路径
+            char *path = rx_buf + 4;
+            char *end = strchr(path, ' ');
+            if (end)
+                *end = 0;
+            serve_file(client, path);
+        }
+    }
+
+    epoll_ctl(epfd, EPOLL_CTL_DEL, client, NULL);
+    close(client);
+}
+
+// 单个进程用 epoll 同时等待监听套接字和所有客户端
 int main(int argc, char const *argv[])
 {
     sockaddr_in_t addr;
-    fd_t client = -1;
     fd_t server = -1;
+    fd_t epfd = -1;
+    epoll_event_t event;
+    epoll_event_t events[MAX_EVENTS];
 
-    server = socket(AF_INET, SOCK_STREAM, PROTO_TCP);
+    server = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, PROTO_TCP);
     if (server < EOK)
     {
         printf("create server socket failure...\n");
@@ -46,45 +141,63 @@ int main(int argc, char const *argv[])
     if (ret < 0)
         goto rollback;
 
+    epfd = epoll_create(1);
+    if (epfd < EOK)
+    {
+        ret = epfd;
+        goto rollback;
+    }
+
+    event.events = EPOLLIN;
+    event.data.fd = server;
+    ret = epoll_ctl(epfd, EPOLL_CTL_ADD, server, &event);
+    if (ret < EOK)
+        goto rollback;
+
+    printf("waiting for clients...\n");
     while (true)
     {
-        printf("waiting for client...\n");
-        client = accept(server, (sockaddr_t *)&addr, 0);
-        if (client < 0)
+        int count = epoll_wait(epfd, events, MAX_EVENTS, TIMELESS);
+        if (count < EOK)
         {
-            printf("accept failure...\n");
+            ret = count;
             goto rollback;
         }
-        printf("socket acccept %d\n", client);
 
-        ret = recv(client, rx_buf, BUFLEN, 0);
-        if (ret < EOK)
+        for (int i = 0; i < count; i++)
         {
-            goto rollback;
-        }
+            fd_t fd = events[i].data.fd;
+            if (fd != server)
+            {
+                serve_client(epfd, fd, events[i].events);
+                continue;
+            }
 
-        rx_buf[ret] = 0;
-        printf("received %d bytes: \n--------------------\n", ret);
-        printf(rx_buf);
+            // 监听套接字为非阻塞方式，接受所有已完成握手的连接
+            while (true)
+            {
+                fd_t client = accept4(server, (sockaddr_t *)&addr, 0, SOCK_NONBLOCK);
+                if (client == -EAGAIN)
+                    break;
+                if (client < 0)
+                {
+                    printf("accept failure %d...\n", client);
+                    break;
+                }
+                printf("socket acccept %d\n", client);
 
-        if (memcmp(rx_buf, "GET /", 5))
-        {
-            close(client);
-            continue;
-        }
-
-        ret = send(client, response, sizeof(response), 0);
-        if (ret < EOK)
-        {
-            goto rollback;
+                // 客户端使用边沿触发，请求到达时只通知一次
+                event.events = EPOLLIN | EPOLLET;
+                event.data.fd = client;
+                if (epoll_ctl(epfd, EPOLL_CTL_ADD, client, &event) < EOK)
+                    close(client);
+            }
         }
-        close(client);
-        continue;
     }
 
 rollback:
-    if (client > 0)
-        close(client);
+    if (epfd > 0)
+        close(epfd);
     if (server > 0)
         close(server);
     return ret;
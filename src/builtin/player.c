@@ -95,6 +95,11 @@ int main(int argc, char const *argv[])
         goto rollback;
     }
 
+    // 使用实时调度，避免其他任务造成播放卡顿
+    sched_param_t param;
+    param.sched_priority = RT_PRIO_USER_MAX;
+    sched_setscheduler(0, SCHED_RR, &param);
+
     ioctl(sb16, SB16_CMD_ON, 0);
     ioctl(sb16, mode, 0);
     ioctl(sb16, SB16_CMD_VOLUME, 0xff);
@@ -0,0 +1,103 @@
+#include "../include/xos/types.h"
+#include "../include/xos/stdio.h"
+#include "../include/xos/syscall.h"
+#include "../include/xos/signal.h"
+
+// 调度延迟测试：在若干计算密集任务的负载下，
+// 分别以普通任务和实时任务周期性睡眠，统计唤醒的延迟
+
+#define HOG_NR 4      // 计算密集任务数量
+#define LOOPS 100     // 测量次数
+#define PERIOD_MS 20  // 睡眠周期
+#define CALIBRATE_MS 100
+
+static pid_t hogs[HOG_NR];
+
+static u32 rdtsc()
+{
+    u32 low, high;
+    asm volatile("rdtsc\n"
+                 : "=a"(low), "=d"(high));
+    return low;
+}
+
+static void hog()
+{
+    volatile u32 counter = 0;
+    while (true)
+    {
+        counter++;
+    }
+}
+
+// 每毫秒的 CPU 周期数
+static u32 calibrate()
+{
+    u32 start = rdtsc();
+    sleep(CALIBRATE_MS);
+    return (rdtsc() - start) / CALIBRATE_MS;
+}
+
+static void measure(const char *name, u32 cycles)
+{
+    u32 min = 0xffffffff;
+    u32 max = 0;
+    u32 total = 0;
+
+    for (size_t i = 0; i < LOOPS; i++)
+    {
+        u32 start = rdtsc();
+        sleep(PERIOD_MS);
+        u32 elapsed = (rdtsc() - start) / (cycles / 1000);
+
+        // 超出睡眠时间的部分即为唤醒延迟，单位微秒
+        u32 latency = elapsed > PERIOD_MS * 1000 ? elapsed - PERIOD_MS * 1000 : 0;
+        if (latency < min)
+            min = latency;
+        if (latency > max)
+            max = latency;
+        total += latency;
+    }
+
+    printf("%s latency us: min %u avg %u max %u\n", name, min, total / LOOPS, max);
+}
+
+int main(int argc, char const *argv[])
+{
+    sched_param_t param;
+
+    u32 cycles = calibrate();
+    printf("calibrate %u cycles per ms\n", cycles);
+
+    for (size_t i = 0; i < HOG_NR; i++)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+            hog();
+        hogs[i] = pid;
+    }
+
+    measure("SCHED_NORMAL", cycles);
+
+    param.sched_priority = RT_PRIO_USER_MAX;
+    int ret = sched_setscheduler(0, SCHED_FIFO, &param);
+    if (ret < EOK)
+    {
+        printf("set SCHED_FIFO failure %d\n", ret);
+        goto rollback;
+    }
+
+    measure("SCHED_FIFO", cycles);
+
+    param.sched_priority = 0;
+    sched_setscheduler(0, SCHED_NORMAL, &param);
+
+rollback:
+    for (size_t i = 0; i < HOG_NR; i++)
+    {
+        int status;
+        kill(hogs[i], SIGTERM);
+        waitpid(hogs[i], &status);
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include "../include/xos/types.h"
+#include "../include/xos/stdio.h"
+#include "../include/xos/syscall.h"
+
+// 空系统调用测试：分别通过 int 0x80 和 sysenter 循环调用 getpid，
+// 比较两种进入内核方式的平均开销
+
+#define LOOPS 100000
+#define ROUNDS 5
+
+static u32 rdtsc()
+{
+    u32 low, high;
+    asm volatile("rdtsc\n"
+                 : "=a"(low), "=d"(high));
+    return low;
+}
+
+static u32 getpid_int80()
+{
+    u32 ret;
+    asm volatile("int $0x80\n"
+                 : "=a"(ret)
+                 : "a"(SYS_NR_GETPID));
+    return ret;
+}
+
+static u32 getpid_sysenter()
+{
+    u32 ret;
+    asm volatile("pushl %%ebp\n"
+                 "pushl $1f\n"
+                 "movl %%esp, %%ebp\n"
+                 "sysenter\n"
+                 "1:\n"
+                 "addl $4, %%esp\n"
+                 "popl %%ebp\n"
+                 : "=a"(ret)
+                 : "a"(SYS_NR_GETPID)
+                 : "ecx", "edx");
+    return ret;
+}
+
+// 返回每次调用的最少周期数，取多轮中的最小值减少中断的干扰
+static u32 measure(const char *name, u32 (*call)())
+{
+    u32 pid = getpid();
+    u32 best = 0xffffffff;
+
+    for (size_t round = 0; round < ROUNDS; round++)
+    {
+        u32 start = rdtsc();
+        for (size_t i = 0; i < LOOPS; i++)
+        {
+            if (call() != pid)
+            {
+                printf("%s return wrong pid\n", name);
+                return 0;
+            }
+        }
+        u32 cycles = (rdtsc() - start) / LOOPS;
+        if (cycles < best)
+            best = cycles;
+    }
+
+    printf("%s: %u cycles per call\n", name, best);
+    return best;
+}
+
+int main(int argc, char const *argv[])
+{
+    u32 slow = measure("int 0x80", getpid_int80);
+
+    if (!cpu_has_sep())
+    {
+        printf("sysenter not supported\n");
+        return 0;
+    }
+
+    u32 fast = measure("sysenter", getpid_sysenter);
+    if (slow && fast)
+        printf("sysenter saves %d cycles per call\n", (int)slow - (int)fast);
+    return 0;
+}
@@ -6,9 +6,37 @@
 #include "../include/xos/net.h"
 
 #define BUFLEN 4096
+#define STACK_SIZE 4096
 
 static char tx_buf[BUFLEN];
 static char rx_buf[BUFLEN];
+static char recv_stack[STACK_SIZE]; // 接收线程用户栈
+
+// 接收线程，与发送共享套接字
+static int recv_thread(void *arg)
+{
+    int fd = (int)arg;
+    u32 recv_timing = time();
+    u32 recv_count = 0;
+
+    while (true)
+    {
+        recv_count++;
+        int ret = recv(fd, rx_buf, BUFLEN, 0);
+        // printf("message recv %d...\n", ret);
+        if (ret < EOK)
+            return ret;
+
+        u32 now = time();
+        int offset = now - recv_timing;
+        recv_timing = now;
+        if (offset > 0)
+        {
+            printf("recv speed: %dKB/s\n", recv_count * 4 / offset);
+            recv_count = 0;
+        }
+    }
+}
 
 int main(int argc, char const *argv[])
 {
@@ -51,47 +79,28 @@ int main(int argc, char const *argv[])
     memset(tx_buf, 'A', sizeof(tx_buf));
 
     u32 send_timing = time();
-    u32 recv_timing = time();
     u32 send_count = 0;
-    u32 recv_count = 0;
 
-    pid_t pid = fork();
+    ret = clone(recv_thread, recv_stack + STACK_SIZE, CLONE_THREAD_FLAGS, (void *)fd, NULL, NULL);
+    printf("clone recv thread %d\n", ret);
+    if (ret < EOK)
+        goto rollback;
 
     while (true)
     {
-        if (pid)
-        {
-            send_count++;
-            ret = send(fd, tx_buf, sizeof(tx_buf), 0);
-            // printf("message sent %d...\n", ret);
-            if (ret < EOK)
-                goto rollback;
-
-            u32 now = time();
-            int offset = now - send_timing;
-            send_timing = now;
-            if (offset > 0)
-            {
-                printf("send speed: %dKB/s\n", send_count * 4 / offset);
-                send_count = 0;
-            }
-        }
-        else
+        send_count++;
+        ret = send(fd, tx_buf, sizeof(tx_buf), 0);
+        // printf("message sent %d...\n", ret);
+        if (ret < EOK)
+            goto rollback;
+
+        u32 now = time();
+        int offset = now - send_timing;
+        send_timing = now;
+        if (offset > 0)
         {
-            recv_count++;
-            ret = recv(fd, rx_buf, BUFLEN, 0);
-            // printf("message recv %d...\n", ret);
-            if (ret < EOK)
-                goto rollback;
-
-            u32 now = time();
-            int offset = now - recv_timing;
-            recv_timing = now;
-            if (offset > 0)
-            {
-                printf("recv speed: %dKB/s\n", recv_count * 4 / offset);
-                recv_count = 0;
-            }
+            printf("send speed: %dKB/s\n", send_count * 4 / offset);
+            send_count = 0;
         }
     }
 
@@ -0,0 +1,105 @@
+#include "../include/xos/types.h"
+#include "../include/xos/stdio.h"
+#include "../include/xos/syscall.h"
+#include "../include/xos/errno.h"
+
+// 线程测试：多个线程在 futex 互斥量保护下累加共享计数，
+// 以 CLONE_CHILD_CLEARTID 等待线程结束
+
+#define THREAD_NR 4
+#define LOOPS 10000
+#define STACK_SIZE 4096
+
+static char stacks[THREAD_NR][STACK_SIZE];
+static int tids[THREAD_NR];
+
+static volatile int lock = 0; // 0 未加锁，1 加锁，2 加锁且有等待者
+static volatile u32 counter = 0;
+
+static int cmpxchg(volatile int *ptr, int old, int new)
+{
+    int ret;
+    asm volatile(
+        "lock cmpxchgl %2, %1\n"
+        : "=a"(ret), "+m"(*ptr)
+        : "r"(new), "0"(old)
+        : "memory");
+    return ret;
+}
+
+static int xchg(volatile int *ptr, int val)
+{
+    asm volatile(
+        "xchgl %0, %1\n"
+        : "+r"(val), "+m"(*ptr)
+        :
+        : "memory");
+    return val;
+}
+
+static void user_lock(volatile int *m)
+{
+    int c = cmpxchg(m, 0, 1);
+    if (c == 0)
+        return;
+    if (c != 2)
+        c = xchg(m, 2);
+    while (c != 0)
+    {
+        futex((int *)m, FUTEX_WAIT | FUTEX_PRIVATE_FLAG, 2, TIMELESS);
+        c = xchg(m, 2);
+    }
+}
+
+static void user_unlock(volatile int *m)
+{
+    if (xchg(m, 0) == 2)
+        futex((int *)m, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, 1, 0);
+}
+
+static int worker(void *arg)
+{
+    for (size_t i = 0; i < LOOPS; i++)
+    {
+        user_lock(&lock);
+        counter++;
+        user_unlock(&lock);
+    }
+    return 0;
+}
+
+// 线程退出时内核清零 tid 并唤醒等待者
+static void join(volatile int *tid)
+{
+    int val;
+    while ((val = *tid) != 0)
+    {
+        futex((int *)tid, FUTEX_WAIT, val, TIMELESS);
+    }
+}
+
+int main(int argc, char const *argv[])
+{
+    int flags = CLONE_THREAD_FLAGS | CLONE_CHILD_SETTID | CLONE_CHILD_CLEARTID;
+
+    printf("process %d thread %d\n", getpid(), gettid());
+
+    for (size_t i = 0; i < THREAD_NR; i++)
+    {
+        // 内核在 tids[i] 中写入线程 id，退出时清零
+        int ret = clone(worker, stacks[i] + STACK_SIZE, flags, NULL, NULL, &tids[i]);
+        if (ret < EOK)
+        {
+            printf("clone failure %d\n", ret);
+            return ret;
+        }
+    }
+
+    for (size_t i = 0; i < THREAD_NR; i++)
+    {
+        join(&tids[i]);
+    }
+
+    printf("counter %u expected %u\n", counter, THREAD_NR * LOOPS);
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include "../include/xos/types.h"
+#include "../include/xos/stdio.h"
+#include "../include/xos/string.h"
+#include "../include/xos/syscall.h"
+#include "../include/xos/errno.h"
+
+// 提交 / 完成队列测试：通过管道分别提交一批写和一批读，
+// 读和超时、空操作一起提交，每批用一次 io_uring_enter 等待全部完成
+
+#define MSG_NR 4
+#define MSG_LEN 16
+#define TIMEOUT_MS 50
+
+static io_uring_params_t params;
+static char messages[MSG_NR][MSG_LEN];
+static char buffers[MSG_NR][MSG_LEN];
+
+static io_uring_sqe_t *get_sqe()
+{
+    io_rings_t *rings = params.rings;
+    if (rings->sq_tail - rings->sq_head > rings->sq_mask)
+        return NULL;
+
+    io_uring_sqe_t *sqe = &params.sqes[rings->sq_tail & rings->sq_mask];
+    memset(sqe, 0, sizeof(io_uring_sqe_t));
+    return sqe;
+}
+
+static void submit_sqe()
+{
+    params.rings->sq_tail++;
+}
+
+static void prep_rw(u8 opcode, int fd, char *buf, u32 len, u64 user_data)
+{
+    io_uring_sqe_t *sqe = get_sqe();
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = (u32)buf;
+    sqe->len = len;
+    sqe->off = IORING_OFF_CURRENT;
+    sqe->user_data = user_data;
+    submit_sqe();
+}
+
+// 处理所有完成项
+static void reap()
+{
+    io_rings_t *rings = params.rings;
+    while (rings->cq_head != rings->cq_tail)
+    {
+        io_uring_cqe_t *cqe = &params.cqes[rings->cq_head & rings->cq_mask];
+        printf("complete %d res %d\n", (u32)cqe->user_data, cqe->res);
+        rings->cq_head++;
+    }
+}
+
+int main(int argc, char const *argv[])
+{
+    fd_t ring = io_uring_setup(16, &params);
+    if (ring < EOK)
+    {
+        printf("io_uring_setup failure %d\n", ring);
+        return ring;
+    }
+    printf("ring %d sq %d cq %d\n", ring, params.sq_entries, params.cq_entries);
+
+    fd_t pipefd[2];
+    if (pipe(pipefd) < EOK)
+    {
+        printf("pipe failure\n");
+        close(ring);
+        return -1;
+    }
+
+    // 管道只支持一个阻塞的读者，先写入一批数据，之后的读不会阻塞
+    for (size_t i = 0; i < MSG_NR; i++)
+    {
+        sprintf(messages[i], "message %d", i);
+        prep_rw(IORING_OP_WRITE, pipefd[1], messages[i], MSG_LEN, i);
+    }
+    printf("submitted %d\n", io_uring_enter(ring, MSG_NR, MSG_NR, IORING_ENTER_GETEVENTS));
+    reap();
+
+    for (size_t i = 0; i < MSG_NR; i++)
+    {
+        prep_rw(IORING_OP_READ, pipefd[0], buffers[i], MSG_LEN, MSG_NR + i);
+    }
+
+    io_uring_sqe_t *sqe = get_sqe();
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->off = TIMEOUT_MS;
+    sqe->user_data = 100;
+    submit_sqe();
+
+    sqe = get_sqe();
+    sqe->opcode = IORING_OP_NOP;
+    sqe->user_data = 101;
+    submit_sqe();
+
+    int count = MSG_NR + 2;
+    printf("submitted %d\n", io_uring_enter(ring, count, count, IORING_ENTER_GETEVENTS));
+    reap();
+
+    for (size_t i = 0; i < MSG_NR; i++)
+    {
+        printf("read %s\n", buffers[i]);
+    }
+
+    close(pipefd[0]);
+    close(pipefd[1]);
+    close(ring);
+    return 0;
+}
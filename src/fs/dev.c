@@ -84,6 +84,10 @@ void dev_init() {
         {DEV_IDE_DISK, "/dev/", IFBLK | 0600, 0},
         {DEV_IDE_PART, "/dev/", IFBLK | 0600, 0},
         {DEV_IDE_CD, "/dev/cd", IFBLK | 0400, 0},
+        {DEV_SATA_DISK, "/dev/", IFBLK | 0600, 0},
+        {DEV_SATA_PART, "/dev/", IFBLK | 0600, 0},
+        {DEV_VIRTIO_DISK, "/dev/", IFBLK | 0600, 0},
+        {DEV_VIRTIO_PART, "/dev/", IFBLK | 0600, 0},
         {DEV_RAMDISK, "/dev/", IFBLK | 0600, 1},
         {DEV_FLOPPY, "/dev/", IFBLK | 0600, 0},
         {DEV_SERIAL, "/dev/", IFCHR | 0600, 0},
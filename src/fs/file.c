@@ -1,6 +1,7 @@
 #include "../include/xos/assert.h"
 #include "../include/xos/fs.h"
 #include "../include/xos/task.h"
+#include "../include/xos/poll.h"
 
 #define FILE_NR 128
 
@@ -33,17 +34,30 @@ void *fs_default_null() {
 file_t *get_file() {
     for (size_t i = 3; i < FILE_NR; i++) {
         if (file_table[i].count == 0) {
-            file_table[i].count++;
-            return &file_table[i];
+            file_t *file = &file_table[i];
+            file->count++;
+            file->ra.prev = 0;
+            file->ra.end = 0;
+            file->ra.mark = 0;
+            file->ra.size = 0;
+            return file;
         }
     }
     panic("Exceed max open files!!!");
 }
 
+// 读取文件之前预读
+void file_readahead(inode_t *inode, readahead_t *ra, off_t offset, int len) {
+    if (inode && inode->op && inode->op->readahead)
+        inode->op->readahead(inode, ra, offset, len);
+}
+
 // 释放文件表项
 void put_file(file_t *file) {
     assert(file->count > 0);
     if (--file->count == 0) {
+        if (file->epolls)
+            epoll_release(file);
         iput(file->inode);
     }
 }
@@ -51,7 +65,7 @@ void put_file(file_t *file) {
 // 检查文件描述符是否合法并返回对应文件表项
 err_t fd_check(fd_t fd, file_t **file) {
     task_t *task = running_task();
-    if (fd >= TASK_FILE_NR || !task->files[fd])
+    if (fd < 0 || fd >= TASK_FILE_NR || !task->files[fd])
         return -EINVAL;
 
     *file = task->files[fd];
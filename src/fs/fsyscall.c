@@ -7,6 +7,8 @@
 #include "../include/xos/debug.h"
 #include "../include/xos/string.h"
 #include "../include/xos/stat.h"
+#include "../include/xos/arena.h"
+#include "../include/xos/buffer.h"
 
 #define LOGK(fmt, args...) DEBUGK(fmt, ##args)
 #define CHECK_PERMISSION(dir, mode) \
@@ -73,6 +75,7 @@ int sys_read(fd_t fd, char *buf, int count) {
     if (ret < EOK) return ret;
     if ((file->flags & O_ACCMODE) == O_WRONLY) return EOF;
     inode_t *inode = file->inode;
+    file_readahead(inode, &file->ra, file->offset, count);
     HANDLE_INODE_OPERATION(read, inode, buf, count, file->offset)
 }
 
@@ -85,6 +88,155 @@ int sys_write(unsigned int fd, char *buf, int count) {
     HANDLE_INODE_OPERATION(write, inode, buf, count, file->offset)
 }
 
+// 向量读写 inode，文件系统不支持时依次读写每个缓冲区，iov 会被消耗
+static int inode_rw_iov(inode_t *inode, iovec_t *iov, int iovlen, off_t offset, bool write) {
+    int len = iovec_size(iov, iovlen);
+    int ret = -ENOSYS;
+    if (write && inode->op->writev)
+        ret = inode->op->writev(inode, iov, iovlen, len, offset);
+    else if (!write && inode->op->readv)
+        ret = inode->op->readv(inode, iov, iovlen, len, offset);
+    if (ret != -ENOSYS) return ret;
+
+    int nr = 0;
+    for (; iovlen > 0; iov++, iovlen--) {
+        if (write)
+            ret = inode->op->write(inode, iov->base, iov->size, offset + nr);
+        else
+            ret = inode->op->read(inode, iov->base, iov->size, offset + nr);
+        if (ret <= 0) break;
+        nr += ret;
+        if (ret < iov->size) break;
+    }
+    return nr ? nr : ret;
+}
+
+// 检查并复制用户的向量缓冲，读文件时缓冲要可写
+static iovec_t *iov_get(iovec_t *iov, int iovlen, bool write, int *err) {
+    if (iovlen <= 0 || iovlen > UIO_MAXIOV) {
+        *err = -EINVAL;
+        return NULL;
+    }
+    *err = iovec_check(iov, iovlen, write);
+    if (*err < EOK) return NULL;
+    return iovec_dup(iov, iovlen);
+}
+
+int sys_readv(fd_t fd, iovec_t *iov, int iovlen) {
+    file_t *file;
+    err_t ret = fd_check(fd, &file);
+    if (ret < EOK) return -EBADF;
+    if ((file->flags & O_ACCMODE) == O_WRONLY) return -EBADF;
+
+    iovec_t *kiov = iov_get(iov, iovlen, true, &ret);
+    if (!kiov) return ret;
+    file_readahead(file->inode, &file->ra, file->offset, iovec_size(kiov, iovlen));
+    int len = inode_rw_iov(file->inode, kiov, iovlen, file->offset, false);
+    kfree(kiov);
+    if (len > 0) file->offset += len;
+    return len;
+}
+
+int sys_writev(fd_t fd, iovec_t *iov, int iovlen) {
+    file_t *file;
+    err_t ret = fd_check(fd, &file);
+    if (ret < EOK) return -EBADF;
+    if ((file->flags & O_ACCMODE) == O_RDONLY) return -EBADF;
+
+    iovec_t *kiov = iov_get(iov, iovlen, false, &ret);
+    if (!kiov) return ret;
+    int len = inode_rw_iov(file->inode, kiov, iovlen, file->offset, true);
+    kfree(kiov);
+    if (len > 0) file->offset += len;
+    return len;
+}
+
+// 管道和套接字没有偏移
+static bool inode_seekable(inode_t *inode) {
+    return inode->type != FS_TYPE_PIPE && inode->type != FS_TYPE_SOCKET;
+}
+
+int sys_pread(fd_t fd, char *buf, int count, off_t offset) {
+    if (count < 0 || offset < 0) return -EINVAL;
+    if (!memory_access(buf, count, true, running_task()->uid != KERNEL_USER)) return -EFAULT;
+    file_t *file;
+    err_t ret = fd_check(fd, &file);
+    if (ret < EOK) return -EBADF;
+    if ((file->flags & O_ACCMODE) == O_WRONLY) return -EBADF;
+    inode_t *inode = file->inode;
+    if (!inode_seekable(inode)) return -ESPIPE;
+    file_readahead(inode, &file->ra, offset, count);
+    return inode->op->read(inode, buf, count, offset);
+}
+
+int sys_pwrite(fd_t fd, char *buf, int count, off_t offset) {
+    if (count < 0 || offset < 0) return -EINVAL;
+    if (!is_user_memory(buf, count)) return -EFAULT;
+    file_t *file;
+    err_t ret = fd_check(fd, &file);
+    if (ret < EOK) return -EBADF;
+    if ((file->flags & O_ACCMODE) == O_RDONLY) return -EBADF;
+    inode_t *inode = file->inode;
+    if (!inode_seekable(inode)) return -ESPIPE;
+    return inode->op->write(inode, buf, count, offset);
+}
+
+// 写入文件所在设备的所有脏缓冲，缓冲不记录所属的文件，
+// 所以同时写入了同一设备上其他文件的数据，fdatasync 与 fsync 相同
+int sys_fsync(fd_t fd) {
+    file_t *file;
+    err_t ret = fd_check(fd, &file);
+    if (ret < EOK) return -EBADF;
+    inode_t *inode = file->inode;
+    if (inode->type != FS_TYPE_MINIX) return -EINVAL;
+    return bsync(inode->dev);
+}
+
+int sys_fdatasync(fd_t fd) {
+    return sys_fsync(fd);
+}
+
+// 设置文件标记，非阻塞方式变化时通知 inode
+static int file_setfl(file_t *file, int flags) {
+    int changed = (file->flags ^ flags) & O_NONBLOCK;
+    file->flags = (file->flags & ~O_SETFL_MASK) | (flags & O_SETFL_MASK);
+    inode_t *inode = file->inode;
+    if (changed && inode->op->ioctl)
+        inode->op->ioctl(inode, FIONBIO, (void *)(flags & O_NONBLOCK ? 1 : 0));
+    return EOK;
+}
+
+int sys_fcntl(fd_t fd, int cmd, int arg) {
+    file_t *file;
+    err_t ret = fd_check(fd, &file);
+    if (ret < EOK) return -EBADF;
+    switch (cmd) {
+    case F_GETFL:
+        return file->flags;
+    case F_SETFL:
+        return file_setfl(file, arg);
+    case F_GETPIPE_SZ:
+    case F_SETPIPE_SZ:
+        if (file->inode->type != FS_TYPE_PIPE) return -EBADF;
+        return file->inode->op->ioctl(file->inode, cmd, (void *)arg);
+    default:
+        return -EINVAL;
+    }
+}
+
+int sys_ioctl(fd_t fd, int cmd, void *args) {
+    file_t *file;
+    err_t ret = fd_check(fd, &file);
+    if (ret < EOK) return -EBADF;
+    if (cmd == FIONBIO) {
+        if (!is_user_memory((char *)args, sizeof(int))) return -EFAULT;
+        int flags = *(int *)args ? file->flags | O_NONBLOCK : file->flags & ~O_NONBLOCK;
+        return file_setfl(file, flags);
+    }
+    inode_t *inode = file->inode;
+    return inode->op->ioctl(inode, cmd, args);
+}
+
 int sys_stat(char *filename, stat_t *statbuf) {
     inode_t *inode = namei(filename);
     if (!inode) return -ENOENT;
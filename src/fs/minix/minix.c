@@ -12,6 +12,7 @@
 #include "../../include/xos/stat.h"
 #include "../../include/xos/task.h"
 #include "../../include/xos/device.h"
+#include "../../include/xos/poll.h"
 
 #include "minix.h"
 
@@ -41,7 +42,7 @@ idx_t minix_balloc(super_t *super)
         {
             // 如果扫描成功，则 标记缓冲区脏，中止查找
             assert(bit < desc->zones);
-            buf->dirty = true;
+            bdirty(buf, true);
             break;
         }
     }
@@ -79,7 +80,7 @@ void minix_bfree(super_t *super, idx_t idx)
         bitmap_set(&map, idx, 0);
 
         // 标记缓冲区脏
-        buf->dirty = true;
+        bdirty(buf, true);
         break;
     }
     brelse(buf); // todo 调试期间强同步
@@ -104,7 +105,7 @@ idx_t minix_ialloc(super_t *super)
         if (bit != EOF)
         {
             assert(bit < desc->inodes);
-            buf->dirty = true;
+            bdirty(buf, true);
             break;
         }
     }
@@ -135,7 +136,7 @@ void minix_ifree(super_t *super, idx_t idx)
         bitmap_make(&map, buf->data, BLOCK_BITS, i * BLOCK_BITS);
         assert(bitmap_test(&map, idx));
         bitmap_set(&map, idx, 0);
-        buf->dirty = true;
+        bdirty(buf, true);
         break;
     }
     brelse(buf); // todo 调试期间强同步
@@ -197,7 +198,7 @@ reckon:
         if (!array[index] && create)
         {
             array[index] = minix_balloc(inode->super);
-            buf->dirty = true;
+            bdirty(buf, true);
         }
 
         brelse(buf);
@@ -285,7 +286,7 @@ static inode_t *new_inode(dev_t dev, idx_t nr)
 
     // assert(inode->desc->nlinks == 0);
 
-    inode->buf->dirty = true;
+    bdirty(inode->buf, true);
 
     minix_inode_t *minode = (minix_inode_t *)inode->desc;
     memset(minode, 0, sizeof(minix_inode_t));
@@ -306,12 +307,6 @@ static void minix_close(inode_t *inode)
 {
     assert(inode->type == FS_TYPE_MINIX);
 
-    // TODO: need write... ?
-    if (inode->buf->dirty)
-    {
-        bwrite(inode->buf);
-    }
-
     inode->count--;
 
     if (inode->count)
@@ -319,7 +314,7 @@ static void minix_close(inode_t *inode)
         return;
     }
 
-    // 释放 inode 对应的缓冲
+    // 释放 inode 对应的缓冲，脏缓冲由回写线程写入
     brelse(inode->buf);
 
     // 从超级块链表中移除
@@ -334,25 +329,39 @@ static void minix_close(inode_t *inode)
     put_free_inode(inode);
 }
 
-// 从 inode 的 offset 处，读 len 个字节到 buf
-static int minix_read(inode_t *inode, char *data, int len, off_t offset)
+// 文件块 block 之后最多 max - 1 块中，在磁盘上与它连续的块数，nr 为它的磁盘块号
+static u32 minix_contiguous(inode_t *inode, idx_t block, idx_t nr, u32 max)
 {
-    minix_inode_t *minode = (minix_inode_t *)inode->desc;
-    if (ISCHR(minode->mode))
+    u32 count = 1;
+    while (count < max && minix_bmap(inode, block + count, false) == nr + count)
+        count++;
+    return count;
+}
+
+// 读取文件块 block 的缓冲，*run 为 0 时把之后 blocks - 1 块中磁盘上连续的块一起读入，
+// 并把一起读入的块数记到 *run，之后的块直接读取
+static buffer_t *minix_bread_file(inode_t *inode, idx_t block, u32 blocks, u32 *run)
+{
+    idx_t nr = minix_bmap(inode, block, false);
+    assert(nr);
+
+    if (*run)
     {
-        assert(minode->zone[0]);
-        return device_read(minode->zone[0], data, len, 0, 0);
-    }
-    else if (ISBLK(minode->mode))
-    {
-        assert(minode->zone[0]);
-        device_t *device = device_get(minode->zone[0]);
-        assert(len % BLOCK_SIZE == 0);
-        assert(device_read(minode->zone[0], data, len / BLOCK_SIZE, offset / BLOCK_SIZE, 0) == EOK);
-        return len;
+        (*run)--;
+        return bread(inode->dev, nr, BLOCK_SIZE);
     }
 
-    assert(ISFILE(minode->mode) || ISDIR(minode->mode));
+    u32 count = minix_contiguous(inode, block, nr, blocks);
+    *run = count - 1;
+    return bread_cluster(inode->dev, nr, count, BLOCK_SIZE);
+}
+
+// 从 inode 的 offset 处，读 len 个字节到向量缓冲 iov，每个文件块只读取一次
+static int minix_readv(inode_t *inode, iovec_t *iov, int iovlen, int len, off_t offset)
+{
+    minix_inode_t *minode = (minix_inode_t *)inode->desc;
+    if (!ISFILE(minode->mode) && !ISDIR(minode->mode))
+        return -ENOSYS;
 
     // 如果偏移量超过文件大小，返回 EOF
     if (offset >= minode->size)
@@ -365,14 +374,15 @@ static int minix_read(inode_t *inode, char *data, int len, off_t offset)
 
     // 剩余字节数
     u32 left = MIN(len, minode->size - offset);
+
+    // 磁盘上连续的文件块合并读取
+    idx_t last = (offset + left - 1) / BLOCK_SIZE;
+    u32 run = 0;
     while (left)
     {
-        // 找到对应的文件便宜，所在文件块
-        idx_t nr = minix_bmap(inode, offset / BLOCK_SIZE, false);
-        assert(nr);
-
-        // 读取文件块缓冲
-        buffer_t *buf = bread(inode->dev, nr, BLOCK_SIZE);
+        // 读取对应的文件块缓冲
+        idx_t block = offset / BLOCK_SIZE;
+        buffer_t *buf = minix_bread_file(inode, block, last - block + 1, &run);
 
         // 文件块中的偏移量
         u32 start = offset % BLOCK_SIZE;
@@ -387,11 +397,8 @@ static int minix_read(inode_t *inode, char *data, int len, off_t offset)
         // 文件块中的指针
         char *ptr = buf->data + start;
 
-        // 拷贝内容
-        memcpy(data, ptr, chars);
-
-        // 更新缓存位置
-        data += chars;
+        // 拷贝内容，同时消耗 iov
+        iovec_write(iov, iovlen, ptr, chars);
 
         // 释放文件块缓冲
         brelse(buf);
@@ -404,27 +411,37 @@ static int minix_read(inode_t *inode, char *data, int len, off_t offset)
     return offset - begin;
 }
 
-// 从 inode 的 offset 处，将 data 的 len 个字节写入磁盘
-static int minix_write(inode_t *inode, char *data, int len, off_t offset)
+// 从 inode 的 offset 处，读 len 个字节到 buf
+static int minix_read(inode_t *inode, char *data, int len, off_t offset)
 {
     minix_inode_t *minode = (minix_inode_t *)inode->desc;
     if (ISCHR(minode->mode))
     {
         assert(minode->zone[0]);
-        device_t *device = device_get(minode->zone[0]);
-        return device_write(minode->zone[0], data, len, 0, 0);
+        return device_read(minode->zone[0], data, len, 0, 0);
     }
     else if (ISBLK(minode->mode))
     {
         assert(minode->zone[0]);
         device_t *device = device_get(minode->zone[0]);
         assert(len % BLOCK_SIZE == 0);
-        assert(device_write(minode->zone[0], data, len / BLOCK_SIZE, offset / BLOCK_SIZE, 0) == EOK);
+        assert(device_read(minode->zone[0], data, len / BLOCK_SIZE, offset / BLOCK_SIZE, 0) == EOK);
         return len;
     }
 
+    iovec_t iov = {len, data};
+    return minix_readv(inode, &iov, 1, len, offset);
+}
+
+// 从 inode 的 offset 处，将向量缓冲 iov 中的 len 个字节写入磁盘，
+// 每个文件块只写入一次，inode 在最后写入一次
+static int minix_writev(inode_t *inode, iovec_t *iov, int iovlen, int len, off_t offset)
+{
+    minix_inode_t *minode = (minix_inode_t *)inode->desc;
+
     // 不允许目录写入目录文件，修改目录有其他的专用方法
-    assert(ISFILE(minode->mode));
+    if (!ISFILE(minode->mode))
+        return -ENOSYS;
 
     // 开始的位置
     u32 begin = offset;
@@ -438,18 +455,27 @@ static int minix_write(inode_t *inode, char *data, int len, off_t offset)
         idx_t nr = minix_bmap(inode, offset / BLOCK_SIZE, true);
         assert(nr);
 
-        // 将读入文件块
-        buffer_t *buf = bread(inode->dev, nr, BLOCK_SIZE);
-        buf->dirty = true;
-
         // 块中的偏移量
         u32 start = offset % BLOCK_SIZE;
-        // 文件块中的指针
-        char *ptr = buf->data + start;
 
-        // 读取的数量
+        // 写入的数量
         u32 chars = MIN(BLOCK_SIZE - start, left);
 
+        // 整块覆盖时不必从磁盘读入文件块
+        buffer_t *buf;
+        if (chars == BLOCK_SIZE)
+        {
+            buf = bget(inode->dev, nr, BLOCK_SIZE);
+        }
+        else
+        {
+            buf = bread(inode->dev, nr, BLOCK_SIZE);
+        }
+        bdirty(buf, true);
+
+        // 文件块中的指针
+        char *ptr = buf->data + start;
+
         // 更新偏移量
         offset += chars;
 
@@ -460,14 +486,11 @@ static int minix_write(inode_t *inode, char *data, int len, off_t offset)
         if (offset > minode->size)
         {
             inode->size = minode->size = offset;
-            inode->buf->dirty = true;
+            bdirty(inode->buf, true);
         }
 
-        // 拷贝内容
-        memcpy(ptr, data, chars);
-
-        // 更新缓存偏移
-        data += chars;
+        // 拷贝内容，同时消耗 iov
+        iovec_read(iov, iovlen, ptr, chars);
 
         // 释放文件块
         brelse(buf);
@@ -475,14 +498,38 @@ static int minix_write(inode_t *inode, char *data, int len, off_t offset)
 
     // 更新修改时间
     minode->mtime = inode->atime = time();
-
-    // TODO: 写入磁盘 ？
-    bwrite(inode->buf);
+    bdirty(inode->buf, true);
 
     // 返回写入大小
     return offset - begin;
 }
 
+// 从 inode 的 offset 处，将 data 的 len 个字节写入磁盘
+static int minix_write(inode_t *inode, char *data, int len, off_t offset)
+{
+    minix_inode_t *minode = (minix_inode_t *)inode->desc;
+    if (ISCHR(minode->mode))
+    {
+        assert(minode->zone[0]);
+        device_t *device = device_get(minode->zone[0]);
+        return device_write(minode->zone[0], data, len, 0, 0);
+    }
+    else if (ISBLK(minode->mode))
+    {
+        assert(minode->zone[0]);
+        device_t *device = device_get(minode->zone[0]);
+        assert(len % BLOCK_SIZE == 0);
+        assert(device_write(minode->zone[0], data, len / BLOCK_SIZE, offset / BLOCK_SIZE, 0) == EOK);
+        return len;
+    }
+
+    // 不允许目录写入目录文件，修改目录有其他的专用方法
+    assert(ISFILE(minode->mode));
+
+    iovec_t iov = {len, data};
+    return minix_writev(inode, &iov, 1, len, offset);
+}
+
 static void inode_bfree(inode_t *inode, u16 *array, int index, int level)
 {
     if (!array[index])
@@ -546,9 +593,8 @@ static int minix_truncate(inode_t *inode)
     minode->zone[DIRECT_BLOCK + 1] = 0;
 
     inode->size = minode->size = 0;
-    inode->buf->dirty = true;
+    bdirty(inode->buf, true);
     minode->mtime = time();
-    bwrite(inode->buf);
     return EOK;
 }
 
@@ -668,16 +714,16 @@ static buffer_t *add_entry(inode_t *dir, const char *name, minix_dentry_t **resu
         {
             entry->nr = 0;
             dir->size = minode->size = (i + 1) * sizeof(minix_dentry_t);
-            dir->buf->dirty = true;
+            bdirty(dir->buf, true);
         }
         if (entry->nr)
             continue;
 
         strncpy(entry->name, name, MINIX1_NAME_LEN);
 
-        buf->dirty = true;
+        bdirty(buf, true);
         dir->mtime = minode->mtime = time();
-        dir->buf->dirty = true;
+        bdirty(dir->buf, true);
         *result = entry;
         return buf;
     };
@@ -803,7 +849,7 @@ int minix_mkdir(inode_t *dir, char *name, int mode)
         goto rollback;
     }
 
-    ebuf->dirty = true;
+    bdirty(ebuf, true);
     idx_t idx = minix_ialloc(dir->super);
     entry->nr = idx;
 
@@ -817,7 +863,7 @@ int minix_mkdir(inode_t *dir, char *name, int mode)
     iminode->nlinks = 2;                                      // 一个是 '.' 一个是 name
 
     // 父目录链接数加 1
-    dir->buf->dirty = true;
+    bdirty(dir->buf, true);
     dminode->nlinks++; // ..
 
     // 写入 inode 目录中的默认目录项
@@ -827,7 +873,7 @@ int minix_mkdir(inode_t *dir, char *name, int mode)
     zbuf = bread(inode->dev, idx, BLOCK_SIZE);
     assert(zbuf);
 
-    zbuf->dirty = true;
+    bdirty(zbuf, true);
 
     entry = (minix_dentry_t *)zbuf->data;
 
@@ -839,7 +885,6 @@ int minix_mkdir(inode_t *dir, char *name, int mode)
     entry->nr = dir->nr;
 
     iput(inode);
-    bwrite(dir->buf);
 
     ret = EOK;
 
@@ -960,16 +1005,16 @@ int minix_rmdir(inode_t *dir, char *name)
     minix_ifree(inode->super, inode->nr);
 
     iminode->nlinks = 0;
-    inode->buf->dirty = true;
+    bdirty(inode->buf, true);
     inode->nr = 0;
 
     dminode->nlinks--;
     dir->ctime = dir->atime = dminode->mtime = time();
-    dir->buf->dirty = true;
+    bdirty(dir->buf, true);
     assert(dminode->nlinks > 0);
 
     entry->nr = 0;
-    ebuf->dirty = true;
+    bdirty(ebuf, true);
     ret = 0;
 
 rollback:
@@ -1034,11 +1079,11 @@ int minix_link(inode_t *odir, char *oldname, inode_t *ndir, char *newname)
     }
 
     entry->nr = inode->nr;
-    buf->dirty = true;
+    bdirty(buf, true);
 
     minode->nlinks++;
     inode->ctime = time();
-    inode->buf->dirty = true;
+    bdirty(inode->buf, true);
     ret = EOK;
 
 rollback:
@@ -1094,10 +1139,10 @@ int minix_unlink(inode_t *dir, char *name)
     }
 
     entry->nr = 0;
-    buf->dirty = true;
+    bdirty(buf, true);
 
     minode->nlinks--;
-    inode->buf->dirty = true;
+    bdirty(inode->buf, true);
 
     if (minode->nlinks == 0)
     {
@@ -1140,7 +1185,7 @@ int minix_mknod(inode_t *dir, char *name, int mode, int dev)
         goto rollback;
     }
 
-    buf->dirty = true;
+    bdirty(buf, true);
     idx_t idx = minix_ialloc(dir->super);
     entry->nr = idx;
 
@@ -1209,7 +1254,7 @@ int minix_mkfs(dev_t dev, int icount)
 
     buf = bread(dev, 1, BLOCK_SIZE);
     super->buf = buf;
-    buf->dirty = true;
+    bdirty(buf, true);
 
     // 初始化超级块
     minix_super_t *desc = (minix_super_t *)buf->data;
@@ -1233,7 +1278,7 @@ int minix_mkfs(dev_t dev, int icount)
     {
         buf = bread(dev, idx, BLOCK_SIZE);
         assert(buf);
-        buf->dirty = true;
+        bdirty(buf, true);
         memset(buf->data, 0, BLOCK_SIZE);
         brelse(buf);
     }
@@ -1259,7 +1304,7 @@ int minix_mkfs(dev_t dev, int icount)
     minode->nlinks = 2;                        // 一个是 '.' 一个是 name
 
     buf = bread(dev, minix_bmap(iroot, 0, true), BLOCK_SIZE);
-    buf->dirty = true;
+    bdirty(buf, true);
 
     minix_dentry_t *entry = (minix_dentry_t *)buf->data;
     memset(entry, 0, BLOCK_SIZE);
@@ -1295,6 +1340,114 @@ int minix_ioctl(inode_t *inode, int cmd, void *args)
     return device_ioctl(dev, cmd, args, 0);
 }
 
+// 字符设备由设备决定就绪事件，普通文件总是可读写
+static int minix_poll(inode_t *inode, poll_table_t *pt)
+{
+    if (!ISCHR(inode->mode) || inode->rdev >= DEVICE_NR)
+        return POLLIN | POLLOUT;
+    return device_poll(inode->rdev, pt);
+}
+
+// 把普通文件 offset 处的文件块缓冲直接交给 actor，数据不经过用户空间
+static int minix_sendfile(inode_t *inode, int len, off_t offset, read_actor_t actor, void *target)
+{
+    minix_inode_t *minode = (minix_inode_t *)inode->desc;
+    if (!ISFILE(minode->mode))
+        return -EINVAL;
+
+    if (offset >= minode->size)
+        return 0;
+
+    u32 begin = offset;
+    u32 left = MIN(len, minode->size - offset);
+    idx_t last = (offset + left - 1) / BLOCK_SIZE;
+    u32 run = 0;
+    int ret = EOK;
+    while (left)
+    {
+        idx_t block = offset / BLOCK_SIZE;
+        buffer_t *buf = minix_bread_file(inode, block, last - block + 1, &run);
+
+        u32 start = offset % BLOCK_SIZE;
+        u32 chars = MIN(BLOCK_SIZE - start, left);
+
+        // 接收者在文件块缓冲释放前使用数据
+        ret = actor(target, buf, buf->data + start, chars);
+        brelse(buf);
+
+        if (ret <= 0)
+            break;
+
+        offset += ret;
+        left -= ret;
+        if (ret < chars)
+            break;
+    }
+
+    inode->atime = time();
+
+    // 已经发送了部分数据时返回发送的字节数
+    if (offset == begin && ret < EOK)
+        return ret;
+    return offset - begin;
+}
+
+// 预读 [start, end) 中已经分配的文件块，磁盘上连续的块合并成一次预读
+static void minix_prefetch(inode_t *inode, idx_t start, idx_t end)
+{
+    for (idx_t block = start; block < end;)
+    {
+        idx_t nr = minix_bmap(inode, block, false);
+        if (!nr)
+        {
+            block++;
+            continue;
+        }
+
+        u32 count = minix_contiguous(inode, block, nr, end - block);
+        bprefetch(inode->dev, nr, count, BLOCK_SIZE);
+        block += count;
+    }
+}
+
+// 读取之前预读：本次请求的其余文件块总是预读，
+// 顺序读取时还预读后面一个窗口，读者进入上一个窗口时预读下一个，窗口每次加倍，
+// 随机读取不预读请求之外的文件块
+static int minix_readahead(inode_t *inode, readahead_t *ra, off_t offset, int len)
+{
+    minix_inode_t *minode = (minix_inode_t *)inode->desc;
+    if (!ISFILE(minode->mode) || len <= 0 || offset >= minode->size)
+        return EOK;
+
+    idx_t blocks = div_round_up(minode->size, BLOCK_SIZE);
+    idx_t first = offset / BLOCK_SIZE;
+    idx_t last = (MIN(offset + len, minode->size) - 1) / BLOCK_SIZE;
+
+    minix_prefetch(inode, first + 1, MIN(last + 1, first + 1 + READAHEAD_MAX));
+
+    // 从上次读到的块或它的下一块开始读，视为顺序读取，新打开的文件从头读也一样
+    bool sequential = (first == ra->prev || first == ra->prev + 1);
+    ra->prev = last;
+    if (!sequential)
+    {
+        ra->size = 0;
+        return EOK;
+    }
+
+    if (ra->size && last < ra->mark)
+        return EOK;
+
+    ra->size = ra->size ? MIN(ra->size * 2, READAHEAD_MAX) : READAHEAD_MIN;
+    if (ra->end <= last)
+        ra->end = last + 1;
+    ra->mark = ra->end;
+
+    idx_t end = MIN(ra->end + ra->size, blocks);
+    minix_prefetch(inode, ra->end, end);
+    ra->end = MAX(end, ra->end);
+    return EOK;
+}
+
 static fs_op_t minix_op = {
     minix_mkfs,
     minix_super,
@@ -1317,6 +1470,14 @@ static fs_op_t minix_op = {
     minix_unlink,
     minix_mknod,
     minix_readdir,
+
+    minix_poll,
+    minix_sendfile,
+
+    minix_readv,
+    minix_writev,
+
+    minix_readahead,
 };
 
 void minix_init()
@@ -3,69 +3,319 @@
 #include "../../include/xos/memory.h"
 #include "../../include/xos/arena.h"
 #include "../../include/xos/stat.h"
-#include "../../include/xos/fifo.h"
+#include "../../include/xos/buffer.h"
+#include "../../include/xos/pipe.h"
 #include "../../include/xos/assert.h"
 #include "../../include/xos/debug.h"
 #include "../../include/xos/errno.h"
+#include "../../include/xos/poll.h"
+#include "../../include/xos/string.h"
+#include "../../include/xos/stdlib.h"
 
 #define LOGK(fmt, args...) DEBUGK(fmt, ##args)
 
-// 通用的 inode 初始化函数
-static inode_t *init_inode(int type, size_t desc_size, size_t page_count) {
-    inode_t *inode = get_free_inode();
-    inode->dev = -type;
-    inode->desc = kmalloc(desc_size);
-    inode->addr = alloc_kpage(page_count);
-    inode->count = 2;
-    inode->type = type;
-    inode->op = fs_get_op(type);
-    return inode;
+// 管道缓冲引用的页，tee 之后可能被多个管道共享
+typedef struct pipe_page_t {
+    u32 addr;  // 页地址
+    u32 count; // 引用计数
+} pipe_page_t;
+
+static void page_buf_get(pipe_buffer_t *buf) {
+    ((pipe_page_t *)buf->private)->count++;
+}
+
+static void page_buf_release(pipe_buffer_t *buf) {
+    pipe_page_t *page = (pipe_page_t *)buf->private;
+    assert(page->count > 0);
+    if (--page->count)
+        return;
+    free_kpage(page->addr, 1);
+    kfree(page);
+}
+
+static pipe_buf_op_t page_buf_op = {
+    page_buf_get,
+    page_buf_release,
+};
+
+static void cache_buf_get(pipe_buffer_t *buf) {
+    ((buffer_t *)buf->private)->count++;
+}
+
+static void cache_buf_release(pipe_buffer_t *buf) {
+    brelse((buffer_t *)buf->private);
+}
+
+static pipe_buf_op_t cache_buf_op = {
+    cache_buf_get,
+    cache_buf_release,
+};
+
+void pipe_buf_alloc(pipe_buffer_t *buf) {
+    pipe_page_t *page = (pipe_page_t *)kmalloc(sizeof(pipe_page_t));
+    page->addr = alloc_kpage(1);
+    page->count = 1;
+    buf->data = (char *)page->addr;
+    buf->len = 0;
+    buf->op = &page_buf_op;
+    buf->private = page;
+}
+
+void pipe_buf_cache(pipe_buffer_t *buf, buffer_t *cache, char *data, u32 len) {
+    cache->count++;
+    buf->data = data;
+    buf->len = len;
+    buf->op = &cache_buf_op;
+    buf->private = cache;
+}
+
+// 独占的页中数据后面剩余的空间，共享的页和文件块缓冲不能追加
+static u32 pipe_buf_room(pipe_buffer_t *buf) {
+    if (buf->op != &page_buf_op || ((pipe_page_t *)buf->private)->count != 1)
+        return 0;
+    pipe_page_t *page = (pipe_page_t *)buf->private;
+    return page->addr + PAGE_SIZE - (u32)(buf->data + buf->len);
+}
+
+pipe_buffer_t *pipe_buf_first(pipe_t *pipe) {
+    if (!pipe->nrbufs)
+        return NULL;
+    return &pipe->bufs[pipe->head];
+}
+
+// 最后一个有数据的缓冲
+static pipe_buffer_t *pipe_buf_last(pipe_t *pipe) {
+    if (!pipe->nrbufs)
+        return NULL;
+    return &pipe->bufs[(pipe->head + pipe->nrbufs - 1) % pipe->size];
+}
+
+pipe_buffer_t *pipe_buf_push(pipe_t *pipe) {
+    if (pipe->nrbufs == pipe->size)
+        return NULL;
+    pipe_buffer_t *buf = &pipe->bufs[(pipe->head + pipe->nrbufs) % pipe->size];
+    pipe->nrbufs++;
+    return buf;
+}
+
+void pipe_buf_pop(pipe_t *pipe) {
+    assert(pipe->nrbufs > 0);
+    pipe_buffer_t *buf = &pipe->bufs[pipe->head];
+    buf->op->release(buf);
+    buf->op = NULL;
+    pipe->head = (pipe->head + 1) % pipe->size;
+    pipe->nrbufs--;
+}
+
+// 阻塞等待对端，自己在 waiter 中，线程组退出时返回 -EINTR
+static err_t pipe_wait(task_t **waiter) {
+    assert(*waiter == NULL);
+    task_t *task = running_task();
+    *waiter = task;
+    task->flags |= TASK_KILLABLE;
+    err_t ret = task_block(task, NULL, TASK_BLOCKED, TIMELESS);
+    task->flags &= ~TASK_KILLABLE;
+
+    // 不是被对端唤醒的，自己退出等待
+    if (*waiter == task)
+        *waiter = NULL;
+    return ret;
+}
+
+// 唤醒阻塞在 waiter 中的对端
+static void pipe_wakeup(task_t **waiter) {
+    if (*waiter) {
+        task_unblock(*waiter, EOK);
+        *waiter = NULL;
+    }
+}
+
+void pipe_notify_readable(inode_t *inode) {
+    pipe_t *pipe = (pipe_t *)inode->desc;
+    pipe_wakeup(&inode->rxwaiter);
+    wake_up(&pipe->wait, POLLIN);
+}
+
+void pipe_notify_writable(inode_t *inode) {
+    pipe_t *pipe = (pipe_t *)inode->desc;
+    pipe_wakeup(&inode->txwaiter);
+    wake_up(&pipe->wait, POLLOUT);
+}
+
+// 管道的两端各占一个引用，少于两个说明对端已经关闭
+int pipe_wait_readable(inode_t *inode, bool nonblock) {
+    pipe_t *pipe = (pipe_t *)inode->desc;
+    while (!pipe->nrbufs) {
+        if (inode->count < 2)
+            return EOF;
+        if (nonblock)
+            return -EAGAIN;
+        int ret = pipe_wait(&inode->rxwaiter);
+        if (ret < EOK)
+            return ret;
+    }
+    return EOK;
+}
+
+int pipe_wait_writable(inode_t *inode, bool nonblock) {
+    pipe_t *pipe = (pipe_t *)inode->desc;
+    while (true) {
+        if (inode->count < 2)
+            return -EPIPE;
+        if (pipe->nrbufs < pipe->size)
+            return EOK;
+        if (nonblock)
+            return -EAGAIN;
+        // 缓冲区满，先通知读者再等待
+        pipe_notify_readable(inode);
+        int ret = pipe_wait(&inode->txwaiter);
+        if (ret < EOK)
+            return ret;
+    }
 }
 
 // 打开管道
 static inode_t *pipe_open() {
-    inode_t *inode = init_inode(FS_TYPE_PIPE, sizeof(fifo_t), 1);
-    fifo_init((fifo_t *)inode->desc, (char *)inode->addr, PAGE_SIZE);
+    inode_t *inode = get_free_inode();
+    inode->dev = -FS_TYPE_PIPE;
+    inode->desc = kmalloc(sizeof(pipe_t));
+    inode->addr = NULL;
+    inode->count = 2;
+    inode->type = FS_TYPE_PIPE;
+    inode->op = fs_get_op(FS_TYPE_PIPE);
+
+    pipe_t *pipe = (pipe_t *)inode->desc;
+    pipe->size = PIPE_DEF_BUFFERS;
+    pipe->bufs = (pipe_buffer_t *)kmalloc(pipe->size * sizeof(pipe_buffer_t));
+    pipe->head = 0;
+    pipe->nrbufs = 0;
+    wait_queue_init(&pipe->wait);
     return inode;
 }
 
-// 关闭管道
+// 关闭管道，一端关闭时唤醒另一端
 static void pipe_close(inode_t *inode) {
-    if (inode && --inode->count == 0) {
-        inode->type = FS_TYPE_NONE;
-        kfree(inode->desc);
-        free_kpage((u32)inode->addr, 1);
-        put_free_inode(inode);
+    if (!inode)
+        return;
+    if (--inode->count) {
+        pipe_notify_readable(inode);
+        pipe_notify_writable(inode);
+        return;
     }
+
+    pipe_t *pipe = (pipe_t *)inode->desc;
+    while (pipe->nrbufs)
+        pipe_buf_pop(pipe);
+    kfree(pipe->bufs);
+    kfree(pipe);
+
+    inode->type = FS_TYPE_NONE;
+    inode->desc = NULL;
+    put_free_inode(inode);
 }
 
-// 通用的 IO 操作处理函数
-static int pipe_io(inode_t *inode, char *data, int count, int (*condition)(fifo_t *), void (*action)(fifo_t *, char), task_t **waiter) {
-    fifo_t *fifo = (fifo_t *)inode->desc;
+// 读管道，至少读到一个字节后，管道为空即返回，写端关闭且管道为空时返回 EOF
+static int pipe_read(inode_t *inode, char *data, int count, off_t offset) {
+    pipe_t *pipe = (pipe_t *)inode->desc;
     int nr = 0;
     while (nr < count) {
-        if (condition(fifo)) {
-            assert(*waiter == NULL);
-            *waiter = running_task();
-            task_block(*waiter, NULL, TASK_BLOCKED, TIMELESS);
+        if (!pipe->nrbufs) {
+            if (nr > 0)
+                break;
+            int ret = pipe_wait_readable(inode, false);
+            if (ret < EOK)
+                return ret;
         }
-        action(fifo, data[nr++]);
-        if (*waiter) {
-            task_unblock(*waiter, EOK);
-            *waiter = NULL;
+
+        pipe_buffer_t *buf = pipe_buf_first(pipe);
+        u32 chars = MIN(count - nr, buf->len);
+        memcpy(data + nr, buf->data, chars);
+        nr += chars;
+        buf->data += chars;
+        buf->len -= chars;
+        if (!buf->len)
+            pipe_buf_pop(pipe);
+    }
+    if (nr > 0)
+        pipe_notify_writable(inode);
+    return nr;
+}
+
+// 写管道，数据追加到最后一页，放不下时使用新页，全部写入才返回
+static int pipe_write(inode_t *inode, char *data, int count, off_t offset) {
+    pipe_t *pipe = (pipe_t *)inode->desc;
+    int nr = 0;
+    while (nr < count) {
+        pipe_buffer_t *buf = pipe_buf_last(pipe);
+        u32 room = buf ? pipe_buf_room(buf) : 0;
+        if (!room) {
+            int ret = pipe_wait_writable(inode, false);
+            if (ret < EOK)
+                return nr ? nr : ret;
+            buf = pipe_buf_push(pipe);
+            pipe_buf_alloc(buf);
+            room = PAGE_SIZE;
         }
+
+        u32 chars = MIN(count - nr, room);
+        memcpy(buf->data + buf->len, data + nr, chars);
+        buf->len += chars;
+        nr += chars;
     }
+    if (nr > 0)
+        pipe_notify_readable(inode);
     return nr;
 }
 
-// 读管道
-static int pipe_read(inode_t *inode, char *data, int count, off_t offset) {
-    return pipe_io(inode, data, count, fifo_empty, fifo_get, &inode->rxwaiter);
+// 调整管道容量，容量不能小于已有数据的缓冲数量
+static int pipe_resize(pipe_t *pipe, u32 size) {
+    if (size < pipe->nrbufs)
+        return -EBUSY;
+
+    pipe_buffer_t *bufs = (pipe_buffer_t *)kmalloc(size * sizeof(pipe_buffer_t));
+    for (size_t i = 0; i < pipe->nrbufs; i++)
+        bufs[i] = pipe->bufs[(pipe->head + i) % pipe->size];
+
+    kfree(pipe->bufs);
+    pipe->bufs = bufs;
+    pipe->size = size;
+    pipe->head = 0;
+    return EOK;
 }
 
-// 写管道
-static int pipe_write(inode_t *inode, char *data, int count, off_t offset) {
-    return pipe_io(inode, data, count, fifo_full, fifo_put, &inode->txwaiter);
+// 设置和获取管道容量，以字节为单位，按页取整
+static int pipe_ioctl(inode_t *inode, int cmd, void *args) {
+    pipe_t *pipe = (pipe_t *)inode->desc;
+    u32 size;
+    switch (cmd) {
+    case F_GETPIPE_SZ:
+        return pipe->size * PAGE_SIZE;
+    case F_SETPIPE_SZ:
+        size = div_round_up((u32)args, PAGE_SIZE);
+        if (size == 0 || size > PIPE_MAX_BUFFERS)
+            return -EINVAL;
+        int ret = pipe_resize(pipe, size);
+        if (ret < EOK)
+            return ret;
+        pipe_notify_writable(inode);
+        return size * PAGE_SIZE;
+    default:
+        return -EINVAL;
+    }
+}
+
+// 管道就绪事件
+static int pipe_poll(inode_t *inode, poll_table_t *pt) {
+    pipe_t *pipe = (pipe_t *)inode->desc;
+    poll_wait(pt, &pipe->wait);
+    int mask = 0;
+    if (pipe->nrbufs)
+        mask |= POLLIN;
+    if (pipe->nrbufs < pipe->size)
+        mask |= POLLOUT;
+    if (inode->count < 2)
+        mask |= POLLHUP;
+    return mask;
 }
 
 // 管道系统调用
@@ -89,16 +339,16 @@ int sys_pipe(fd_t pipefd[2]) {
 static fs_op_t pipe_op = {
     fs_default_nosys, fs_default_nosys,
     fs_default_nosys, pipe_close,
-    fs_default_nosys, pipe_read,
+    pipe_ioctl, pipe_read,
     pipe_write, fs_default_nosys,
     fs_default_nosys, fs_default_nosys,
     fs_default_nosys, fs_default_nosys,
     fs_default_nosys, fs_default_nosys,
     fs_default_nosys, fs_default_nosys,
-    fs_default_nosys
+    fs_default_nosys, pipe_poll
 };
 
 // 初始化管道
 void pipe_init() {
     fs_register_op(FS_TYPE_PIPE, &pipe_op);
-}
\ No newline at end of file
+}
@@ -0,0 +1,237 @@
+#include "../../include/xos/fs.h"
+#include "../../include/xos/task.h"
+#include "../../include/xos/memory.h"
+#include "../../include/xos/buffer.h"
+#include "../../include/xos/pipe.h"
+#include "../../include/xos/assert.h"
+#include "../../include/xos/debug.h"
+#include "../../include/xos/errno.h"
+#include "../../include/xos/net/socket.h"
+
+#define LOGK(fmt, args...) DEBUGK(fmt, ##args)
+
+// 文件是管道时返回 inode
+static inode_t *pipe_inode(file_t *file) {
+    inode_t *inode = file->inode;
+    if (!inode || inode->type != FS_TYPE_PIPE)
+        return NULL;
+    return inode;
+}
+
+// 在两个管道之间移动缓冲，不复制数据，缓冲只移动一部分时由两个管道共享
+static int splice_pipe_to_pipe(inode_t *in, inode_t *out, size_t len, u32 flags) {
+    bool nonblock = flags & SPLICE_F_NONBLOCK;
+    int ret = pipe_wait_readable(in, nonblock);
+    if (ret == EOF)
+        return 0;
+    if (ret < EOK)
+        return ret;
+    if ((ret = pipe_wait_writable(out, nonblock)) < EOK)
+        return ret;
+
+    pipe_t *ipipe = (pipe_t *)in->desc;
+    pipe_t *opipe = (pipe_t *)out->desc;
+    size_t nr = 0;
+    while (nr < len && ipipe->nrbufs && opipe->nrbufs < opipe->size) {
+        pipe_buffer_t *ibuf = pipe_buf_first(ipipe);
+        pipe_buffer_t *obuf = pipe_buf_push(opipe);
+
+        ibuf->op->get(ibuf);
+        *obuf = *ibuf;
+        if (ibuf->len <= len - nr) {
+            nr += ibuf->len;
+            pipe_buf_pop(ipipe);
+            continue;
+        }
+
+        obuf->len = len - nr;
+        ibuf->data += obuf->len;
+        ibuf->len -= obuf->len;
+        nr = len;
+    }
+
+    pipe_notify_writable(in);
+    pipe_notify_readable(out);
+    return nr;
+}
+
+// 从管道取出缓冲写入文件或套接字，套接字直接从缓冲发送
+static int splice_from_pipe(inode_t *in, file_t *out, off_t *offset, size_t len, u32 flags) {
+    int ret = pipe_wait_readable(in, flags & SPLICE_F_NONBLOCK);
+    if (ret == EOF)
+        return 0;
+    if (ret < EOK)
+        return ret;
+
+    inode_t *inode = out->inode;
+    socket_t *s = NULL;
+    if (inode->type == FS_TYPE_SOCKET)
+        s = (socket_t *)inode->desc;
+
+    pipe_t *pipe = (pipe_t *)in->desc;
+    size_t nr = 0;
+    while (nr < len && pipe->nrbufs) {
+        pipe_buffer_t *buf = pipe_buf_first(pipe);
+        u32 chars = MIN(buf->len, len - nr);
+
+        if (s) {
+            ret = socket_sendpage(s, buf->data, chars, MSG_MORE);
+        } else {
+            ret = inode->op->write(inode, buf->data, chars, *offset);
+            if (ret > 0)
+                *offset += ret;
+        }
+        if (ret <= 0)
+            break;
+
+        nr += ret;
+        buf->data += ret;
+        buf->len -= ret;
+        if (!buf->len)
+            pipe_buf_pop(pipe);
+        if (ret < chars)
+            break;
+    }
+
+    // 推送最后不满一段的数据
+    if (s && nr > 0)
+        socket_sendpage(s, NULL, 0, (flags & SPLICE_F_MORE) ? MSG_MORE : 0);
+
+    if (nr > 0)
+        pipe_notify_writable(in);
+    return nr ? nr : ret;
+}
+
+// 文件块缓冲直接加入管道
+static int splice_actor(void *target, buffer_t *buf, char *ptr, int len) {
+    pipe_buffer_t *pbuf = pipe_buf_push((pipe_t *)target);
+    if (!pbuf)
+        return 0;
+    pipe_buf_cache(pbuf, buf, ptr, len);
+    return len;
+}
+
+// 把文件数据放入管道，普通文件引用文件块缓冲，其他文件读到新页中
+static int splice_to_pipe(file_t *in, off_t *offset, inode_t *out, size_t len, u32 flags) {
+    int ret = pipe_wait_writable(out, flags & SPLICE_F_NONBLOCK);
+    if (ret < EOK)
+        return ret;
+
+    inode_t *inode = in->inode;
+    pipe_t *pipe = (pipe_t *)out->desc;
+
+    // 字符设备等不能按文件块读取的文件返回 -EINVAL
+    ret = -EINVAL;
+    if (inode->op->sendfile)
+        ret = inode->op->sendfile(inode, len, *offset, splice_actor, pipe);
+
+    if (ret == -EINVAL) {
+        // 流式文件每次最多读一页，避免在已经读到数据后继续阻塞
+        pipe_buffer_t buf;
+        pipe_buf_alloc(&buf);
+        ret = inode->op->read(inode, buf.data, MIN(len, PAGE_SIZE), *offset);
+        if (ret <= 0) {
+            buf.op->release(&buf);
+            return ret == EOF ? 0 : ret;
+        }
+        buf.len = ret;
+        *pipe_buf_push(pipe) = buf;
+    }
+
+    if (ret > 0) {
+        *offset += ret;
+        pipe_notify_readable(out);
+    }
+    return ret;
+}
+
+int sys_splice(fd_t fd_in, off_t *off_in, fd_t fd_out, off_t *off_out, size_t len, u32 flags) {
+    file_t *in;
+    file_t *out;
+    if (fd_check(fd_in, &in) < EOK || fd_check(fd_out, &out) < EOK)
+        return -EBADF;
+    if ((in->flags & O_ACCMODE) == O_WRONLY || (out->flags & O_ACCMODE) == O_RDONLY)
+        return -EBADF;
+
+    inode_t *ipipe = pipe_inode(in);
+    inode_t *opipe = pipe_inode(out);
+    if ((ipipe && off_in) || (opipe && off_out))
+        return -ESPIPE;
+    if (off_in && !memory_access(off_in, sizeof(off_t), true, true))
+        return -EFAULT;
+    if (off_out && !memory_access(off_out, sizeof(off_t), true, true))
+        return -EFAULT;
+    if (!len)
+        return 0;
+
+    if (ipipe && opipe) {
+        if (ipipe == opipe)
+            return -EINVAL;
+        return splice_pipe_to_pipe(ipipe, opipe, len, flags);
+    }
+
+    // 给出偏移时使用并更新 *off，否则使用并更新文件偏移
+    int ret;
+    if (ipipe) {
+        off_t pos = off_out ? *off_out : out->offset;
+        ret = splice_from_pipe(ipipe, out, &pos, len, flags);
+        if (off_out)
+            *off_out = pos;
+        else
+            out->offset = pos;
+        return ret;
+    }
+
+    if (opipe) {
+        off_t pos = off_in ? *off_in : in->offset;
+        ret = splice_to_pipe(in, &pos, opipe, len, flags);
+        if (off_in)
+            *off_in = pos;
+        else
+            in->offset = pos;
+        return ret;
+    }
+    return -EINVAL;
+}
+
+// 复制管道中的缓冲到另一个管道，两个管道共享数据，输入管道中的数据不被取出
+int sys_tee(fd_t fd_in, fd_t fd_out, size_t len, u32 flags) {
+    file_t *in;
+    file_t *out;
+    if (fd_check(fd_in, &in) < EOK || fd_check(fd_out, &out) < EOK)
+        return -EBADF;
+
+    inode_t *ipipe = pipe_inode(in);
+    inode_t *opipe = pipe_inode(out);
+    if (!ipipe || !opipe || ipipe == opipe)
+        return -EINVAL;
+    if ((in->flags & O_ACCMODE) == O_WRONLY || (out->flags & O_ACCMODE) == O_RDONLY)
+        return -EBADF;
+
+    bool nonblock = flags & SPLICE_F_NONBLOCK;
+    int ret = pipe_wait_readable(ipipe, nonblock);
+    if (ret == EOF)
+        return 0;
+    if (ret < EOK)
+        return ret;
+    if ((ret = pipe_wait_writable(opipe, nonblock)) < EOK)
+        return ret;
+
+    pipe_t *src = (pipe_t *)ipipe->desc;
+    pipe_t *dst = (pipe_t *)opipe->desc;
+    size_t nr = 0;
+    for (size_t i = 0; i < src->nrbufs && nr < len; i++) {
+        pipe_buffer_t *obuf = pipe_buf_push(dst);
+        if (!obuf)
+            break;
+
+        pipe_buffer_t *ibuf = &src->bufs[(src->head + i) % src->size];
+        ibuf->op->get(ibuf);
+        *obuf = *ibuf;
+        obuf->len = MIN(ibuf->len, len - nr);
+        nr += obuf->len;
+    }
+
+    pipe_notify_readable(opipe);
+    return nr;
+}
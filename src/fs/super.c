@@ -62,6 +62,9 @@ void put_super(super_t *super) {
     iput(super->imount);
     iput(super->iroot);
     brelse(super->buf);
+
+    // 卸载之前写入设备上所有的脏缓冲
+    bsync(super->dev);
 }
 
 // 读取设备 dev 的超级块
@@ -93,6 +96,12 @@ static void mount_root() {
     LOGK("Mount root file system...\n");
 
     device_t *device = device_find(DEV_IDE_PART, 0);
+    if (!device) {
+        device = device_find(DEV_SATA_PART, 0);
+    }
+    if (!device) {
+        device = device_find(DEV_VIRTIO_PART, 0);
+    }
     if (!device) {
         device = device_find(DEV_IDE_CD, 0);
     }
@@ -0,0 +1,120 @@
+#ifndef XOS_AHCI_H
+#define XOS_AHCI_H
+
+#include "./types.h"
+#include "./list.h"
+#include "./device.h"
+
+#define AHCI_PORT_NR 32 // 控制器最多端口数量
+#define AHCI_SLOT_NR 32 // 每个端口命令槽数量
+#define AHCI_PART_NR 4  // 每个磁盘分区数量，只支持主分区
+#define AHCI_PRD_NR 56  // 每个命令表的 PRD 项数，命令表正好 1K
+
+// 命令头，命令列表由 32 个命令头组成，1K 对齐
+typedef struct ahci_cmd_header_t
+{
+    u16 flags;       // 低 5 位为命令 FIS 的双字数，第 6 位为写
+    u16 prdtl;       // PRD 项数
+    u32 prdbc;       // 已经传输的字节数
+    u32 ctba;        // 命令表物理地址，128 字节对齐
+    u32 ctbau;       // 命令表物理地址高 32 位
+    u32 reserved[4]; // 保留
+} _packed ahci_cmd_header_t;
+
+// Physical Region Descriptor，描述一段物理内存
+typedef struct ahci_prd_t
+{
+    u32 dba;      // 物理地址，双字节对齐
+    u32 dbau;     // 物理地址高 32 位
+    u32 reserved; // 保留
+    u32 dbc;      // 低 22 位为字节数减一，最高位表示完成时中断
+} _packed ahci_prd_t;
+
+// 命令表，每个命令槽一个
+typedef struct ahci_cmd_table_t
+{
+    u8 cfis[64];                  // 命令 FIS
+    u8 acmd[16];                  // ATAPI 命令
+    u8 reserved[48];              // 保留
+    ahci_prd_t prdt[AHCI_PRD_NR]; // PRD 表
+} _packed ahci_cmd_table_t;
+
+// 主机到设备的寄存器 FIS
+typedef struct fis_reg_h2d_t
+{
+    u8 type;        // FIS 类型 0x27
+    u8 flags;       // 最高位为 1 表示命令，0 表示控制
+    u8 command;     // 命令
+    u8 featurel;    // 特性低 8 位，NCQ 中为扇区数量
+    u8 lba0;        // LBA 0 ~ 7
+    u8 lba1;        // LBA 8 ~ 15
+    u8 lba2;        // LBA 16 ~ 23
+    u8 device;      // 设备寄存器
+    u8 lba3;        // LBA 24 ~ 31
+    u8 lba4;        // LBA 32 ~ 39
+    u8 lba5;        // LBA 40 ~ 47
+    u8 featureh;    // 特性高 8 位
+    u8 countl;      // 扇区数量低 8 位，NCQ 中高 5 位为命令标签
+    u8 counth;      // 扇区数量高 8 位
+    u8 icc;         // 同步命令完成
+    u8 control;     // 控制寄存器
+    u8 reserved[4]; // 保留
+} _packed fis_reg_h2d_t;
+
+// 同步命令的等待状态，放在等待者的栈上，命令槽释放之后结果仍然有效
+typedef struct ahci_wait_t
+{
+    struct task_t *task; // 等待完成的任务
+    err_t ret;           // 执行结果
+    bool done;           // 是否已经完成
+} ahci_wait_t;
+
+// 命令槽，记录占用者，完成时通知
+typedef struct ahci_slot_t
+{
+    request_t *req;    // 异步执行的请求
+    ahci_wait_t *wait; // 同步等待的状态
+} ahci_slot_t;
+
+// AHCI 磁盘分区
+typedef struct ahci_part_t
+{
+    char name[8];             // 分区名称
+    struct ahci_port_t *port; // 端口指针
+    u32 system;               // 分区类型
+    u32 start;                // 分区起始物理扇区号 LBA
+    u32 count;                // 分区占用的扇区数
+} ahci_part_t;
+
+// AHCI 端口，每个端口连接一个 SATA 磁盘
+typedef struct ahci_port_t
+{
+    char name[8];                     // 磁盘名称
+    struct ahci_ctrl_t *ctrl;         // 控制器指针
+    u32 index;                        // 端口号
+    u32 base;                         // 端口寄存器地址
+    ahci_cmd_header_t *cmdlist;       // 命令列表
+    u8 *fis;                          // 接收 FIS 区域
+    ahci_cmd_table_t *tables;         // 命令表，每个命令槽一个
+    u32 slots;                        // 可以同时执行的命令数量
+    bool ncq;                         // 是否使用本地命令队列
+    u32 issued;                       // 已经发出命令的槽位图
+    ahci_slot_t slot[AHCI_SLOT_NR];   // 命令槽
+    list_t wait_list;                 // 等待空闲命令槽的任务
+    u32 total_lba;                    // 可用扇区数量
+    dev_t dev;                        // 磁盘设备号
+    ahci_part_t parts[AHCI_PART_NR];  // 磁盘分区
+} ahci_port_t;
+
+// AHCI 控制器
+typedef struct ahci_ctrl_t
+{
+    char name[8];                     // 控制器名称
+    u32 membase;                      // 映射内存基地址
+    u32 vector;                       // 中断向量
+    u32 slots;                        // 每个端口支持的命令槽数量
+    bool ncq;                         // 控制器是否支持本地命令队列
+    ahci_port_t *ports[AHCI_PORT_NR]; // 连接了磁盘的端口
+} ahci_ctrl_t;
+
+#endif
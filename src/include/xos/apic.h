@@ -0,0 +1,96 @@
+#ifndef XOS_APIC_H
+#define XOS_APIC_H
+
+#include "./types.h"
+
+#define LAPIC_DEFAULT_BASE 0xFEE00000  // local APIC 默认物理地址
+#define IOAPIC_DEFAULT_BASE 0xFEC00000 // IOAPIC 默认物理地址
+
+// local APIC 寄存器偏移
+#define LAPIC_ID 0x020         // 编号
+#define LAPIC_VERSION 0x030    // 版本
+#define LAPIC_TPR 0x080        // 任务优先级
+#define LAPIC_EOI 0x0B0        // 中断结束
+#define LAPIC_SVR 0x0F0        // 伪中断向量
+#define LAPIC_ESR 0x280        // 错误状态
+#define LAPIC_ICR_LOW 0x300    // 中断命令低 32 位
+#define LAPIC_ICR_HIGH 0x310   // 中断命令高 32 位
+#define LAPIC_LVT_TIMER 0x320  // 定时器本地向量
+#define LAPIC_LVT_LINT0 0x350  // LINT0 本地向量
+#define LAPIC_LVT_LINT1 0x360  // LINT1 本地向量
+#define LAPIC_LVT_ERROR 0x370  // 错误本地向量
+#define LAPIC_TIMER_ICR 0x380  // 定时器初始计数
+#define LAPIC_TIMER_CCR 0x390  // 定时器当前计数
+#define LAPIC_TIMER_DCR 0x3E0  // 定时器分频
+
+#define LAPIC_SVR_ENABLE (1 << 8)     // 软件启用 local APIC
+#define LAPIC_LVT_MASKED (1 << 16)    // 屏蔽本地中断
+#define LAPIC_TIMER_PERIODIC (1 << 17) // 定时器周期模式
+#define LAPIC_TIMER_DIV16 0x3          // 定时器 16 分频
+
+// 中断命令寄存器
+#define LAPIC_ICR_FIXED (0 << 8)    // 固定向量
+#define LAPIC_ICR_NMI (4 << 8)      // 不可屏蔽中断
+#define LAPIC_ICR_INIT (5 << 8)     // INIT
+#define LAPIC_ICR_STARTUP (6 << 8)  // STARTUP
+#define LAPIC_ICR_EXTINT (7 << 8)   // 外部中断，用于 8259 虚拟线模式
+#define LAPIC_ICR_PENDING (1 << 12) // 发送中
+#define LAPIC_ICR_ASSERT (1 << 14)  // 电平有效
+#define LAPIC_ICR_LEVEL (1 << 15)   // 电平触发
+
+// IOAPIC 寄存器
+#define IOAPIC_REGSEL 0x00  // 寄存器选择
+#define IOAPIC_WINDOW 0x10  // 寄存器数据窗口
+#define IOAPIC_REG_ID 0x00  // 编号
+#define IOAPIC_REG_VER 0x01 // 版本，16 ~ 23 位为最大重定向表项
+#define IOAPIC_REG_TABLE 0x10 // 重定向表起始，每项占两个寄存器
+
+#define IOAPIC_ACTIVE_LOW (1 << 13) // 低电平有效
+#define IOAPIC_LEVEL (1 << 15)      // 电平触发
+#define IOAPIC_MASKED (1 << 16)     // 屏蔽重定向表项
+
+// 消息信号中断地址，目的处理器编号位于 12 ~ 19 位
+#define MSI_ADDRESS(apic_id) (LAPIC_DEFAULT_BASE | ((apic_id) << 12))
+
+// local APIC 中断向量，位于 8259 的 16 个向量之后
+#define LAPIC_RESCHED_VECTOR 0x30  // 重新调度处理器间中断
+#define LAPIC_TIMER_VECTOR 0x31    // local APIC 定时器
+#define MSI_VECTOR_BASE 0x32       // 消息信号中断向量起始
+#define MSI_VECTOR_END 0x3E        // 消息信号中断向量结束
+#define LAPIC_ERROR_VECTOR 0x3E    // local APIC 错误
+#define LAPIC_SPURIOUS_VECTOR 0x3F // 伪中断，低 4 位必须全为 1
+
+// 使用 IOAPIC 时，启动处理器以 local APIC 定时器代替 PIT 产生时钟中断
+#define LAPIC_CLOCK true
+
+extern u32 lapic_base;  // local APIC 映射地址，0 表示不可用
+extern u32 ioapic_base; // IOAPIC 映射地址，0 表示不可用
+
+u32 lapic_read(u32 reg);
+void lapic_write(u32 reg, u32 value);
+
+// 初始化当前处理器的 local APIC
+void lapic_init(bool bsp);
+// 当前处理器的 local APIC 编号
+u32 lapic_id();
+// 通知 local APIC 中断处理结束
+void lapic_eoi();
+
+// 向 apic_id 处理器发送处理器间中断
+void lapic_send_ipi(u32 apic_id, u32 icr);
+// 以 local APIC 定时器作为当前处理器的时钟中断
+void lapic_timer_start();
+
+// 分配消息信号中断向量，用尽返回 0
+u32 msi_alloc_vector();
+
+// 屏蔽 IOAPIC 的所有重定向表项
+void ioapic_init();
+// 设置 ISA 中断 irq 连接的 IOAPIC 引脚，flags 为 MP 表中的极性和触发方式
+void ioapic_set_irq(u32 irq, u32 pin, u16 flags);
+// 将 irq 重定向到启动处理器的 vector 向量
+void ioapic_route(u32 irq, u32 vector, bool masked);
+// 屏蔽或启用 irq 的重定向表项
+void ioapic_mask(u32 irq, bool masked);
+
+#endif
@@ -5,9 +5,17 @@
 #include "./list.h"
 #include "./mutex.h"
 
-#define HASH_COUNT 31      // 应该是个素数
+#define HASH_INIT_BITS 5   // 哈希表初始为 32 个桶
+#define HASH_LOAD_FACTOR 2 // 平均每个桶的缓冲超过这个数量时哈希表扩大一倍
 #define MAX_BUF_COUNT 4096 // 最大缓冲数量
 
+#define BUFFER_FLUSH_INTERVAL 500   // 回写线程的唤醒间隔，毫秒
+#define BUFFER_DIRTY_EXPIRE 3000    // 脏缓冲超过这个时间必须回写，毫秒
+#define BUFFER_DIRTY_RATIO 40       // 脏缓冲超过这个百分比时立即唤醒回写线程
+#define BUFFER_DIRTY_BACKGROUND 10  // 回写线程把脏缓冲降到这个百分比以下
+#define BUFFER_CLUSTER_SIZE 0x10000 // 相邻块合并成一次请求的最大字节数
+#define BUFFER_PREFETCH_NR 64       // 等待预读的请求的最大数量，超过时丢弃新的预读
+
 typedef struct bdesc_t
 {
     u32 count; // 缓存数量
@@ -16,7 +24,14 @@ typedef struct bdesc_t
     list_t free_list;              // 已经申请未使用的块
     list_t idle_list;              // 缓存链表，被释放的块
     list_t wait_list;              // 等待进程链表
-    list_t hash_table[HASH_COUNT]; // 缓存哈希表
+    list_t dirty_list;  // 脏缓冲链表，按变脏的先后排列
+    u32 dirty;          // 脏缓冲数量
+    list_t *hash_table; // 缓存哈希表，按 (dev, block) 散列
+    u32 hash_bits;      // 哈希表大小为 1 << hash_bits
+
+    u32 hits;      // 在缓存中找到
+    u32 misses;    // 不在缓存中
+    u32 evictions; // 回收闲置缓冲中的有效数据
 } bdesc_t;
 
 typedef struct buffer_t
@@ -27,15 +42,26 @@ typedef struct buffer_t
     idx_t block;       // 块号
     int count;         // 引用计数
     list_node_t hnode; // 哈希表拉链节点
-    list_node_t rnode; // 缓冲节点
+    list_node_t rnode; // 空闲或闲置链表节点，闲置链表头部为最近释放的缓冲
+    list_node_t dnode; // 脏缓冲链表节点
+    u32 dirtied;       // 变脏时的时间片
     lock_t lock;       // 锁
     bool dirty;        // 是否与磁盘不一致
     bool valid;        // 是否有效
+    bool hashed;       // 是否在哈希表中
+    bool idle;         // 是否在闲置链表中
+    bool mapped;       // 数据直接指向内存中的设备，不占用缓存页
 } buffer_t;
 
 buffer_t *bread(dev_t dev, idx_t block, size_t size);
+buffer_t *bread_cluster(dev_t dev, idx_t block, u32 count, size_t size); // 同时读入之后连续的 count - 1 块
+buffer_t *bget(dev_t dev, idx_t block, size_t size); // 不读取磁盘，返回有效的缓冲，调用者将覆盖整块
 err_t bwrite(buffer_t *buf);
 err_t brelse(buffer_t *buf);
-err_t bdirty(buffer_t *buf, bool dirty);
+err_t bdirty(buffer_t *buf, bool dirty); // 修改缓冲之后必须调用，由回写线程延迟写入
+err_t bsync(dev_t dev);                  // 写入设备 dev 的所有脏缓冲，dev 为 EOF 时写入所有设备
+err_t bprefetch(dev_t dev, idx_t block, u32 count, size_t size); // 由预读线程异步读入缓存，不等待完成
+
+void buffer_stat(); // 输出各种大小缓存的数量和命中统计
 
 #endif
\ No newline at end of file
@@ -105,4 +105,12 @@ typedef struct cpu_version_t
 
 void cpu_version(cpu_version_t *ver);
 
+// 快速系统调用相关的模型特定寄存器
+#define MSR_SYSENTER_CS 0x174
+#define MSR_SYSENTER_ESP 0x175
+#define MSR_SYSENTER_EIP 0x176
+
+u64 rdmsr(u32 msr);
+void wrmsr(u32 msr, u64 value);
+
 #endif
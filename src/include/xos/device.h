@@ -3,6 +3,7 @@
 
 #include "./types.h"
 #include "./list.h"
+#include "./uio.h"
 
 #define DEVICE_NR 64 // 设备数量
 #define NAMELEN 16
@@ -30,6 +31,10 @@ enum device_subtype_t
     DEV_RAMDISK,     // 虚拟磁盘
     DEV_FLOPPY,      // 软盘
     DEV_NETIF,       // 网卡
+    DEV_SATA_DISK,   // SATA 磁盘
+    DEV_SATA_PART,   // SATA 磁盘分区
+    DEV_VIRTIO_DISK, // virtio 磁盘
+    DEV_VIRTIO_PART, // virtio 磁盘分区
 };
 
 // 设备控制命令
@@ -46,29 +51,80 @@ enum device_cmd_t
 #define DIRECT_UP 0   // 上楼
 #define DIRECT_DOWN 1 // 下楼
 
+#define REQ_MAX_SECTORS 0xff  // 合并后的请求最多的扇区数，驱动的扇区数量为 u8
+#define REQ_QUEUE_DEPTH 32    // 设备队列中最多等待的请求数量，超过时提交者阻塞
+#define REQ_READ_EXPIRE 500   // deadline 调度中读请求的期限，毫秒
+#define REQ_WRITE_EXPIRE 5000 // deadline 调度中写请求的期限，毫秒
+
+struct bio_t;
+struct device_t;
+
+// 块读写完成回调，在设备的请求线程中执行，ret 为读写结果
+typedef void (*bio_end_t)(struct bio_t *bio, err_t ret);
+
+// 一段连续扇区的读写，合并之后一个请求包含多段
+typedef struct bio_t
+{
+    u8 *buf;            // 缓冲区
+    idx_t idx;          // 扇区位置，提交时转换为磁盘上的位置
+    u32 count;          // 扇区数量
+    bio_end_t end;      // 完成回调
+    void *private;      // 回调使用的数据
+    struct bio_t *next; // 同一请求中的下一段
+} bio_t;
+
 // 块设备请求
 typedef struct request_t
 {
-    dev_t dev;           // 设备号
-    u32 type;            // 请求类型
-    u32 idx;             // 扇区位置
-    u32 count;           // 扇区数量
-    int flags;           // 特殊标志
-    u8 *buf;             // 缓冲区
-    struct task_t *task; // 请求进程
-    list_node_t node;    // 列表节点
+    dev_t dev;        // 设备号
+    u32 type;         // 请求类型
+    u32 idx;          // 扇区位置
+    u32 count;        // 扇区数量
+    int flags;        // 特殊标志
+    bio_t *bio;       // 第一段
+    bio_t *biotail;   // 最后一段
+    u32 deadline;     // 期限，时间片
+    err_t ret;        // 异步执行的结果
+    list_node_t node; // 按扇区排序的链表结点，完成后为完成链表结点
+    list_node_t fifo; // 按提交顺序的链表结点
 } request_t;
 
+// 电梯调度算法
+typedef struct elevator_t
+{
+    char *name; // 算法名称
+    // 请求加入队列
+    void (*add)(struct device_t *device, request_t *req);
+    // 取出下一个执行的请求，队列为空时返回 NULL
+    request_t *(*next)(struct device_t *device);
+} elevator_t;
+
+struct poll_table_t;
+struct task_t;
+
+// 内存中的块设备返回从 idx 开始 count 个扇区的地址，不支持时返回 NULL
+typedef void *(*device_mmap_t)(void *dev, idx_t idx, size_t count);
+
 typedef struct device_t
 {
-    char name[NAMELEN];  // 设备名
-    int type;            // 设备类型
-    int subtype;         // 设备子类型
-    dev_t dev;           // 设备号
-    dev_t parent;        // 父设备号
-    void *ptr;           // 设备指针
-    list_t request_list; // 块设备请求链表
-    bool direct;         // 磁盘寻道方向
+    char name[NAMELEN];    // 设备名
+    int type;              // 设备类型
+    int subtype;           // 设备子类型
+    dev_t dev;             // 设备号
+    dev_t parent;          // 父设备号
+    void *ptr;             // 设备指针
+    list_t request_list;   // 块设备请求链表，按扇区排序
+    list_t fifo_list[2];   // 读写请求按提交顺序的链表
+    bool direct;           // 磁盘寻道方向
+    idx_t head;            // 最后执行的请求结束的扇区
+    elevator_t *elevator;  // 电梯调度算法
+    u32 nr_requests;       // 队列中的请求数量
+    u32 depth;             // 队列深度
+    list_t wait_list;      // 等待队列空位的任务
+    struct task_t *worker; // 执行请求的内核线程
+    u32 slots;             // 驱动可以同时执行的请求数量
+    u32 inflight;          // 已经交给驱动还没有完成的请求数量
+    list_t done_list;      // 驱动已经完成等待回调的请求
 
     // 设备控制
     int (*ioctl)(void *dev, int cmd, void *args, int flags);
@@ -76,6 +132,19 @@ typedef struct device_t
     int (*read)(void *dev, void *buf, size_t count, idx_t idx, int flags);
     // 写设备
     int (*write)(void *dev, void *buf, size_t count, idx_t idx, int flags);
+    // 就绪事件，为空时视为总是可读写
+    int (*poll)(void *dev, struct poll_table_t *pt);
+    // 分散聚集读写，iov 中的缓冲区依次对应从 idx 开始的连续扇区，
+    // 为空或返回 -ENOSYS、-EINVAL 时合并的请求经过连续的内存读写
+    int (*sgio)(void *dev, iovec_t *iov, int iovcnt, idx_t idx, u32 type);
+    // 异步执行请求，请求中每一段对应一个缓冲区，完成时由驱动调用 device_complete，
+    // 不为空时请求线程最多同时交给驱动 slots 个请求
+    err_t (*queue)(void *dev, request_t *req);
+    // 交给驱动一批请求之后调用，驱动可以在这里一次通知硬件
+    void (*kick)(void *dev);
+    // 内存中的块设备返回从 idx 开始 count 个扇区的地址，缓冲直接指向这里不再复制，
+    // 为空或返回 NULL 时经过请求读写
+    device_mmap_t mmap;
 } device_t;
 
 // 安装设备
@@ -99,7 +168,25 @@ int device_read(dev_t dev, void *buf, size_t count, idx_t idx, int flags);
 // 写设备
 int device_write(dev_t dev, void *buf, size_t count, idx_t idx, int flags);
 
-// 块设备请求
+// 查询字符设备就绪事件
+int device_poll(dev_t dev, struct poll_table_t *pt);
+
+// 获取内存中的块设备从 idx 开始 count 个扇区的地址，不支持时返回 NULL
+void *device_mmap(dev_t dev, idx_t idx, size_t count);
+
+// 块设备请求，等待完成
 err_t device_request(dev_t dev, void *buf, u8 count, idx_t idx, int flags, u32 type);
 
+// 异步提交块设备请求，完成时调用 bio->end，与队列中相邻的请求合并
+err_t device_submit(dev_t dev, bio_t *bio, int flags, u32 type);
+
+// 驱动完成异步请求，可以在中断处理函数中调用，回调在请求线程中执行
+void device_complete(request_t *req, err_t ret);
+
+// 设置块设备的电梯调度算法，name 为 "scan" 或 "deadline"
+err_t device_elevator(dev_t dev, char *name);
+
+// 设置块设备的队列深度
+err_t device_queue_depth(dev_t dev, u32 depth);
+
 #endif
\ No newline at end of file
@@ -67,6 +67,8 @@ enum
     ERESET,    // 连接重置
     ECHKSUM,   // 校验和错误
 
+    EINPROGRESS = 115, // 操作正在进行
+
     // 错误数量，应该在枚举的最后
     ENUM,
 };
@@ -40,5 +40,6 @@ typedef struct fpu_t
 bool fpu_check();
 void fpu_disable(task_t *task);
 void fpu_enable(task_t *task);
+void fpu_cpu_init();
 
 #endif
\ No newline at end of file
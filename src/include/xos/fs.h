@@ -4,6 +4,7 @@
 #include "./types.h"
 #include "./list.h"
 #include "./stat.h"
+#include "./uio.h"
 
 #define MAXNAMELEN 64
 
@@ -25,6 +26,22 @@ enum file_flag
     O_NONBLOCK = 04000, // 非阻塞方式打开和操作文件
 };
 
+// fcntl F_SETFL 可以修改的文件标记
+#define O_SETFL_MASK (O_APPEND | O_NONBLOCK)
+
+// fcntl 命令
+enum
+{
+    F_GETFL = 3,         // 获取文件标记
+    F_SETFL = 4,         // 设置文件标记
+    F_SETPIPE_SZ = 1031, // 设置管道容量，字节
+    F_GETPIPE_SZ = 1032, // 获取管道容量，字节
+};
+
+// ioctl 设置非阻塞方式，参数为 int 指针，非零为非阻塞，
+// 文件层转给 inode 时参数直接为是否非阻塞
+#define FIONBIO 0x5421
+
 enum
 {
     FS_TYPE_NONE = 0,
@@ -32,6 +49,8 @@ enum
     FS_TYPE_SOCKET,
     FS_TYPE_MINIX,
     FS_TYPE_ISO9660,
+    FS_TYPE_IO_URING,
+    FS_TYPE_EPOLL,
     FS_TYPE_NUM,
 };
 
@@ -95,12 +114,26 @@ typedef struct dentry_t
     char name[MAXNAMELEN];
 } dentry_t;
 
+#define READAHEAD_MIN 4  // 顺序读取开始时的预读窗口，块数
+#define READAHEAD_MAX 32 // 最大预读窗口，块数
+
+// 文件的预读状态，识别顺序读取
+typedef struct readahead_t
+{
+    idx_t prev; // 上次读取的最后一块
+    idx_t end;  // 已经预读到的位置
+    idx_t mark; // 读到这一块时预读下一个窗口
+    u32 size;   // 当前预读窗口，为 0 表示不在顺序读取
+} readahead_t;
+
 typedef struct file_t
 {
     inode_t *inode; // 文件 inode
     u32 count;      // 引用计数
     off_t offset;   // 文件偏移
     int flags;      // 文件标记
+    u32 epolls;     // 关注该文件的 epoll 项数量
+    readahead_t ra; // 预读状态
 } file_t;
 
 typedef dentry_t dirent_t;
@@ -112,6 +145,13 @@ typedef enum whence_t
     SEEK_END      // 结束位置偏移
 } whence_t;
 
+struct poll_table_t;
+struct buffer_t;
+
+// 文件数据的接收者，ptr 指向文件块缓冲 buf 中的数据，需要在返回后继续使用时增加 buf 的引用，
+// 返回接收的字节数，少于 len 或小于 0 时停止读取
+typedef int (*read_actor_t)(void *target, struct buffer_t *buf, char *ptr, int len);
+
 typedef struct fs_op_t
 {
     int (*mkfs)(dev_t dev, int args);
@@ -136,8 +176,26 @@ typedef struct fs_op_t
     int (*unlink)(inode_t *dir, char *name);
     int (*mknod)(inode_t *dir, char *name, int mode, int dev);
     int (*readdir)(inode_t *inode, dentry_t *entry, size_t count, off_t offset);
+
+    // 返回就绪事件，pt 不为空时同时登记等待，未实现时视为总是可读写
+    int (*poll)(inode_t *inode, struct poll_table_t *pt);
+
+    // 从 offset 处把最多 len 个字节所在的文件块缓冲依次交给 actor，不复制数据，
+    // 返回 actor 接收的总字节数
+    int (*sendfile)(inode_t *inode, int len, off_t offset, read_actor_t actor, void *target);
+
+    // 在 offset 处读写 iov 中共 len 个字节，iov 会被消耗，
+    // 返回 -ENOSYS 时由调用者依次读写每个缓冲区
+    int (*readv)(inode_t *inode, iovec_t *iov, int iovlen, int len, off_t offset);
+    int (*writev)(inode_t *inode, iovec_t *iov, int iovlen, int len, off_t offset);
+
+    // 读取 offset 处的 len 个字节之前调用，按 ra 记录的访问模式异步预读文件块
+    int (*readahead)(inode_t *inode, readahead_t *ra, off_t offset, int len);
 } fs_op_t;
 
+// 读取文件之前预读，文件系统不支持预读时什么也不做
+void file_readahead(inode_t *inode, readahead_t *ra, off_t offset, int len);
+
 err_t fd_check(fd_t fd, file_t **file);
 fd_t fd_get(file_t **file);
 err_t fd_put(fd_t fd);
@@ -7,10 +7,18 @@
 
 #define KERNEL_CODE_IDX 1
 #define KERNEL_DATA_IDX 2
-#define KERNEL_TSS_IDX 3
 
-#define USER_CODE_IDX 4
-#define USER_DATA_IDX 5
+// sysexit 要求用户代码段和数据段紧跟内核代码段，
+// 分别为 SYSENTER_CS + 16 和 SYSENTER_CS + 24
+#define USER_CODE_IDX 3
+#define USER_DATA_IDX 4
+
+#define KERNEL_TSS_IDX 5
+
+#define AP_TSS_IDX 6 // 应用处理器任务状态段起始，启动处理器使用 KERNEL_TSS_IDX
+
+// 处理器 cpu 的任务状态段描述符
+#define TSS_IDX(cpu) ((cpu) ? AP_TSS_IDX + (cpu) - 1 : KERNEL_TSS_IDX)
 
 #define KERNEL_CODE_SELECTOR (KERNEL_CODE_IDX << 3)
 #define KERNEL_DATA_SELECTOR (KERNEL_DATA_IDX << 3)
@@ -14,6 +14,8 @@
 #define IDE_TYPE_PIO 0  // Programming Input Output
 #define IDE_TYPE_UDMA 1 // Ultra DMA
 
+#define IDE_PRD_NR 64 // PRD 表的项数，每项最多 64K 且不跨 64K 边界
+
 typedef struct part_entry_t
 {
     u8 bootable;             // 引导标志
@@ -44,10 +46,11 @@ typedef struct ide_part_t
     u32 count;               // 分区占用的扇区数
 } ide_part_t;
 
+// Physical Region Descriptor，描述一段物理内存
 typedef struct ide_prd_t
 {
-    u32 addr;
-    u32 len;
+    u32 addr; // 物理地址
+    u32 len;  // 低 16 位为字节数，0 表示 64K，最高位标记最后一项
 } ide_prd_t;
 
 // IDE 磁盘
@@ -63,6 +66,8 @@ typedef struct ide_disk_t
     u32 sectors;                   // 扇区数
     u32 interface;                 // 磁盘类型
     u32 sector_size;               // 扇区大小
+    u8 multiple;                   // READ/WRITE MULTIPLE 每次中断传输的扇区数，0 表示不使用
+    bool dword_io;                 // 数据寄存器支持 32 位传输
     ide_part_t parts[IDE_PART_NR]; // 硬盘分区
 } ide_disk_t;
 
@@ -78,7 +83,7 @@ typedef struct ide_ctrl_t
     ide_disk_t *active;            // 当前选择的磁盘
     u8 control;                    // 控制字节
     struct task_t *waiter;         // 等待控制器的进程
-    ide_prd_t prd;                 // Physical Region Descriptor
+    ide_prd_t *prdt;               // PRD 表，占一页，不会跨 64K 边界
 } ide_ctrl_t;
 
 int ide_pio_read(ide_disk_t *disk, void *buf, u8 count, idx_t lba);
@@ -62,13 +62,19 @@ typedef struct gate_t
 
 typedef void *handler_t; // 中断处理函数
 
+// 向中断控制器发送中断结束信号
 void send_eoi(int vector);
 
+// 改用 IOAPIC 分发外部中断
+void interrupt_apic_init();
+
 void set_exception_handler(u32 intr, handler_t handler);
 
 // 设置中断处理函数
 void set_interrupt_handler(u32 irq, handler_t handler);
 void set_interrupt_mask(u32 irq, bool enable);
+// 设置 local APIC 中断向量的处理函数
+void set_vector_handler(u32 vector, handler_t handler);
 
 bool interrupt_disable();             // 清除 IF 位，返回设置之前的值
 bool get_interrupt_state();           // 获得 IF 位
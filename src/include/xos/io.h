@@ -11,4 +11,9 @@ extern void outb(u16 port, u8 value);  // 输出一个字节
 extern void outw(u16 port, u16 value); // 输出一个字
 extern void outl(u16 port, u32 value); // 输出一个双字
 
+extern void insw(u16 port, void *buf, u32 count);  // 连续输入 count 个字
+extern void outsw(u16 port, void *buf, u32 count); // 连续输出 count 个字
+extern void insl(u16 port, void *buf, u32 count);  // 连续输入 count 个双字
+extern void outsl(u16 port, void *buf, u32 count); // 连续输出 count 个双字
+
 #endif
\ No newline at end of file
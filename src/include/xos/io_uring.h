@@ -0,0 +1,75 @@
+#ifndef XOS_IO_URING_H
+#define XOS_IO_URING_H
+
+#include "./types.h"
+
+#define IO_URING_ENTRIES_MAX 256 // 提交队列最大长度，完成队列为其两倍
+
+// 请求操作码
+enum
+{
+    IORING_OP_NOP,     // 空操作，立即完成
+    IORING_OP_READ,    // 读文件 / 管道 / 套接字
+    IORING_OP_WRITE,   // 写文件 / 管道 / 套接字
+    IORING_OP_SENDMSG, // 发送消息，addr 为 msghdr_t
+    IORING_OP_RECVMSG, // 接收消息，addr 为 msghdr_t
+    IORING_OP_ACCEPT,  // 接受连接，addr 为 sockaddr_t，len 为地址长度指针
+    IORING_OP_TIMEOUT, // 超时，off 为毫秒数，到期返回 -ETIME
+    IORING_OP_LAST,
+};
+
+// 读写使用并更新文件当前偏移
+#define IORING_OFF_CURRENT ((u32)-1)
+
+// io_uring_enter 标志
+enum
+{
+    IORING_ENTER_GETEVENTS = 1, // 等待至少 min_complete 个完成事件
+};
+
+// 提交队列项
+typedef struct io_uring_sqe_t
+{
+    u8 opcode;     // 操作码
+    u8 flags;      // 请求标志，保留
+    u16 ioprio;    // 优先级，保留
+    int fd;        // 文件描述符
+    u32 off;       // 文件偏移或超时毫秒数
+    u32 addr;      // 缓冲区或参数地址
+    u32 len;       // 缓冲区长度或参数
+    u32 op_flags;  // 操作标志，如 sendmsg / recvmsg 的 flags
+    u64 user_data; // 原样返回到完成队列项
+} io_uring_sqe_t;
+
+// 完成队列项
+typedef struct io_uring_cqe_t
+{
+    u64 user_data; // 对应提交队列项的 user_data
+    int res;       // 操作结果，与对应系统调用的返回值相同
+    u32 flags;     // 保留
+} io_uring_cqe_t;
+
+// 用户态和内核共享的队列头，提交队列由用户态生产、内核消费，
+// 完成队列由内核生产、用户态消费，下标自由增长，使用 mask 取模；
+// 用户态可以改写这一页，内核只读取 sq_tail 和 cq_head，其余字段只写不读
+typedef struct io_rings_t
+{
+    volatile u32 sq_head;     // 内核已取走的提交项
+    volatile u32 sq_tail;     // 用户态已提交的提交项
+    volatile u32 cq_head;     // 用户态已处理的完成项
+    volatile u32 cq_tail;     // 内核已写入的完成项
+    u32 sq_mask;              // 提交队列长度减一，只供用户态读取
+    u32 cq_mask;              // 完成队列长度减一，只供用户态读取
+    volatile u32 cq_overflow; // 完成队列满而丢弃的完成项数量
+} io_rings_t;
+
+typedef struct io_uring_params_t
+{
+    u32 sq_entries;        // 提交队列长度
+    u32 cq_entries;        // 完成队列长度
+    io_rings_t *rings;     // 队列头
+    io_uring_sqe_t *sqes;  // 提交队列
+    io_uring_cqe_t *cqes;  // 完成队列
+} io_uring_params_t;
+
+#endif
@@ -97,4 +97,7 @@ u32 get_paddr(u32 vaddr);
 // 检测内存是否可以访问
 bool memory_access(void *vaddr, int size, bool write, bool user);
 
+// 缓冲区能否直接交给设备 DMA，只有一一映射的内核内存可以
+bool dma_capable(void *buf, size_t size);
+
 #endif
\ No newline at end of file
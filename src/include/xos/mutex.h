@@ -6,14 +6,19 @@
 
 typedef struct mutex_t
 {
-    bool value;     // 信号量
-    list_t waiters; // 等待队列
+    bool value;           // 信号量
+    list_t waiters;       // 等待队列
+    struct task_t *owner; // 持有者
+    list_node_t node;     // 持有者互斥量链表结点
 } mutex_t;
 
 void mutex_init(mutex_t *mutex);   // 初始化互斥量
 void mutex_lock(mutex_t *mutex);   // 尝试持有互斥量
 void mutex_unlock(mutex_t *mutex); // 释放互斥量
 
+// 重新计算任务继承的优先级，并沿阻塞链传递
+void mutex_pi_update(struct task_t *task);
+
 typedef struct lock_t
 {
     struct task_t *holder; // 持有者
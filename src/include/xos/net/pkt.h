@@ -4,6 +4,7 @@
 #include "./types.h"
 #include "./pbuf.h"
 #include "../list.h"
+#include "../wait.h"
 
 typedef struct pkt_pcb_t
 {
@@ -17,6 +18,7 @@ typedef struct pkt_pcb_t
 
     list_t rx_pbuf_list;
     struct task_t *rx_waiter;
+    wait_queue_t wait;
 } pkt_pcb_t;
 
 err_t pkt_input(netif_t *netif, pbuf_t *pbuf);
@@ -4,6 +4,7 @@
 #include "./types.h"
 #include "./pbuf.h"
 #include "../list.h"
+#include "../wait.h"
 
 #define RAW_TTL 255
 
@@ -16,6 +17,7 @@ typedef struct raw_pcb_t
 
     list_t rx_pbuf_list;
     struct task_t *rx_waiter;
+    wait_queue_t wait;
 } raw_pcb_t;
 
 err_t raw_input(netif_t *netif, pbuf_t *pbuf);
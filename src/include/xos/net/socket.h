@@ -3,6 +3,7 @@
 
 
 #include "../stdlib.h"
+#include "../uio.h"
 #include "./types.h"
 #include "./pkt.h"
 #include "./raw.h"
@@ -32,6 +33,19 @@ enum
     PROTO_UDP = 17,
 };
 
+// socket / accept4 类型标志
+enum
+{
+    SOCK_NONBLOCK = 04000, // 非阻塞方式，与 O_NONBLOCK 相同
+};
+
+// 收发标志
+enum
+{
+    MSG_DONTWAIT = 0x40, // 本次调用不阻塞
+    MSG_MORE = 0x8000,   // 后面还有数据，暂不推送
+};
+
 typedef enum socktype_t
 {
     SOCK_TYPE_NONE = 0,
@@ -80,12 +94,6 @@ typedef struct sockaddr_ll_t
     u8 zero[8];
 } sockaddr_ll_t;
 
-typedef struct iovec_t
-{
-    size_t size;
-    void *base;
-} iovec_t;
-
 typedef struct msghdr_t
 {
     sockaddr_t *name;
@@ -97,6 +105,7 @@ typedef struct msghdr_t
 typedef struct socket_t
 {
     socktype_t type; // socket 类型
+    int flags;       // SOCK_NONBLOCK
     int sndtimeo;    // 发送超时
     int rcvtimeo;    // 接收超时
     union
@@ -108,6 +117,8 @@ typedef struct socket_t
     };
 } socket_t;
 
+struct poll_table_t;
+
 typedef struct socket_op_t
 {
     int (*socket)(socket_t *s, int domain, int type, int protocol);
@@ -125,15 +136,17 @@ typedef struct socket_op_t
 
     int (*recvmsg)(socket_t *s, msghdr_t *msg, u32 flags);
     int (*sendmsg)(socket_t *s, msghdr_t *msg, u32 flags);
+
+    int (*poll)(socket_t *s, struct poll_table_t *pt);
+
+    // 直接发送内核缓冲区中的数据，供 sendfile 使用，未实现时通过 sendmsg 发送
+    int (*sendpage)(socket_t *s, void *data, size_t size, u32 flags);
 } socket_op_t;
 
 void socket_register_op(socktype_t type, socket_op_t *op);
 socket_t *socket_create();
 
-err_t iovec_check(iovec_t *iov, int iovlen, int write);
-size_t iovec_size(iovec_t *iov, int iovlen);
-iovec_t *iovec_dup(iovec_t *iov, int iovlen);
-int iovec_read(iovec_t *iov, int iovlen, char *buf, size_t count);
-int iovec_write(iovec_t *iov, int iovlen, char *buf, size_t count);
+// 发送内核缓冲区中的数据，协议没有 sendpage 时通过 sendmsg 复制发送
+int socket_sendpage(socket_t *s, void *data, size_t size, u32 flags);
 
 #endif
@@ -3,6 +3,7 @@
 
 #include "./types.h"
 #include "../list.h"
+#include "../wait.h"
 
 #define TCP_MSS (1500 - 40)  // 默认 MSS 大小
 #define TCP_WINDOW 8192      // 默认窗口大小
@@ -181,6 +182,7 @@ typedef struct tcp_pcb_t
     struct task_t *ac_waiter; // 接受等待进程
     struct task_t *tx_waiter; // 写等待进程
     struct task_t *rx_waiter; // 读等待进程
+    wait_queue_t wait;        // 就绪等待队列
 } tcp_pcb_t;
 
 // 获取初始序列号
@@ -219,6 +221,9 @@ err_t tcp_output(tcp_pcb_t *pcb);
 // TCP 入队列
 err_t tcp_enqueue(tcp_pcb_t *pcb, void *data, size_t size, int flags);
 
+// 将 nagle 缓存中的数据放入发送队列
+void tcp_push(tcp_pcb_t *pcb);
+
 // TCP 重传
 err_t tcp_rexmit(tcp_pcb_t *pcb);
 
@@ -3,6 +3,7 @@
 
 #include "./types.h"
 #include "../list.h"
+#include "../wait.h"
 
 enum
 {
@@ -35,6 +36,7 @@ typedef struct udp_pcb_t
 
     list_t rx_pbuf_list;      // 接收缓冲队列
     struct task_t *rx_waiter; // 等待进程
+    wait_queue_t wait;        // 就绪等待队列
 } udp_pcb_t;
 
 int udp_input(netif_t *netif, pbuf_t *pbuf);
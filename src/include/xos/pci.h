@@ -15,12 +15,14 @@
 #define PCI_CONF_BASE_ADDR3 0x1C
 #define PCI_CONF_BASE_ADDR4 0x20
 #define PCI_CONF_BASE_ADDR5 0x24
+#define PCI_CONF_CAPABILITY 0x34 // 能力链表起始偏移
 #define PCI_CONF_INTERRUPT 0x3C
 
 #define PCI_CLASS_MASK 0xFF0000
 #define PCI_SUBCLASS_MASK 0xFFFF00
 
 #define PCI_CLASS_STORAGE_IDE 0x010100
+#define PCI_CLASS_STORAGE_AHCI 0x010601
 
 #define PCI_BAR_TYPE_MEM 0
 #define PCI_BAR_TYPE_IO 1
@@ -38,6 +40,7 @@
 #define PCI_COMMAND_WAIT 0x0080        // Enable address/data stepping
 #define PCI_COMMAND_SERR 0x0100        // Enable SERR/
 #define PCI_COMMAND_FAST_BACK 0x0200   // Enable back-to-back writes
+#define PCI_COMMAND_INTX_DISABLE 0x0400 // INTx Emulation Disable
 
 #define PCI_STATUS_CAP_LIST 0x010    // Support Capability List
 #define PCI_STATUS_66MHZ 0x020       // Support 66 Mhz PCI 2.1 bus
@@ -49,6 +52,12 @@
 #define PCI_STATUS_DEVSEL_MEDIUM 0x200
 #define PCI_STATUS_DEVSEL_SLOW 0x400
 
+#define PCI_CAP_ID_MSI 0x05 // Message Signalled Interrupts
+
+#define PCI_MSI_FLAGS_ENABLE 0x0001 // MSI feature enabled
+#define PCI_MSI_FLAGS_QSIZE 0x0070  // Message queue size configured
+#define PCI_MSI_FLAGS_64BIT 0x0080  // 64-bit addresses allowed
+
 typedef struct pci_addr_t
 {
     u8 RESERVED : 2; // 最低位
@@ -90,4 +99,9 @@ pci_device_t *pci_find_device(u16 vendorid, u16 deviceid);
 pci_device_t *pci_find_device_by_class(u32 classcode);
 void pci_enable_busmastering(pci_device_t *device);
 
+// 查找设备能力，返回能力结构在配置空间的偏移，0 表示不存在
+u8 pci_find_capability(pci_device_t *device, u8 id);
+// 启用 MSI，中断以 vector 发送到 apic_id 对应的处理器
+err_t pci_enable_msi(pci_device_t *device, u8 vector, u8 apic_id);
+
 #endif
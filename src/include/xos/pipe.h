@@ -0,0 +1,74 @@
+#ifndef XOS_PIPE_H
+#define XOS_PIPE_H
+
+#include "./types.h"
+#include "./fs.h"
+#include "./wait.h"
+
+#define PIPE_DEF_BUFFERS 16 // 默认容量，缓冲数量
+#define PIPE_MAX_BUFFERS 64 // 最大容量，缓冲数量
+
+// splice / tee 标志
+enum
+{
+    SPLICE_F_MOVE = 1,     // 尽量移动而不是复制页
+    SPLICE_F_NONBLOCK = 2, // 管道操作不阻塞
+    SPLICE_F_MORE = 4,     // 后面还有数据
+};
+
+struct pipe_buffer_t;
+
+// 管道缓冲的引用操作
+typedef struct pipe_buf_op_t
+{
+    void (*get)(struct pipe_buffer_t *buf);     // 增加引用，tee 复制缓冲时使用
+    void (*release)(struct pipe_buffer_t *buf); // 释放引用
+} pipe_buf_op_t;
+
+// 管道中的一段数据，引用一页内存或者一个文件块缓冲
+typedef struct pipe_buffer_t
+{
+    char *data;        // 数据起始位置
+    u32 len;           // 数据长度
+    pipe_buf_op_t *op; // 引用操作
+    void *private;     // 页引用或者文件块缓冲
+} pipe_buffer_t;
+
+// 管道描述符，位于 inode->desc，缓冲组成环形队列
+typedef struct pipe_t
+{
+    pipe_buffer_t *bufs; // 缓冲环
+    u32 size;            // 缓冲环容量
+    u32 head;            // 第一个有数据的缓冲
+    u32 nrbufs;          // 有数据的缓冲数量
+    wait_queue_t wait;   // 就绪等待队列
+} pipe_t;
+
+// 第一个有数据的缓冲，管道为空时返回 NULL
+pipe_buffer_t *pipe_buf_first(pipe_t *pipe);
+
+// 在队尾取得一个空闲缓冲，管道已满时返回 NULL
+pipe_buffer_t *pipe_buf_push(pipe_t *pipe);
+
+// 释放第一个缓冲
+void pipe_buf_pop(pipe_t *pipe);
+
+// 用新分配的一页初始化缓冲
+void pipe_buf_alloc(pipe_buffer_t *buf);
+
+// 引用文件块缓冲中的数据初始化缓冲
+void pipe_buf_cache(pipe_buffer_t *buf, struct buffer_t *cache, char *data, u32 len);
+
+// 等待管道有数据，写端关闭时返回 EOF
+int pipe_wait_readable(inode_t *inode, bool nonblock);
+
+// 等待管道有空闲缓冲，读端关闭时返回 -EPIPE
+int pipe_wait_writable(inode_t *inode, bool nonblock);
+
+// 管道有了新数据，唤醒读者
+void pipe_notify_readable(inode_t *inode);
+
+// 管道有了空闲缓冲，唤醒写者
+void pipe_notify_writable(inode_t *inode);
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef XOS_POLL_H
+#define XOS_POLL_H
+
+#include "./types.h"
+#include "./wait.h"
+
+// 就绪事件
+enum
+{
+    POLLIN = 0x0001,   // 可读
+    POLLPRI = 0x0002,  // 有紧急数据可读
+    POLLOUT = 0x0004,  // 可写
+    POLLERR = 0x0008,  // 出错，总是返回
+    POLLHUP = 0x0010,  // 连接挂断，总是返回
+    POLLNVAL = 0x0020, // 文件描述符无效，总是返回
+};
+
+typedef struct pollfd_t
+{
+    fd_t fd;       // 文件描述符，小于 0 时忽略
+    short events;  // 关心的事件
+    short revents; // 返回的就绪事件
+} pollfd_t;
+
+#define FD_SETSIZE 1024 // select 支持的文件描述符数量
+
+typedef struct fd_set
+{
+    u32 bits[FD_SETSIZE / 32];
+} fd_set;
+
+#define FD_ZERO(set) memset((set), 0, sizeof(fd_set))
+#define FD_SET(fd, set) ((set)->bits[(fd) / 32] |= (1 << ((fd) % 32)))
+#define FD_CLR(fd, set) ((set)->bits[(fd) / 32] &= ~(1 << ((fd) % 32)))
+#define FD_ISSET(fd, set) ((set)->bits[(fd) / 32] & (1 << ((fd) % 32)))
+
+typedef struct timeval
+{
+    u32 tv_sec;  // 秒
+    u32 tv_usec; // 微秒
+} timeval;
+
+// epoll_ctl 操作
+enum
+{
+    EPOLL_CTL_ADD = 1, // 加入关注列表
+    EPOLL_CTL_DEL = 2, // 移出关注列表
+    EPOLL_CTL_MOD = 3, // 修改关注的事件
+};
+
+// epoll 事件，低位与 poll 事件相同
+enum
+{
+    EPOLLIN = POLLIN,
+    EPOLLPRI = POLLPRI,
+    EPOLLOUT = POLLOUT,
+    EPOLLERR = POLLERR,
+    EPOLLHUP = POLLHUP,
+};
+
+#define EPOLLONESHOT (1u << 30) // 返回一次后停止关注，直到 EPOLL_CTL_MOD 重新设置
+#define EPOLLET (1u << 31)      // 边沿触发，只在状态变化后返回一次
+
+typedef union epoll_data_t
+{
+    void *ptr;
+    fd_t fd;
+    u64 value;
+} epoll_data_t;
+
+typedef struct epoll_event_t
+{
+    u32 events;        // 关心 / 返回的事件
+    epoll_data_t data; // 用户数据，原样返回
+} _packed epoll_event_t;
+
+// 轮询表，文件的 poll 操作通过 poll_wait 把等待项挂到自己的等待队列上，
+// 为空时只查询就绪状态
+typedef struct poll_table_t
+{
+    void (*queue)(struct poll_table_t *pt, wait_queue_t *wq);
+} poll_table_t;
+
+struct file_t;
+
+// 在等待队列 wq 上登记轮询表
+void poll_wait(poll_table_t *pt, wait_queue_t *wq);
+
+// 查询文件的就绪事件，pt 不为空时同时登记等待
+int file_poll(struct file_t *file, poll_table_t *pt);
+
+// 文件最后一次关闭时移出所有 epoll 关注列表
+void epoll_release(struct file_t *file);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef XOS_RBTREE_H
+#define XOS_RBTREE_H
+
+#include "./types.h"
+
+#define RB_UNLINKED 0 // 结点不在树中，清零的结点即为该状态
+#define RB_RED 1
+#define RB_BLACK 2
+
+// 红黑树结点
+typedef struct rbnode_t
+{
+    struct rbnode_t *parent; // 父结点
+    struct rbnode_t *left;   // 左孩子
+    struct rbnode_t *right;  // 右孩子
+    u32 color;               // 颜色
+} rbnode_t;
+
+// 比较函数，a 排在 b 之前返回 true
+typedef bool (*rbtree_less_t)(rbnode_t *a, rbnode_t *b);
+
+// 红黑树
+typedef struct rbtree_t
+{
+    rbnode_t *root;     // 根结点
+    rbnode_t *leftmost; // 最左结点缓存
+    rbtree_less_t less; // 比较函数
+    u32 count;          // 结点数量
+} rbtree_t;
+
+// 初始化红黑树
+void rbtree_init(rbtree_t *tree, rbtree_less_t less);
+
+// 插入结点，相等的结点插入到右侧
+void rbtree_insert(rbtree_t *tree, rbnode_t *node);
+
+// 删除结点
+void rbtree_remove(rbtree_t *tree, rbnode_t *node);
+
+// 获得最小结点
+rbnode_t *rbtree_first(rbtree_t *tree);
+
+// 获得最大结点
+rbnode_t *rbtree_last(rbtree_t *tree);
+
+// 获得中序后继结点
+rbnode_t *rbtree_next(rbnode_t *node);
+
+// 判断树是否为空
+bool rbtree_empty(rbtree_t *tree);
+
+// 判断结点是否在树中
+bool rbnode_linked(rbnode_t *node);
+
+#endif
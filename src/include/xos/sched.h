@@ -0,0 +1,111 @@
+#ifndef XOS_SCHED_H
+#define XOS_SCHED_H
+
+#include "./types.h"
+#include "./rbtree.h"
+#include "./list.h"
+#include "./spinlock.h"
+
+#define NICE_MIN -20 // 最高优先级
+#define NICE_MAX 19  // 最低优先级
+#define NICE_WIDTH (NICE_MAX - NICE_MIN + 1)
+
+#define NICE_0_LOAD 1024 // nice 为 0 的任务权重
+#define NICE_0_SHIFT 10  // 虚拟时间放大位数，避免小权重时精度损失
+
+#define SCHED_MAX_SLICE 20        // 最长时间片
+#define SCHED_GRANULARITY 2       // 抢占粒度，虚拟时间领先超过该时间片数则抢占
+#define SCHED_WAKEUP_CREDIT 5     // 唤醒任务最多补偿的时间片数
+#define SCHED_BALANCE_INTERVAL 10 // 负载均衡间隔的时间片数
+
+// 调度策略
+enum
+{
+    SCHED_NORMAL = 0, // 普通任务，按虚拟运行时间公平调度
+    SCHED_FIFO = 1,   // 实时任务，先进先出，直到阻塞或让出
+    SCHED_RR = 2,     // 实时任务，同优先级时间片轮转
+};
+
+#define RT_PRIO_MIN 1        // 最低实时优先级
+#define RT_PRIO_MAX 99       // 最高实时优先级
+#define RT_PRIO_NR 100       // 实时优先级数量
+#define RT_PRIO_USER_MAX 49  // 普通用户可设置的最高实时优先级
+#define RT_PRIO_NET 60       // 网络收发线程实时优先级
+
+// 生效优先级，数值越小优先级越高，实时任务在前，普通任务按 nice 排列在后
+#define MAX_RT_PRIO RT_PRIO_NR
+#define MAX_PRIO (MAX_RT_PRIO + NICE_WIDTH)
+#define NICE_TO_PRIO(nice) (MAX_RT_PRIO + (nice) - NICE_MIN)
+#define RT_TO_PRIO(rt_priority) (MAX_RT_PRIO - 1 - (rt_priority))
+
+#define RT_RR_SLICE 10 // SCHED_RR 时间片
+#define RT_PERIOD 100  // 实时任务带宽统计周期
+#define RT_RUNTIME 95  // 每周期实时任务最多运行的时间片，防止实时任务饿死系统
+
+typedef struct sched_param_t
+{
+    int sched_priority; // 实时优先级
+} sched_param_t;
+
+// getpriority / setpriority which 参数
+enum
+{
+    PRIO_PROCESS = 0, // 进程
+    PRIO_PGRP = 1,    // 进程组
+    PRIO_USER = 2,    // 用户
+};
+
+struct task_t;
+struct cpu_t;
+
+// 就绪队列，每个处理器一个
+typedef struct runqueue_t
+{
+    spinlock_t lock;        // 队列锁
+    struct task_t *curr;    // 正在执行的任务
+    u32 balance;            // 上次负载均衡的时间片
+    rbtree_t tree;          // 按虚拟运行时间排序的就绪任务
+    u32 min_vruntime;       // 单调递增的最小虚拟运行时间
+    u32 load;               // 就绪任务权重和
+    struct task_t *idle;    // 空闲任务
+
+    list_t rt_queue[RT_PRIO_NR]; // 实时任务就绪队列
+    u32 rt_bitmap[4];            // 非空实时队列位图
+    u32 rt_nr;                   // 就绪实时任务数量
+    u32 rt_time;                 // 本周期实时任务已运行时间片
+    u32 rt_period;               // 本周期开始的时间片
+    bool rt_throttled;           // 实时任务带宽已耗尽
+} runqueue_t;
+
+void sched_init();
+// 设置处理器的空闲任务
+void sched_set_idle(struct cpu_t *cpu, struct task_t *idle);
+
+// 新建任务加入就绪队列
+void sched_wakeup_new(struct task_t *task);
+// 唤醒阻塞的任务加入就绪队列
+void sched_wakeup(struct task_t *task);
+// 就绪的任务被阻塞，移出就绪队列
+void sched_dequeue(struct task_t *task);
+
+// 任务让出执行权
+void sched_yield(struct task_t *task);
+// 选择下一个执行的任务，当前任务若就绪则放回队列
+struct task_t *sched_pick_next(struct task_t *current);
+// 时钟中断中更新当前任务，返回是否需要调度
+bool sched_tick(struct task_t *current);
+
+// 根据权重计算时间片
+int sched_slice(struct task_t *task);
+// 设置任务 nice 值
+void sched_set_nice(struct task_t *task, int nice);
+// 设置任务调度策略和实时优先级
+err_t sched_set_policy(struct task_t *task, int policy, int priority);
+// 由调度策略、实时优先级和 nice 计算的优先级
+int sched_normal_prio(struct task_t *task);
+// 设置任务生效优先级，用于优先级继承
+void sched_set_prio(struct task_t *task, int prio);
+// 判断任务是否为实时任务
+bool sched_rt_task(struct task_t *task);
+
+#endif
@@ -55,6 +55,20 @@ typedef struct sigaction_t
     void (*restorer)(void); // 恢复函数指针
 } sigaction_t;
 
+// 信号处理函数表，CLONE_SIGHAND 创建的线程共享
+typedef struct sighand_t
+{
+    u32 count;                   // 引用计数
+    sigaction_t actions[MAXSIG]; // 信号处理函数
+} sighand_t;
+
+// 分配默认处理的信号处理函数表
+sighand_t *sighand_alloc();
+// 复制信号处理函数表，用于 fork
+sighand_t *sighand_copy(sighand_t *sighand);
+// 减少引用，最后一个引用释放时回收
+void sighand_put(sighand_t *sighand);
+
 // 获取信号屏蔽码
 int sgetmask(); 
 // 设置信号屏蔽码
@@ -0,0 +1,52 @@
+#ifndef XOS_SMP_H
+#define XOS_SMP_H
+
+#include "./types.h"
+#include "./global.h"
+#include "./sched.h"
+
+#define CPU_NR 8 // 最多支持的处理器数量
+
+#define TRAMPOLINE_ADDR 0x8000 // 应用处理器启动代码地址，必须 4K 对齐且低于 1M
+
+// 每个处理器私有的数据
+typedef struct cpu_t
+{
+    u32 id;         // 逻辑编号，启动处理器为 0
+    u32 apic_id;    // local APIC 编号
+    bool online;    // 是否已启动
+    int lock_depth; // 大内核锁嵌套深度
+    bool in_softirq; // 正在执行软中断
+    bool tlb_flush;  // 进入内核时需要刷新快表
+    tss_t tss;      // 任务状态段
+    runqueue_t rq;  // 就绪队列
+} cpu_t;
+
+extern cpu_t cpus[CPU_NR];
+extern u32 cpu_count;
+
+// 当前处理器
+cpu_t *this_cpu();
+
+// 初始化启动处理器的私有数据，并获得大内核锁
+void percpu_init();
+// 解析 MP 表，初始化 local APIC 和 IOAPIC
+void smp_init();
+// 启动应用处理器
+void smp_boot();
+
+// 中断和系统调用入口获得大内核锁，出口释放
+void kernel_enter();
+void kernel_exit();
+
+// 完全释放大内核锁，返回嵌套深度
+int kernel_unlock();
+// 重新获得大内核锁，恢复嵌套深度
+void kernel_relock(int depth);
+
+// 通知处理器重新调度
+void smp_send_reschedule(cpu_t *cpu);
+// 通知正在使用页目录 pde 的其他处理器刷新快表
+void smp_flush_tlb(u32 pde);
+
+#endif
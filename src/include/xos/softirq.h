@@ -0,0 +1,29 @@
+#ifndef XOS_SOFTIRQ_H
+#define XOS_SOFTIRQ_H
+
+#include "./types.h"
+
+// 软中断，硬件中断处理函数只做必要的应答，其余工作推迟到中断返回前，
+// 开中断执行，执行期间不会被调度，所以不能阻塞
+enum
+{
+    SOFTIRQ_NET_TX, // 网卡发送完成
+    SOFTIRQ_NET_RX, // 网卡接收
+    SOFTIRQ_BLOCK,  // 块设备请求完成
+    SOFTIRQ_NR,
+};
+
+#define SOFTIRQ_RESTART 10 // 中断返回时最多重复处理的次数，之后交给 softirqd
+
+typedef void (*softirq_handler_t)();
+
+// 设置软中断处理函数
+void softirq_open(int nr, softirq_handler_t handler);
+// 触发软中断，可以在中断处理函数中调用
+void softirq_raise(int nr);
+// 执行挂起的软中断
+void do_softirq();
+// 当前处理器是否正在执行软中断
+bool in_softirq();
+
+#endif
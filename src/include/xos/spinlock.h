@@ -0,0 +1,22 @@
+#ifndef XOS_SPINLOCK_H
+#define XOS_SPINLOCK_H
+
+#include "./types.h"
+
+// 自旋锁，用于多处理器之间的短临界区，持有期间不能阻塞
+typedef struct spinlock_t
+{
+    volatile u32 locked; // 是否被持有
+} spinlock_t;
+
+void spin_init(spinlock_t *lock);    // 初始化自旋锁
+void spin_lock(spinlock_t *lock);    // 加锁，忙等直到获得
+bool spin_trylock(spinlock_t *lock); // 尝试加锁，成功返回 true
+void spin_unlock(spinlock_t *lock);  // 解锁
+
+// 关中断并加锁，返回之前的中断状态
+bool spin_lock_irqsave(spinlock_t *lock);
+// 解锁并恢复中断状态
+void spin_unlock_irqrestore(spinlock_t *lock, bool state);
+
+#endif
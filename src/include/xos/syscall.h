@@ -3,6 +3,9 @@
 
 #include "./types.h"
 #include "./stat.h"
+#include "./sched.h"
+#include "./io_uring.h"
+#include "./poll.h"
 #include "./net/socket.h"
 
 #define SYSCALL_SIZE 512
@@ -37,6 +40,8 @@ typedef enum syscall_t
     SYS_NR_FSTAT = 28,
     SYS_NR_STTY = 31,
     SYS_NR_GTTY = 32,
+    SYS_NR_NICE = 34,
+    SYS_NR_SYNC = 36,
     SYS_NR_KILL = 37,
     SYS_NR_MKDIR = 39,
     SYS_NR_RMDIR = 40,
@@ -45,6 +50,7 @@ typedef enum syscall_t
     SYS_NR_BRK = 45,
     SYS_NR_SIGNAL = 48,
     SYS_NR_IOCTL = 54,
+    SYS_NR_FCNTL = 55,
     SYS_NR_SETPGID = 57,
     SYS_NR_UNAME = 59,
     SYS_NR_UMASK = 60,
@@ -59,15 +65,38 @@ typedef enum syscall_t
     SYS_NR_READDIR = 89,
     SYS_NR_MMAP = 90,
     SYS_NR_MUNMAP = 91,
+    SYS_NR_GETPRIORITY = 96,
+    SYS_NR_SETPRIORITY = 97,
+    SYS_NR_FSYNC = 118,
+    SYS_NR_CLONE = 120,
+    SYS_NR_SELECT = 142,
+    SYS_NR_READV = 145,
+    SYS_NR_WRITEV = 146,
+    SYS_NR_FDATASYNC = 148,
+    SYS_NR_SCHED_SETPARAM = 154,
+    SYS_NR_SCHED_GETPARAM = 155,
+    SYS_NR_SCHED_SETSCHEDULER = 156,
+    SYS_NR_SCHED_GETSCHEDULER = 157,
     SYS_NR_YIELD = 158,
     SYS_NR_SLEEP = 162,
+    SYS_NR_POLL = 168,
+    SYS_NR_PREAD = 180,
+    SYS_NR_PWRITE = 181,
     SYS_NR_GETCWD = 183,
+    SYS_NR_SENDFILE = 187,
+    SYS_NR_GETTID = 224,
+    SYS_NR_FUTEX = 240,
+    SYS_NR_EPOLL_CREATE = 254,
+    SYS_NR_EPOLL_CTL = 255,
+    SYS_NR_EPOLL_WAIT = 256,
+    SYS_NR_SPLICE = 313,
+    SYS_NR_TEE = 315,
 
     SYS_NR_SOCKET = 359,
     SYS_NR_BIND = 361,
     SYS_NR_CONNECT,
     SYS_NR_LISTEN,
-    SYS_NR_ACCEPT,
+    SYS_NR_ACCEPT, // 即 accept4
     SYS_NR_GETSOCKOPT,
     SYS_NR_SETSOCKOPT,
     SYS_NR_GETSOCKNAME,
@@ -79,6 +108,9 @@ typedef enum syscall_t
     SYS_NR_SHUTDOWN,
     SYS_NR_RESOLV,
 
+    SYS_NR_IO_URING_SETUP = 425,
+    SYS_NR_IO_URING_ENTER = 426,
+
     SYS_NR_MKFS = SYSCALL_SIZE - 1,
 } syscall_t;
 
@@ -98,6 +130,28 @@ enum mmap_type_t
     MAP_FIXED = 0x10,
 };
 
+enum clone_flag_t
+{
+    CLONE_VM = 0x00000100,             // 共享地址空间
+    CLONE_FS = 0x00000200,             // 共享工作目录
+    CLONE_FILES = 0x00000400,          // 共享文件表
+    CLONE_SIGHAND = 0x00000800,        // 共享信号处理
+    CLONE_THREAD = 0x00010000,         // 加入同一线程组
+    CLONE_PARENT_SETTID = 0x00100000,  // 在父线程的 ptid 中写入线程 id
+    CLONE_CHILD_CLEARTID = 0x00200000, // 线程退出时清零 ctid 并唤醒等待者
+    CLONE_CHILD_SETTID = 0x01000000,   // 在 ctid 中写入线程 id
+};
+
+// 创建线程需要的标志
+#define CLONE_THREAD_FLAGS (CLONE_VM | CLONE_FS | CLONE_FILES | CLONE_SIGHAND | CLONE_THREAD)
+
+enum futex_op_t
+{
+    FUTEX_WAIT = 0,           // *addr == val 时阻塞
+    FUTEX_WAKE = 1,           // 唤醒至多 val 个等待者
+    FUTEX_PRIVATE_FLAG = 128, // 仅用于进程内，与不带该标志等价
+};
+
 u32 test();
 
 pid_t fork();
@@ -112,6 +166,26 @@ void sleep(u32 ms);
 
 pid_t getpid();
 pid_t getppid();
+pid_t gettid();
+
+// 创建线程，在 stack 栈上执行 fn(arg)，fn 返回值作为线程退出状态，
+// ptid 和 ctid 分别用于 CLONE_PARENT_SETTID 和 CLONE_CHILD_SETTID / CLONE_CHILD_CLEARTID
+int clone(int (*fn)(void *), void *stack, int flags, void *arg, pid_t *ptid, pid_t *ctid);
+// 快速用户空间互斥，timeout 单位为毫秒，TIMELESS 表示不超时
+int futex(int *addr, int op, int val, int timeout);
+
+// 调整当前进程 nice 值，成功返回 0
+int nice(int increment);
+// 获取 / 设置进程优先级，which 为 PRIO_PROCESS / PRIO_PGRP / PRIO_USER
+int getpriority(int which, int who);
+int setpriority(int which, int who, int prio);
+
+// 设置 / 获取调度策略，policy 为 SCHED_NORMAL / SCHED_FIFO / SCHED_RR
+int sched_setscheduler(pid_t pid, int policy, sched_param_t *param);
+int sched_getscheduler(pid_t pid);
+// 设置 / 获取实时优先级
+int sched_setparam(pid_t pid, sched_param_t *param);
+int sched_getparam(pid_t pid, sched_param_t *param);
 
 // 设置进程组
 pid_t setpgrp();
@@ -128,6 +202,8 @@ int gtty();
 
 // 操作 IO 设备
 int ioctl(fd_t fd, int cmd, int args);
+// 获取 / 设置文件标记，cmd 为 F_GETFL / F_SETFL
+int fcntl(fd_t fd, int cmd, int arg);
 
 int brk(void *addr);
 void *mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offset);
@@ -140,6 +216,24 @@ fd_t creat(char *filename, int mode);
 // 关闭文件
 void close(fd_t fd);
 
+// 创建提交 / 完成队列，队列映射到进程地址空间，地址写入 params
+fd_t io_uring_setup(u32 entries, io_uring_params_t *params);
+// 提交至多 to_submit 个请求，带 IORING_ENTER_GETEVENTS 时等待至少 min_complete 个完成项，
+// 返回提交的请求数量
+int io_uring_enter(fd_t fd, u32 to_submit, u32 min_complete, u32 flags);
+
+// 等待文件就绪，timeout 单位为毫秒，TIMELESS 表示不超时，返回就绪的文件数量
+int poll(pollfd_t *fds, u32 nfds, int timeout);
+// 等待集合中的文件就绪，返回时集合中只保留就绪的文件，timeout 为空表示不超时
+int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, timeval *timeout);
+
+// 创建 epoll 实例，size 大于 0 即可
+fd_t epoll_create(int size);
+// 添加 / 修改 / 删除关注的文件
+int epoll_ctl(fd_t epfd, int op, fd_t fd, epoll_event_t *event);
+// 等待关注的文件就绪，返回写入 events 的事件数量
+int epoll_wait(fd_t epfd, epoll_event_t *events, int maxevents, int timeout);
+
 // 复制文件描述符
 fd_t dup(fd_t oldfd);
 fd_t dup2(fd_t oldfd, fd_t newfd);
@@ -147,15 +241,34 @@ fd_t dup2(fd_t oldfd, fd_t newfd);
 // 创建管道
 int pipe(fd_t pipefd[2]);
 
+// 在管道和文件、套接字之间移动 len 个字节，至少一端是管道，数据以页或文件块为单位移动而不复制，
+// 非管道一端的 off 不为空时使用并更新 *off，否则使用并更新文件偏移
+int splice(fd_t fd_in, off_t *off_in, fd_t fd_out, off_t *off_out, size_t len, u32 flags);
+
+// 把管道 fd_in 中最多 len 个字节复制到管道 fd_out，两个管道共享数据，fd_in 中的数据不被取出
+int tee(fd_t fd_in, fd_t fd_out, size_t len, u32 flags);
+
 // 读文件
 int read(fd_t fd, char *buf, int len);
 // 写文件
 int write(fd_t fd, char *buf, int len);
+// 依次读入多个缓冲区 / 写出多个缓冲区，只需一次系统调用
+int readv(fd_t fd, iovec_t *iov, int iovlen);
+int writev(fd_t fd, iovec_t *iov, int iovlen);
+// 在指定偏移处读写，不使用也不修改文件偏移
+int pread(fd_t fd, char *buf, int len, off_t offset);
+int pwrite(fd_t fd, char *buf, int len, off_t offset);
 // 设置文件偏移量
 int lseek(fd_t fd, off_t offset, int whence);
 // 读取目录
 int readdir(fd_t fd, void *dir, int count);
 
+// 写入所有脏缓冲
+int sync();
+// 写入文件所在设备的脏缓冲，返回时数据已经写入磁盘
+int fsync(fd_t fd);
+int fdatasync(fd_t fd);
+
 // 获取当前路径
 char *getcwd(char *buf, size_t size);
 // 切换当前目录
@@ -205,6 +318,8 @@ int alarm(int sec);
 int socket(int domain, int type, int protocol);
 int listen(int fd, int backlog);
 int accept(int fd, sockaddr_t *addr, int *addrlen);
+// flags 为 SOCK_NONBLOCK 时新连接为非阻塞方式
+int accept4(int fd, sockaddr_t *addr, int *addrlen, int flags);
 int bind(int fd, const sockaddr_t *name, int namelen);
 int connect(int fd, const sockaddr_t *name, int namelen);
 int shutdown(int fd, int how);
@@ -222,8 +337,15 @@ int send(int fd, const void *data, int size, u32 flags);
 int sendto(int fd, const void *data, int size, u32 flags, const sockaddr_t *to, int tolen);
 int sendmsg(int fd, msghdr_t *msg, u32 flags);
 
+// 把文件 in_fd 的 count 个字节直接发送到套接字 out_fd，数据不经过用户空间，
+// offset 不为空时从 *offset 处读取并更新 *offset，否则使用并更新文件偏移
+int sendfile(int out_fd, fd_t in_fd, off_t *offset, int count);
+
 int resolv(const char *name, ip_addr_t addr);
 
 int uname(void *buf);
 
+// 处理器是否支持 sysenter / sysexit，内核和用户程序共用
+bool cpu_has_sep();
+
 #endif
@@ -4,6 +4,7 @@
 #include "./types.h"
 #include "./list.h"
 #include "./signal.h"
+#include "./rbtree.h"
 
 #define KERNEL_USER 0
 #define NORMAL_USER 1000
@@ -29,6 +30,8 @@ typedef enum task_flag_t
 {
     TASK_FPU_USED = 1,
     TASK_FPU_ENABLED = 2,
+    TASK_NEED_RESCHED = 4, // 需要尽快调度
+    TASK_KILLABLE = 8,     // 阻塞时可以被线程组退出唤醒，唤醒后需要检查 SIGKILL
 } task_flag_t;
 
 typedef struct task_t
@@ -36,14 +39,30 @@ typedef struct task_t
     u32 *stack;                         // 内核栈
     list_node_t node;                   // 任务阻塞节点
     task_state_t state;                 // 任务状态
-    u32 priority;                       // 任务优先级
+    u32 priority;                       // 任务基础时间片
     int ticks;                          // 剩余时间片
     u32 jiffies;                        // 上次执行时全局时间片
+    int nice;                           // 友好值 -20 ~ 19
+    u32 weight;                         // 调度权重，由 nice 决定
+    u32 vruntime;                       // 虚拟运行时间
+    rbnode_t rbnode;                    // 就绪树结点
+    int policy;                         // 调度策略
+    int rt_priority;                    // 实时优先级 1 ~ 99
+    list_node_t rtnode;                 // 实时就绪队列结点
+    int prio;                           // 生效优先级，数值越小越高，可能被继承提升
+    int normal_prio;                    // 调度策略决定的优先级
+    list_t pi_mutexes;                  // 持有的互斥量，用于计算继承的优先级
+    struct mutex_t *pi_blocked_on;      // 阻塞等待的互斥量
+    struct cpu_t *cpu;                  // 所在处理器
+    int lock_depth;                     // 换出时大内核锁的嵌套深度
     char name[TASK_NAME_LEN];           // 任务名
     u32 uid;                            // 用户 id
     u32 gid;                            // 用户组 id
     pid_t pid;                          // 任务 id
     pid_t ppid;                         // 父任务 id
+    pid_t tgid;                         // 线程组 id，即线程组首领的 pid
+    int threads;                        // 线程组首领记录组内其他未退出的线程数量
+    u32 *clear_child_tid;               // 线程退出时清零该地址并唤醒等待者
     pid_t pgid;                         // 进程组
     pid_t sid;                          // 进程会话
     dev_t tty;                          // tty 设备
@@ -60,12 +79,13 @@ typedef struct task_t
     struct inode_t *iroot;              // 进程根目录 inode
     struct inode_t *iexec;              // 程序文件 inode
     u16 umask;                          // 进程用户权限
-    struct file_t *files[TASK_FILE_NR]; // 进程文件表
+    struct file_t **files;              // 文件表，线程共享线程组首领的文件表
+    struct file_t *fdtab[TASK_FILE_NR]; // 进程文件表
     u32 signal;                         // 进程信号位图
     u32 blocked;                        // 进程信号屏蔽位图
     struct timer_t *alarm;              // 闹钟定时器
     struct timer_t *timer;              // 超时定时器
-    sigaction_t actions[MAXSIG];        // 信号处理函数
+    sighand_t *sighand;                 // 信号处理函数表，线程组共享
     struct fpu_t *fpu;                  // fpu 指针
     u32 flags;                          // 特殊标记
     u32 magic;                          // 内核魔数，用于检测栈溢出
@@ -130,9 +150,25 @@ void task_to_user_mode();
 
 pid_t sys_getpid();
 pid_t sys_getppid();
+pid_t sys_gettid();
+
+// 创建共享地址空间、文件表和工作目录的线程
+pid_t sys_clone(u32 flags, u32 stack, pid_t *ptid, u32 tls, pid_t *ctid);
+// 在当前线程组中创建只在内核态执行的线程，执行 target(arg)，target 不能返回
+task_t *task_create_worker(void (*target)(void *), void *arg, const char *name);
+// 线程组中是否还有其他线程
+bool task_threaded(task_t *task);
+// 同步线程组的堆顶
+void task_sync_brk(task_t *task);
 
 bool task_leader(task_t *task);
 
+int sys_nice(int increment);
+int sys_getpriority(int which, int who);
+int sys_setpriority(int which, int who, int nice);
+
+void task_preempt();
+
 task_t *task_create(target_t target, const char *name, u32 priority, u32 uid);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,24 @@
+#ifndef XOS_UIO_H
+#define XOS_UIO_H
+
+#include "./types.h"
+
+#define UIO_MAXIOV 1024 // readv / writev 一次最多的缓冲区数量
+
+typedef struct iovec_t
+{
+    size_t size;
+    void *base;
+} iovec_t;
+
+err_t iovec_check(iovec_t *iov, int iovlen, int write);
+size_t iovec_size(iovec_t *iov, int iovlen);
+iovec_t *iovec_dup(iovec_t *iov, int iovlen);
+
+// 从 iov 复制 count 个字节到 buf，同时消耗 iov
+int iovec_read(iovec_t *iov, int iovlen, char *buf, size_t count);
+
+// 从 buf 复制 count 个字节到 iov，同时消耗 iov
+int iovec_write(iovec_t *iov, int iovlen, char *buf, size_t count);
+
+#endif
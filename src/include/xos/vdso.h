@@ -0,0 +1,37 @@
+#ifndef XOS_VDSO_H
+#define XOS_VDSO_H
+
+#include "./types.h"
+#include "./memory.h"
+
+// 内核共享数据页映射在用户栈之上，独占一个页目录项，
+// 第一页为所有进程共享的系统数据，第二页为进程私有数据，用户态只读
+#define VDSO_ADDR USER_STACK_TOP
+#define VDSO_DATA_ADDR VDSO_ADDR
+#define VDSO_TASK_ADDR (VDSO_ADDR + PAGE_SIZE)
+
+// 系统数据，由时钟中断更新
+typedef struct vdso_data_t
+{
+    volatile u32 jiffies; // 系统时钟中断次数
+    u32 jiffy;            // 每次中断的毫秒数
+    time_t startup_time;  // 系统启动时间
+} vdso_data_t;
+
+// 进程数据
+typedef struct vdso_task_t
+{
+    pid_t pid; // 进程 id，即线程组 id
+} vdso_task_t;
+
+#define VDSO_DATA ((vdso_data_t *)VDSO_DATA_ADDR)
+#define VDSO_TASK ((vdso_task_t *)VDSO_TASK_ADDR)
+
+// 为页目录 pde 映射共享数据页，并分配记录 pid 的进程页
+void vdso_map(page_entry_t *pde, pid_t pid);
+// 释放页目录 pde 中的共享数据页映射
+void vdso_unmap(page_entry_t *pde);
+// 时钟中断中更新系统数据
+void vdso_update();
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef XOS_VIRTIO_H
+#define XOS_VIRTIO_H
+
+#include "./types.h"
+#include "./list.h"
+#include "./device.h"
+
+#define VIRTIO_VENDORID 0x1AF4     // 红帽 virtio 设备
+#define VIRTIO_DEVICEID_BLK 0x1001 // 过渡版 virtio 块设备，支持传统接口
+
+// 传统 PCI 接口的 IO 寄存器偏移
+#define VIRTIO_PCI_HOST_FEATURES 0x00  // 设备支持的特性
+#define VIRTIO_PCI_GUEST_FEATURES 0x04 // 驱动选择的特性
+#define VIRTIO_PCI_QUEUE_PFN 0x08      // 队列的物理页号
+#define VIRTIO_PCI_QUEUE_NUM 0x0C      // 队列大小
+#define VIRTIO_PCI_QUEUE_SEL 0x0E      // 选择队列
+#define VIRTIO_PCI_QUEUE_NOTIFY 0x10   // 通知设备队列有新的缓冲
+#define VIRTIO_PCI_STATUS 0x12         // 设备状态
+#define VIRTIO_PCI_ISR 0x13            // 中断状态，读取时清除
+#define VIRTIO_PCI_CONFIG 0x14         // 设备配置，没有启用 MSI-X
+
+// 设备状态
+#define VIRTIO_STATUS_ACKNOWLEDGE 0x01 // 发现了设备
+#define VIRTIO_STATUS_DRIVER 0x02      // 有驱动程序
+#define VIRTIO_STATUS_DRIVER_OK 0x04   // 驱动初始化完成
+#define VIRTIO_STATUS_FAILED 0x80      // 驱动初始化失败
+
+// 队列特性
+#define VIRTIO_RING_F_INDIRECT_DESC (1 << 28) // 间接描述符
+#define VIRTIO_RING_F_EVENT_IDX (1 << 29)     // 用事件索引抑制通知和中断
+
+#define VRING_DESC_F_NEXT 1     // 后面还有描述符
+#define VRING_DESC_F_WRITE 2    // 设备写缓冲区
+#define VRING_DESC_F_INDIRECT 4 // 缓冲区是间接描述符表
+
+#define VRING_AVAIL_F_NO_INTERRUPT 1 // 驱动不需要中断
+#define VRING_USED_F_NO_NOTIFY 1     // 设备不需要通知
+
+#define VIRTIO_PCI_VRING_ALIGN 4096 // 传统接口中已用环的对齐
+
+// 编译器屏障，x86 的写操作之间不会重排
+#define virtio_wmb() asm volatile("" ::: "memory")
+// 全屏障，之后的读操作不会提前到之前的写操作前面
+#define virtio_mb() asm volatile("lock; addl $0, (%%esp)" ::: "memory")
+
+// 描述符，描述一段物理内存
+typedef struct vring_desc_t
+{
+    u64 addr;  // 物理地址
+    u32 len;   // 长度
+    u16 flags; // 标志
+    u16 next;  // 下一个描述符
+} _packed vring_desc_t;
+
+// 可用环，驱动放入缓冲，之后是 used_event
+typedef struct vring_avail_t
+{
+    u16 flags;  // 标志
+    u16 idx;    // 驱动下一个放入的位置
+    u16 ring[]; // 描述符链的第一个描述符
+} vring_avail_t;
+
+typedef struct vring_used_elem_t
+{
+    u32 id;  // 描述符链的第一个描述符
+    u32 len; // 设备写入的字节数
+} vring_used_elem_t;
+
+// 已用环，设备放回用过的缓冲，之后是 avail_event
+typedef struct vring_used_t
+{
+    u16 flags;                // 标志
+    u16 idx;                  // 设备下一个放入的位置
+    vring_used_elem_t ring[]; // 用过的缓冲
+} vring_used_t;
+
+// 分离式虚拟队列
+typedef struct virtqueue_t
+{
+    u16 iobase;                  // 设备 IO 寄存器基址
+    u16 index;                   // 队列号
+    u16 size;                    // 描述符数量
+    bool indirect;               // 使用间接描述符
+    bool event_idx;              // 使用事件索引
+    vring_desc_t *desc;          // 描述符表
+    vring_avail_t *avail;        // 可用环
+    volatile vring_used_t *used; // 已用环
+    u32 pages;                   // 占用的页数
+    u16 free_head;               // 第一个空闲描述符
+    u16 num_free;                // 空闲描述符数量
+    u16 avail_idx;               // 已经放入可用环的数量，通知时才对设备可见
+    u16 kicked;                  // 上次通知时的 avail_idx
+    u16 last_used;               // 已经取出的已用环位置
+    void **data;                 // 每个描述符链对应的数据
+} virtqueue_t;
+
+// 创建队列，队列大小由设备决定，features 为协商后的特性
+virtqueue_t *virtq_create(u16 iobase, u16 index, u32 features);
+
+// 放入一个描述符链，支持间接描述符时放入 table 中只占一个描述符，
+// 描述符不够时返回 -ENOSPC，通知之前对设备不可见
+err_t virtq_add(virtqueue_t *vq, vring_desc_t *descs, int count, vring_desc_t *table, void *data);
+
+// 把放入的描述符链交给设备，设备需要时通知设备，多次放入可以一次通知
+void virtq_kick(virtqueue_t *vq);
+
+// 取出一个设备用过的描述符链，返回放入时的数据，没有时返回 NULL
+void *virtq_get(virtqueue_t *vq, u32 *len);
+
+// 请求在设备用过下一个缓冲时中断，返回是否已经有新的缓冲
+bool virtq_enable_intr(virtqueue_t *vq);
+
+#define VIRTIO_BLK_QUEUE_NR 4  // 最多使用的队列数量
+#define VIRTIO_BLK_SLOT_NR 32  // 每个队列同时执行的请求数量
+#define VIRTIO_BLK_SEG_NR 128  // 每个请求最多的数据段数量
+#define VIRTIO_BLK_PART_NR 4   // 每个磁盘分区数量，只支持主分区
+
+// 块设备请求头
+typedef struct virtio_blk_outhdr_t
+{
+    u32 type;     // 请求类型
+    u32 reserved; // 保留
+    u64 sector;   // 扇区位置
+} _packed virtio_blk_outhdr_t;
+
+// 执行中的块设备请求
+typedef struct virtio_blk_req_t
+{
+    virtio_blk_outhdr_t hdr;       // 请求头
+    u8 status;                     // 设备写回的状态
+    request_t *req;                // 异步执行的请求
+    struct task_t *waiter;         // 同步等待完成的任务
+    err_t ret;                     // 执行结果
+    bool done;                     // 是否已经完成
+    vring_desc_t *table;           // 间接描述符表
+    struct virtio_blk_req_t *next; // 下一个空闲请求
+} virtio_blk_req_t;
+
+// 块设备的一个队列
+typedef struct virtio_blk_queue_t
+{
+    virtqueue_t *vq;        // 虚拟队列
+    virtio_blk_req_t *reqs; // 请求数组
+    virtio_blk_req_t *free; // 空闲请求链表
+    u32 slots;              // 请求数量
+    u32 inflight;           // 执行中的请求数量
+} virtio_blk_queue_t;
+
+// virtio 块设备分区
+typedef struct virtio_blk_part_t
+{
+    char name[8];             // 分区名称
+    struct virtio_blk_t *blk; // 磁盘指针
+    u32 system;               // 分区类型
+    u32 start;                // 分区起始物理扇区号 LBA
+    u32 count;                // 分区占用的扇区数
+} virtio_blk_part_t;
+
+// virtio 块设备
+typedef struct virtio_blk_t
+{
+    char name[8];                                   // 磁盘名称
+    u16 iobase;                                     // IO 寄存器基址
+    u32 vector;                                     // 中断向量
+    u32 features;                                   // 协商后的特性
+    u32 capacity;                                   // 扇区数量
+    u32 seg_max;                                    // 每个请求最多的数据段数量
+    virtio_blk_queue_t queues[VIRTIO_BLK_QUEUE_NR]; // 队列
+    u32 nr_queues;                                  // 队列数量
+    list_t wait_list;                               // 等待空闲请求的任务
+    dev_t dev;                                      // 磁盘设备号
+    virtio_blk_part_t parts[VIRTIO_BLK_PART_NR];    // 磁盘分区
+} virtio_blk_t;
+
+#endif
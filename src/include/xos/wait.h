@@ -0,0 +1,43 @@
+#ifndef XOS_WAIT_H
+#define XOS_WAIT_H
+
+#include "./types.h"
+#include "./list.h"
+
+// 等待队列，挂在套接字、管道和终端等可以等待的对象上，
+// 对象状态变化时以就绪事件调用队列中每一项的回调
+typedef struct wait_queue_t
+{
+    list_t list; // 等待项链表
+} wait_queue_t;
+
+struct wait_entry_t;
+
+// 唤醒回调，events 为本次唤醒的就绪事件
+typedef void (*wait_func_t)(struct wait_entry_t *entry, u32 events);
+
+// 等待项
+typedef struct wait_entry_t
+{
+    list_node_t node;    // 等待队列结点
+    wait_queue_t *queue; // 所在等待队列
+    wait_func_t func;    // 唤醒回调
+    void *data;          // 回调私有数据
+} wait_entry_t;
+
+// 初始化等待队列
+void wait_queue_init(wait_queue_t *wq);
+
+// 初始化等待项
+void wait_entry_init(wait_entry_t *entry, wait_func_t func, void *data);
+
+// 将等待项加入等待队列
+void wait_add(wait_queue_t *wq, wait_entry_t *entry);
+
+// 将等待项移出所在等待队列，不在队列中时忽略
+void wait_remove(wait_entry_t *entry);
+
+// 以就绪事件 events 调用队列中所有等待项的回调
+void wake_up(wait_queue_t *wq, u32 events);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef XOS_WORKQUEUE_H
+#define XOS_WORKQUEUE_H
+
+#include "./types.h"
+#include "./list.h"
+
+#define WORKQUEUE_NR 8        // 工作队列数量
+#define WORKQUEUE_NAME_LEN 16 // 工作队列名称长度
+
+struct work_t;
+struct task_t;
+
+typedef void (*work_func_t)(struct work_t *work);
+
+// 工作项，由中断处理函数提交，在工作线程中执行，可以阻塞
+typedef struct work_t
+{
+    list_node_t node;           // 队列结点
+    work_func_t func;           // 处理函数
+    struct workqueue_t *wq;     // 最近提交的队列
+    bool pending;               // 已提交未执行
+} work_t;
+
+// 工作队列，每个队列一个内核线程，按提交顺序执行
+typedef struct workqueue_t
+{
+    char name[WORKQUEUE_NAME_LEN]; // 名称
+    list_t works;                  // 待执行的工作项
+    struct task_t *worker;         // 工作线程
+    work_t *current;               // 正在执行的工作项
+    bool idle;                     // 工作线程没有工作项，阻塞等待提交
+} workqueue_t;
+
+// 系统默认工作队列
+extern workqueue_t *system_wq;
+
+// 初始化工作项
+void work_init(work_t *work, work_func_t func);
+
+// 创建工作队列，policy 和 priority 为工作线程的调度策略
+workqueue_t *workqueue_create(const char *name, int policy, int priority);
+
+// 提交工作项，已提交未执行时返回 false，可以在中断处理函数中调用
+bool queue_work(workqueue_t *wq, work_t *work);
+// 提交到系统默认工作队列
+bool schedule_work(work_t *work);
+
+// 取消未执行的工作项，返回工作项是否处于提交状态
+bool cancel_work(work_t *work);
+// 取消工作项，并等待正在执行的工作项结束
+bool cancel_work_sync(work_t *work);
+
+// 等待此前提交到队列的工作项全部执行完毕
+void flush_workqueue(workqueue_t *wq);
+// 等待工作项执行完毕
+bool flush_work(work_t *work);
+
+#endif
@@ -0,0 +1,710 @@
+#include "hyc.h"
+
+#define LOGK(fmt, args...) DEBUGK(fmt, ##args)
+
+#define AHCI_TIMEOUT 1000 // 等待端口状态变化的毫秒数
+
+// 全局寄存器偏移
+#define AHCI_CAP 0x00 // Host Capabilities 控制器能力
+#define AHCI_GHC 0x04 // Global Host Control 全局控制
+#define AHCI_IS 0x08  // Interrupt Status 中断状态，每个端口一位
+#define AHCI_PI 0x0C  // Ports Implemented 实现的端口
+#define AHCI_VS 0x10  // Version 版本
+
+#define AHCI_CAP_NCS(cap) ((((cap) >> 8) & 0x1f) + 1) // 每个端口的命令槽数量
+#define AHCI_CAP_SNCQ (1 << 30)                      // 支持本地命令队列
+
+#define AHCI_GHC_HR 0x01        // 控制器复位
+#define AHCI_GHC_IE 0x02        // 中断使能
+#define AHCI_GHC_AE (1u << 31) // AHCI 模式使能
+
+// 端口寄存器偏移
+#define AHCI_PORT_BASE 0x100 // 第一个端口寄存器偏移
+#define AHCI_PORT_SIZE 0x80  // 每个端口寄存器大小
+
+#define PORT_CLB 0x00   // Command List Base Address 命令列表地址
+#define PORT_CLBU 0x04  // 命令列表地址高 32 位
+#define PORT_FB 0x08    // FIS Base Address 接收 FIS 地址
+#define PORT_FBU 0x0C   // 接收 FIS 地址高 32 位
+#define PORT_IS 0x10    // Interrupt Status 中断状态
+#define PORT_IE 0x14    // Interrupt Enable 中断使能
+#define PORT_CMD 0x18   // Command and Status 命令和状态
+#define PORT_TFD 0x20   // Task File Data 任务文件数据
+#define PORT_SIG 0x24   // Signature 设备签名
+#define PORT_SSTS 0x28  // SATA Status 状态
+#define PORT_SCTL 0x2C  // SATA Control 控制
+#define PORT_SERR 0x30  // SATA Error 错误
+#define PORT_SACT 0x34  // SATA Active 本地命令队列中未完成的命令
+#define PORT_CI 0x38    // Command Issue 已发出的命令
+
+#define PORT_CMD_ST 0x0001  // Start 开始处理命令列表
+#define PORT_CMD_SUD 0x0002 // Spin-Up Device
+#define PORT_CMD_POD 0x0004 // Power On Device
+#define PORT_CMD_FRE 0x0010 // FIS Receive Enable 接收 FIS
+#define PORT_CMD_FR 0x4000  // FIS Receive Running
+#define PORT_CMD_CR 0x8000  // Command List Running
+
+#define PORT_IS_DHRS 0x00000001 // 收到设备到主机寄存器 FIS
+#define PORT_IS_PSS 0x00000002  // 收到 PIO Setup FIS
+#define PORT_IS_DSS 0x00000004  // 收到 DMA Setup FIS
+#define PORT_IS_SDBS 0x00000008 // 收到 Set Device Bits FIS，本地命令队列完成
+#define PORT_IS_IFS 0x08000000  // 接口严重错误
+#define PORT_IS_HBDS 0x10000000 // 主机总线数据错误
+#define PORT_IS_HBFS 0x20000000 // 主机总线严重错误
+#define PORT_IS_TFES 0x40000000 // 任务文件错误
+
+#define PORT_IS_DONE (PORT_IS_DHRS | PORT_IS_PSS | PORT_IS_DSS | PORT_IS_SDBS)
+#define PORT_IS_ERROR (PORT_IS_IFS | PORT_IS_HBDS | PORT_IS_HBFS | PORT_IS_TFES)
+
+#define PORT_SSTS_DET_PRESENT 3 // 检测到设备并建立通信
+#define PORT_SSTS_IPM_ACTIVE 1  // 接口处于活动状态
+
+#define SATA_SIG_ATA 0x00000101 // SATA 磁盘
+
+#define FIS_TYPE_REG_H2D 0x27 // 主机到设备的寄存器 FIS
+#define FIS_H2D_COMMAND 0x80  // FIS 为命令
+
+#define CMD_HEADER_WRITE 0x40 // 数据由主机到设备
+
+#define AHCI_PRD_MAX 0x400000 // 每个 PRD 最多的字节数
+
+// ATA 命令
+#define ATA_CMD_READ_DMA_EXT 0x25
+#define ATA_CMD_WRITE_DMA_EXT 0x35
+#define ATA_CMD_READ_FPDMA_QUEUED 0x60
+#define ATA_CMD_WRITE_FPDMA_QUEUED 0x61
+#define ATA_CMD_IDENTIFY 0xEC
+
+#define ATA_DEVICE_LBA 0x40
+
+// IDENTIFY 返回数据中的字位置
+#define ATA_ID_LBA28 60          // 28 位 LBA 扇区数量，两个字
+#define ATA_ID_QUEUE_DEPTH 75    // 低 5 位为队列深度减一
+#define ATA_ID_SATA_CAP 76       // SATA 能力
+#define ATA_ID_COMMAND_SET 83    // 支持的命令集
+#define ATA_ID_LBA48 100         // 48 位 LBA 扇区数量，四个字
+
+#define ATA_SATA_CAP_NCQ (1 << 8)   // 支持本地命令队列
+#define ATA_COMMAND_SET_LBA48 (1 << 10) // 支持 48 位 LBA
+
+// 分区文件系统类型定义
+#define PART_FS_EXTENDED 5
+
+static ahci_ctrl_t controller;
+
+#define PORT_REG(port, reg) ((port)->base + (reg))
+
+// 等待寄存器中 mask 对应的位变成 value
+static err_t ahci_wait(u32 addr, u32 mask, u32 value, int timeout_ms)
+{
+    int expiration = timer_expire_jiffies(timeout_ms);
+    while ((minl(addr) & mask) != value)
+    {
+        if (timer_is_expires(expiration))
+            return -ETIME;
+        task_sleep(10);
+    }
+    return EOK;
+}
+
+// 停止处理命令列表和接收 FIS
+static err_t ahci_port_stop(ahci_port_t *port)
+{
+    u32 cmd = minl(PORT_REG(port, PORT_CMD));
+    moutl(PORT_REG(port, PORT_CMD), cmd & ~PORT_CMD_ST);
+    if (ahci_wait(PORT_REG(port, PORT_CMD), PORT_CMD_CR, 0, AHCI_TIMEOUT) < EOK)
+        return -ETIME;
+
+    cmd = minl(PORT_REG(port, PORT_CMD));
+    moutl(PORT_REG(port, PORT_CMD), cmd & ~PORT_CMD_FRE);
+    return ahci_wait(PORT_REG(port, PORT_CMD), PORT_CMD_FR, 0, AHCI_TIMEOUT);
+}
+
+// 开始接收 FIS 和处理命令列表
+static void ahci_port_start(ahci_port_t *port)
+{
+    u32 cmd = minl(PORT_REG(port, PORT_CMD));
+    moutl(PORT_REG(port, PORT_CMD), cmd | PORT_CMD_FRE);
+    moutl(PORT_REG(port, PORT_CMD), cmd | PORT_CMD_FRE | PORT_CMD_ST);
+}
+
+// 命令槽完成，唤醒同步等待的任务或者通知请求队列
+static void ahci_slot_end(ahci_port_t *port, int tag, err_t ret)
+{
+    ahci_slot_t *slot = &port->slot[tag];
+    port->issued &= ~(1 << tag);
+
+    if (slot->req)
+    {
+        request_t *req = slot->req;
+        slot->req = NULL;
+        device_complete(req, ret);
+    }
+    else if (slot->wait)
+    {
+        // 结果写到等待者的栈上，命令槽马上被别的任务取走也不影响
+        ahci_wait_t *wait = slot->wait;
+        slot->wait = NULL;
+        wait->ret = ret;
+        wait->done = true;
+        task_unblock(wait->task, EOK);
+    }
+
+    // 有了空闲命令槽，唤醒一个等待的任务
+    if (!list_empty(&port->wait_list))
+    {
+        task_t *task = element_entry(task_t, node, list_popback(&port->wait_list));
+        task_unblock(task, EOK);
+    }
+}
+
+// 任务文件错误，本地命令队列中的命令全部中止，重启端口后以 -EIO 结束所有命令
+static void ahci_port_error(ahci_port_t *port, u32 status)
+{
+    LOGK("ahci port %s error status 0x%x tfd 0x%x serr 0x%x\n",
+         port->name, status, minl(PORT_REG(port, PORT_TFD)), minl(PORT_REG(port, PORT_SERR)));
+
+    u32 cmd = minl(PORT_REG(port, PORT_CMD));
+    moutl(PORT_REG(port, PORT_CMD), cmd & ~PORT_CMD_ST);
+
+    // 中断处理中不能睡眠，直接轮询命令列表停止
+    for (size_t i = 0; i < 0x100000 && (minl(PORT_REG(port, PORT_CMD)) & PORT_CMD_CR); i++)
+        ;
+
+    moutl(PORT_REG(port, PORT_SERR), 0xFFFFFFFF);
+    moutl(PORT_REG(port, PORT_IS), 0xFFFFFFFF);
+    moutl(PORT_REG(port, PORT_CMD), cmd | PORT_CMD_ST);
+
+    u32 issued = port->issued;
+    for (int tag = 0; tag < AHCI_SLOT_NR; tag++)
+    {
+        if (issued & (1 << tag))
+            ahci_slot_end(port, tag, -EIO);
+    }
+}
+
+// 端口中断，SACT 和 CI 中都已经清除的命令已经完成
+static void ahci_port_handler(ahci_port_t *port)
+{
+    u32 status = minl(PORT_REG(port, PORT_IS));
+    moutl(PORT_REG(port, PORT_IS), status);
+
+    if (status & PORT_IS_ERROR)
+    {
+        ahci_port_error(port, status);
+        return;
+    }
+
+    u32 active = minl(PORT_REG(port, PORT_SACT)) | minl(PORT_REG(port, PORT_CI));
+    u32 done = port->issued & ~active;
+    for (int tag = 0; done; tag++)
+    {
+        if (!(done & (1 << tag)))
+            continue;
+        done &= ~(1 << tag);
+        ahci_slot_end(port, tag, EOK);
+    }
+}
+
+// 中断处理函数
+static void ahci_handler(int vector)
+{
+    ahci_ctrl_t *ctrl = &controller;
+    assert(vector == ctrl->vector);
+
+    u32 status = minl(ctrl->membase + AHCI_IS);
+    for (size_t i = 0; i < AHCI_PORT_NR; i++)
+    {
+        if ((status & (1 << i)) && ctrl->ports[i])
+            ahci_port_handler(ctrl->ports[i]);
+    }
+
+    // 端口中断状态清除之后再清除全局中断状态
+    moutl(ctrl->membase + AHCI_IS, status);
+    send_eoi(vector);
+}
+
+// 取得空闲命令槽，没有时阻塞等待
+static int ahci_slot_get(ahci_port_t *port)
+{
+    while (true)
+    {
+        for (int tag = 0; tag < port->slots; tag++)
+        {
+            if (port->issued & (1 << tag))
+                continue;
+
+            ahci_slot_t *slot = &port->slot[tag];
+            slot->req = NULL;
+            slot->wait = NULL;
+            return tag;
+        }
+        task_block(running_task(), &port->wait_list, TASK_BLOCKED, TIMELESS);
+    }
+}
+
+// 把一段缓冲区按物理页拆分加入 PRD 表，物理地址连续的相邻两段合并，
+// 返回使用的 PRD 数量，PRD 表放不下或者缓冲区不能 DMA 时返回 -EINVAL
+static int ahci_prd_add(ahci_cmd_table_t *table, int nr, void *buf, u32 size)
+{
+    if (!dma_capable(buf, size))
+        return -EINVAL;
+
+    u32 addr = (u32)buf;
+    while (size)
+    {
+        u32 chars = MIN(size, PAGE_SIZE - (addr & (PAGE_SIZE - 1)));
+        u32 paddr = get_paddr(addr);
+
+        ahci_prd_t *prev = nr ? &table->prdt[nr - 1] : NULL;
+        if (prev && prev->dba + prev->dbc + 1 == paddr && prev->dbc + 1 + chars <= AHCI_PRD_MAX)
+        {
+            prev->dbc += chars;
+        }
+        else
+        {
+            if (nr == AHCI_PRD_NR)
+                return -EINVAL;
+            ahci_prd_t *prd = &table->prdt[nr++];
+            prd->dba = paddr;
+            prd->dbau = 0;
+            prd->reserved = 0;
+            prd->dbc = chars - 1;
+        }
+        addr += chars;
+        size -= chars;
+    }
+    return nr;
+}
+
+// 填写命令 FIS，本地命令队列中扇区数量在特性寄存器，命令标签在扇区数量寄存器
+static void ahci_fis_fill(ahci_port_t *port, int tag, u8 command, idx_t lba, u32 count)
+{
+    fis_reg_h2d_t *fis = (fis_reg_h2d_t *)port->tables[tag].cfis;
+    memset(fis, 0, sizeof(fis_reg_h2d_t));
+    fis->type = FIS_TYPE_REG_H2D;
+    fis->flags = FIS_H2D_COMMAND;
+    fis->command = command;
+    if (command == ATA_CMD_IDENTIFY)
+        return;
+
+    fis->device = ATA_DEVICE_LBA;
+    fis->lba0 = lba & 0xff;
+    fis->lba1 = (lba >> 8) & 0xff;
+    fis->lba2 = (lba >> 16) & 0xff;
+    fis->lba3 = (lba >> 24) & 0xff;
+
+    if (command == ATA_CMD_READ_FPDMA_QUEUED || command == ATA_CMD_WRITE_FPDMA_QUEUED)
+    {
+        fis->featurel = count & 0xff;
+        fis->featureh = (count >> 8) & 0xff;
+        fis->countl = tag << 3;
+    }
+    else
+    {
+        fis->countl = count & 0xff;
+        fis->counth = (count >> 8) & 0xff;
+    }
+}
+
+// 读写命令，使用本地命令队列时为 FPDMA QUEUED
+static u8 ahci_rw_command(ahci_port_t *port, u32 type)
+{
+    if (port->ncq)
+        return (type == REQ_READ) ? ATA_CMD_READ_FPDMA_QUEUED : ATA_CMD_WRITE_FPDMA_QUEUED;
+    return (type == REQ_READ) ? ATA_CMD_READ_DMA_EXT : ATA_CMD_WRITE_DMA_EXT;
+}
+
+// 发出命令，PRD 表已经填好
+static void ahci_issue(ahci_port_t *port, int tag, u8 command, int prdtl, bool write)
+{
+    ahci_cmd_header_t *header = &port->cmdlist[tag];
+    header->flags = sizeof(fis_reg_h2d_t) / 4;
+    if (write)
+        header->flags |= CMD_HEADER_WRITE;
+    header->prdtl = prdtl;
+    header->prdbc = 0;
+
+    port->issued |= (1 << tag);
+    if (command == ATA_CMD_READ_FPDMA_QUEUED || command == ATA_CMD_WRITE_FPDMA_QUEUED)
+        moutl(PORT_REG(port, PORT_SACT), 1 << tag);
+    moutl(PORT_REG(port, PORT_CI), 1 << tag);
+}
+
+// 同步执行命令，iov 中的缓冲区依次对应从 lba 开始的连续扇区
+static int ahci_transfer(ahci_port_t *port, u8 command, iovec_t *iov, int iovcnt, idx_t lba, u32 type)
+{
+    int tag = ahci_slot_get(port);
+    ahci_cmd_table_t *table = &port->tables[tag];
+
+    u32 bytes = 0;
+    int nr = 0;
+    for (size_t i = 0; i < iovcnt; i++)
+    {
+        nr = ahci_prd_add(table, nr, iov[i].base, iov[i].size);
+        if (nr < EOK)
+            return nr;
+        bytes += iov[i].size;
+    }
+
+    ahci_wait_t wait = {running_task(), EOK, false};
+    port->slot[tag].wait = &wait;
+    ahci_fis_fill(port, tag, command, lba, bytes / SECTOR_SIZE);
+    ahci_issue(port, tag, command, nr, type == REQ_WRITE);
+
+    while (!wait.done)
+        task_block(running_task(), NULL, TASK_BLOCKED, TIMELESS);
+    return wait.ret;
+}
+
+// 异步执行请求，请求中每一段直接作为 DMA 缓冲区，不能 DMA 时返回 -EINVAL 由请求队列中转
+static err_t ahci_queue(ahci_port_t *port, request_t *req)
+{
+    int tag = ahci_slot_get(port);
+    ahci_cmd_table_t *table = &port->tables[tag];
+
+    int nr = 0;
+    for (bio_t *bio = req->bio; bio; bio = bio->next)
+    {
+        nr = ahci_prd_add(table, nr, bio->buf, bio->count * SECTOR_SIZE);
+        if (nr < EOK)
+            return nr;
+    }
+
+    u8 command = ahci_rw_command(port, req->type);
+    port->slot[tag].req = req;
+    ahci_fis_fill(port, tag, command, req->idx, req->count);
+    ahci_issue(port, tag, command, nr, req->type == REQ_WRITE);
+    return EOK;
+}
+
+// 磁盘控制
+static int ahci_ioctl(ahci_port_t *port, int cmd, void *args, int flags)
+{
+    switch (cmd)
+    {
+    case DEV_CMD_SECTOR_START:
+        return 0;
+    case DEV_CMD_SECTOR_COUNT:
+        return port->total_lba;
+    case DEV_CMD_SECTOR_SIZE:
+        return SECTOR_SIZE;
+    default:
+        panic("Unrecognized device command %d!!!", cmd);
+    }
+}
+
+// 读写一段连续的缓冲区，缓冲区不能 DMA 时（如用户内存）经过内核页中转
+static int ahci_rw(ahci_port_t *port, void *buf, u8 count, idx_t lba, u32 type)
+{
+    u32 size = count * SECTOR_SIZE;
+    u8 command = ahci_rw_command(port, type);
+    iovec_t iov = {size, buf};
+    if (dma_capable(buf, size))
+        return ahci_transfer(port, command, &iov, 1, lba, type);
+
+    u32 pages = div_round_up(size, PAGE_SIZE);
+    iov.base = (void *)alloc_kpage(pages);
+    if (type == REQ_WRITE)
+        memcpy(iov.base, buf, size);
+
+    int ret = ahci_transfer(port, command, &iov, 1, lba, type);
+    if (type == REQ_READ && ret >= EOK)
+        memcpy(buf, iov.base, size);
+
+    free_kpage((u32)iov.base, pages);
+    return ret;
+}
+
+// 读磁盘
+static int ahci_read(ahci_port_t *port, void *buf, u8 count, idx_t lba)
+{
+    return ahci_rw(port, buf, count, lba, REQ_READ);
+}
+
+// 写磁盘
+static int ahci_write(ahci_port_t *port, void *buf, u8 count, idx_t lba)
+{
+    return ahci_rw(port, buf, count, lba, REQ_WRITE);
+}
+
+// 分散聚集读写磁盘
+static int ahci_sgio(ahci_port_t *port, iovec_t *iov, int iovcnt, idx_t lba, u32 type)
+{
+    return ahci_transfer(port, ahci_rw_command(port, type), iov, iovcnt, lba, type);
+}
+
+// 分区控制
+static int ahci_part_ioctl(ahci_part_t *part, int cmd, void *args, int flags)
+{
+    switch (cmd)
+    {
+    case DEV_CMD_SECTOR_START:
+        return part->start;
+    case DEV_CMD_SECTOR_COUNT:
+        return part->count;
+    case DEV_CMD_SECTOR_SIZE:
+        return SECTOR_SIZE;
+    default:
+        panic("Unrecognized device command %d!!!", cmd);
+    }
+}
+
+// 读取分区
+static int ahci_part_read(ahci_part_t *part, void *buf, u8 count, idx_t lba)
+{
+    return ahci_read(part->port, buf, count, part->start + lba);
+}
+
+// 写入分区
+static int ahci_part_write(ahci_part_t *part, void *buf, u8 count, idx_t lba)
+{
+    return ahci_write(part->port, buf, count, part->start + lba);
+}
+
+// 识别磁盘，磁盘和控制器都支持时使用本地命令队列
+static err_t ahci_identify(ahci_port_t *port, u16 *buf)
+{
+    iovec_t iov = {SECTOR_SIZE, buf};
+    int ret = ahci_transfer(port, ATA_CMD_IDENTIFY, &iov, 1, 0, REQ_READ);
+    if (ret < EOK)
+        return ret;
+
+    if (buf[ATA_ID_COMMAND_SET] & ATA_COMMAND_SET_LBA48)
+    {
+        port->total_lba = buf[ATA_ID_LBA48] | (buf[ATA_ID_LBA48 + 1] << 16);
+        // 只能访问 32 位扇区号
+        if (buf[ATA_ID_LBA48 + 2] || buf[ATA_ID_LBA48 + 3])
+            port->total_lba = 0xFFFFFFFF;
+    }
+    else
+    {
+        port->total_lba = buf[ATA_ID_LBA28] | (buf[ATA_ID_LBA28 + 1] << 16);
+    }
+    if (!port->total_lba)
+        return -EIO;
+
+    if (port->ctrl->ncq && (buf[ATA_ID_SATA_CAP] & ATA_SATA_CAP_NCQ))
+    {
+        port->ncq = true;
+        port->slots = MIN(port->ctrl->slots, (buf[ATA_ID_QUEUE_DEPTH] & 0x1f) + 1);
+    }
+
+    LOGK("Disk %s total lba %d ncq %d slots %d\n",
+         port->name, port->total_lba, port->ncq, port->slots);
+    return EOK;
+}
+
+// 读取主引导记录中的主分区
+static void ahci_part_init(ahci_port_t *port, u16 *buf)
+{
+    if (ahci_read(port, buf, 1, 0) < EOK)
+        return;
+
+    boot_sector_t *boot = (boot_sector_t *)buf;
+    for (size_t i = 0; i < AHCI_PART_NR; i++)
+    {
+        part_entry_t *entry = &boot->entry[i];
+        ahci_part_t *part = &port->parts[i];
+        if (entry->count == 0)
+            continue;
+
+        sprintf(part->name, "%s%d", port->name, i + 1);
+        LOGK("Partition %s start %d count %d system 0x%x\n",
+             part->name, entry->start, entry->count, entry->system);
+
+        part->port = port;
+        part->count = entry->count;
+        part->system = entry->system;
+        part->start = entry->start;
+
+        if (entry->system == PART_FS_EXTENDED)
+            LOGK("Extended partitions are not supported.\n");
+    }
+}
+
+// 初始化连接了 SATA 磁盘的端口，设置命令列表和接收 FIS 区域
+static ahci_port_t *ahci_port_init(ahci_ctrl_t *ctrl, u32 index, u16 *buf)
+{
+    u32 base = ctrl->membase + AHCI_PORT_BASE + index * AHCI_PORT_SIZE;
+
+    u32 ssts = minl(base + PORT_SSTS);
+    if ((ssts & 0xf) != PORT_SSTS_DET_PRESENT || ((ssts >> 8) & 0xf) != PORT_SSTS_IPM_ACTIVE)
+        return NULL;
+    if (minl(base + PORT_SIG) != SATA_SIG_ATA)
+    {
+        LOGK("ahci port %d signature 0x%x not supported\n", index, minl(base + PORT_SIG));
+        return NULL;
+    }
+
+    ahci_port_t *port = (ahci_port_t *)kmalloc(sizeof(ahci_port_t));
+    memset(port, 0, sizeof(ahci_port_t));
+    sprintf(port->name, "sd%c", 'a' + index);
+    port->ctrl = ctrl;
+    port->index = index;
+    port->base = base;
+    port->slots = 1;
+    list_init(&port->wait_list);
+
+    if (ahci_port_stop(port) < EOK)
+    {
+        LOGK("ahci port %s stop timeout\n", port->name);
+        kfree(port);
+        return NULL;
+    }
+
+    // 一页中前 1K 为命令列表，之后 256 字节为接收 FIS 区域
+    u32 page = alloc_kpage(1);
+    memset((void *)page, 0, PAGE_SIZE);
+    port->cmdlist = (ahci_cmd_header_t *)page;
+    port->fis = (u8 *)(page + sizeof(ahci_cmd_header_t) * AHCI_SLOT_NR);
+
+    // 每个命令表 1K，一页放 4 个
+    u32 pages = div_round_up(sizeof(ahci_cmd_table_t) * AHCI_SLOT_NR, PAGE_SIZE);
+    port->tables = (ahci_cmd_table_t *)alloc_kpage(pages);
+    memset(port->tables, 0, pages * PAGE_SIZE);
+    for (size_t i = 0; i < AHCI_SLOT_NR; i++)
+    {
+        port->cmdlist[i].ctba = get_paddr((u32)&port->tables[i]);
+        port->cmdlist[i].ctbau = 0;
+    }
+
+    moutl(base + PORT_CLB, get_paddr((u32)port->cmdlist));
+    moutl(base + PORT_CLBU, 0);
+    moutl(base + PORT_FB, get_paddr((u32)port->fis));
+    moutl(base + PORT_FBU, 0);
+
+    // 写 1 清除错误和中断状态
+    moutl(base + PORT_SERR, 0xFFFFFFFF);
+    moutl(base + PORT_IS, 0xFFFFFFFF);
+    moutl(base + PORT_IE, PORT_IS_DONE | PORT_IS_ERROR);
+
+    ctrl->ports[index] = port;
+    ahci_port_start(port);
+
+    if (ahci_identify(port, buf) < EOK)
+    {
+        LOGK("ahci port %s identify failed\n", port->name);
+        return port;
+    }
+    ahci_part_init(port, buf);
+    return port;
+}
+
+// 设置中断，优先使用 MSI
+static void ahci_interrupt_init(ahci_ctrl_t *ctrl, pci_device_t *device)
+{
+    // 先确认设备支持 MSI 再分配向量，避免回退到传统中断时浪费向量
+    u32 vector = 0;
+    if (pci_find_capability(device, PCI_CAP_ID_MSI))
+        vector = msi_alloc_vector();
+    if (vector && pci_enable_msi(device, vector, cpus[0].apic_id) == EOK)
+    {
+        LOGK("ahci msi vector 0x%X...\n", vector);
+        ctrl->vector = vector;
+        set_vector_handler(vector, ahci_handler);
+        return;
+    }
+
+    u32 intr = pci_interrupt(device);
+    LOGK("ahci irq 0x%X...\n", intr);
+    ctrl->vector = IRQ_MASTER_NR + intr;
+
+    set_interrupt_handler(intr, ahci_handler);
+    set_interrupt_mask(intr, true);
+    if (intr >= 8)
+        set_interrupt_mask(IRQ_CASCADE, true);
+}
+
+// 初始化控制器，复位后进入 AHCI 模式
+static err_t ahci_ctrl_init(ahci_ctrl_t *ctrl, pci_device_t *device)
+{
+    strcpy(ctrl->name, "ahci");
+    pci_enable_busmastering(device);
+
+    pci_bar_t membar;
+    err_t ret = pci_find_bar(device, &membar, PCI_BAR_TYPE_MEM);
+    assert(ret == EOK);
+    LOGK("ahci membase 0x%x size 0x%x\n", membar.iobase, membar.size);
+
+    // 与 e1000 相同，映射内存在高地址，但是不在最后 4M 的页表中
+    assert(membar.iobase < 0xFFC00000 && membar.iobase >= 0xF0000000);
+    ctrl->membase = membar.iobase;
+    map_area(membar.iobase, membar.size);
+
+    moutl(ctrl->membase + AHCI_GHC, AHCI_GHC_AE);
+    moutl(ctrl->membase + AHCI_GHC, AHCI_GHC_AE | AHCI_GHC_HR);
+    if (ahci_wait(ctrl->membase + AHCI_GHC, AHCI_GHC_HR, 0, AHCI_TIMEOUT) < EOK)
+    {
+        LOGK("ahci reset timeout\n");
+        return -ETIME;
+    }
+    moutl(ctrl->membase + AHCI_GHC, AHCI_GHC_AE);
+
+    u32 cap = minl(ctrl->membase + AHCI_CAP);
+    ctrl->slots = AHCI_CAP_NCS(cap);
+    ctrl->ncq = (cap & AHCI_CAP_SNCQ) != 0;
+    LOGK("ahci version 0x%x slots %d ncq %d\n", minl(ctrl->membase + AHCI_VS), ctrl->slots, ctrl->ncq);
+
+    ahci_interrupt_init(ctrl, device);
+    moutl(ctrl->membase + AHCI_IS, 0xFFFFFFFF);
+    moutl(ctrl->membase + AHCI_GHC, AHCI_GHC_AE | AHCI_GHC_IE);
+    return EOK;
+}
+
+// 注册磁盘和分区，请求队列同时交给磁盘多个请求
+static void ahci_install(ahci_ctrl_t *ctrl)
+{
+    for (size_t i = 0; i < AHCI_PORT_NR; i++)
+    {
+        ahci_port_t *port = ctrl->ports[i];
+        if (!port || !port->total_lba)
+            continue;
+
+        port->dev = device_install(
+            DEV_BLOCK, DEV_SATA_DISK, port, port->name, 0,
+            ahci_ioctl, ahci_read, ahci_write);
+
+        device_t *device = device_get(port->dev);
+        device->sgio = (void *)ahci_sgio;
+        device->queue = (void *)ahci_queue;
+        device->slots = port->slots;
+
+        for (size_t j = 0; j < AHCI_PART_NR; j++)
+        {
+            ahci_part_t *part = &port->parts[j];
+            if (part->count == 0)
+                continue;
+
+            device_install(
+                DEV_BLOCK, DEV_SATA_PART, part, part->name, port->dev,
+                ahci_part_ioctl, ahci_part_read, ahci_part_write);
+        }
+    }
+}
+
+// AHCI 初始化
+void ahci_init()
+{
+    pci_device_t *device = pci_find_device_by_class(PCI_CLASS_STORAGE_AHCI);
+    if (!device)
+    {
+        LOGK("PCI AHCI controller not exists...\n");
+        return;
+    }
+
+    ahci_ctrl_t *ctrl = &controller;
+    if (ahci_ctrl_init(ctrl, device) < EOK)
+        return;
+
+    u16 *buf = (u16 *)alloc_kpage(1);
+    u32 implemented = minl(ctrl->membase + AHCI_PI);
+    for (size_t i = 0; i < AHCI_PORT_NR; i++)
+    {
+        if (implemented & (1 << i))
+            ahci_port_init(ctrl, i, buf);
+    }
+    free_kpage((u32)buf, 1);
+
+    ahci_install(ctrl);
+}
@@ -0,0 +1,221 @@
+#include "hyc.h"
+
+#define LOGK(fmt, args...) DEBUGK(fmt, ##args)
+
+extern u32 jiffy;
+extern void pit_udelay(u32 us);
+extern void clock_tick();
+
+u32 lapic_base = 0;
+u32 ioapic_base = 0;
+
+static u32 lapic_timer_count = 0; // 每个时钟周期 local APIC 定时器的计数
+static u32 msi_next_vector = MSI_VECTOR_BASE;
+
+// MP 表中的中断极性和触发方式
+#define MP_POLARITY_MASK 0x3
+#define MP_POLARITY_HIGH 0x1
+#define MP_POLARITY_LOW 0x3
+#define MP_TRIGGER_MASK 0xC
+#define MP_TRIGGER_EDGE 0x4
+#define MP_TRIGGER_LEVEL 0xC
+
+static u8 irq_pin[16];    // ISA 中断连接的 IOAPIC 引脚
+static u32 irq_flags[16]; // 重定向表项的极性和触发方式
+
+u32 lapic_read(u32 reg)
+{
+    return minl(lapic_base + reg);
+}
+
+void lapic_write(u32 reg, u32 value)
+{
+    moutl(lapic_base + reg, value);
+    // 读取 ID 寄存器，确保写操作已经完成
+    minl(lapic_base + LAPIC_ID);
+}
+
+u32 lapic_id()
+{
+    if (!lapic_base)
+        return 0;
+    return lapic_read(LAPIC_ID) >> 24;
+}
+
+void lapic_eoi()
+{
+    if (lapic_base)
+        lapic_write(LAPIC_EOI, 0);
+}
+
+void lapic_send_ipi(u32 apic_id, u32 icr)
+{
+    lapic_write(LAPIC_ICR_HIGH, apic_id << 24);
+    lapic_write(LAPIC_ICR_LOW, icr);
+    while (lapic_read(LAPIC_ICR_LOW) & LAPIC_ICR_PENDING)
+        ;
+}
+
+// 使用 PIT 测量一个时钟周期内 local APIC 定时器的计数，
+// 各处理器总线频率相同，只需在启动处理器上测量一次
+static void lapic_timer_calibrate()
+{
+    lapic_write(LAPIC_TIMER_DCR, LAPIC_TIMER_DIV16);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_TIMER_ICR, 0xFFFFFFFF);
+
+    pit_udelay(jiffy * 1000);
+
+    lapic_timer_count = 0xFFFFFFFF - lapic_read(LAPIC_TIMER_CCR);
+    lapic_write(LAPIC_TIMER_ICR, 0);
+
+    LOGK("local APIC timer %d counts per jiffy\n", lapic_timer_count);
+}
+
+// local APIC 定时器中断，驱动应用处理器的调度，
+// 使用 IOAPIC 时也作为启动处理器的时钟中断
+static void lapic_timer_handler(int vector)
+{
+    assert(vector == LAPIC_TIMER_VECTOR);
+    lapic_eoi();
+    clock_tick();
+}
+
+// local APIC 错误中断
+static void lapic_error_handler(int vector)
+{
+    assert(vector == LAPIC_ERROR_VECTOR);
+    // 先写再读才能获得最新的错误状态
+    lapic_write(LAPIC_ESR, 0);
+    u32 status = lapic_read(LAPIC_ESR);
+    lapic_eoi();
+    LOGK("local APIC %d error 0x%x\n", lapic_id(), status);
+}
+
+// 伪中断不需要发送中断结束信号
+static void lapic_spurious_handler(int vector)
+{
+    assert(vector == LAPIC_SPURIOUS_VECTOR);
+}
+
+void lapic_timer_start()
+{
+    assert(lapic_timer_count);
+    lapic_write(LAPIC_TIMER_DCR, LAPIC_TIMER_DIV16);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_TIMER_VECTOR | LAPIC_TIMER_PERIODIC);
+    lapic_write(LAPIC_TIMER_ICR, lapic_timer_count);
+}
+
+void lapic_init(bool bsp)
+{
+    assert(lapic_base);
+
+    // 启用 local APIC，并设置伪中断向量
+    lapic_write(LAPIC_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_VECTOR);
+
+    if (bsp)
+    {
+        // 启动处理器继续通过 LINT0 接收 8259 的中断（虚拟线模式）
+        lapic_write(LAPIC_LVT_LINT0, LAPIC_ICR_EXTINT);
+        lapic_write(LAPIC_LVT_LINT1, LAPIC_ICR_NMI);
+
+        set_vector_handler(LAPIC_TIMER_VECTOR, lapic_timer_handler);
+        set_vector_handler(LAPIC_ERROR_VECTOR, lapic_error_handler);
+        set_vector_handler(LAPIC_SPURIOUS_VECTOR, lapic_spurious_handler);
+    }
+    else
+    {
+        lapic_write(LAPIC_LVT_LINT0, LAPIC_LVT_MASKED);
+        lapic_write(LAPIC_LVT_LINT1, LAPIC_LVT_MASKED);
+    }
+
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_LVT_ERROR, LAPIC_ERROR_VECTOR);
+
+    // 清除错误状态和未处理的中断，接收所有优先级的中断
+    lapic_write(LAPIC_ESR, 0);
+    lapic_write(LAPIC_ESR, 0);
+    lapic_write(LAPIC_EOI, 0);
+    lapic_write(LAPIC_TPR, 0);
+
+    if (bsp)
+        lapic_timer_calibrate();
+}
+
+static u32 ioapic_read(u32 reg)
+{
+    moutl(ioapic_base + IOAPIC_REGSEL, reg);
+    return minl(ioapic_base + IOAPIC_WINDOW);
+}
+
+static void ioapic_write(u32 reg, u32 value)
+{
+    moutl(ioapic_base + IOAPIC_REGSEL, reg);
+    moutl(ioapic_base + IOAPIC_WINDOW, value);
+}
+
+u32 msi_alloc_vector()
+{
+    if (!lapic_base || msi_next_vector >= MSI_VECTOR_END)
+        return 0;
+    return msi_next_vector++;
+}
+
+void ioapic_init()
+{
+    if (!ioapic_base)
+        return;
+
+    // 默认 ISA 中断直连同号引脚，上升沿触发
+    for (size_t i = 0; i < 16; i++)
+    {
+        irq_pin[i] = i;
+        irq_flags[i] = 0;
+    }
+
+    u32 count = ((ioapic_read(IOAPIC_REG_VER) >> 16) & 0xFF) + 1;
+    LOGK("IOAPIC 0x%p with %d redirection entries\n", ioapic_base, count);
+
+    // 切换到 IOAPIC 之前先屏蔽所有重定向表项
+    for (size_t i = 0; i < count; i++)
+    {
+        ioapic_write(IOAPIC_REG_TABLE + i * 2, IOAPIC_MASKED);
+        ioapic_write(IOAPIC_REG_TABLE + i * 2 + 1, 0);
+    }
+}
+
+void ioapic_set_irq(u32 irq, u32 pin, u16 flags)
+{
+    assert(irq < 16);
+    irq_pin[irq] = pin;
+    irq_flags[irq] = 0;
+
+    // 默认高电平有效，边沿触发，PCI 总线的默认方式由调用者转换
+    if ((flags & MP_POLARITY_MASK) == MP_POLARITY_LOW)
+        irq_flags[irq] |= IOAPIC_ACTIVE_LOW;
+    if ((flags & MP_TRIGGER_MASK) == MP_TRIGGER_LEVEL)
+        irq_flags[irq] |= IOAPIC_LEVEL;
+}
+
+void ioapic_route(u32 irq, u32 vector, bool masked)
+{
+    assert(irq < 16 && ioapic_base);
+    u32 reg = IOAPIC_REG_TABLE + irq_pin[irq] * 2;
+
+    // 固定投递到启动处理器，物理目的模式
+    ioapic_write(reg + 1, cpus[0].apic_id << 24);
+    ioapic_write(reg, vector | irq_flags[irq] | (masked ? IOAPIC_MASKED : 0));
+}
+
+void ioapic_mask(u32 irq, bool masked)
+{
+    assert(irq < 16 && ioapic_base);
+    u32 reg = IOAPIC_REG_TABLE + irq_pin[irq] * 2;
+
+    u32 value = ioapic_read(reg);
+    if (masked)
+        value |= IOAPIC_MASKED;
+    else
+        value &= ~IOAPIC_MASKED;
+    ioapic_write(reg, value);
+}
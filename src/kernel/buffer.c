@@ -4,12 +4,34 @@
 
 #define BUFFER_DESC_NR 3 // 描述符数量: 1024, 2048, 4096
 
+extern volatile u32 jiffies;
+extern u32 jiffy;
+
 static bdesc_t bdescs[BUFFER_DESC_NR];
 
-// 哈希函数，根据设备和块号生成哈希值
-u32 hash(dev_t dev, idx_t block)
+static task_t *flusher;    // 回写线程
+static lock_t cluster_lock; // 合并写入缓冲的锁
+static char *cluster_data;  // 合并写入缓冲，相邻的脏缓冲复制到这里一次写入
+
+// 等待预读的块
+typedef struct prefetch_t
 {
-    return (dev ^ block) % HASH_COUNT;
+    dev_t dev;
+    idx_t block; // 第一块
+    u32 count;   // 连续的块数
+    size_t size;
+} prefetch_t;
+
+static task_t *prefetcher; // 预读线程
+static prefetch_t prefetch_queue[BUFFER_PREFETCH_NR];
+static u32 prefetch_head;  // 队列中第一个块
+static u32 prefetch_count; // 队列中块的数量
+
+// 哈希函数，根据设备和块号生成哈希值，乘法散列取高位
+static u32 hash(bdesc_t *desc, dev_t dev, idx_t block)
+{
+    u32 key = block ^ ((u32)dev << 24) ^ ((u32)dev >> 8);
+    return (key * 0x9E3779B1) >> (32 - desc->hash_bits);
 }
 
 // 根据大小获取缓冲区描述符
@@ -25,72 +47,135 @@ static bdesc_t *desc_get(int size)
     panic("No buffer for size %d\n", size);
 }
 
-// 从哈希表中查找缓冲区
-static buffer_t *get_from_hash_table(bdesc_t *desc, dev_t dev, idx_t block)
+// 在哈希表中查找缓冲区，不改变缓冲区的状态
+static buffer_t *hash_find(bdesc_t *desc, dev_t dev, idx_t block)
 {
-    u32 idx = hash(dev, block);
+    u32 idx = hash(desc, dev, block);
     list_t *list = &desc->hash_table[idx];
 
     for (list_node_t *node = list->head.next; node != &list->tail; node = node->next)
     {
         buffer_t *buf = element_entry(buffer_t, hnode, node);
         if (buf->dev == dev && buf->block == block)
-        {
-            if (list_search(&desc->idle_list, &buf->rnode))
-            {
-                list_remove(&buf->rnode);
-            }
             return buf;
-        }
     }
 
     return NULL;
 }
 
+// 移出闲置链表
+static void idle_remove(buffer_t *buf)
+{
+    if (!buf->idle)
+        return;
+    list_remove(&buf->rnode);
+    buf->idle = false;
+}
+
+// 从哈希表中查找缓冲区，找到时移出闲置链表
+static buffer_t *get_from_hash_table(bdesc_t *desc, dev_t dev, idx_t block)
+{
+    buffer_t *buf = hash_find(desc, dev, block);
+    if (buf)
+    {
+        idle_remove(buf);
+    }
+    return buf;
+}
+
+// 增加缓冲区的引用，闲置的缓冲区移出闲置链表
+static void bhold(buffer_t *buf)
+{
+    idle_remove(buf);
+    buf->count++;
+}
+
 // 将缓冲区插入哈希表
 static void hash_locate(bdesc_t *desc, buffer_t *buf)
 {
-    u32 idx = hash(buf->dev, buf->block);
-    list_t *list = &desc->hash_table[idx];
-    assert(!list_search(list, &buf->hnode));
-    list_push(list, &buf->hnode);
+    assert(!buf->hashed);
+    u32 idx = hash(desc, buf->dev, buf->block);
+    list_push(&desc->hash_table[idx], &buf->hnode);
+    buf->hashed = true;
 }
 
 // 从哈希表中移除缓冲区
 static void hash_remove(bdesc_t *desc, buffer_t *buf)
 {
-    u32 idx = hash(buf->dev, buf->block);
-    list_t *list = &desc->hash_table[idx];
-    if (buf->hnode.next)
+    if (!buf->hashed)
+        return;
+    list_remove(&buf->hnode);
+    buf->hashed = false;
+}
+
+// 分配 1 << bits 个桶的哈希表
+static list_t *hash_alloc(u32 bits)
+{
+    u32 size = 1 << bits;
+    list_t *table = (list_t *)kmalloc(size * sizeof(list_t));
+    for (size_t i = 0; i < size; i++)
+    {
+        list_init(&table[i]);
+    }
+    return table;
+}
+
+// 缓冲数量超过负载时哈希表扩大一倍，重新散列所有缓冲
+static void hash_grow(bdesc_t *desc)
+{
+    if (desc->count <= (HASH_LOAD_FACTOR << desc->hash_bits))
+        return;
+
+    list_t *old = desc->hash_table;
+    u32 size = 1 << desc->hash_bits;
+
+    desc->hash_bits++;
+    desc->hash_table = hash_alloc(desc->hash_bits);
+
+    for (size_t i = 0; i < size; i++)
     {
-        list_remove(&buf->hnode);
+        while (!list_empty(&old[i]))
+        {
+            buffer_t *buf = element_entry(buffer_t, hnode, list_popback(&old[i]));
+            list_push(&desc->hash_table[hash(desc, buf->dev, buf->block)], &buf->hnode);
+        }
     }
+    kfree(old);
+    LOGK("Buffer %d hash table grows to %d buckets\n", desc->size, 1 << desc->hash_bits);
 }
 
-// 分配缓冲区
+// 分配一页缓冲区，缓冲头在一个数组中一起分配
 static err_t buffer_alloc(bdesc_t *desc)
 {
-    void *addr = alloc_kpage(1);
-    for (size_t left = PAGE_SIZE; left > 0; left -= desc->size, addr += desc->size, desc->count++)
+    u32 nr = PAGE_SIZE / desc->size;
+    void *addr = (void *)alloc_kpage(1);
+    buffer_t *bufs = (buffer_t *)kmalloc(nr * sizeof(buffer_t));
+
+    for (size_t i = 0; i < nr; i++, addr += desc->size, desc->count++)
     {
-        buffer_t *buf = kmalloc(sizeof(buffer_t));
+        buffer_t *buf = &bufs[i];
         buf->desc = desc;
         buf->data = addr;
         buf->dev = EOF;
         buf->block = 0;
         buf->count = 0;
         buf->dirty = false;
+        buf->dirtied = 0;
         buf->valid = false;
+        buf->hashed = false;
+        buf->idle = false;
+        buf->mapped = false;
         lock_init(&buf->lock);
 
         list_push(&desc->free_list, &buf->rnode);
-        LOGK("Allocated buffer of size %d, count %d\n", desc->size, desc->count);
     }
+    LOGK("Allocated buffer of size %d, count %d\n", desc->size, desc->count);
 
+    hash_grow(desc);
     return EOK;
 }
 
-// 获取空闲缓冲区
+// 获取空闲缓冲区，没有空闲的缓冲区时回收最久未使用的闲置缓冲区
 static buffer_t *get_free_buffer(bdesc_t *desc)
 {
     if (desc->count < MAX_BUF_COUNT && list_empty(&desc->free_list))
@@ -98,39 +183,94 @@ static buffer_t *get_free_buffer(bdesc_t *desc)
         buffer_alloc(desc);
     }
 
-    if (!list_empty(&desc->free_list))
+    buffer_t *failed = NULL; // 第一个写入失败放回闲置链表的缓冲
+    while (true)
     {
-        buffer_t *buf = element_entry(buffer_t, rnode, list_popback(&desc->free_list));
+        while (list_empty(&desc->free_list) && list_empty(&desc->idle_list))
+        {
+            task_block(running_task(), &desc->wait_list, TASK_BLOCKED, TIMELESS);
+        }
+
+        // 等待期间其他任务可能放回了没有用上的空闲缓冲
+        if (!list_empty(&desc->free_list))
+        {
+            buffer_t *buf = element_entry(buffer_t, rnode, list_popback(&desc->free_list));
+            hash_remove(desc, buf);
+            buf->valid = false;
+            return buf;
+        }
+
+        buffer_t *buf = element_entry(buffer_t, rnode, list_popback(&desc->idle_list));
+        buf->idle = false;
+
+        // 又取到写入失败的缓冲，说明闲置的缓冲都写入失败了，
+        // 等待一段时间或者有缓冲释放之后再试，避免不停地重试写入
+        if (buf == failed && buf->dirty)
+        {
+            list_push(&desc->idle_list, &buf->rnode);
+            buf->idle = true;
+            failed = NULL;
+            task_block(running_task(), &desc->wait_list, TASK_BLOCKED, BUFFER_FLUSH_INTERVAL);
+            continue;
+        }
+
+        // 闲置的缓冲还没有回写，写入之后才能使用，
+        // 写入期间被其他任务引用或者写入失败，则放回闲置链表换一个
+        if (buf->dirty)
+        {
+            buf->count++;
+            bwrite(buf);
+            if (--buf->count || buf->dirty)
+            {
+                if (!buf->count)
+                {
+                    list_push(&desc->idle_list, &buf->rnode);
+                    buf->idle = true;
+                    if (!failed)
+                        failed = buf;
+                }
+                continue;
+            }
+        }
+
+        if (buf->valid)
+            desc->evictions++;
         hash_remove(desc, buf);
         buf->valid = false;
         return buf;
     }
-
-    while (list_empty(&desc->idle_list))
-    {
-        task_block(running_task(), &desc->wait_list, TASK_BLOCKED, TIMELESS);
-    }
-
-    buffer_t *buf = element_entry(buffer_t, rnode, list_popback(&desc->idle_list));
-    hash_remove(desc, buf);
-    buf->valid = false;
-    return buf;
 }
 
-// 获取设备 dev 和块 block 对应的缓冲区
-static buffer_t *getblk(bdesc_t *desc, dev_t dev, idx_t block)
+// 放回取得之后没有用上的空闲缓冲，唤醒一个等待缓冲的任务
+static void put_free_buffer(bdesc_t *desc, buffer_t *buf)
 {
-    buffer_t *buf = get_from_hash_table(desc, dev, block);
-    if (buf)
+    assert(!buf->hashed && !buf->dirty);
+    buf->dev = EOF;
+    buf->block = 0;
+    list_push(&desc->free_list, &buf->rnode);
+
+    if (!list_empty(&desc->wait_list))
     {
-        buf->count++;
-        return buf;
+        task_t *task = element_entry(task_t, node, list_popback(&desc->wait_list));
+        task_unblock(task, EOK);
     }
+}
 
-    buf = get_free_buffer(desc);
+// 为不在缓存中的块取得新的缓冲，回收闲置缓冲时可能因为回写而阻塞，
+// 期间其他任务已经建立了这个块的缓冲时放回新缓冲并返回 NULL
+static buffer_t *getblk_new(bdesc_t *desc, dev_t dev, idx_t block)
+{
+    buffer_t *buf = get_free_buffer(desc);
     assert(buf->count == 0);
     assert(!buf->dirty);
 
+    if (hash_find(desc, dev, block))
+    {
+        put_free_buffer(desc, buf);
+        return NULL;
+    }
+
+    desc->misses++;
     buf->count = 1;
     buf->dev = dev;
     buf->block = block;
@@ -138,6 +278,78 @@ static buffer_t *getblk(bdesc_t *desc, dev_t dev, idx_t block)
     return buf;
 }
 
+// 内存中的设备不需要复制到缓存页，单独分配缓冲头直接指向设备的内存，
+// 数据总是有效，最后一个引用释放时缓冲头也释放；
+// 设备是否支持映射由安装时设置的 mmap 记录，不支持的设备直接返回
+static buffer_t *getblk_mapped(bdesc_t *desc, dev_t dev, idx_t block)
+{
+    if (!device_get(dev)->mmap)
+        return NULL;
+
+    u32 sector_size = device_ioctl(dev, DEV_CMD_SECTOR_SIZE, 0, 0);
+    if (sector_size > desc->size)
+        return NULL;
+
+    u32 bs = desc->size / sector_size;
+    void *data = device_mmap(dev, block * bs, bs);
+    if (!data)
+        return NULL;
+
+    buffer_t *buf = (buffer_t *)kmalloc(sizeof(buffer_t));
+    buf->desc = desc;
+    buf->data = data;
+    buf->dev = dev;
+    buf->block = block;
+    buf->count = 1;
+    buf->dirty = false;
+    buf->dirtied = 0;
+    buf->valid = true;
+    buf->hashed = false;
+    buf->idle = false;
+    buf->mapped = true;
+    lock_init(&buf->lock);
+
+    hash_locate(desc, buf);
+    return buf;
+}
+
+// 获取设备 dev 和块 block 对应的缓冲区，
+// 取得新缓冲期间这个块已经被其他任务建立时，重新查找使用已有的缓冲
+static buffer_t *getblk(bdesc_t *desc, dev_t dev, idx_t block)
+{
+    while (true)
+    {
+        buffer_t *buf = get_from_hash_table(desc, dev, block);
+        if (buf)
+        {
+            desc->hits++;
+            buf->count++;
+            return buf;
+        }
+
+        buf = getblk_mapped(desc, dev, block);
+        if (buf)
+            return buf;
+
+        buf = getblk_new(desc, dev, block);
+        if (buf)
+            return buf;
+    }
+}
+
+// 获取 dev 的 block 块对应的缓冲区，不从磁盘读取，用于整块覆盖写，
+// 正在读入的缓冲等待读取结束，否则读入的数据会覆盖调用者写入的数据
+buffer_t *bget(dev_t dev, idx_t block, size_t size)
+{
+    buffer_t *buf = getblk(desc_get(size), dev, block);
+    assert(buf != NULL);
+
+    lock_acquire(&buf->lock);
+    buf->valid = true;
+    lock_release(&buf->lock);
+    return buf;
+}
+
 // 读取 dev 的 block 块
 buffer_t *bread(dev_t dev, idx_t block, size_t size)
 {
@@ -177,42 +389,176 @@ rollback:
     return NULL;
 }
 
-// 写缓冲区
+// 一次请求最多合并的块数，受合并缓冲大小和请求的扇区数量限制
+static u32 cluster_max(bdesc_t *desc, u32 block_sector)
+{
+    return MIN(BUFFER_CLUSTER_SIZE / desc->size, 0xff / block_sector);
+}
+
+// 读取 dev 从 block 开始的 count 块，只返回第一块的缓冲，
+// 之后连续的不在缓存中的块读入合并缓冲，一次请求之后分散复制到各自的缓冲
+buffer_t *bread_cluster(dev_t dev, idx_t block, u32 count, size_t size)
+{
+    bdesc_t *desc = desc_get(size);
+    buffer_t *buf = getblk(desc, dev, block);
+    if (buf->valid)
+        return buf;
+    if (count <= 1)
+    {
+        brelse(buf);
+        return bread(dev, block, size);
+    }
+
+    lock_acquire(&cluster_lock);
+    lock_acquire(&buf->lock);
+
+    // 等待锁期间可能已经被其他任务读入
+    if (buf->valid)
+    {
+        lock_release(&buf->lock);
+        lock_release(&cluster_lock);
+        return buf;
+    }
+
+    u32 sector_size = device_ioctl(dev, DEV_CMD_SECTOR_SIZE, 0, 0);
+    if (sector_size > size)
+    {
+        lock_release(&buf->lock);
+        lock_release(&cluster_lock);
+        brelse(buf);
+        return NULL;
+    }
+
+    u32 block_sector = size / sector_size;
+    count = MIN(count, cluster_max(desc, block_sector));
+
+    // 遇到已经在缓存中的块就停止，它可能有新的数据或者正在被读写
+    buffer_t *cluster[BUFFER_CLUSTER_SIZE / 1024];
+    cluster[0] = buf;
+    u32 nr = 1;
+    while (nr < count && !hash_find(desc, dev, block + nr))
+    {
+        // 没有空闲或闲置的缓冲时不再扩大，避免持有合并缓冲的锁时等待其他任务释放缓冲
+        if (desc->count >= MAX_BUF_COUNT &&
+            list_empty(&desc->free_list) && list_empty(&desc->idle_list))
+            break;
+
+        // 回收脏的闲置缓冲时仍会阻塞，期间这个块可能已经被其他任务建立，此时到此为止
+        buffer_t *ptr = getblk_new(desc, dev, block + nr);
+        if (!ptr)
+            break;
+        lock_acquire(&ptr->lock);
+        cluster[nr++] = ptr;
+    }
+
+    int ret = device_request(dev, cluster_data, nr * block_sector, block * block_sector, 0, REQ_READ);
+
+    for (size_t i = 0; i < nr; i++)
+    {
+        buffer_t *ptr = cluster[i];
+        if (ret >= EOK && !ptr->valid)
+        {
+            memcpy(ptr->data, cluster_data + i * size, size);
+            ptr->valid = true;
+        }
+        lock_release(&ptr->lock);
+        if (i > 0)
+            brelse(ptr);
+    }
+    lock_release(&cluster_lock);
+
+    if (ret < EOK)
+    {
+        brelse(buf);
+        return NULL;
+    }
+    return buf;
+}
+
+// 写缓冲区，前后相邻的脏缓冲复制到合并缓冲中一次写入
 err_t bwrite(buffer_t *buf)
 {
     assert(buf != NULL);
     if (!buf->dirty)
         return EOK;
 
+    lock_acquire(&cluster_lock);
+
+    // 等待锁期间可能已经被其他任务写入
+    if (!buf->dirty)
+    {
+        lock_release(&cluster_lock);
+        return EOK;
+    }
+
     bdesc_t *desc = buf->desc;
     u32 block_size = desc->size;
     u32 sector_size = device_ioctl(buf->dev, DEV_CMD_SECTOR_SIZE, 0, 0);
     u32 block_sector = block_size / sector_size;
-    int ret = device_request(buf->dev, buf->data, block_sector, buf->block * block_sector, 0, REQ_WRITE);
+    u32 max = cluster_max(desc, block_sector);
 
-    if (ret < 0)
-        return ret;
+    // 向前找到连续脏缓冲的起点
+    idx_t start = buf->block;
+    while (start > 0 && buf->block - start + 1 < max)
+    {
+        buffer_t *prev = hash_find(desc, buf->dev, start - 1);
+        if (!prev || !prev->dirty)
+            break;
+        start--;
+    }
 
-    bdirty(buf, false);
-    buf->valid = true;
-    return ret;
+    // 复制到合并缓冲，写入期间再次修改的缓冲会重新变脏
+    buffer_t *cluster[BUFFER_CLUSTER_SIZE / 1024];
+    u32 count = 0;
+    for (idx_t block = start; count < max; block++)
+    {
+        buffer_t *ptr = hash_find(desc, buf->dev, block);
+        if (!ptr || !ptr->dirty)
+            break;
+        bhold(ptr);
+        memcpy(cluster_data + count * block_size, ptr->data, block_size);
+        bdirty(ptr, false);
+        cluster[count++] = ptr;
+    }
+    assert(count > 0);
+
+    int ret = device_request(
+        buf->dev, cluster_data, count * block_sector, start * block_sector, 0, REQ_WRITE);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (ret < EOK)
+            bdirty(cluster[i], true);
+        else
+            cluster[i]->valid = true;
+        brelse(cluster[i]);
+    }
+
+    lock_release(&cluster_lock);
+    return ret < EOK ? ret : EOK;
 }
 
-// 释放缓冲区
+// 释放缓冲区，脏缓冲留在缓存中由回写线程写入
 err_t brelse(buffer_t *buf)
 {
     if (!buf)
         return EOK;
 
-    int ret = bwrite(buf);
-
     buf->count--;
     assert(buf->count >= 0);
     if (buf->count) // 仍有其他用户占用，直接返回
-        return ret;
+        return EOK;
 
     bdesc_t *desc = buf->desc;
+    if (buf->mapped)
+    {
+        hash_remove(desc, buf);
+        kfree(buf);
+        return EOK;
+    }
+
     list_push(&desc->idle_list, &buf->rnode);
+    buf->idle = true;
 
     if (!list_empty(&desc->wait_list))
     {
@@ -222,10 +568,143 @@ err_t brelse(buffer_t *buf)
     return EOK;
 }
 
-// 设置缓冲区的脏标记
+// 设置缓冲区的脏标记，变脏的缓冲加入脏缓冲链表，脏缓冲过多时唤醒回写线程
 err_t bdirty(buffer_t *buf, bool dirty)
 {
+    // 直接修改的是设备的内存，不需要回写
+    if (buf->mapped || buf->dirty == dirty)
+        return EOK;
+
+    bdesc_t *desc = buf->desc;
     buf->dirty = dirty;
+    if (!dirty)
+    {
+        list_remove(&buf->dnode);
+        desc->dirty--;
+        return EOK;
+    }
+
+    buf->dirtied = jiffies;
+    list_push(&desc->dirty_list, &buf->dnode);
+    desc->dirty++;
+
+    if (desc->dirty * 100 > desc->count * BUFFER_DIRTY_RATIO &&
+        flusher && flusher->state == TASK_WAITING)
+    {
+        task_unblock(flusher, EOK);
+    }
+    return EOK;
+}
+
+// 写入最早变脏的缓冲，以及与它相邻的脏缓冲
+static err_t bflush_oldest(bdesc_t *desc, dev_t dev)
+{
+    list_t *list = &desc->dirty_list;
+    for (list_node_t *node = list->tail.prev; node != &list->head; node = node->prev)
+    {
+        buffer_t *buf = element_entry(buffer_t, dnode, node);
+        if (dev != EOF && buf->dev != dev)
+            continue;
+
+        bhold(buf);
+        err_t ret = bwrite(buf);
+        brelse(buf);
+        return ret;
+    }
+    return -ENOENT;
+}
+
+err_t bsync(dev_t dev)
+{
+    for (size_t i = 0; i < BUFFER_DESC_NR; i++)
+    {
+        bdesc_t *desc = &bdescs[i];
+        while (true)
+        {
+            // 每次写入后链表都会变化，重新从最早的开始查找
+            err_t ret = bflush_oldest(desc, dev);
+            if (ret == -ENOENT)
+                break;
+            if (ret < EOK)
+                return ret;
+        }
+    }
+    return EOK;
+}
+
+// 回写线程，写入超时的脏缓冲，并在脏缓冲过多时把比例降下来
+static void buffer_flush_thread()
+{
+    while (true)
+    {
+        for (size_t i = 0; i < BUFFER_DESC_NR; i++)
+        {
+            bdesc_t *desc = &bdescs[i];
+            while (!list_empty(&desc->dirty_list))
+            {
+                buffer_t *buf = element_entry(buffer_t, dnode, desc->dirty_list.tail.prev);
+                bool expired = (jiffies - buf->dirtied) * jiffy >= BUFFER_DIRTY_EXPIRE;
+                bool excess = desc->dirty * 100 > desc->count * BUFFER_DIRTY_BACKGROUND;
+                if (!expired && !excess)
+                    break;
+                if (bflush_oldest(desc, EOF) < EOK)
+                    break;
+            }
+        }
+        task_block(flusher, NULL, TASK_WAITING, BUFFER_FLUSH_INTERVAL);
+    }
+}
+
+// 预读只是提示，第一块已经在缓存中或者队列已满时直接忽略
+err_t bprefetch(dev_t dev, idx_t block, u32 count, size_t size)
+{
+    if (hash_find(desc_get(size), dev, block))
+        return EOK;
+    if (prefetch_count == BUFFER_PREFETCH_NR)
+        return -EBUSY;
+
+    prefetch_t *item = &prefetch_queue[(prefetch_head + prefetch_count) % BUFFER_PREFETCH_NR];
+    item->dev = dev;
+    item->block = block;
+    item->count = count;
+    item->size = size;
+    prefetch_count++;
+
+    if (prefetcher && prefetcher->state == TASK_WAITING)
+        task_unblock(prefetcher, EOK);
+    return EOK;
+}
+
+// 预读线程，依次读入队列中的块，读取期间访问同一块的任务在缓冲锁上等待
+static void buffer_prefetch_thread()
+{
+    while (true)
+    {
+        while (prefetch_count)
+        {
+            prefetch_t item = prefetch_queue[prefetch_head];
+            prefetch_head = (prefetch_head + 1) % BUFFER_PREFETCH_NR;
+            prefetch_count--;
+            brelse(bread_cluster(item.dev, item.block, item.count, item.size));
+        }
+        task_block(prefetcher, NULL, TASK_WAITING, TIMELESS);
+    }
+}
+
+int sys_sync()
+{
+    return bsync(EOF);
+}
+
+void buffer_stat()
+{
+    for (size_t i = 0; i < BUFFER_DESC_NR; i++)
+    {
+        bdesc_t *desc = &bdescs[i];
+        LOGK("Buffer %d: count %d dirty %d buckets %d hits %d misses %d evictions %d\n",
+             desc->size, desc->count, desc->dirty, 1 << desc->hash_bits,
+             desc->hits, desc->misses, desc->evictions);
+    }
 }
 
 // 初始化缓冲区管理系统
@@ -244,11 +723,23 @@ void buffer_init()
         list_init(&desc->free_list);  // 初始化空闲链表
         list_init(&desc->idle_list);  // 初始化闲置链表
         list_init(&desc->wait_list);  // 初始化等待链表
+        list_init(&desc->dirty_list); // 初始化脏缓冲链表
+        desc->dirty = 0;
 
-        // 初始化哈希表
-        for (size_t j = 0; j < HASH_COUNT; j++)
-        {
-            list_init(&desc->hash_table[j]);
-        }
+        // 初始化哈希表，随缓冲数量增长
+        desc->hash_bits = HASH_INIT_BITS;
+        desc->hash_table = hash_alloc(desc->hash_bits);
+
+        desc->hits = 0;
+        desc->misses = 0;
+        desc->evictions = 0;
     }
+
+    lock_init(&cluster_lock);
+    cluster_data = (char *)alloc_kpage(div_round_up(BUFFER_CLUSTER_SIZE, PAGE_SIZE));
+    flusher = task_create(buffer_flush_thread, "flusher", 5, KERNEL_USER);
+
+    prefetch_head = 0;
+    prefetch_count = 0;
+    prefetcher = task_create(buffer_prefetch_thread, "prefetch", 5, KERNEL_USER);
 }
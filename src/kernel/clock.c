@@ -42,28 +42,41 @@ void start_beep()
     }
 }
 
-// 时钟中断处理程序
-void clock_handler(int vector)
+// 时钟节拍，由 PIT 或 local APIC 定时器中断调用
+void clock_tick()
 {
-    assert(vector == 0x20); // 确认中断向量为时钟中断
-    send_eoi(vector); // 发送中断结束信号
-
-    jiffies++; // 增加时钟计数
-    // DEBUGK("clock jiffies %d ...\n", jiffies);
+    // 系统时间和定时器只由引导处理器维护
+    if (this_cpu()->id == 0)
+    {
+        jiffies++; // 增加时钟计数
+        vdso_update();
+        // DEBUGK("clock jiffies %d ...\n", jiffies);
 
-    timer_wakeup(); // 唤醒任何等待的定时器任务
+        timer_wakeup(); // 唤醒任何等待的定时器任务
+    }
 
     task_t *current_task = running_task();
     assert(current_task->magic == ONIX_MAGIC);
 
     current_task->jiffies = jiffies;
-    current_task->ticks--;
-    if (current_task->ticks == 0)
+    if (sched_tick(current_task))
     {
-        schedule(); // 调度下一个任务
+        // 打断了软中断，推迟到中断返回时调度
+        if (in_softirq())
+            current_task->flags |= TASK_NEED_RESCHED;
+        else
+            schedule(); // 调度下一个任务
     }
 }
 
+// 时钟中断处理程序
+void clock_handler(int vector)
+{
+    assert(vector == 0x20); // 确认中断向量为时钟中断
+    send_eoi(vector); // 发送中断结束信号
+    clock_tick();
+}
+
 // 系统启动时间（外部变量）
 extern u32 startup_time;
 
@@ -87,6 +100,33 @@ void pit_init()
     outb(PIT_CHANNEL_2, (u8)(BEEP_TICK >> 8));
 }
 
+// 使用 PIT 通道 2 忙等待 us 微秒，最长约 54 毫秒，
+// 用于时钟中断不可用时的短延时，结束后恢复蜂鸣器设置
+void pit_udelay(u32 us)
+{
+    u32 count = OSCILLATOR_FREQUENCY / 1000 * us / 1000;
+    if (count == 0)
+        count = 1;
+    if (count > 0xffff)
+        count = 0xffff;
+
+    // 关闭门控和扬声器，通道 2 设置为计数结束中断模式
+    outb(SPEAKER_CONTROL, inb(SPEAKER_CONTROL) & 0xfc);
+    outb(PIT_CONTROL, 0b10110000);
+    outb(PIT_CHANNEL_2, count & 0xff);
+    outb(PIT_CHANNEL_2, (count >> 8) & 0xff);
+
+    // 打开门控开始计数，计数结束时输出位变高
+    outb(SPEAKER_CONTROL, inb(SPEAKER_CONTROL) | 0b01);
+    while (!(inb(SPEAKER_CONTROL) & 0x20))
+        ;
+
+    outb(SPEAKER_CONTROL, inb(SPEAKER_CONTROL) & 0xfc);
+    outb(PIT_CONTROL, 0b10110110);
+    outb(PIT_CHANNEL_2, (u8)BEEP_TICK);
+    outb(PIT_CHANNEL_2, (u8)(BEEP_TICK >> 8));
+}
+
 // 初始化时钟
 void clock_init()
 {
@@ -47,3 +47,21 @@ void cpu_version(cpu_version_t *version_info)
           "=d"(info[3])   // EDX 寄存器值
         : "a"(1));        // CPUID 功能号 1
 }
+
+// 读取模型特定寄存器
+u64 rdmsr(u32 msr)
+{
+    u32 low, high;
+    asm volatile("rdmsr\n"
+                 : "=a"(low), "=d"(high)
+                 : "c"(msr));
+    return ((u64)high << 32) | low;
+}
+
+// 写入模型特定寄存器
+void wrmsr(u32 msr, u64 value)
+{
+    asm volatile("wrmsr\n" ::"c"(msr),
+                 "a"((u32)value),
+                 "d"((u32)(value >> 32)));
+}
@@ -2,7 +2,13 @@
 
 #define LOGK(fmt, args...) DEBUGK(fmt, ##args)
 
-static device_t devices[DEVICE_NR]; // 设备数组
+extern volatile u32 jiffies;
+extern u32 jiffy;
+
+#define ELEVATOR_NR 2 // 电梯调度算法数量
+
+static device_t devices[DEVICE_NR];       // 设备数组
+static elevator_t elevators[ELEVATOR_NR]; // 电梯调度算法，第一个为默认算法
 
 // 获取空设备
 static device_t *get_null_device()
@@ -52,6 +58,28 @@ int device_write(dev_t dev, void *buf, size_t count, idx_t idx, int flags)
     return -ENOSYS; // 否则报错
 }
 
+// 查询设备就绪事件
+int device_poll(dev_t dev, poll_table_t *pt)
+{
+    device_t *device = device_get(dev);
+    if (device->poll)
+    {
+        return device->poll(device->ptr, pt);
+    }
+    return POLLIN | POLLOUT;
+}
+
+// 获取内存中的块设备扇区的地址
+void *device_mmap(dev_t dev, idx_t idx, size_t count)
+{
+    device_t *device = device_get(dev);
+    if (device->mmap)
+    {
+        return device->mmap(device->ptr, idx, count);
+    }
+    return NULL;
+}
+
 // 安装设备
 dev_t device_install(
     int type, int subtype,
@@ -86,9 +114,25 @@ void device_init()
         device->ioctl = NULL; // 空指针
         device->read = NULL; // 空指针
         device->write = NULL; // 空指针
+        device->poll = NULL;  // 空指针
+        device->sgio = NULL;  // 空指针
+        device->queue = NULL; // 空指针
+        device->kick = NULL;  // 空指针
+        device->mmap = NULL;  // 空指针
 
         list_init(&device->request_list);
+        list_init(&device->fifo_list[REQ_READ]);
+        list_init(&device->fifo_list[REQ_WRITE]);
         device->direct = DIRECT_UP;
+        device->head = 0;
+        device->elevator = &elevators[0];
+        device->nr_requests = 0;
+        device->depth = REQ_QUEUE_DEPTH;
+        list_init(&device->wait_list);
+        device->worker = NULL;
+        device->slots = 1;
+        device->inflight = 0;
+        list_init(&device->done_list);
     }
 }
 
@@ -116,107 +160,445 @@ device_t *device_get(dev_t dev) // 设备号
     return &devices[dev]; // 返回设备
 }
 
-// 执行块设备请求
-static int do_request(request_t *req)
+// 同步请求的等待状态
+typedef struct request_sync_t
+{
+    task_t *task; // 等待的任务
+    err_t ret;    // 读写结果
+    bool done;    // 是否已经完成
+    bool waiting; // 任务是否正在阻塞
+} request_sync_t;
+
+// 按请求的类型读写设备
+static int do_transfer(request_t *req, void *buf)
 {
-    LOGK("dev %d do request idx %d\n", req->dev, req->idx);
+    LOGK("dev %d do request idx %d count %d\n", req->dev, req->idx, req->count);
 
     switch (req->type)
     {
     case REQ_READ: // 执行设备读
-        return device_read(req->dev, req->buf, req->count, req->idx, req->flags);
-        break;
+        return device_read(req->dev, buf, req->count, req->idx, req->flags);
     case REQ_WRITE: // 执行设备写
-        return device_write(req->dev, req->buf, req->count, req->idx, req->flags);
-        break;
+        return device_write(req->dev, buf, req->count, req->idx, req->flags);
     default:
-        panic("req type %d unknown!!!");
-        break;
+        panic("req type %d unknown!!!", req->type);
+    }
+}
+
+// 每一段作为一个缓冲区，由设备分散聚集读写
+static int do_sgio(device_t *device, request_t *req, u32 sector_size)
+{
+    int iovcnt = 0;
+    for (bio_t *bio = req->bio; bio; bio = bio->next)
+        iovcnt++;
+
+    iovec_t *iov = (iovec_t *)kmalloc(iovcnt * sizeof(iovec_t));
+    iovec_t *ptr = iov;
+    for (bio_t *bio = req->bio; bio; bio = bio->next, ptr++)
+    {
+        ptr->base = bio->buf;
+        ptr->size = bio->count * sector_size;
+    }
+
+    int ret = device->sgio(device->ptr, iov, iovcnt, req->idx, req->type);
+    kfree(iov);
+    return ret;
+}
+
+// 执行块设备请求，合并过的请求由设备分散聚集读写，
+// 设备不支持时经过一块连续的内存一次读写
+static int do_request(request_t *req)
+{
+    bio_t *bio = req->bio;
+    if (!bio->next)
+        return do_transfer(req, bio->buf);
+
+    u32 sector_size = device_ioctl(req->dev, DEV_CMD_SECTOR_SIZE, 0, 0);
+
+    device_t *device = device_get(req->dev);
+    if (device->sgio)
+    {
+        int ret = do_sgio(device, req, sector_size);
+        if (ret != -ENOSYS && ret != -EINVAL)
+            return ret;
+    }
+    u32 pages = div_round_up(req->count * sector_size, PAGE_SIZE);
+    u8 *data = (u8 *)alloc_kpage(pages);
+
+    if (req->type == REQ_WRITE)
+    {
+        for (bio = req->bio; bio; bio = bio->next)
+            memcpy(data + (bio->idx - req->idx) * sector_size, bio->buf, bio->count * sector_size);
+    }
+
+    int ret = do_transfer(req, data);
+
+    if (req->type == REQ_READ && ret >= EOK)
+    {
+        for (bio = req->bio; bio; bio = bio->next)
+            memcpy(bio->buf, data + (bio->idx - req->idx) * sector_size, bio->count * sector_size);
     }
+
+    free_kpage((u32)data, pages);
+    return ret;
+}
+
+// 从队列中取出请求
+static request_t *request_take(request_t *req)
+{
+    list_remove(&req->node);
+    list_remove(&req->fifo);
+    return req;
+}
+
+// 请求加入按扇区排序的链表和按提交顺序的链表
+static void elv_add(device_t *device, request_t *req)
+{
+    list_insert_sort(&device->request_list, &req->node, element_node_offset(request_t, node, idx));
+    list_push(&device->fifo_list[req->type], &req->fifo);
 }
 
-// 获得下一个请求
-static request_t *request_nextreq(device_t *device, request_t *req)
+// 电梯算法，沿当前方向取得最近的请求，这个方向上没有请求时掉头
+static request_t *scan_next(device_t *device)
 {
     list_t *list = &device->request_list;
+    if (list_empty(list))
+        return NULL;
 
-    if ((device->direct == DIRECT_UP && req->node.next == &list->tail) ||
-        (device->direct == DIRECT_DOWN && req->node.prev == &list->head))
-    {  // 如果“向上”且下一个请求到结尾则改成“向下”
-       // 如果“向下”且下一个请求到开头则改成“向上”
+    while (true)
+    {
+        if (device->direct == DIRECT_UP)
+        {
+            for (list_node_t *node = list->head.next; node != &list->tail; node = node->next)
+            {
+                request_t *req = element_entry(request_t, node, node);
+                if (req->idx >= device->head)
+                    return request_take(req);
+            }
+        }
+        else
+        {
+            for (list_node_t *node = list->tail.prev; node != &list->head; node = node->prev)
+            {
+                request_t *req = element_entry(request_t, node, node);
+                if (req->idx < device->head)
+                    return request_take(req);
+            }
+        }
         device->direct = (device->direct == DIRECT_UP) ? DIRECT_DOWN : DIRECT_UP;
     }
+}
+
+// 期限算法，先执行超过期限的请求，读请求优先，
+// 没有超过期限的请求时从最后的位置向上单向扫描
+static request_t *deadline_next(device_t *device)
+{
+    list_t *list = &device->request_list;
+    if (list_empty(list))
+        return NULL;
 
-    // 得到 next
-    list_node_t *next = (device->direct == DIRECT_UP) ? req->node.next : req->node.prev;
+    u32 types[2] = {REQ_READ, REQ_WRITE};
+    for (size_t i = 0; i < 2; i++)
+    {
+        list_t *fifo = &device->fifo_list[types[i]];
+        if (list_empty(fifo))
+            continue;
+        request_t *req = element_entry(request_t, fifo, fifo->tail.prev);
+        if ((int)(jiffies - req->deadline) >= 0)
+            return request_take(req);
+    }
 
-    if (next == &list->head || next == &list->tail)
+    for (list_node_t *node = list->head.next; node != &list->tail; node = node->next)
     {
-        return NULL; // 结束
+        request_t *req = element_entry(request_t, node, node);
+        if (req->idx >= device->head)
+            return request_take(req);
     }
+    return request_take(element_entry(request_t, node, list->head.next));
+}
+
+static elevator_t elevators[ELEVATOR_NR] = {
+    {"scan", elv_add, scan_next},
+    {"deadline", elv_add, deadline_next},
+};
+
+// 与队列中前后相邻的请求合并，合并成功返回 true
+static bool request_merge(device_t *device, bio_t *bio, int flags, u32 type)
+{
+    list_t *list = &device->request_list;
+    for (list_node_t *node = list->head.next; node != &list->tail; node = node->next)
+    {
+        request_t *req = element_entry(request_t, node, node);
+        if (req->type != type || req->flags != flags)
+            continue;
+        if (req->count + bio->count > REQ_MAX_SECTORS)
+            continue;
 
-    return element_entry(request_t, node, next); // 得到请求，返回指针
+        if (req->idx + req->count == bio->idx)
+        {
+            req->biotail->next = bio;
+            req->biotail = bio;
+            req->count += bio->count;
+            return true;
+        }
+        if (bio->idx + bio->count == req->idx)
+        {
+            bio->next = req->bio;
+            req->bio = bio;
+            req->idx = bio->idx;
+            req->count += bio->count;
+            return true;
+        }
+    }
+    return false;
 }
 
-// 块设备请求
-// "dev"：访问的设备 
-// "*buf"：缓冲区
-// "count"：扇区数量
-// "idx"：扇区开始的位置
+// 当前请求线程对应的设备
+static device_t *worker_device()
+{
+    task_t *task = running_task();
+    for (size_t i = 0; i < DEVICE_NR; i++)
+    {
+        if (devices[i].worker == task)
+            return &devices[i];
+    }
+    panic("no device for worker %s!!!", task->name);
+}
+
+// 按电梯算法取出下一个请求，唤醒等待队列空位的任务
+static request_t *request_next(device_t *device)
+{
+    request_t *req = device->elevator->next(device);
+    if (!req)
+        return NULL;
+
+    device->nr_requests--;
+    if (!list_empty(&device->wait_list))
+    {
+        task_t *task = element_entry(task_t, node, list_popback(&device->wait_list));
+        task_unblock(task, EOK);
+    }
+    device->head = req->idx + req->count;
+    return req;
+}
+
+// 请求完成，调用每一段的回调
+static void request_end(request_t *req, err_t ret)
+{
+    for (bio_t *bio = req->bio; bio;)
+    {
+        bio_t *next = bio->next;
+        bio->next = NULL;
+        bio->end(bio, ret);
+        bio = next;
+    }
+    kfree(req);
+}
+
+// 把请求交给驱动异步执行，直到驱动的槽位用完，之后一次通知驱动，
+// 驱动不能直接执行的请求（-EINVAL）经过连续的内存同步执行
+static bool request_dispatch(device_t *device)
+{
+    bool busy = false;
+    while (device->inflight < device->slots)
+    {
+        request_t *req = request_next(device);
+        if (!req)
+            break;
+
+        busy = true;
+        device->inflight++;
+        err_t ret = device->queue(device->ptr, req);
+        if (ret < EOK)
+        {
+            device->inflight--;
+            if (ret == -EINVAL)
+                ret = do_request(req);
+            request_end(req, ret);
+        }
+    }
+    if (busy && device->kick)
+        device->kick(device->ptr);
+    return busy;
+}
+
+// 请求线程，按电梯算法依次执行请求，完成后调用每一段的回调，
+// 驱动支持异步执行时同时交给驱动多个请求
+static void device_worker()
+{
+    device_t *device = worker_device();
+    while (true)
+    {
+        if (!list_empty(&device->done_list))
+        {
+            request_t *req = element_entry(request_t, node, list_popback(&device->done_list));
+            device->inflight--;
+            request_end(req, req->ret);
+            continue;
+        }
+
+        if (device->queue)
+        {
+            if (!request_dispatch(device))
+                task_block(device->worker, NULL, TASK_WAITING, TIMELESS);
+            continue;
+        }
+
+        request_t *req = request_next(device);
+        if (!req)
+        {
+            task_block(device->worker, NULL, TASK_WAITING, TIMELESS);
+            continue;
+        }
+        request_end(req, do_request(req));
+    }
+}
+
+// 唤醒空闲的请求线程
+static void worker_wakeup(device_t *device)
+{
+    if (!device->worker)
+        device->worker = task_create(device_worker, device->name, 5, KERNEL_USER);
+    else if (device->worker->state == TASK_WAITING)
+        task_unblock(device->worker, EOK);
+}
+
+// 驱动完成异步请求，请求放入完成链表，由请求线程执行回调
+void device_complete(request_t *req, err_t ret)
+{
+    device_t *device = device_get(req->dev);
+    req->ret = ret;
+    list_push(&device->done_list, &req->node);
+    worker_wakeup(device);
+}
+
+// 异步块设备请求
+// "dev"：访问的设备
+// "bio"：要读写的扇区和缓冲区，完成之前不能释放
 // "type"：访问的类型
-err_t device_request(dev_t dev, void *buf, u8 count, idx_t idx, int flags, u32 type)
+err_t device_submit(dev_t dev, bio_t *bio, int flags, u32 type)
 {
     device_t *device = device_get(dev);
-    assert(device->type = DEV_BLOCK); // 是块设备
-    idx_t offset = idx + device_ioctl(device->dev, DEV_CMD_SECTOR_START, 0, 0); // "offset"：磁盘扇区的位置
+    assert(device->type == DEV_BLOCK); // 是块设备
+    assert(bio->count > 0 && bio->count <= REQ_MAX_SECTORS);
+
+    // 转换成磁盘扇区的位置
+    bio->idx += device_ioctl(device->dev, DEV_CMD_SECTOR_START, 0, 0);
+    bio->next = NULL;
 
     if (device->parent) // 如果有父设备则找到其磁盘，对磁盘进行操作
     {
         device = device_get(device->parent);
     }
 
-    // 申请一块内存用来存放请求的参数
+    // 队列已满时等待，等待之后可能可以合并
+    while (true)
+    {
+        if (request_merge(device, bio, flags, type))
+            return EOK;
+        if (device->nr_requests < device->depth)
+            break;
+        task_block(running_task(), &device->wait_list, TASK_BLOCKED, TIMELESS);
+    }
+
     request_t *req = kmalloc(sizeof(request_t));
     memset(req, 0, sizeof(request_t));
 
-    // 给参数赋值
     req->dev = device->dev;
-    req->buf = buf;
-    req->count = count;
-    req->idx = offset;
-    req->flags = flags;
     req->type = type;
-    req->task = NULL;
+    req->idx = bio->idx;
+    req->count = bio->count;
+    req->flags = flags;
+    req->bio = bio;
+    req->biotail = bio;
+
+    u32 expire = (type == REQ_READ) ? REQ_READ_EXPIRE : REQ_WRITE_EXPIRE;
+    req->deadline = jiffies + expire / jiffy;
 
     LOGK("dev %d request idx %d\n", req->dev, req->idx);
 
-    // 判断列表是否为空
-    bool empty = list_empty(&device->request_list);
+    device->elevator->add(device, req);
+    device->nr_requests++;
 
-    // 将请求插入链表
-    list_insert_sort(&device->request_list, &req->node, element_node_offset(request_t, node, idx));
+    worker_wakeup(device);
+    return EOK;
+}
 
-    // 如果列表不为空，则阻塞，因为已经有请求在处理了，等待处理完成；
-    if (!empty)
+// 同步请求完成，唤醒等待的任务
+static void request_sync_end(bio_t *bio, err_t ret)
+{
+    request_sync_t *sync = (request_sync_t *)bio->private;
+    sync->ret = ret;
+    sync->done = true;
+    if (sync->waiting)
     {
-        req->task = running_task();
-        assert(task_block(req->task, NULL, TASK_BLOCKED, TIMELESS) == EOK);
+        sync->waiting = false;
+        task_unblock(sync->task, EOK);
     }
+}
+
+// 块设备请求
+// "dev"：访问的设备
+// "*buf"：缓冲区
+// "count"：扇区数量
+// "idx"：扇区开始的位置
+// "type"：访问的类型
+err_t device_request(dev_t dev, void *buf, u8 count, idx_t idx, int flags, u32 type)
+{
+    request_sync_t sync;
+    sync.task = running_task();
+    sync.ret = EOK;
+    sync.done = false;
+    sync.waiting = false;
 
-    // 执行请求
-    err_t ret = do_request(req);
+    bio_t bio;
+    bio.buf = buf;
+    bio.idx = idx;
+    bio.count = count;
+    bio.end = request_sync_end;
+    bio.private = &sync;
 
-    request_t *nextreq = request_nextreq(device, req);
+    device_submit(dev, &bio, flags, type);
 
-    // 将 node 从链表中移除
-    list_remove(&req->node);
-    kfree(req);
+    // 完成回调在请求线程中执行，提交之后才可能完成
+    while (!sync.done)
+    {
+        sync.waiting = true;
+        task_block(sync.task, NULL, TASK_BLOCKED, TIMELESS);
+    }
+    return sync.ret;
+}
+
+// 设置块设备的电梯调度算法
+err_t device_elevator(dev_t dev, char *name)
+{
+    device_t *device = device_get(dev);
+    if (device->type != DEV_BLOCK || device->parent)
+        return -EINVAL;
 
-    if (nextreq)
+    for (size_t i = 0; i < ELEVATOR_NR; i++)
     {
-        assert(nextreq->task->magic == ONIX_MAGIC);
-        task_unblock(nextreq->task, EOK); // 唤醒进程
+        if (!strcmp(elevators[i].name, name))
+        {
+            device->elevator = &elevators[i];
+            return EOK;
+        }
     }
+    return -EINVAL;
+}
 
-    return ret;
-}
\ No newline at end of file
+// 设置块设备的队列深度，增大时唤醒等待的任务
+err_t device_queue_depth(dev_t dev, u32 depth)
+{
+    device_t *device = device_get(dev);
+    if (device->type != DEV_BLOCK || device->parent || !depth)
+        return -EINVAL;
+
+    device->depth = depth;
+    while (device->nr_requests < device->depth && !list_empty(&device->wait_list))
+    {
+        task_t *task = element_entry(task_t, node, list_popback(&device->wait_list));
+        task_unblock(task, EOK);
+    }
+    return EOK;
+}
@@ -224,6 +224,10 @@ typedef struct e1000_t
     pbuf_t **tx_pbuf; // 传输高速缓冲数组
 
     netif_t *netif; // 虚拟网卡
+    u8 vector;      // 中断向量
+
+    work_t rx_work;     // 接收工作项
+    workqueue_t *rx_wq; // 接收工作队列
 } e1000_t;
 
 static e1000_t obj;
@@ -325,17 +329,31 @@ static void free_packet(e1000_t *e1000)
 
     if (e1000->tx_waiter)
     {
+        bool intr = interrupt_disable();
         task_unblock(e1000->tx_waiter, EOK);
         e1000->tx_waiter = NULL;
+        set_interrupt_state(intr);
     }
 }
 
+// 发送完成软中断，回收已发送的高速缓冲
+static void e1000_tx_softirq()
+{
+    free_packet(&obj);
+}
+
+// 接收工作项，netif_input 可能阻塞，所以在工作线程中执行
+static void e1000_rx_work(work_t *work)
+{
+    e1000_t *e1000 = element_entry(e1000_t, rx_work, work);
+    recv_packet(e1000);
+}
+
 // 中断处理函数
 static void e1000_handler(int vector)
 {
-    assert(vector == IRQ_NIC + 0x20);
-
     e1000_t *e1000 = &obj;
+    assert(vector == e1000->vector);
 
     u32 status = minl(e1000->membase + E1000_ICR);
     // LOGK("e1000 interrupt fired status %X\n", status);
@@ -344,7 +362,7 @@ static void e1000_handler(int vector)
     if ((status & IM_TXDW))
     {
         LOGK("e1000 TXDW...\n");
-        free_packet(e1000);
+        softirq_raise(SOFTIRQ_NET_TX);
     }
 
     // 传输队列为空，并且传输进程阻塞
@@ -373,9 +391,10 @@ static void e1000_handler(int vector)
         LOGK("e1000 RXDMT0...\n");
     }
 
+    // 中断处理函数只应答中断，接收推迟到工作线程
     if (status & IM_RXT0)
     {
-        recv_packet(e1000);
+        queue_work(e1000->rx_wq, &e1000->rx_work);
     }
 
     // 去掉已知中断状态，其他的如果发生再说；
@@ -588,10 +607,28 @@ void e1000_init()
 
     e1000->netif = netif_setup(e1000, e1000->mac, send_packet);
 
+    work_init(&e1000->rx_work, e1000_rx_work);
+    e1000->rx_wq = workqueue_create("e1000_rx", SCHED_FIFO, RT_PRIO_NET);
+    softirq_open(SOFTIRQ_NET_TX, e1000_tx_softirq);
+
+    // 优先使用 MSI，中断直接发送到启动处理器，不经过中断控制器
+    // 先确认设备支持 MSI 再分配向量，避免回退到传统中断时浪费向量
+    u32 vector = 0;
+    if (pci_find_capability(device, PCI_CAP_ID_MSI))
+        vector = msi_alloc_vector();
+    if (vector && pci_enable_msi(device, vector, cpus[0].apic_id) == EOK)
+    {
+        LOGK("e1000 msi vector 0x%X...\n", vector);
+        e1000->vector = vector;
+        set_vector_handler(vector, e1000_handler);
+        return;
+    }
+
     u32 intr = pci_interrupt(device);
 
     LOGK("e1000 irq 0x%X...\n", intr);
     assert(intr == IRQ_NIC);
+    e1000->vector = IRQ_MASTER_NR + intr;
 
     // 设置中断处理函数
     set_interrupt_handler(intr, e1000_handler);
@@ -0,0 +1,390 @@
+#include "hyc.h"
+
+#define LOGK(fmt, args...) DEBUGK(fmt, ##args)
+
+#define EPOLL_PRIVATE (EPOLLONESHOT | EPOLLET) // 不属于就绪事件的标志
+
+extern volatile u32 jiffies;
+extern u32 jiffy;
+
+struct eventpoll_t;
+
+// 关注列表中的一项
+typedef struct epitem_t
+{
+    list_node_t node;       // 关注列表结点
+    list_node_t rdnode;     // 就绪列表结点
+    bool ready;             // 是否在就绪列表中
+    struct eventpoll_t *ep; // 所属 epoll 实例
+    fd_t fd;                // 文件描述符
+    file_t *file;           // 文件
+    u32 events;             // 关心的事件和标志
+    epoll_data_t data;      // 用户数据
+    wait_entry_t wait;      // 挂在文件等待队列上的等待项
+} epitem_t;
+
+// epoll 实例，位于 inode->desc
+typedef struct eventpoll_t
+{
+    list_node_t node;  // 所有 epoll 实例链表结点
+    list_t items;      // 关注列表
+    list_t ready;      // 就绪列表，先进先出
+    list_t waiters;    // 在 epoll_wait 中阻塞的任务
+    wait_queue_t wait; // epoll 文件自身的等待队列，供 poll 或嵌套的 epoll 使用
+} eventpoll_t;
+
+// 登记等待时使用的轮询表
+typedef struct ep_pqueue_t
+{
+    poll_table_t pt;
+    epitem_t *item;
+} ep_pqueue_t;
+
+static list_t eventpoll_list; // 所有 epoll 实例
+
+// 加入就绪列表，唤醒等待的任务
+static void ep_ready(eventpoll_t *ep, epitem_t *item)
+{
+    if (item->ready)
+        return;
+
+    item->ready = true;
+    list_push(&ep->ready, &item->rdnode);
+
+    while (!list_empty(&ep->waiters))
+    {
+        task_t *task = element_entry(task_t, node, ep->waiters.tail.prev);
+        task_unblock(task, EOK);
+    }
+    wake_up(&ep->wait, POLLIN);
+}
+
+// 文件等待队列的唤醒回调
+static void ep_wake(wait_entry_t *entry, u32 events)
+{
+    epitem_t *item = (epitem_t *)entry->data;
+    u32 mask = item->events & ~EPOLL_PRIVATE;
+
+    // EPOLLONESHOT 返回后不再关注任何事件
+    if (!mask)
+        return;
+    if (!(events & (mask | POLLERR | POLLHUP)))
+        return;
+    ep_ready(item->ep, item);
+}
+
+static void ep_queue(poll_table_t *pt, wait_queue_t *wq)
+{
+    epitem_t *item = ((ep_pqueue_t *)pt)->item;
+
+    // 每项只挂在一个等待队列上
+    if (item->wait.queue)
+        return;
+    wait_add(wq, &item->wait);
+}
+
+static epitem_t *ep_find(eventpoll_t *ep, file_t *file, fd_t fd)
+{
+    list_t *list = &ep->items;
+    for (list_node_t *node = list->head.next; node != &list->tail; node = node->next)
+    {
+        epitem_t *item = element_entry(epitem_t, node, node);
+        if (item->file == file && item->fd == fd)
+            return item;
+    }
+    return NULL;
+}
+
+static int ep_insert(eventpoll_t *ep, epoll_event_t *event, file_t *file, fd_t fd)
+{
+    epitem_t *item = (epitem_t *)kmalloc(sizeof(epitem_t));
+    item->ready = false;
+    item->ep = ep;
+    item->fd = fd;
+    item->file = file;
+    item->events = event->events;
+    item->data = event->data;
+    wait_entry_init(&item->wait, ep_wake, item);
+
+    list_push(&ep->items, &item->node);
+    file->epolls++;
+
+    ep_pqueue_t epq;
+    epq.pt.queue = ep_queue;
+    epq.item = item;
+
+    int mask = file_poll(file, &epq.pt);
+    if (mask & (item->events | POLLERR | POLLHUP))
+        ep_ready(ep, item);
+    return EOK;
+}
+
+static int ep_modify(eventpoll_t *ep, epitem_t *item, epoll_event_t *event)
+{
+    item->events = event->events;
+    item->data = event->data;
+
+    int mask = file_poll(item->file, NULL);
+    if (mask & (item->events | POLLERR | POLLHUP))
+        ep_ready(ep, item);
+    return EOK;
+}
+
+static void ep_remove(eventpoll_t *ep, epitem_t *item)
+{
+    wait_remove(&item->wait);
+    list_remove(&item->node);
+    if (item->ready)
+        list_remove(&item->rdnode);
+
+    assert(item->file->epolls > 0);
+    item->file->epolls--;
+    kfree(item);
+}
+
+// 从就绪列表取出事件，水平触发的项重新检查后放回就绪列表
+static int ep_send_events(eventpoll_t *ep, epoll_event_t *events, int maxevents)
+{
+    list_t relist;
+    list_init(&relist);
+
+    int count = 0;
+    while (count < maxevents && !list_empty(&ep->ready))
+    {
+        epitem_t *item = element_entry(epitem_t, rdnode, list_popback(&ep->ready));
+        item->ready = false;
+
+        u32 mask = item->events & ~EPOLL_PRIVATE;
+        if (!mask)
+            continue;
+
+        mask = file_poll(item->file, NULL) & (mask | POLLERR | POLLHUP);
+        if (!mask)
+            continue;
+
+        events[count].events = mask;
+        events[count].data = item->data;
+        count++;
+
+        if (item->events & EPOLLONESHOT)
+        {
+            item->events &= EPOLL_PRIVATE;
+        }
+        else if (!(item->events & EPOLLET))
+        {
+            item->ready = true;
+            list_push(&relist, &item->rdnode);
+        }
+    }
+
+    while (!list_empty(&relist))
+    {
+        list_push(&ep->ready, list_popback(&relist));
+    }
+    return count;
+}
+
+static eventpoll_t *ep_get(fd_t epfd, file_t **file)
+{
+    if (fd_check(epfd, file) < EOK)
+        return NULL;
+    inode_t *inode = (*file)->inode;
+    if (!inode || inode->type != FS_TYPE_EPOLL)
+        return NULL;
+    return (eventpoll_t *)inode->desc;
+}
+
+void epoll_release(file_t *file)
+{
+    list_t *list = &eventpoll_list;
+    for (list_node_t *node = list->head.next; node != &list->tail && file->epolls; node = node->next)
+    {
+        eventpoll_t *ep = element_entry(eventpoll_t, node, node);
+        list_t *items = &ep->items;
+        for (list_node_t *ptr = items->head.next; ptr != &items->tail;)
+        {
+            epitem_t *item = element_entry(epitem_t, node, ptr);
+            ptr = ptr->next;
+            if (item->file == file)
+                ep_remove(ep, item);
+        }
+    }
+}
+
+fd_t sys_epoll_create(int size)
+{
+    if (size <= 0)
+        return -EINVAL;
+
+    file_t *file;
+    fd_t fd = fd_get(&file);
+    if (fd < EOK)
+        return fd;
+
+    eventpoll_t *ep = (eventpoll_t *)kmalloc(sizeof(eventpoll_t));
+    list_init(&ep->items);
+    list_init(&ep->ready);
+    list_init(&ep->waiters);
+    wait_queue_init(&ep->wait);
+    list_push(&eventpoll_list, &ep->node);
+
+    inode_t *inode = get_free_inode();
+    inode->dev = -FS_TYPE_EPOLL;
+    inode->type = FS_TYPE_EPOLL;
+    inode->op = fs_get_op(FS_TYPE_EPOLL);
+    inode->desc = ep;
+    inode->count = 1;
+
+    file->inode = inode;
+    file->flags = O_RDWR;
+    file->offset = 0;
+
+    LOGK("epoll create fd %d\n", fd);
+    return fd;
+}
+
+int sys_epoll_ctl(fd_t epfd, int op, fd_t fd, epoll_event_t *event)
+{
+    file_t *epfile;
+    eventpoll_t *ep = ep_get(epfd, &epfile);
+    if (!ep)
+        return -EBADF;
+
+    file_t *file;
+    if (fd_check(fd, &file) < EOK)
+        return -EBADF;
+    if (file == epfile)
+        return -EINVAL;
+
+    if (op != EPOLL_CTL_DEL && !memory_access(event, sizeof(epoll_event_t), false, true))
+        return -EFAULT;
+
+    epitem_t *item = ep_find(ep, file, fd);
+    switch (op)
+    {
+    case EPOLL_CTL_ADD:
+        if (item)
+            return -EEXIST;
+        return ep_insert(ep, event, file, fd);
+    case EPOLL_CTL_MOD:
+        if (!item)
+            return -ENOENT;
+        return ep_modify(ep, item, event);
+    case EPOLL_CTL_DEL:
+        if (!item)
+            return -ENOENT;
+        ep_remove(ep, item);
+        return EOK;
+    default:
+        return -EINVAL;
+    }
+}
+
+int sys_epoll_wait(fd_t epfd, epoll_event_t *events, int maxevents, int timeout)
+{
+    if (maxevents <= 0)
+        return -EINVAL;
+    if (!memory_access(events, maxevents * sizeof(epoll_event_t), true, true))
+        return -EFAULT;
+
+    file_t *file;
+    eventpoll_t *ep = ep_get(epfd, &file);
+    if (!ep)
+        return -EBADF;
+
+    task_t *task = running_task();
+    u32 start = jiffies;
+
+    while (true)
+    {
+        int count = ep_send_events(ep, events, maxevents);
+        if (count || timeout == 0)
+            return count;
+
+        int remain = TIMELESS;
+        if (timeout > 0)
+        {
+            u32 elapsed = (jiffies - start) * jiffy;
+            if (elapsed >= timeout)
+                return 0;
+            remain = timeout - elapsed;
+        }
+
+        // 关闭 epoll 时以 -EINTR 唤醒，之后不能再访问 ep
+        int ret = task_block(task, &ep->waiters, TASK_WAITING, remain);
+        if (ret == -ETIME)
+            return 0;
+        if (ret < EOK)
+            return ret;
+    }
+}
+
+static int epoll_poll(inode_t *inode, poll_table_t *pt)
+{
+    eventpoll_t *ep = (eventpoll_t *)inode->desc;
+    poll_wait(pt, &ep->wait);
+    return list_empty(&ep->ready) ? 0 : POLLIN;
+}
+
+static void epoll_close(inode_t *inode)
+{
+    if (!inode)
+        return;
+    inode->count--;
+    if (inode->count)
+        return;
+
+    eventpoll_t *ep = (eventpoll_t *)inode->desc;
+    while (!list_empty(&ep->items))
+    {
+        epitem_t *item = element_entry(epitem_t, node, ep->items.tail.prev);
+        ep_remove(ep, item);
+    }
+
+    while (!list_empty(&ep->waiters))
+    {
+        task_t *task = element_entry(task_t, node, ep->waiters.tail.prev);
+        task_unblock(task, -EINTR);
+    }
+
+    list_remove(&ep->node);
+    kfree(ep);
+
+    inode->type = FS_TYPE_NONE;
+    inode->desc = NULL;
+    inode->op = NULL;
+    put_free_inode(inode);
+    LOGK("epoll close...\n");
+}
+
+static fs_op_t epoll_op = {
+    fs_default_nosys,
+    fs_default_nosys,
+
+    fs_default_nosys,
+    epoll_close,
+
+    fs_default_nosys,
+    fs_default_nosys,
+    fs_default_nosys,
+    fs_default_nosys,
+
+    fs_default_nosys,
+    fs_default_nosys,
+
+    fs_default_nosys,
+    fs_default_nosys,
+    fs_default_nosys,
+    fs_default_nosys,
+    fs_default_nosys,
+    fs_default_nosys,
+    fs_default_nosys,
+
+    epoll_poll,
+};
+
+void epoll_init()
+{
+    list_init(&eventpoll_list);
+    fs_register_op(FS_TYPE_EPOLL, &epoll_op);
+}
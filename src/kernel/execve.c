@@ -230,6 +230,9 @@ static void load_segment(inode_t *inode, Elf32_Phdr *phdr)
         link_page(addr);
     }
 
+    // 段内的文件块在读取的同时预读
+    readahead_t ra = {0};
+    file_readahead(inode, &ra, phdr->p_offset, phdr->p_filesz);
     inode->op->read(inode, (char *)vaddr, phdr->p_filesz, phdr->p_offset);
     if (phdr->p_filesz < phdr->p_memsz)
     {
@@ -414,6 +417,14 @@ int sys_execve(char *filename, char *argv[], char *envp[])
     }
 
     task_t *task = running_task();
+
+    // 其他线程仍在使用地址空间
+    if (task_threaded(task))
+    {
+        ret = -EBUSY;
+        goto rollback;
+    }
+
     strncpy(task->name, filename, TASK_NAME_LEN);
 
     // 处理参数和环境变量
@@ -2,8 +2,6 @@
 
 #define LOGK(fmt, args...) DEBUGK(fmt, ##args)
 
-task_t *last_fpu_task = NULL;
-
 // 验证系统是否支持 FPU
 bool fpu_check()
 {
@@ -49,20 +47,6 @@ void fpu_enable(task_t *task)
 
     set_cr0(get_cr0() & ~(CR0_EM | CR0_TS));
 
-    // 如果当前任务和上次使用 FPU 的任务相同，则无需恢复浮点环境
-    if (last_fpu_task == task)
-        return;
-
-    // 如果上一个任务使用了 FPU，则保存它的浮点环境
-    if (last_fpu_task && (last_fpu_task->flags & TASK_FPU_ENABLED))
-    {
-        assert(last_fpu_task->fpu);
-        asm volatile("fnsave (%%eax)" ::"a"(last_fpu_task->fpu));
-        last_fpu_task->flags &= ~TASK_FPU_ENABLED;
-    }
-
-    last_fpu_task = task;
-
     // 如果当前任务已经有 FPU 环境，则恢复它
     if (task->fpu)
     {
@@ -77,13 +61,21 @@ void fpu_enable(task_t *task)
 
         LOGK("为任务 0x%p 创建 FPU 状态\n", task);
         task->fpu = (fpu_t *)kmalloc(sizeof(fpu_t));
-        task->flags |= (TASK_FPU_ENABLED | TASK_FPU_USED);
     }
+    task->flags |= (TASK_FPU_ENABLED | TASK_FPU_USED);
 }
 
 // 禁用 FPU
+// 多处理器下任务可能迁移到其他处理器执行，浮点环境不能留在本处理器的寄存器中，
+// 所以在任务换出时保存，下次使用时再恢复
 void fpu_disable(task_t *task)
 {
+    if (task->flags & TASK_FPU_ENABLED)
+    {
+        assert(task->fpu);
+        asm volatile("fnsave (%%eax)" ::"a"(task->fpu));
+        task->flags &= ~TASK_FPU_ENABLED;
+    }
     set_cr0(get_cr0() | (CR0_EM | CR0_TS));
 }
 
@@ -98,21 +90,25 @@ void fpu_handler(int vector)
     fpu_enable(task);
 }
 
+// 配置当前处理器的 CR0 寄存器，使用 FPU 时触发异常
+void fpu_cpu_init()
+{
+    set_cr0(get_cr0() | CR0_EM | CR0_TS | CR0_NE);
+}
+
 // 初始化 FPU
 void fpu_init()
 {
     LOGK("初始化 FPU...\n");
 
     bool has_fpu = fpu_check();
-    last_fpu_task = NULL;
     assert(has_fpu);
 
     if (has_fpu)
     {
         // 设置 FPU 异常处理程序
         set_exception_handler(INTR_NM, fpu_handler);
-        // 配置 CR0 寄存器
-        set_cr0(get_cr0() | CR0_EM | CR0_TS | CR0_NE);
+        fpu_cpu_init();
     }
     else
     {
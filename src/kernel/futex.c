@@ -0,0 +1,99 @@
+#include "hyc.h"
+
+#define LOGK(fmt, args...) DEBUGK(fmt, ##args)
+
+#define FUTEX_HASH_SIZE 31 // 等待队列哈希表大小
+
+// 以页目录和用户虚拟地址标识一个 futex，同一线程组共享页目录
+typedef struct futex_waiter_t
+{
+    list_node_t node; // 等待队列结点
+    task_t *task;     // 等待的任务
+    u32 pde;          // 页目录
+    u32 *addr;        // 用户地址
+    bool woken;       // 已被唤醒
+} futex_waiter_t;
+
+static list_t futex_queues[FUTEX_HASH_SIZE];
+
+static list_t *futex_queue(u32 pde, u32 *addr)
+{
+    return &futex_queues[((u32)addr ^ pde) % FUTEX_HASH_SIZE];
+}
+
+static int futex_wait(u32 *addr, u32 val, int timeout)
+{
+    task_t *task = running_task();
+
+    // 检查和阻塞之间不会发生调度，不会丢失唤醒
+    if (*addr != val)
+        return -EAGAIN;
+
+    futex_waiter_t waiter;
+    waiter.task = task;
+    waiter.pde = task->pde;
+    waiter.addr = addr;
+    waiter.woken = false;
+    list_push(futex_queue(waiter.pde, addr), &waiter.node);
+
+    if (timeout <= 0)
+        timeout = TIMELESS;
+
+    int ret = task_block(task, NULL, TASK_WAITING, timeout);
+    if (waiter.woken)
+        return EOK;
+
+    // 超时或被信号打断
+    list_remove(&waiter.node);
+    return ret < 0 ? ret : -EINTR;
+}
+
+// 唤醒 addr 上至多 count 个等待者，返回唤醒的数量
+int futex_wake(u32 *addr, int count)
+{
+    task_t *task = running_task();
+    list_t *queue = futex_queue(task->pde, addr);
+
+    int woken = 0;
+    list_node_t *node = queue->tail.prev;
+    while (node != &queue->head && woken < count)
+    {
+        futex_waiter_t *waiter = element_entry(futex_waiter_t, node, node);
+        node = node->prev;
+
+        if (waiter->pde != task->pde || waiter->addr != addr)
+            continue;
+
+        list_remove(&waiter->node);
+        waiter->woken = true;
+        task_unblock(waiter->task, EOK);
+        woken++;
+    }
+    return woken;
+}
+
+int sys_futex(u32 *addr, int op, int val, int timeout)
+{
+    if ((u32)addr & 3)
+        return -EINVAL;
+    if (!memory_access(addr, sizeof(u32), false, true))
+        return -EFAULT;
+
+    switch (op & ~FUTEX_PRIVATE_FLAG)
+    {
+    case FUTEX_WAIT:
+        return futex_wait(addr, val, timeout);
+    case FUTEX_WAKE:
+        return futex_wake(addr, val);
+    default:
+        return -EINVAL;
+    }
+}
+
+void futex_init()
+{
+    for (size_t i = 0; i < FUTEX_HASH_SIZE; i++)
+    {
+        list_init(&futex_queues[i]);
+    }
+}
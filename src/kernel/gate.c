@@ -12,6 +12,35 @@ void syscall_check(u32 nr)
     }
 }
 
+// sysenter 的返回地址位于用户栈 ebp 处，ebp 由用户提供，
+// 不在用户内存中或不可读时返回 0，并向当前任务发送 SIGSEGV
+u32 sysenter_user_eip(u32 ebp)
+{
+    if (ebp < USER_EXEC_ADDR || ebp > USER_STACK_TOP - sizeof(u32) ||
+        !memory_access((void *)ebp, sizeof(u32), false, true))
+    {
+        running_task()->signal |= SIGMASK(SIGSEGV);
+        return 0;
+    }
+    return *(u32 *)ebp;
+}
+
+extern void sysenter_entry();
+
+static bool sysenter_enabled = false;
+
+// 设置当前处理器的快速系统调用入口，
+// sysenter 之后的栈指针指向 tss.esp0，由入口处切换到当前任务的内核栈
+void sysenter_cpu_init(tss_t *tss)
+{
+    if (!sysenter_enabled)
+        return;
+
+    wrmsr(MSR_SYSENTER_CS, KERNEL_CODE_SELECTOR);
+    wrmsr(MSR_SYSENTER_ESP, (u32)&tss->esp0);
+    wrmsr(MSR_SYSENTER_EIP, (u32)sysenter_entry);
+}
+
 static void sys_default()
 {
     panic("Unimplemented syscall!!!");
@@ -26,11 +55,20 @@ extern fd_t sys_dup();
 extern fd_t sys_dup2();
 
 extern int sys_pipe();
+extern int sys_splice();
+extern int sys_tee();
 
 extern int sys_read();
 extern int sys_write();
+extern int sys_readv();
+extern int sys_writev();
+extern int sys_pread();
+extern int sys_pwrite();
 extern int sys_lseek();
 extern int sys_readdir();
+extern int sys_sync();
+extern int sys_fsync();
+extern int sys_fdatasync();
 
 extern fd_t sys_open();
 extern fd_t sys_creat();
@@ -68,6 +106,7 @@ extern int sys_getpgrp();
 extern int sys_stty();
 extern int sys_gtty();
 extern int sys_ioctl();
+extern int sys_fcntl();
 
 extern int sys_signal();
 extern int sys_sgetmask();
@@ -80,7 +119,7 @@ extern int sys_mkfs();
 
 extern int sys_socket();
 extern int sys_listen();
-extern int sys_accept();
+extern int sys_accept4();
 extern int sys_bind();
 extern int sys_connect();
 extern int sys_shutdown();
@@ -95,11 +134,32 @@ extern int sys_recvmsg();
 
 extern int sys_sendto();
 extern int sys_sendmsg();
+extern int sys_sendfile();
 
 extern int sys_resolv();
 
 extern int sys_uname();
 
+extern int sys_nice();
+extern int sys_getpriority();
+extern int sys_setpriority();
+
+extern int sys_sched_setparam();
+extern int sys_sched_getparam();
+extern int sys_sched_setscheduler();
+extern int sys_sched_getscheduler();
+
+extern int sys_futex();
+
+extern int sys_io_uring_setup();
+extern int sys_io_uring_enter();
+
+extern int sys_select();
+extern int sys_poll();
+extern int sys_epoll_create();
+extern int sys_epoll_ctl();
+extern int sys_epoll_wait();
+
 void syscall_init()
 {
     for (size_t i = 0; i < SYSCALL_SIZE; i++)
@@ -121,6 +181,16 @@ void syscall_init()
 
     syscall_table[SYS_NR_GETPID] = sys_getpid;
     syscall_table[SYS_NR_GETPPID] = sys_getppid;
+    syscall_table[SYS_NR_GETTID] = sys_gettid;
+    syscall_table[SYS_NR_CLONE] = sys_clone;
+    syscall_table[SYS_NR_FUTEX] = sys_futex;
+    syscall_table[SYS_NR_NICE] = sys_nice;
+    syscall_table[SYS_NR_GETPRIORITY] = sys_getpriority;
+    syscall_table[SYS_NR_SETPRIORITY] = sys_setpriority;
+    syscall_table[SYS_NR_SCHED_SETPARAM] = sys_sched_setparam;
+    syscall_table[SYS_NR_SCHED_GETPARAM] = sys_sched_getparam;
+    syscall_table[SYS_NR_SCHED_SETSCHEDULER] = sys_sched_setscheduler;
+    syscall_table[SYS_NR_SCHED_GETSCHEDULER] = sys_sched_getscheduler;
     syscall_table[SYS_NR_SETPGID] = sys_setpgid;
     syscall_table[SYS_NR_GETPGRP] = sys_getpgrp;
     syscall_table[SYS_NR_SETSID] = sys_setsid;
@@ -128,6 +198,7 @@ void syscall_init()
     syscall_table[SYS_NR_STTY] = sys_stty;
     syscall_table[SYS_NR_GTTY] = sys_gtty;
     syscall_table[SYS_NR_IOCTL] = sys_ioctl;
+    syscall_table[SYS_NR_FCNTL] = sys_fcntl;
 
     syscall_table[SYS_NR_BRK] = sys_brk;
     syscall_table[SYS_NR_MMAP] = sys_mmap;
@@ -137,11 +208,20 @@ void syscall_init()
     syscall_table[SYS_NR_DUP2] = sys_dup2;
 
     syscall_table[SYS_NR_PIPE] = sys_pipe;
+    syscall_table[SYS_NR_SPLICE] = sys_splice;
+    syscall_table[SYS_NR_TEE] = sys_tee;
 
     syscall_table[SYS_NR_READ] = sys_read;
     syscall_table[SYS_NR_WRITE] = sys_write;
+    syscall_table[SYS_NR_READV] = sys_readv;
+    syscall_table[SYS_NR_WRITEV] = sys_writev;
+    syscall_table[SYS_NR_PREAD] = sys_pread;
+    syscall_table[SYS_NR_PWRITE] = sys_pwrite;
     syscall_table[SYS_NR_LSEEK] = sys_lseek;
     syscall_table[SYS_NR_READDIR] = sys_readdir;
+    syscall_table[SYS_NR_SYNC] = sys_sync;
+    syscall_table[SYS_NR_FSYNC] = sys_fsync;
+    syscall_table[SYS_NR_FDATASYNC] = sys_fdatasync;
 
     syscall_table[SYS_NR_MKDIR] = sys_mkdir;
     syscall_table[SYS_NR_RMDIR] = sys_rmdir;
@@ -181,13 +261,14 @@ void syscall_init()
     syscall_table[SYS_NR_BIND] = sys_bind;
     syscall_table[SYS_NR_CONNECT] = sys_connect;
     syscall_table[SYS_NR_LISTEN] = sys_listen;
-    syscall_table[SYS_NR_ACCEPT] = sys_accept;
+    syscall_table[SYS_NR_ACCEPT] = sys_accept4;
     syscall_table[SYS_NR_GETSOCKOPT] = sys_getsockopt;
     syscall_table[SYS_NR_SETSOCKOPT] = sys_setsockopt;
     syscall_table[SYS_NR_GETSOCKNAME] = sys_getsockname;
     syscall_table[SYS_NR_GETPEERNAME] = sys_getpeername;
     syscall_table[SYS_NR_SENDTO] = sys_sendto;
     syscall_table[SYS_NR_SENDMSG] = sys_sendmsg;
+    syscall_table[SYS_NR_SENDFILE] = sys_sendfile;
     syscall_table[SYS_NR_RECVFROM] = sys_recvfrom;
     syscall_table[SYS_NR_RECVMSG] = sys_recvmsg;
     syscall_table[SYS_NR_SHUTDOWN] = sys_shutdown;
@@ -195,4 +276,18 @@ void syscall_init()
     syscall_table[SYS_NR_RESOLV] = sys_resolv;
 
     syscall_table[SYS_NR_UNAME] = sys_uname;
+
+    syscall_table[SYS_NR_IO_URING_SETUP] = sys_io_uring_setup;
+    syscall_table[SYS_NR_IO_URING_ENTER] = sys_io_uring_enter;
+
+    syscall_table[SYS_NR_SELECT] = sys_select;
+    syscall_table[SYS_NR_POLL] = sys_poll;
+    syscall_table[SYS_NR_EPOLL_CREATE] = sys_epoll_create;
+    syscall_table[SYS_NR_EPOLL_CTL] = sys_epoll_ctl;
+    syscall_table[SYS_NR_EPOLL_WAIT] = sys_epoll_wait;
+
+    // 应用处理器启动时各自设置
+    sysenter_enabled = cpu_has_sep();
+    sysenter_cpu_init(&cpus[0].tss);
+    LOGK("sysenter %s\n", sysenter_enabled ? "enabled" : "not supported");
 }
\ No newline at end of file
@@ -2,7 +2,6 @@
 
 descriptor_t gdt[GDT_SIZE]; // 全局描述符表
 pointer_t gdt_ptr;          // 全局描述符表指针
-tss_t tss;                  // 任务状态段（TSS）
 
 void descriptor_init(descriptor_t *desc, u32 base, u32 limit)
 {
@@ -65,15 +64,16 @@ void gdt_init()
     gdt_ptr.limit = sizeof(gdt) - 1;
 }
 
-void tss_init()
+// 初始化处理器 id 的任务状态段（TSS），并加载到任务寄存器
+void tss_init_cpu(u32 id, tss_t *tss)
 {
-    memset(&tss, 0, sizeof(tss));
+    memset(tss, 0, sizeof(tss_t));
 
-    tss.ss0 = KERNEL_DATA_SELECTOR;
-    tss.iobase = sizeof(tss);
+    tss->ss0 = KERNEL_DATA_SELECTOR;
+    tss->iobase = sizeof(tss_t);
 
-    descriptor_t *desc = &gdt[KERNEL_TSS_IDX];
-    descriptor_init(desc, (u32)&tss, sizeof(tss) - 1);
+    descriptor_t *desc = &gdt[TSS_IDX(id)];
+    descriptor_init(desc, (u32)tss, sizeof(tss_t) - 1);
     desc->segment = 0;     // 标识为系统段
     desc->granularity = 0; // 使用字节单位
     desc->big = 0;         // 固定为0
@@ -84,6 +84,10 @@ void tss_init()
 
     // 加载任务状态段寄存器
     asm volatile(
-        "ltr %%ax\n" ::"a"(KERNEL_TSS_SELECTOR));
+        "ltr %%ax\n" ::"a"(TSS_IDX(id) << 3));
 }
 
+void tss_init()
+{
+    tss_init_cpu(0, &cpus[0].tss);
+}
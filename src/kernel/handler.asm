@@ -3,6 +3,10 @@
 
 extern handler_table
 extern task_signal
+extern task_preempt
+extern kernel_enter
+extern kernel_exit
+extern do_softirq
 
 section .text
 
@@ -25,6 +29,9 @@ interrupt_entry:
     push gs
     pusha
 
+    ; 获得大内核锁
+    call kernel_enter
+
     ; 获取中断向量号
     mov eax, [esp + 12 * 4]
 
@@ -40,9 +47,21 @@ interrupt_exit:
     ; 恢复栈指针，清理参数
     add esp, 4
 
+    ; 被中断的上下文允许中断时，执行挂起的软中断
+    test dword [esp + 16 * 4], 0x200
+    jz .softirq_done
+    call do_softirq
+.softirq_done:
+
+    ; 唤醒了更高优先级的任务则立即调度
+    call task_preempt
+
     ; 执行信号处理
     call task_signal
 
+    ; 返回用户态前释放大内核锁
+    call kernel_exit
+
     ; 恢复上下文环境
     popa
     pop gs
@@ -111,6 +130,22 @@ INTERRUPT_HANDLER 0x2C, 0  ; 保留
 INTERRUPT_HANDLER 0x2D, 0  ; 保留
 INTERRUPT_HANDLER 0x2E, 0  ; 硬盘主通道
 INTERRUPT_HANDLER 0x2F, 0  ; 硬盘从通道
+INTERRUPT_HANDLER 0x30, 0  ; 重新调度处理器间中断
+INTERRUPT_HANDLER 0x31, 0  ; local APIC 定时器
+INTERRUPT_HANDLER 0x32, 0  ; 保留
+INTERRUPT_HANDLER 0x33, 0  ; 保留
+INTERRUPT_HANDLER 0x34, 0  ; 保留
+INTERRUPT_HANDLER 0x35, 0  ; 保留
+INTERRUPT_HANDLER 0x36, 0  ; 保留
+INTERRUPT_HANDLER 0x37, 0  ; 保留
+INTERRUPT_HANDLER 0x38, 0  ; 保留
+INTERRUPT_HANDLER 0x39, 0  ; 保留
+INTERRUPT_HANDLER 0x3A, 0  ; 保留
+INTERRUPT_HANDLER 0x3B, 0  ; 保留
+INTERRUPT_HANDLER 0x3C, 0  ; 保留
+INTERRUPT_HANDLER 0x3D, 0  ; 保留
+INTERRUPT_HANDLER 0x3E, 0  ; local APIC 错误
+INTERRUPT_HANDLER 0x3F, 0  ; local APIC 伪中断
 
 ; 中断入口函数指针表
 section .data
@@ -164,10 +199,27 @@ handler_entry_table:
     dd interrupt_handler_0x2D
     dd interrupt_handler_0x2E
     dd interrupt_handler_0x2F
+    dd interrupt_handler_0x30
+    dd interrupt_handler_0x31
+    dd interrupt_handler_0x32
+    dd interrupt_handler_0x33
+    dd interrupt_handler_0x34
+    dd interrupt_handler_0x35
+    dd interrupt_handler_0x36
+    dd interrupt_handler_0x37
+    dd interrupt_handler_0x38
+    dd interrupt_handler_0x39
+    dd interrupt_handler_0x3A
+    dd interrupt_handler_0x3B
+    dd interrupt_handler_0x3C
+    dd interrupt_handler_0x3D
+    dd interrupt_handler_0x3E
+    dd interrupt_handler_0x3F
 
 section .text
 
 extern syscall_check
+extern sysenter_user_eip
 extern syscall_table
 global syscall_handler
 syscall_handler:
@@ -189,6 +241,12 @@ syscall_handler:
     push gs
     pusha
 
+    ; 获得大内核锁，调用会破坏 eax ecx edx，从栈中恢复
+    call kernel_enter
+    mov eax, [esp + 7 * 4]
+    mov ecx, [esp + 6 * 4]
+    mov edx, [esp + 5 * 4]
+
     push 0x80    ; 向中断处理函数传递系统调用中断向量
     ; xchg bx, bx
 
@@ -211,3 +269,113 @@ syscall_handler:
 
     ; 跳转到中断退出处理
     jmp interrupt_exit
+
+; sysenter 快速系统调用入口，用户态约定：
+; ebp 指向用户栈，栈顶为返回地址，参数寄存器与 int 0x80 相同
+global sysenter_entry
+sysenter_entry:
+    ; MSR_SYSENTER_ESP 指向当前处理器 tss.esp0，切换到当前任务的内核栈
+    mov esp, [esp]
+
+    ; 构造与 int 0x80 相同的中断帧，信号处理和 fork 无需区分两种入口
+    push 0x23               ; ss，USER_DATA_SELECTOR
+    push ebp                ; esp
+    pushfd                  ; eflags，sysenter 清除了 IF
+    or dword [esp], 0x200
+    push 0x1b               ; cs，USER_CODE_SELECTOR
+
+    ; ebp 由用户提供，检查之后才能读取返回地址，不可访问时得到 0，
+    ; 调用会破坏 eax ecx edx，保存的 eax 所在位置正好换成 eip
+    push eax
+    push ecx
+    push edx
+    push ebp
+    call sysenter_user_eip
+    add esp, 4
+    pop edx
+    pop ecx
+    xchg eax, [esp]         ; eip
+
+    ; 验证系统调用号
+    push eax
+    call syscall_check
+    add esp, 4
+
+    push 0x20222202
+
+    push 0x80
+
+    ; 保存上下文环境
+    push ds
+    push es
+    push fs
+    push gs
+    pusha
+
+    ; 获得大内核锁，调用会破坏 eax ecx edx，从栈中恢复
+    call kernel_enter
+    mov eax, [esp + 7 * 4]
+    mov ecx, [esp + 6 * 4]
+    mov edx, [esp + 5 * 4]
+
+    push 0x80    ; 向中断处理函数传递系统调用中断向量
+
+    ; 返回地址不可访问时不执行系统调用，进程收到 SIGSEGV
+    cmp dword [esp + 15 * 4], 0
+    je .fault
+
+    ; 保存系统调用的参数，sysenter 只支持 5 个参数
+    push ebp    ; 参数6
+    push edi    ; 参数5
+    push esi    ; 参数4
+    push edx    ; 参数3
+    push ecx    ; 参数2
+    push ebx    ; 参数1
+
+    call [syscall_table + eax * 4]
+
+    add esp, 6 * 4
+
+    ; 设置返回值到 eax，并修改栈中的 eax
+    mov dword [esp + 8 * 4], eax
+    jmp .syscall_done
+
+.fault:
+    mov dword [esp + 8 * 4], -14    ; -EFAULT
+
+.syscall_done:
+
+    ; 恢复栈指针，清理参数
+    add esp, 4
+
+    test dword [esp + 16 * 4], 0x200
+    jz .softirq_done
+    call do_softirq
+.softirq_done:
+
+    call task_preempt
+    call task_signal
+    call kernel_exit
+
+    ; 恢复上下文环境
+    popa
+    pop gs
+    pop fs
+    pop es
+    pop ds
+
+    ; 跳过中断向量和错误码
+    add esp, 8
+
+    ; 由中断帧返回，eip 和 esp 可能已被信号处理或 execve 修改，
+    ; sysexit 从 edx 和 ecx 中取得返回地址和用户栈，所以用户态需视二者为破坏
+    pop edx                 ; eip
+    add esp, 4              ; cs
+    and dword [esp], ~0x200
+    popfd                   ; eflags，暂不开中断
+    pop ecx                 ; esp
+    add esp, 4              ; ss
+
+    ; sti 之后的一条指令执行完毕才响应中断，不会在内核态被打断
+    sti
+    sysexit
@@ -29,6 +29,9 @@
 // IDE 命令定义
 #define IDE_CMD_READ 0x20
 #define IDE_CMD_WRITE 0x30
+#define IDE_CMD_READ_MULTIPLE 0xC4
+#define IDE_CMD_WRITE_MULTIPLE 0xC5
+#define IDE_CMD_SET_MULTIPLE 0xC6
 #define IDE_CMD_IDENTIFY 0xEC
 #define IDE_CMD_DIAGNOSTIC 0x90
 #define IDE_CMD_READ_UDMA 0xC8
@@ -119,8 +122,9 @@ typedef struct ide_params_t {
     u16 reserved4[3];
     u8 firmware[8];
     u8 model[40];
-    u8 drq_sectors;
-    u8 reserved5[3];
+    u8 drq_sectors; // READ/WRITE MULTIPLE 每块最多扇区数
+    u8 reserved5;
+    u16 dword_io; // 支持 32 位传输
     u16 capabilities;
     u16 reserved6[10];
     u32 total_lba;
@@ -264,13 +268,24 @@ static void ide_pio_read_sector(ide_disk_t *disk, u16 *buf)
     }
 }
 
-// 从 buf 写入一个扇区到磁盘
-static void ide_pio_write_sector(ide_disk_t *disk, u16 *buf)
+// 从磁盘连续读取 count 个扇区到 buf，支持时每次传输 32 位
+static void ide_pio_read_sectors(ide_disk_t *disk, void *buf, u32 count)
 {
-    for (size_t i = 0; i < (disk->sector_size / 2); i++)
-    {
-        outw(disk->ctrl->iobase + IDE_DATA, buf[i]);
-    }
+    u32 size = count * SECTOR_SIZE;
+    if (disk->dword_io)
+        insl(disk->ctrl->iobase + IDE_DATA, buf, size / 4);
+    else
+        insw(disk->ctrl->iobase + IDE_DATA, buf, size / 2);
+}
+
+// 从 buf 连续写入 count 个扇区到磁盘
+static void ide_pio_write_sectors(ide_disk_t *disk, void *buf, u32 count)
+{
+    u32 size = count * SECTOR_SIZE;
+    if (disk->dword_io)
+        outsl(disk->ctrl->iobase + IDE_DATA, buf, size / 4);
+    else
+        outsw(disk->ctrl->iobase + IDE_DATA, buf, size / 2);
 }
 
 // 磁盘控制
@@ -313,11 +328,12 @@ int ide_pio_read(ide_disk_t *disk, void *buf, u8 count, idx_t lba)
     // 选择扇区
     ide_select_sector(disk, lba, count);
 
-    // 发送读取命令
-    outb(ctrl->iobase + IDE_COMMAND, IDE_CMD_READ);
+    // 发送读取命令，块模式下每次中断读取一块
+    u8 block = disk->multiple ? disk->multiple : 1;
+    outb(ctrl->iobase + IDE_COMMAND, disk->multiple ? IDE_CMD_READ_MULTIPLE : IDE_CMD_READ);
 
     task_t *current_task = running_task();
-    for (size_t i = 0; i < count; i++)
+    for (size_t i = 0; i < count; i += block)
     {
         // 阻塞任务，等待中断
         ctrl->waiter = current_task;
@@ -327,8 +343,9 @@ int ide_pio_read(ide_disk_t *disk, void *buf, u8 count, idx_t lba)
         if ((result = ide_busy_wait(ctrl, IDE_SR_DRQ, IDE_TIMEOUT)) < EOK)
             goto cleanup;
 
+        // 读取一块，最后一块可能不满
         u32 offset = ((u32)buf + i * SECTOR_SIZE);
-        ide_pio_read_sector(disk, (u16 *)offset); // 读取扇区
+        ide_pio_read_sectors(disk, (void *)offset, MIN(block, count - i));
     }
     result = EOK;
 
@@ -362,14 +379,19 @@ int ide_pio_write(ide_disk_t *disk, void *buf, u8 count, idx_t lba)
     // 选择扇区
     ide_select_sector(disk, lba, count);
 
-    // 发送写入命令
-    outb(ctrl->iobase + IDE_COMMAND, IDE_CMD_WRITE);
+    // 发送写入命令，块模式下每次中断写入一块
+    u8 block = disk->multiple ? disk->multiple : 1;
+    outb(ctrl->iobase + IDE_COMMAND, disk->multiple ? IDE_CMD_WRITE_MULTIPLE : IDE_CMD_WRITE);
+
     task_t *current_task = running_task();
-    for (size_t i = 0; i < count; i++)
+    for (size_t i = 0; i < count; i += block)
     {
-        // 直接先写，写完后 wait
+        // 磁盘准备好接收数据后写入一块，写完后 wait
+        if ((result = ide_busy_wait(ctrl, IDE_SR_DRQ, IDE_TIMEOUT)) < EOK)
+            goto cleanup;
+
         u32 offset = ((u32)buf + i * SECTOR_SIZE);
-        ide_pio_write_sector(disk, (u16 *)offset);
+        ide_pio_write_sectors(disk, (void *)offset, MIN(block, count - i));
 
         // 阻塞任务，等待中断
         ctrl->waiter = current_task;
@@ -404,35 +426,69 @@ int ide_pio_part_ioctl(ide_part_t *part, int cmd, void *args, int flags)
 }
 
 
-// 读取分区
-int ide_pio_part_read(ide_part_t *part, void *buffer, u8 sector_count, idx_t lba_offset)
-{
-    return ide_pio_read(part->disk, buffer, sector_count, part->start + lba_offset);
-}
 
-// 写入分区
-int ide_pio_part_write(ide_part_t *part, void *buffer, u8 sector_count, idx_t lba_offset)
+// 把 iov 中的缓冲区按物理页拆分填入 PRD 表，物理地址连续且在同一个 64K 中的相邻两段合并，
+// 返回使用的 PRD 数量，PRD 表放不下或者缓冲区不能 DMA 时返回 -EINVAL
+static int ide_prd_fill(ide_ctrl_t *ctrl, iovec_t *iov, int iovcnt)
 {
-    return ide_pio_write(part->disk, buffer, sector_count, part->start + lba_offset);
+    int nr = 0;
+    for (size_t i = 0; i < iovcnt; i++)
+    {
+        if (!dma_capable(iov[i].base, iov[i].size))
+            return -EINVAL;
+
+        u32 addr = (u32)iov[i].base;
+        u32 left = iov[i].size;
+        while (left)
+        {
+            u32 chars = MIN(left, PAGE_SIZE - (addr & (PAGE_SIZE - 1)));
+            u32 paddr = get_paddr(addr);
+            if (!paddr)
+                return -EINVAL;
+
+            ide_prd_t *prev = nr ? &ctrl->prdt[nr - 1] : NULL;
+            if (prev && prev->addr + prev->len == paddr &&
+                (prev->addr >> 16) == ((paddr + chars - 1) >> 16))
+            {
+                prev->len += chars;
+            }
+            else
+            {
+                if (nr == IDE_PRD_NR)
+                    return -EINVAL;
+                ctrl->prdt[nr].addr = paddr;
+                ctrl->prdt[nr].len = chars;
+                nr++;
+            }
+            addr += chars;
+            left -= chars;
+        }
+    }
+    assert(nr > 0);
+
+    // 长度只保留低 16 位，64K 为 0
+    for (size_t i = 0; i < nr; i++)
+        ctrl->prdt[i].len &= 0xffff;
+    ctrl->prdt[nr - 1].len |= IDE_LAST_PRD;
+    return nr;
 }
 
-static void ide_configure_dma(ide_ctrl_t *ctrl, int command, char *buffer, u32 length)
+static err_t ide_configure_dma(ide_ctrl_t *ctrl, int command, iovec_t *iov, int iovcnt)
 {
-    // 确保缓冲区不跨页
-    assert(((u32)buffer + length) <= ((u32)buffer & (~0xfff)) + PAGE_SIZE);
-
     // 配置 PRDT
-    ctrl->prd.addr = get_paddr((u32)buffer);
-    ctrl->prd.len = length | IDE_LAST_PRD;
+    int ret = ide_prd_fill(ctrl, iov, iovcnt);
+    if (ret < EOK)
+        return ret;
 
-    // 设置 PRD 地址
-    outl(ctrl->bmbase + BM_PRD_ADDR, (u32)&ctrl->prd);
+    // 设置 PRD 表的物理地址
+    outl(ctrl->bmbase + BM_PRD_ADDR, get_paddr((u32)ctrl->prdt));
 
     // 设置 DMA 读写命令
     outb(ctrl->bmbase + BM_COMMAND_REG, command | BM_CR_STOP);
 
-    // 启用中断和错误标志
+    // 清除中断和错误标志，写 1 清除
     outb(ctrl->bmbase + BM_STATUS_REG, inb(ctrl->bmbase + BM_STATUS_REG) | BM_SR_INT | BM_SR_ERR);
+    return EOK;
 }
 
 // 启动 DMA
@@ -461,67 +517,142 @@ static err_t ide_terminate_dma(ide_ctrl_t *ctrl)
     return EOK;
 }
 
-err_t ide_udma_read(ide_disk_t *disk, void *buffer, u8 sector_count, idx_t lba_offset)
+// UDMA 方式读写磁盘，一条命令读写 iov 中的所有缓冲区，缓冲区可以分布在不连续的物理页中
+static int ide_udma_transfer(ide_disk_t *disk, iovec_t *iov, int iovcnt, idx_t lba, u32 type)
 {
-    LOGK("Performing DMA read at LBA 0x%x\n", lba_offset);
-
-    int result = 0;
     ide_ctrl_t *ctrl = disk->ctrl;
+    u32 count = iovec_size(iov, iovcnt) / SECTOR_SIZE;
+    if (!count || count > 0xff)
+        return -EINVAL;
+
+    LOGK("Performing DMA %s at LBA 0x%x count %d\n", type == REQ_READ ? "read" : "write", lba, count);
 
     lock_acquire(&ctrl->lock);
 
-    // 配置 DMA 读取
-    ide_configure_dma(ctrl, BM_CR_READ, buffer, sector_count * SECTOR_SIZE);
+    int result = EOK;
+
+    // 选择磁盘
+    ide_select_drive(disk);
+
+    // 等待设备就绪
+    if ((result = ide_busy_wait(ctrl, IDE_SR_DRDY, IDE_TIMEOUT)) < EOK)
+        goto cleanup;
+
+    // 配置 DMA，磁盘读即总线主控写内存
+    if ((result = ide_configure_dma(ctrl, type == REQ_READ ? BM_CR_READ : BM_CR_WRITE, iov, iovcnt)) < EOK)
+        goto cleanup;
 
     // 选择扇区
-    ide_select_sector(disk, lba_offset, sector_count);
+    ide_select_sector(disk, lba, count);
 
-    // 发出 UDMA 读取命令
-    outb(disk->ctrl->iobase + IDE_COMMAND, IDE_CMD_READ_UDMA);
+    // 发出 UDMA 读写命令
+    outb(ctrl->iobase + IDE_COMMAND, type == REQ_READ ? IDE_CMD_READ_UDMA : IDE_CMD_WRITE_UDMA);
 
     ide_begin_dma(ctrl);
 
-    disk->ctrl->waiter = running_task();
-    if ((result = task_block(disk->ctrl->waiter, NULL, TASK_BLOCKED, IDE_TIMEOUT)) < EOK)
+    // 整个传输完成后只有一次中断
+    ctrl->waiter = running_task();
+    if ((result = task_block(ctrl->waiter, NULL, TASK_BLOCKED, IDE_TIMEOUT)) < EOK)
     {
         LOGK("IDE DMA error occurred!!! %d\n", result);
+        ctrl->waiter = NULL;
     }
 
-    assert(ide_terminate_dma(ctrl) == EOK);
+    err_t ret = ide_terminate_dma(ctrl);
+    if (result >= EOK)
+        result = ret;
 
+    // 命令失败时磁盘状态寄存器中有错误标志
+    if (result >= EOK && (inb(ctrl->iobase + IDE_STATUS) & IDE_SR_ERR))
+    {
+        ide_error(ctrl);
+        result = -EIO;
+    }
+
+cleanup:
     lock_release(&ctrl->lock);
     return result;
 }
 
-err_t ide_udma_write(ide_disk_t *disk, void *buffer, u8 sector_count, idx_t lba_offset)
+err_t ide_udma_read(ide_disk_t *disk, void *buffer, u8 sector_count, idx_t lba_offset)
 {
-    LOGK("Performing DMA write at LBA 0x%x\n", lba_offset);
-    int result = EOK;
-    ide_ctrl_t *ctrl = disk->ctrl;
-
-    lock_acquire(&ctrl->lock);
-
-    // 配置 DMA 写入
-    ide_configure_dma(ctrl, BM_CR_WRITE, buffer, sector_count * SECTOR_SIZE);
+    iovec_t iov = {sector_count * SECTOR_SIZE, buffer};
+    return ide_udma_transfer(disk, &iov, 1, lba_offset, REQ_READ);
+}
 
-    // 选择扇区
-    ide_select_sector(disk, lba_offset, sector_count);
+err_t ide_udma_write(ide_disk_t *disk, void *buffer, u8 sector_count, idx_t lba_offset)
+{
+    iovec_t iov = {sector_count * SECTOR_SIZE, buffer};
+    return ide_udma_transfer(disk, &iov, 1, lba_offset, REQ_WRITE);
+}
 
-    // 发出 UDMA 写入命令
-    outb(disk->ctrl->iobase + IDE_COMMAND, IDE_CMD_WRITE_UDMA);
+// DMA 失败说明控制器或磁盘不支持，复位控制器之后改用 PIO
+static void ide_dma_fallback(ide_disk_t *disk, int ret)
+{
+    LOGK("IDE %s DMA failed %d, fall back to PIO\n", disk->name, ret);
+    ide_reset_controller(disk->ctrl);
+    disk->ctrl->iotype = IDE_TYPE_PIO;
+}
 
-    ide_begin_dma(ctrl);
+// 读磁盘，控制器支持时使用 UDMA，否则使用 PIO，
+// 缓冲区不能 DMA 时（如用户内存）这次请求使用 PIO
+static int ide_read(ide_disk_t *disk, void *buf, u8 count, idx_t lba)
+{
+    if (disk->ctrl->iotype == IDE_TYPE_UDMA)
+    {
+        int ret = ide_udma_read(disk, buf, count, lba);
+        if (ret >= EOK)
+            return ret;
+        if (ret != -EINVAL)
+            ide_dma_fallback(disk, ret);
+    }
+    return ide_pio_read(disk, buf, count, lba);
+}
 
-    disk->ctrl->waiter = running_task();
-    if ((result = task_block(disk->ctrl->waiter, NULL, TASK_BLOCKED, IDE_TIMEOUT)) < EOK)
+// 写磁盘，控制器支持时使用 UDMA，否则使用 PIO，
+// 缓冲区不能 DMA 时（如用户内存）这次请求使用 PIO
+static int ide_write(ide_disk_t *disk, void *buf, u8 count, idx_t lba)
+{
+    if (disk->ctrl->iotype == IDE_TYPE_UDMA)
     {
-        LOGK("IDE DMA error occurred!!! %d\n", result);
+        int ret = ide_udma_write(disk, buf, count, lba);
+        if (ret >= EOK)
+            return ret;
+        if (ret != -EINVAL)
+            ide_dma_fallback(disk, ret);
     }
+    return ide_pio_write(disk, buf, count, lba);
+}
 
-    assert(ide_terminate_dma(ctrl) == EOK);
+// 分散聚集读写磁盘，只有 UDMA 支持，PIO 时返回 -ENOSYS 由调用者经过连续的内存读写
+static int ide_sgio(ide_disk_t *disk, iovec_t *iov, int iovcnt, idx_t lba, u32 type)
+{
+    if (disk->ctrl->iotype != IDE_TYPE_UDMA)
+        return -ENOSYS;
+
+    int ret = ide_udma_transfer(disk, iov, iovcnt, lba, type);
+    if (ret >= EOK || ret == -EINVAL)
+        return ret;
+    ide_dma_fallback(disk, ret);
+    return -ENOSYS;
+}
 
-    lock_release(&ctrl->lock);
-    return result;
+// 读取分区
+int ide_part_read(ide_part_t *part, void *buffer, u8 sector_count, idx_t lba_offset)
+{
+    return ide_read(part->disk, buffer, sector_count, part->start + lba_offset);
+}
+
+// 写入分区
+int ide_part_write(ide_part_t *part, void *buffer, u8 sector_count, idx_t lba_offset)
+{
+    return ide_write(part->disk, buffer, sector_count, part->start + lba_offset);
+}
+
+// 分区分散聚集读写
+static int ide_part_sgio(ide_part_t *part, iovec_t *iov, int iovcnt, idx_t lba, u32 type)
+{
+    return ide_sgio(part->disk, iov, iovcnt, part->start + lba, type);
 }
 
 // 读取 ATAPI 数据包
@@ -595,7 +726,7 @@ exit:
 }
 
 
-sstatic int ide_atapi_packet_read_dma(ide_disk_t *disk, u8 *pkt, int pktlen, void *buf, size_t bufsize)
+static int ide_atapi_packet_read_dma(ide_disk_t *disk, u8 *pkt, int pktlen, void *buf, size_t bufsize)
 {
     // 等待磁盘空闲
     // ide_busy_wait(disk->ctrl, IDE_SR_NULL);
@@ -604,7 +735,10 @@ sstatic int ide_atapi_packet_read_dma(ide_disk_t *disk, u8 *pkt, int pktlen, voi
     lock_acquire(&disk->ctrl->lock);
 
     // 初始化 DMA 设置
-    ide_setup_dma(disk->ctrl, BM_CR_READ, buf, bufsize);
+    int result = EOF;
+    iovec_t iov = {bufsize, buf};
+    if ((result = ide_configure_dma(disk->ctrl, BM_CR_READ, &iov, 1)) < EOK)
+        goto error;
 
     // 配置必要的寄存器
     outb(disk->ctrl->iobase + IDE_FEATURE, IDE_ATAPI_FEATURE_DMA);
@@ -617,7 +751,6 @@ sstatic int ide_atapi_packet_read_dma(ide_disk_t *disk, u8 *pkt, int pktlen, voi
     // 发出 ATAPI 命令
     outb(disk->ctrl->iobase + IDE_COMMAND, IDE_CMD_PACKET);
 
-    int result = EOF;
     // 检查磁盘状态，确保设备就绪
     if ((result = ide_busy_wait(disk->ctrl, IDE_SR_DRDY, IDE_TIMEOUT)) < 0)
         goto error;
@@ -630,7 +763,7 @@ sstatic int ide_atapi_packet_read_dma(ide_disk_t *disk, u8 *pkt, int pktlen, voi
     }
 
     // 启动 DMA 操作
-    ide_start_dma(disk->ctrl);
+    ide_begin_dma(disk->ctrl);
 
     // 等待 DMA 操作完成
     task_t *task = running_task();
@@ -639,7 +772,8 @@ sstatic int ide_atapi_packet_read_dma(ide_disk_t *disk, u8 *pkt, int pktlen, voi
         goto error;
 
     // 确保 DMA 正常停止并无错误
-    assert(ide_stop_dma(disk->ctrl) == EOK);
+    if ((result = ide_terminate_dma(disk->ctrl)) < EOK)
+        goto error;
     result = bufsize;
 
 error:
@@ -698,11 +832,13 @@ static int ide_atapi_read(ide_disk_t *disk, void *buf, int count, idx_t lba)
     packet[7] = (count >> 8) & 0xFF;
     packet[8] = count & 0xFF;
 
+    // 用户内存不能 DMA，改用 PIO
+    size_t size = count * disk->sector_size;
     int (*read_func)() = ide_atapi_packet_read_pio;
-    if (disk->ctrl->iotype == IDE_TYPE_UDMA)
+    if (disk->ctrl->iotype == IDE_TYPE_UDMA && dma_capable(buf, size))
         read_func = ide_atapi_packet_read_dma;
 
-    return read_func(disk, packet, sizeof(packet), buf, count * disk->sector_size);
+    return read_func(disk, packet, sizeof(packet), buf, size);
 }
 
 // 设备探测
@@ -768,6 +904,30 @@ static void ide_fixstrings(char *buf, u32 len)
     buf[len - 1] = '\0';
 }
 
+// 设置块模式，每次中断传输 sectors 个扇区，磁盘拒绝时不使用块模式
+static void ide_set_multiple(ide_disk_t *disk, u8 sectors)
+{
+    disk->multiple = 0;
+    if (sectors <= 1)
+        return;
+
+    // 每块扇区数必须是 2 的幂
+    while (sectors & (sectors - 1))
+        sectors &= sectors - 1;
+
+    outb(disk->ctrl->iobase + IDE_SECTOR, sectors);
+    outb(disk->ctrl->iobase + IDE_COMMAND, IDE_CMD_SET_MULTIPLE);
+    if (ide_busy_wait(disk->ctrl, IDE_SR_DRDY, IDE_TIMEOUT) < EOK)
+    {
+        LOGK("Disk %s rejects multiple mode %d\n", disk->name, sectors);
+        return;
+    }
+
+    disk->multiple = sectors;
+    LOGK("Disk %s multiple mode %d sectors, %d bits io\n",
+         disk->name, sectors, disk->dword_io ? 32 : 16);
+}
+
 // 识别 IDE 设备
 static err_t ide_identify(ide_disk_t *disk, u16 *buf)
 {
@@ -816,13 +976,15 @@ static err_t ide_identify(ide_disk_t *disk, u16 *buf)
     // 赋值
     disk->total_lba = params->total_lba;
     disk->cylinders = params->cylinders;
-    disk->heads = params->heads
+    disk->heads = params->heads;
     disk->sectors = params->sectors;
-    ret = EOK;
+    disk->dword_io = params->dword_io & 1;
+    ide_set_multiple(disk, params->drq_sectors);
+    status = EOK;
 
 rollback:
     lock_release(&disk->ctrl->lock); // 释放锁
-    return ret;
+    return status;
 }
 
 static void ide_part_init(ide_disk_t *disk, u16 *buf)
@@ -845,7 +1007,7 @@ static void ide_part_init(ide_disk_t *disk, u16 *buf)
         if (entry->count == 0)
             continue;
 
-        snprintf(part->name, sizeof(part->name), "%s%d", disk->name, i + 1);
+        sprintf(part->name, "%s%d", disk->name, i + 1);
 
         LOGK("Partition %s\n", part->name);
         LOGK("    Bootable flag: %d\n", entry->bootable);
@@ -907,12 +1069,18 @@ static void ide_ctrl_init()
     for (size_t cidx = 0; cidx < IDE_CTRL_NR; cidx++)
     {
         ide_ctrl_t *ctrl = &controllers[cidx];
-        snprintf(ctrl->name, sizeof(ctrl->name), "ide%u", (unsigned)cidx);
+        sprintf(ctrl->name, "ide%u", (unsigned)cidx);
         lock_init(&ctrl->lock);
         ctrl->active = NULL;
         ctrl->waiter = NULL;
         ctrl->iotype = iotype;
         ctrl->bmbase = bmbase + cidx * 8;
+        ctrl->prdt = NULL;
+        if (iotype == IDE_TYPE_UDMA)
+        {
+            // 一页对齐到 4K，PRD 表不会跨 64K 边界
+            ctrl->prdt = (ide_prd_t *)alloc_kpage(1);
+        }
 
         if (cidx == 1)
         {
@@ -928,7 +1096,7 @@ static void ide_ctrl_init()
         for (size_t didx = 0; didx < IDE_DISK_NR; didx++)
         {
             ide_disk_t *disk = &ctrl->disks[didx];
-            snprintf(disk->name, sizeof(disk->name), "hd%c", 'a' + cidx * 2 + didx);
+            sprintf(disk->name, "hd%c", 'a' + cidx * 2 + didx);
             disk->ctrl = ctrl;
             disk->master = (didx == 0);
             disk->selector = (didx == 0) ? IDE_LBA_MASTER : IDE_LBA_SLAVE;
@@ -970,17 +1138,9 @@ static void ide_ctrl_init()
 
 static void ide_install()
 {
-    void *read = ide_pio_read;
-    void *write = ide_pio_write;
-
     for (size_t cidx = 0; cidx < IDE_CTRL_NR; cidx++)
     {
         ide_ctrl_t *ctrl = &controllers[cidx];
-        if (ctrl->iotype == IDE_TYPE_UDMA)
-        {
-            read = ide_udma_read;
-            write = ide_udma_write;
-        }
 
         for (size_t didx = 0; didx < IDE_DISK_NR; didx++)
         {
@@ -990,9 +1150,11 @@ static void ide_install()
 
             if (disk->interface == IDE_INTERFACE_ATA)
             {
+                // 读写时根据控制器选择 UDMA 或 PIO
                 dev_t dev = device_install(
                     DEV_BLOCK, DEV_IDE_DISK, disk, disk->name, 0, // 磁盘为块设备，子类型为磁盘，指针为磁盘指针，父设备为 0 
-                    ide_pio_ioctl, read, write); // 父设备为磁盘
+                    ide_pio_ioctl, ide_read, ide_write); // 父设备为磁盘
+                device_get(dev)->sgio = (void *)ide_sgio;
 
                 for (size_t i = 0; i < IDE_PART_NR; i++)
                 {
@@ -1000,9 +1162,10 @@ static void ide_install()
                     if (part->count == 0)
                         continue;
 
-                    device_install( // 扇区的 count 不为 0 则注册
+                    dev_t pdev = device_install( // 扇区的 count 不为 0 则注册
                         DEV_BLOCK, DEV_IDE_PART, part, part->name, dev,
-                        ide_pio_part_ioctl, ide_pio_part_read, ide_pio_part_write); //块设备是分区
+                        ide_pio_part_ioctl, ide_part_read, ide_part_write); //块设备是分区
+                    device_get(pdev)->sgio = (void *)ide_part_sgio;
                 }
             }
             else if (disk->interface == IDE_INTERFACE_ATAPI)
@@ -12,10 +12,15 @@ void idle_thread()
     {
         // LOGK("idle task.... %d\n", counter++);
         // BMB;
+        // 暂停前释放大内核锁，让其他处理器可以进入内核
+        interrupt_disable();
+        int depth = kernel_unlock();
         asm volatile(
             "sti\n" // 开中断
             "hlt\n" // 关闭 CPU，进入暂停状态，等待外中断的到来
         );
+        interrupt_disable();
+        kernel_relock(depth);
         yield(); // 放弃执行权，调度执行其他任务
     }
 }
@@ -41,6 +41,8 @@ extern void init_tty();
 extern void init_rtc();
 
 extern void init_ide();
+extern void init_ahci();
+extern void init_virtio_blk();
 extern void init_floppy();
 extern void init_ramdisk();
 extern void init_sb16();
@@ -67,10 +69,12 @@ void configure_thread()
 
     init_ramdisk(); // 配置内存虚拟磁盘
 
-    init_ide();    // 配置 IDE 设备
-    init_sb16();   // 配置声卡
-    init_floppy(); // 配置软盘驱动器
-    init_e1000();  // 配置 e1000 网卡
+    init_ide();        // 配置 IDE 设备
+    init_ahci();       // 配置 AHCI 设备
+    init_virtio_blk(); // 配置 virtio 块设备
+    init_sb16();       // 配置声卡
+    init_floppy();     // 配置软盘驱动器
+    init_e1000();      // 配置 e1000 网卡
 
     init_buffer(); // 配置高速缓冲
     init_file();   // 配置文件系统
@@ -2,7 +2,7 @@
 
 #define LOGK(fmt, args...) DEBUGK(fmt, ##args)
 
-#define ENTRY_SIZE 0x30
+#define ENTRY_SIZE 0x40
 
 #define PIC_MASTER_CTRL 0x20 // 主片的控制端口
 #define PIC_MASTER_DATA 0x21 // 主片的数据端口
@@ -43,13 +43,50 @@ static const char *exception_messages[] = {
     "#CP Control Protection Exception"
 };
 
-// 向中断控制器发送中断结束信号
-static void send_end_of_interrupt(int vector) {
-    if (vector >= 0x20 && vector < 0x30) {
+#define PIC_READ_ISR 0x0B // 读取中断服务寄存器
+
+static bool apic_mode = false; // 外部中断经 IOAPIC 分发
+
+// 8259 在中断请求撤销过早时会产生 IRQ 7 / 15 伪中断，
+// 此时中断服务寄存器中对应位为 0，不能发送中断结束信号
+static bool pic_spurious(int vector)
+{
+    if (vector == IRQ_MASTER_NR + 7)
+    {
+        outb(PIC_MASTER_CTRL, PIC_READ_ISR);
+        return !(inb(PIC_MASTER_CTRL) & 0x80);
+    }
+    if (vector == IRQ_SLAVE_NR + 7)
+    {
+        outb(PIC_SLAVE_CTRL, PIC_READ_ISR);
+        if (inb(PIC_SLAVE_CTRL) & 0x80)
+            return false;
+        // 主片的级联中断是真实的，仍需要通知主片
         outb(PIC_MASTER_CTRL, PIC_END_OF_INTERRUPT);
-        if (vector >= 0x28) {
-            outb(PIC_SLAVE_CTRL, PIC_END_OF_INTERRUPT);
-        }
+        return true;
+    }
+    return false;
+}
+
+// 向中断控制器发送中断结束信号
+void send_eoi(int vector)
+{
+    if (vector < IRQ_MASTER_NR || vector == LAPIC_SPURIOUS_VECTOR)
+        return;
+
+    if (apic_mode || vector >= IRQ_MASTER_NR + 16)
+    {
+        lapic_eoi();
+        return;
+    }
+
+    if (pic_spurious(vector))
+        return;
+
+    outb(PIC_MASTER_CTRL, PIC_END_OF_INTERRUPT);
+    if (vector >= IRQ_SLAVE_NR)
+    {
+        outb(PIC_SLAVE_CTRL, PIC_END_OF_INTERRUPT);
     }
 }
 
@@ -67,10 +104,26 @@ void set_interrupt_handler(u32 irq, handler_t handler)
     handler_table[IRQ_MASTER_NR + irq] = handler;
 }
 
+// 设置 local APIC 中断向量的处理程序
+void set_vector_handler(u32 vector, handler_t handler)
+{
+    assert(vector >= LAPIC_RESCHED_VECTOR && vector < ENTRY_SIZE);
+    handler_table[vector] = handler;
+}
+
 // 更新中断屏蔽位
 void set_interrupt_mask(u32 irq, bool enable)
 {
     assert(irq < 16 && irq >= 0);
+
+    if (apic_mode)
+    {
+        // IOAPIC 模式下不需要级联，IRQ 2 的引脚可能被时钟占用
+        if (irq != IRQ_CASCADE)
+            ioapic_mask(irq, !enable);
+        return;
+    }
+
     u16 port = (irq < 8) ? PIC_MASTER_DATA : PIC_SLAVE_DATA;  // 根据 IRQ 选择端口
     irq = (irq < 8) ? irq : irq - 8;
 
@@ -113,7 +166,7 @@ void set_interrupt_state(bool state) {
 
 // 默认中断处理程序
 static void default_handler(int vector) {
-    send_end_of_interrupt(vector);
+    send_eoi(vector);
     DEBUGK("[%x] default interrupt called...\n", vector);
 }
 
@@ -205,6 +258,39 @@ static void idt_init() {
     asm volatile("lidt idt_ptr\n");  // 加载 IDT 表地址
 }
 
+// 改用 IOAPIC 分发外部中断：屏蔽 8259，
+// 按 8259 当前的屏蔽状态设置各 IRQ 的重定向表项，中断向量不变
+void interrupt_apic_init()
+{
+    assert(ioapic_base);
+    bool intr = interrupt_disable();
+
+    u16 mask = inb(PIC_MASTER_DATA) | (inb(PIC_SLAVE_DATA) << 8);
+    outb(PIC_MASTER_DATA, 0xFF);
+    outb(PIC_SLAVE_DATA, 0xFF);
+
+    for (size_t irq = 0; irq < 16; irq++)
+    {
+        if (irq == IRQ_CASCADE)
+            continue;
+        ioapic_route(irq, IRQ_MASTER_NR + irq, mask & (1 << irq));
+    }
+
+    // 不再经 LINT0 接收 8259 的中断
+    lapic_write(LAPIC_LVT_LINT0, LAPIC_LVT_MASKED);
+    apic_mode = true;
+
+    // 时钟中断改由 local APIC 定时器产生，PIT 通道 2 仍可用于延时
+    if (LAPIC_CLOCK)
+    {
+        ioapic_mask(IRQ_CLOCK, true);
+        lapic_timer_start();
+    }
+
+    set_interrupt_state(intr);
+    LOGK("interrupt controller switch to IOAPIC\n");
+}
+
 // 中断初始化函数
 void interrupt_init() {
     pic_init(); // 初始化 8259A 可编程中断控制器
@@ -98,3 +98,67 @@ outl:
     leave ; 恢复栈帧
     ret
 
+
+global insw ; 从端口连续输入 count 个字
+insw:
+    push ebp
+    mov ebp, esp ; 建立新的栈帧
+    push edi
+
+    mov edx, [ebp + 8] ; 获取端口号到 edx
+    mov edi, [ebp + 12] ; 获取缓冲区地址到 edi
+    mov ecx, [ebp + 16] ; 获取数量到 ecx
+    cld
+    rep insw ; 从端口 dx 读取 ecx 个字到 es:edi
+
+    pop edi
+    leave ; 恢复栈帧
+    ret
+
+global outsw ; 向端口连续输出 count 个字
+outsw:
+    push ebp
+    mov ebp, esp ; 建立新的栈帧
+    push esi
+
+    mov edx, [ebp + 8] ; 获取端口号到 edx
+    mov esi, [ebp + 12] ; 获取缓冲区地址到 esi
+    mov ecx, [ebp + 16] ; 获取数量到 ecx
+    cld
+    rep outsw ; 将 ds:esi 开始的 ecx 个字写入端口 dx
+
+    pop esi
+    leave ; 恢复栈帧
+    ret
+
+global insl ; 从端口连续输入 count 个双字
+insl:
+    push ebp
+    mov ebp, esp ; 建立新的栈帧
+    push edi
+
+    mov edx, [ebp + 8] ; 获取端口号到 edx
+    mov edi, [ebp + 12] ; 获取缓冲区地址到 edi
+    mov ecx, [ebp + 16] ; 获取数量到 ecx
+    cld
+    rep insd ; 从端口 dx 读取 ecx 个双字到 es:edi
+
+    pop edi
+    leave ; 恢复栈帧
+    ret
+
+global outsl ; 向端口连续输出 count 个双字
+outsl:
+    push ebp
+    mov ebp, esp ; 建立新的栈帧
+    push esi
+
+    mov edx, [ebp + 8] ; 获取端口号到 edx
+    mov esi, [ebp + 12] ; 获取缓冲区地址到 esi
+    mov ecx, [ebp + 16] ; 获取数量到 ecx
+    cld
+    rep outsd ; 将 ds:esi 开始的 ecx 个双字写入端口 dx
+
+    pop esi
+    leave ; 恢复栈帧
+    ret
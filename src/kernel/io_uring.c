@@ -0,0 +1,431 @@
+#include "hyc.h"
+
+#define LOGK(fmt, args...) DEBUGK(fmt, ##args)
+
+#define IO_WORKER_MAX 8       // 每个队列的工作线程上限
+#define IO_WORKER_IDLE 1000   // 工作线程空闲多久退出，毫秒
+
+extern int sys_read(fd_t fd, char *buf, int count);
+extern int sys_write(fd_t fd, char *buf, int count);
+extern int sys_sendmsg(int fd, msghdr_t *msg, u32 flags);
+extern int sys_recvmsg(int fd, msghdr_t *msg, u32 flags);
+extern int sys_accept(int fd, sockaddr_t *addr, int *addrlen);
+extern void *sys_mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offset);
+extern int sys_munmap(void *addr, size_t length);
+
+// 已提交的请求
+typedef struct io_request_t
+{
+    list_node_t node;    // 请求队列结点
+    io_uring_sqe_t sqe;  // 提交时复制的提交项，之后用户态可以复用该位置
+} io_request_t;
+
+// 内核中的队列，位于 inode->desc
+typedef struct io_ring_t
+{
+    io_rings_t *rings;    // 共享队列头，用户地址
+    io_uring_sqe_t *sqes; // 提交队列，用户地址
+    io_uring_cqe_t *cqes; // 完成队列，用户地址
+    size_t size;          // 共享内存大小
+    u32 sq_entries;       // 提交队列长度
+    u32 cq_entries;       // 完成队列长度
+    u32 sq_head;          // 已取走的提交项，共享页中的值只是副本
+    u32 cq_tail;          // 已写入的完成项，共享页中的值只是副本
+
+    pid_t tgid;                   // 所属进程，工作线程共享该进程的地址空间
+    list_t requests;              // 等待工作线程执行的请求
+    list_t idle;                  // 空闲的工作线程
+    int workers;                  // 工作线程数量
+    int inflight;                 // 已提交未完成的请求数量
+    list_t waiters;               // 在 io_uring_enter 中等待完成项的任务
+    task_t *tasks[IO_WORKER_MAX]; // 工作线程，关闭队列时唤醒阻塞在请求中的线程
+    int refs;                     // 引用计数，文件和每个工作线程各持有一个
+    bool dead;                    // 文件已关闭，不再写入完成项
+} io_ring_t;
+
+static void io_ring_put(io_ring_t *ring)
+{
+    assert(ring->refs > 0);
+    if (--ring->refs)
+        return;
+
+    assert(ring->workers == 0);
+    while (!list_empty(&ring->requests))
+    {
+        io_request_t *req = element_entry(io_request_t, node, list_popback(&ring->requests));
+        kfree(req);
+    }
+    kfree(ring);
+}
+
+// 写入完成项，完成队列已满时计入溢出，
+// 下标用内核保存的队尾和长度取模，用户态改写共享页也不会写到完成队列之外
+static void io_complete(io_ring_t *ring, u64 user_data, int res)
+{
+    io_rings_t *rings = ring->rings;
+    if (ring->cq_tail - rings->cq_head >= ring->cq_entries)
+    {
+        rings->cq_overflow++;
+    }
+    else
+    {
+        io_uring_cqe_t *cqe = &ring->cqes[ring->cq_tail & (ring->cq_entries - 1)];
+        cqe->user_data = user_data;
+        cqe->res = res;
+        cqe->flags = 0;
+        // 先写完成项再移动队尾，用户态看到队尾时完成项已经有效
+        ring->cq_tail++;
+        rings->cq_tail = ring->cq_tail;
+    }
+
+    while (!list_empty(&ring->waiters))
+    {
+        task_t *task = element_entry(task_t, node, ring->waiters.tail.prev);
+        task_unblock(task, EOK);
+    }
+}
+
+// 读写指定偏移时不改变文件的当前偏移
+static int io_rw(io_uring_sqe_t *sqe, bool write)
+{
+    if (sqe->off == IORING_OFF_CURRENT)
+    {
+        if (write)
+            return sys_write(sqe->fd, (char *)sqe->addr, sqe->len);
+        return sys_read(sqe->fd, (char *)sqe->addr, sqe->len);
+    }
+
+    file_t *file;
+    if (fd_check(sqe->fd, &file) < EOK)
+        return -EBADF;
+    if ((int)sqe->len < 0 || !memory_access((void *)sqe->addr, sqe->len, !write, true))
+        return -EFAULT;
+
+    int mode = file->flags & O_ACCMODE;
+    inode_t *inode = file->inode;
+    if (write)
+    {
+        if (mode == O_RDONLY)
+            return -EBADF;
+        return inode->op->write(inode, (char *)sqe->addr, sqe->len, sqe->off);
+    }
+    if (mode == O_WRONLY)
+        return -EBADF;
+    return inode->op->read(inode, (char *)sqe->addr, sqe->len, sqe->off);
+}
+
+// 在工作线程中执行请求，返回值写入完成项
+static int io_execute(io_uring_sqe_t *sqe)
+{
+    switch (sqe->opcode)
+    {
+    case IORING_OP_READ:
+        return io_rw(sqe, false);
+    case IORING_OP_WRITE:
+        return io_rw(sqe, true);
+    case IORING_OP_SENDMSG:
+        return sys_sendmsg(sqe->fd, (msghdr_t *)sqe->addr, sqe->op_flags);
+    case IORING_OP_RECVMSG:
+        return sys_recvmsg(sqe->fd, (msghdr_t *)sqe->addr, sqe->op_flags);
+    case IORING_OP_ACCEPT:
+        return sys_accept(sqe->fd, (sockaddr_t *)sqe->addr, (int *)sqe->len);
+    case IORING_OP_TIMEOUT:
+        // 到期由定时器以 -ETIME 唤醒，进程退出时以 -EINTR 唤醒
+        return task_block(running_task(), NULL, TASK_SLEEPING, sqe->off ? sqe->off : 1);
+    default:
+        return -EINVAL;
+    }
+}
+
+// 工作线程，属于提交请求的进程，依次执行队列中的请求，
+// 空闲超时、队列关闭或进程退出时结束
+static void io_worker(io_ring_t *ring)
+{
+    task_t *task = running_task();
+
+    size_t slot = 0;
+    while (ring->tasks[slot])
+        slot++;
+    assert(slot < IO_WORKER_MAX);
+    ring->tasks[slot] = task;
+
+    while (!ring->dead && !(task->signal & SIGMASK(SIGKILL)))
+    {
+        if (list_empty(&ring->requests))
+        {
+            int ret = task_block(task, &ring->idle, TASK_WAITING, IO_WORKER_IDLE);
+            if (ret == -ETIME && list_empty(&ring->requests))
+                break;
+            continue;
+        }
+
+        io_request_t *req = element_entry(io_request_t, node, list_popback(&ring->requests));
+        int res = io_execute(&req->sqe);
+
+        ring->inflight--;
+        if (!ring->dead)
+            io_complete(ring, req->sqe.user_data, res);
+        kfree(req);
+    }
+
+    ring->tasks[slot] = NULL;
+    ring->workers--;
+    io_ring_put(ring);
+    task_exit(0);
+}
+
+// 请求加入队列，唤醒空闲的工作线程，没有则按需创建
+static void io_queue(io_ring_t *ring, io_request_t *req)
+{
+    ring->inflight++;
+    list_push(&ring->requests, &req->node);
+
+    if (!list_empty(&ring->idle))
+    {
+        task_t *worker = element_entry(task_t, node, ring->idle.tail.prev);
+        task_unblock(worker, EOK);
+        return;
+    }
+
+    if (ring->workers >= IO_WORKER_MAX)
+        return;
+
+    ring->workers++;
+    ring->refs++;
+    task_create_worker((void (*)(void *))io_worker, ring, "io_worker");
+}
+
+static io_ring_t *io_ring_get(fd_t fd)
+{
+    file_t *file;
+    if (fd_check(fd, &file) < EOK)
+        return NULL;
+
+    inode_t *inode = file->inode;
+    if (!inode || inode->type != FS_TYPE_IO_URING)
+        return NULL;
+
+    // fork 继承的队列属于父进程的地址空间
+    io_ring_t *ring = (io_ring_t *)inode->desc;
+    if (ring->tgid != running_task()->tgid)
+        return NULL;
+    return ring;
+}
+
+fd_t sys_io_uring_setup(u32 entries, io_uring_params_t *params)
+{
+    if (!memory_access(params, sizeof(io_uring_params_t), true, true))
+        return -EFAULT;
+    if (!entries || entries > IO_URING_ENTRIES_MAX)
+        return -EINVAL;
+
+    // 队列长度取 2 的幂，下标取模只需要掩码
+    u32 sq_entries = 1;
+    while (sq_entries < entries)
+        sq_entries <<= 1;
+    u32 cq_entries = sq_entries * 2;
+
+    size_t size = sizeof(io_rings_t) +
+                  sq_entries * sizeof(io_uring_sqe_t) +
+                  cq_entries * sizeof(io_uring_cqe_t);
+
+    // 共享映射，fork 之后父子进程看到的是同一份队列
+    void *addr = sys_mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, EOF, 0);
+    if ((int)addr < EOK)
+        return (int)addr;
+    memset(addr, 0, size);
+
+    io_ring_t *ring = (io_ring_t *)kmalloc(sizeof(io_ring_t));
+    ring->rings = (io_rings_t *)addr;
+    ring->sqes = (io_uring_sqe_t *)(ring->rings + 1);
+    ring->cqes = (io_uring_cqe_t *)(ring->sqes + sq_entries);
+    ring->size = size;
+    ring->sq_entries = sq_entries;
+    ring->cq_entries = cq_entries;
+    ring->sq_head = 0;
+    ring->cq_tail = 0;
+    ring->tgid = running_task()->tgid;
+    list_init(&ring->requests);
+    list_init(&ring->idle);
+    ring->workers = 0;
+    ring->inflight = 0;
+    list_init(&ring->waiters);
+    memset(ring->tasks, 0, sizeof(ring->tasks));
+    ring->refs = 1;
+    ring->dead = false;
+
+    ring->rings->sq_mask = sq_entries - 1;
+    ring->rings->cq_mask = cq_entries - 1;
+
+    // 最后安装文件描述符，失败时不会留下半初始化的文件
+    file_t *file;
+    fd_t fd = fd_get(&file);
+    if (fd < EOK)
+    {
+        kfree(ring);
+        sys_munmap(addr, size);
+        return fd;
+    }
+
+    inode_t *inode = get_free_inode();
+    inode->dev = -FS_TYPE_IO_URING;
+    inode->type = FS_TYPE_IO_URING;
+    inode->op = fs_get_op(FS_TYPE_IO_URING);
+    inode->desc = ring;
+    inode->count = 1;
+
+    file->inode = inode;
+    file->flags = O_RDWR;
+    file->offset = 0;
+
+    params->sq_entries = sq_entries;
+    params->cq_entries = cq_entries;
+    params->rings = ring->rings;
+    params->sqes = ring->sqes;
+    params->cqes = ring->cqes;
+
+    LOGK("io_uring setup fd %d entries %d at 0x%p\n", fd, sq_entries, addr);
+    return fd;
+}
+
+int sys_io_uring_enter(fd_t fd, u32 to_submit, u32 min_complete, u32 flags)
+{
+    io_ring_t *ring = io_ring_get(fd);
+    if (!ring)
+        return -EBADF;
+
+    io_rings_t *rings = ring->rings;
+    int submitted = 0;
+
+    // 队尾来自用户态，只作为计数使用，最多取走一整个提交队列
+    u32 pending = rings->sq_tail - ring->sq_head;
+    if (pending > ring->sq_entries)
+        pending = ring->sq_entries;
+    if (to_submit > pending)
+        to_submit = pending;
+
+    // 一次系统调用提交一批请求
+    while (submitted < to_submit)
+    {
+        io_uring_sqe_t *sqe = &ring->sqes[ring->sq_head & (ring->sq_entries - 1)];
+        ring->sq_head++;
+        rings->sq_head = ring->sq_head;
+        submitted++;
+
+        if (sqe->opcode == IORING_OP_NOP)
+        {
+            io_complete(ring, sqe->user_data, 0);
+            continue;
+        }
+        if (sqe->opcode >= IORING_OP_LAST)
+        {
+            io_complete(ring, sqe->user_data, -EINVAL);
+            continue;
+        }
+
+        io_request_t *req = (io_request_t *)kmalloc(sizeof(io_request_t));
+        memcpy(&req->sqe, sqe, sizeof(io_uring_sqe_t));
+        req->node.next = req->node.prev = NULL;
+        io_queue(ring, req);
+    }
+
+    if (!(flags & IORING_ENTER_GETEVENTS))
+        return submitted;
+
+    // 等待期间其他线程可能关闭队列
+    task_t *task = running_task();
+    int ret = submitted;
+    ring->refs++;
+    while (ring->cq_tail - rings->cq_head < min_complete)
+    {
+        // 没有未完成的请求，不会再有新的完成项
+        if (!ring->inflight || ring->dead)
+            break;
+
+        // 多个线程可以同时等待，完成时全部唤醒
+        int err = task_block(task, &ring->waiters, TASK_WAITING, TIMELESS);
+        if (err < EOK)
+        {
+            if (!submitted)
+                ret = err;
+            break;
+        }
+    }
+    io_ring_put(ring);
+    return ret;
+}
+
+static void io_uring_close(inode_t *inode)
+{
+    if (!inode)
+        return;
+    inode->count--;
+    if (inode->count)
+        return;
+
+    io_ring_t *ring = (io_ring_t *)inode->desc;
+    ring->dead = true;
+
+    // 由所属进程关闭时解除共享内存映射，进程退出时地址空间随后整体释放
+    task_t *task = running_task();
+    if (ring->tgid == task->tgid)
+        sys_munmap(ring->rings, ring->size);
+
+    // 唤醒空闲的工作线程退出，正在执行请求的线程在请求返回后退出
+    while (!list_empty(&ring->idle))
+    {
+        task_t *worker = element_entry(task_t, node, ring->idle.tail.prev);
+        task_unblock(worker, -EINTR);
+    }
+
+    // 阻塞在管道等可杀死等待中的请求提前返回，线程随后退出
+    for (size_t i = 0; i < IO_WORKER_MAX; i++)
+    {
+        task_t *worker = ring->tasks[i];
+        if (worker && worker->state == TASK_BLOCKED && (worker->flags & TASK_KILLABLE))
+            task_unblock(worker, -EINTR);
+    }
+
+    while (!list_empty(&ring->waiters))
+    {
+        task_t *task = element_entry(task_t, node, ring->waiters.tail.prev);
+        task_unblock(task, -EINTR);
+    }
+
+    inode->type = FS_TYPE_NONE;
+    inode->desc = NULL;
+    inode->op = NULL;
+    put_free_inode(inode);
+
+    io_ring_put(ring);
+    LOGK("io_uring close...\n");
+}
+
+static fs_op_t io_uring_op = {
+    fs_default_nosys,
+    fs_default_nosys,
+
+    fs_default_nosys,
+    io_uring_close,
+
+    fs_default_nosys,
+    fs_default_nosys,
+    fs_default_nosys,
+    fs_default_nosys,
+
+    fs_default_nosys,
+    fs_default_nosys,
+
+    fs_default_nosys,
+    fs_default_nosys,
+    fs_default_nosys,
+    fs_default_nosys,
+    fs_default_nosys,
+    fs_default_nosys,
+    fs_default_nosys,
+};
+
+void io_uring_init()
+{
+    fs_register_op(FS_TYPE_IO_URING, &io_uring_op);
+}
@@ -217,6 +217,7 @@ static char keymap[][4] = {
 
 static lock_t lock;    // 锁
 static task_t *waiter; // 等待输入的任务
+static wait_queue_t rx_wait; // 就绪等待队列
 
 #define BUFFER_SIZE 64        // 输入缓冲区大小
 static char buf[BUFFER_SIZE]; // 输入缓冲区
@@ -327,6 +328,7 @@ static void keyboard_handler(int vector) {
         task_unblock(waiter, EOK); 
         waiter = NULL; 
     }
+    wake_up(&rx_wait, POLLIN);
 
     tty_rx_notify(); 
 }
@@ -356,6 +358,13 @@ u32 keyboard_read(void *dev, char *buf, u32 count) {
     return count;
 }
 
+// 有输入时可读
+int keyboard_poll(void *dev, poll_table_t *pt)
+{
+    poll_wait(pt, &rx_wait);
+    return fifo_empty(&fifo) ? 0 : POLLIN;
+}
+
 void keyboard_init()
 {
     // 初始化 FIFO 缓冲区
@@ -375,6 +384,7 @@ void keyboard_init()
 
     // 初始化等待任务指针
     waiter = NULL;
+    wait_queue_init(&rx_wait);
 
     // 设置中断处理程序
     set_interrupt_handler(IRQ_KEYBOARD, keyboard_handler);
@@ -383,9 +393,10 @@ void keyboard_init()
     set_interrupt_mask(IRQ_KEYBOARD, true);
 
     // 注册设备
-    device_install(
+    dev_t dev = device_install(
         DEV_CHAR, DEV_KEYBOARD,
         NULL, "keyboard", 0,
         NULL, keyboard_read, NULL
     );
+    device_get(dev)->poll = keyboard_poll;
 }
\ No newline at end of file
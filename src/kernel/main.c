@@ -1,5 +1,6 @@
 #include "hyc.h"
 
+extern void percpu_init();
 extern void tss_init();
 extern void memory_map_init();
 extern void mapping_init();
@@ -7,11 +8,19 @@ extern void arena_init();
 
 extern void interrupt_init();
 extern void clock_init();
+extern void vdso_init();
 extern void timer_init();
 extern void syscall_init();
 extern void task_init();
+extern void futex_init();
+extern void io_uring_init();
+extern void epoll_init();
 extern void fpu_init();
 extern void pci_init();
+extern void smp_init();
+extern void softirq_init();
+extern void workqueue_init();
+extern void smp_boot();
 
 extern void pbuf_init();
 extern void netif_init();
@@ -31,6 +40,7 @@ extern void raw_init();
 
 void kernel_init()
 {
+    percpu_init();     // 初始化启动处理器私有数据
     tss_init();        // 初始化任务状态段
     memory_map_init(); // 初始化物理内存数组
     mapping_init();    // 初始化内存映射
@@ -39,11 +49,20 @@ void kernel_init()
     interrupt_init(); // 初始化中断
     timer_init();     // 初始化定时器
     clock_init();     // 初始化时钟
+    vdso_init();      // 初始化共享数据页
     fpu_init();       // 初始化 FPU 浮点运算单元
     pci_init();       // 初始化 PCI 总线
+    smp_init();       // 初始化多处理器
 
-    syscall_init(); // 初始化系统调用
-    task_init();    // 初始化任务
+    syscall_init();  // 初始化系统调用
+    task_init();     // 初始化任务
+    futex_init();    // 初始化 futex
+    io_uring_init(); // 初始化提交 / 完成队列
+    epoll_init();    // 初始化 epoll
+    smp_boot();      // 启动应用处理器
+
+    softirq_init();   // 初始化软中断
+    workqueue_init(); // 初始化工作队列
 
     pbuf_init();   // 初始化 pbuf
     netif_init();  // 初始化 netif
@@ -338,6 +338,8 @@ void flush_tlb(u32 vaddr)
 {
     asm volatile("invlpg (%0)" ::"r"(vaddr)
                  : "memory");
+    // 线程共享页表，其他处理器可能缓存了旧的页表项
+    smp_flush_tlb(get_cr3());
 }
 
 // 在位图中扫描 count 个连续的页
@@ -651,6 +653,7 @@ int32 sys_brk(void *addr)
     }
 
     task->brk = brk;
+    task_sync_brk(task);
     return 0;
 }
 
@@ -664,7 +667,11 @@ void *sys_mmap(void *addr, size_t length, int prot, int flags, int fd, off_t off
     task_t *task = running_task();
     if (!vaddr)
     {
-        vaddr = scan_page(task->vmap, count);
+        // 映射区没有足够的连续空间时返回错误，而不是停机
+        int32 index = bitmap_scan(task->vmap, count);
+        if (index == EOF)
+            return (void *)-ENOMEM;
+        vaddr = PAGE(index);
     }
 
     assert(vaddr >= USER_MMAP_ADDR && vaddr < USER_STACK_BOTTOM);
@@ -766,6 +773,13 @@ void page_fault(
 
         page_entry_t *entry = get_entry(fault_addr, false);
 
+        // 同一线程组的其他线程已经完成写时复制，只是快表过期
+        if (entry->write)
+        {
+            flush_tlb(fault_addr);
+            return;
+        }
+
         assert(entry->present);
         assert(!entry->shared);
         assert(!entry->readonly);
@@ -813,3 +827,11 @@ bool memory_access(void *vaddr, int size, bool write, bool user)
     }
     return true;
 }
+
+// 内核内存一一映射且总是存在；用户内存的页可能不存在，或者写时复制与其他进程共享，
+// 设备直接写入会写到物理地址 0 或者其他进程的页中，只能由 CPU 复制或者经过内核缓冲
+bool dma_capable(void *buf, size_t size)
+{
+    u32 addr = (u32)buf;
+    return size && addr + size > addr && addr + size <= KERNEL_MEMORY_SIZE;
+}
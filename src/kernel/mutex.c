@@ -1,26 +1,96 @@
 #include "hyc.h"
 
+#define PI_CHAIN_MAX 16 // 优先级继承传递的最大深度，防止死锁成环
+
 void mutex_init(mutex_t *mutex) {
     mutex->value = false; // 初始化时互斥量未被占用
+    mutex->owner = NULL;
+    mutex->node.next = mutex->node.prev = NULL;
     list_init(&mutex->waiters);
 }
 
+// 等待队列中优先级最高的任务，同优先级先到先得
+static task_t *mutex_top_waiter(mutex_t *mutex) {
+    task_t *top = NULL;
+
+    // 等待者插入队首，从队尾遍历即为等待的先后顺序
+    list_t *list = &mutex->waiters;
+    for (list_node_t *ptr = list->tail.prev; ptr != &list->head; ptr = ptr->prev) {
+        task_t *task = element_entry(task_t, node, ptr);
+        if (top == NULL || task->prio < top->prio)
+            top = task;
+    }
+    return top;
+}
+
+// 任务应有的优先级：自身优先级和所持互斥量等待者优先级的最高者
+static int mutex_pi_prio(task_t *task) {
+    int prio = task->normal_prio;
+
+    list_t *list = &task->pi_mutexes;
+    for (list_node_t *ptr = list->head.next; ptr != &list->tail; ptr = ptr->next) {
+        mutex_t *mutex = element_entry(mutex_t, node, ptr);
+        task_t *top = mutex_top_waiter(mutex);
+        if (top && top->prio < prio)
+            prio = top->prio;
+    }
+    return prio;
+}
+
+void mutex_pi_update(task_t *task) {
+    assert(!get_interrupt_state());
+
+    for (size_t depth = 0; task && depth < PI_CHAIN_MAX; depth++) {
+        int prio = mutex_pi_prio(task);
+        if (depth && prio == task->prio)
+            break;
+        sched_set_prio(task, prio);
+
+        if (!task->pi_blocked_on)
+            break;
+        task = task->pi_blocked_on->owner;
+    }
+}
+
+// 等待者阻塞前，把优先级传递给持有者及其阻塞链上的任务
+static void mutex_pi_boost(mutex_t *mutex, int prio) {
+    for (size_t depth = 0; mutex && depth < PI_CHAIN_MAX; depth++) {
+        task_t *owner = mutex->owner;
+        if (!owner || owner->prio <= prio)
+            break;
+        sched_set_prio(owner, prio);
+        mutex = owner->pi_blocked_on;
+    }
+}
+
 // 尝试获取互斥量
 void mutex_lock(mutex_t *mutex) {
     // 关闭中断，保证原子操作
     bool intr_state = interrupt_disable();
 
     task_t *current_task = running_task();
-    while (mutex->value) {
-        // 如果互斥量已经被占用，将当前任务加入等待队列
+
+    // 互斥量不可重入，需要重入时使用 lock_t
+    assert(!mutex->value || mutex->owner != current_task);
+
+    // 被唤醒时互斥量可能已经移交给当前任务
+    while (mutex->value && mutex->owner != current_task) {
+        // 如果互斥量已经被占用，提升持有者优先级，将当前任务加入等待队列
+        current_task->pi_blocked_on = mutex;
+        mutex_pi_boost(mutex, current_task->prio);
         task_block(current_task, &mutex->waiters, TASK_BLOCKED, TIMELESS);
+        current_task->pi_blocked_on = NULL;
     }
 
-    // 确保没有其他任务持有互斥量
-    assert(!mutex->value);
+    // 解锁时可能已经直接移交给当前任务
+    if (mutex->owner != current_task) {
+        assert(!mutex->value);
 
-    // 当前任务占用互斥量
-    mutex->value = true;
+        // 当前任务占用互斥量
+        mutex->value = true;
+        mutex->owner = current_task;
+        list_push(&current_task->pi_mutexes, &mutex->node);
+    }
     assert(mutex->value);
 
     // 恢复之前的中断状态
@@ -32,23 +102,37 @@ void mutex_unlock(mutex_t *mutex) {
     // 关闭中断，保证原子操作
     bool intr_state = interrupt_disable();
 
+    task_t *current_task = running_task();
+
     // 确保当前任务确实持有互斥量
     assert(mutex->value);
+    assert(mutex->owner == current_task);
+    list_remove(&mutex->node);
 
-    // 释放互斥量
-    mutex->value = false;
-    assert(!mutex->value);
-
-    // 如果有等待任务，唤醒其中一个
-    if (!list_empty(&mutex->waiters)) {
-        task_t *next_task = element_entry(task_t, node, mutex->waiters.tail.prev);
+    task_t *next_task = mutex_top_waiter(mutex);
+    if (next_task) {
+        // 直接移交给优先级最高的等待者，避免被其他任务抢先获取
         assert(next_task->magic == ONIX_MAGIC);
+        mutex->owner = next_task;
+        list_push(&next_task->pi_mutexes, &mutex->node);
         task_unblock(next_task, EOK);
+        next_task->pi_blocked_on = NULL;
 
-        // 切换到新任务，防止死锁
-        task_yield();
+        // 新的持有者继承剩余等待者的优先级
+        mutex_pi_update(next_task);
+    } else {
+        // 释放互斥量
+        mutex->value = false;
+        mutex->owner = NULL;
     }
 
+    // 恢复当前任务被继承前的优先级
+    mutex_pi_update(current_task);
+
+    // 只有被唤醒的任务优先级更高时才切换
+    if (current_task->flags & TASK_NEED_RESCHED)
+        schedule();
+
     // 恢复之前的中断状态
     set_interrupt_state(intr_state);
 }
@@ -87,4 +171,3 @@ void lock_release(lock_t *lock) {
         mutex_unlock(&lock->mutex);
     }
 }
-
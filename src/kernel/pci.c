@@ -293,6 +293,64 @@ void pci_enable_busmastering(pci_device_t *device)
     pci_outl(device->bus, device->dev, device->func, PCI_CONF_COMMAND, data);
 }
 
+// 查找设备能力，返回能力结构在配置空间的偏移，0 表示不存在
+u8 pci_find_capability(pci_device_t *device, u8 id)
+{
+    u32 data = pci_inl(device->bus, device->dev, device->func, PCI_CONF_COMMAND);
+    if (!((data >> 16) & PCI_STATUS_CAP_LIST))
+        return 0;
+
+    data = pci_inl(device->bus, device->dev, device->func, PCI_CONF_CAPABILITY);
+    u8 offset = data & 0xFC;
+
+    // 能力结构位于标准配置头之后，限制次数防止链表成环
+    for (size_t i = 0; offset >= 0x40 && i < 48; i++)
+    {
+        data = pci_inl(device->bus, device->dev, device->func, offset);
+        if ((data & 0xFF) == id)
+            return offset;
+        offset = (data >> 8) & 0xFC;
+    }
+    return 0;
+}
+
+// 启用 MSI，中断以 vector 发送到 apic_id 对应的处理器
+err_t pci_enable_msi(pci_device_t *device, u8 vector, u8 apic_id)
+{
+    u8 cap = pci_find_capability(device, PCI_CAP_ID_MSI);
+    if (!cap)
+        return -ENODEV;
+
+    u8 bus = device->bus;
+    u8 dev = device->dev;
+    u8 func = device->func;
+
+    u32 data = pci_inl(bus, dev, func, cap);
+    u16 flags = data >> 16;
+
+    pci_outl(bus, dev, func, cap + 4, MSI_ADDRESS(apic_id));
+    if (flags & PCI_MSI_FLAGS_64BIT)
+    {
+        pci_outl(bus, dev, func, cap + 8, 0);
+        pci_outl(bus, dev, func, cap + 12, vector);
+    }
+    else
+    {
+        pci_outl(bus, dev, func, cap + 8, vector);
+    }
+
+    // 只使用一个消息
+    flags &= ~PCI_MSI_FLAGS_QSIZE;
+    flags |= PCI_MSI_FLAGS_ENABLE;
+    pci_outl(bus, dev, func, cap, (data & 0xFFFF) | (flags << 16));
+
+    // 关闭传统中断线
+    data = pci_inl(bus, dev, func, PCI_CONF_COMMAND);
+    data |= PCI_COMMAND_INTX_DISABLE;
+    pci_outl(bus, dev, func, PCI_CONF_COMMAND, data);
+    return EOK;
+}
+
 // 执行 PCI 总线设备枚举
 static void pci_enum_device()
 {
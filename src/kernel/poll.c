@@ -0,0 +1,238 @@
+#include "hyc.h"
+
+#define LOGK(fmt, args...) DEBUGK(fmt, ##args)
+
+#define POLL_QUEUES 2 // 每个文件最多登记的等待队列数量
+
+extern volatile u32 jiffies;
+extern u32 jiffy;
+
+// 一次 poll / select 调用的等待状态
+typedef struct poll_wqueues_t
+{
+    poll_table_t pt;       // 轮询表
+    task_t *task;          // 调用的任务
+    bool triggered;        // 登记之后发生过就绪事件
+    bool waiting;          // 任务正在阻塞
+    wait_entry_t *entries; // 挂在各文件等待队列上的等待项
+    int count;             // 已使用的等待项
+    int size;              // 等待项数量
+} poll_wqueues_t;
+
+void poll_wait(poll_table_t *pt, wait_queue_t *wq)
+{
+    if (pt && pt->queue)
+        pt->queue(pt, wq);
+}
+
+int file_poll(file_t *file, poll_table_t *pt)
+{
+    inode_t *inode = file->inode;
+    if (!inode || !inode->op || !inode->op->poll)
+        return POLLIN | POLLOUT;
+    return inode->op->poll(inode, pt);
+}
+
+static void poll_wake(wait_entry_t *entry, u32 events)
+{
+    poll_wqueues_t *table = (poll_wqueues_t *)entry->data;
+    table->triggered = true;
+    if (table->waiting && table->task->state == TASK_WAITING)
+    {
+        table->waiting = false;
+        task_unblock(table->task, EOK);
+    }
+}
+
+static void poll_queue(poll_table_t *pt, wait_queue_t *wq)
+{
+    poll_wqueues_t *table = (poll_wqueues_t *)pt;
+    if (table->count == table->size)
+        return;
+
+    wait_entry_t *entry = &table->entries[table->count++];
+    wait_entry_init(entry, poll_wake, table);
+    wait_add(wq, entry);
+}
+
+// 检查 fds 中的文件直到有就绪事件、超时或被信号打断，
+// 第一轮检查时在各文件的等待队列上登记，之后由唤醒回调解除阻塞再重新检查；
+// poll 总是报告 POLLERR 和 POLLHUP，select 已经把它们映射到关心的集合，只报告 events 中的事件
+static int do_poll(pollfd_t *fds, u32 nfds, int timeout, bool select)
+{
+    poll_wqueues_t table;
+    table.pt.queue = poll_queue;
+    table.task = running_task();
+    table.triggered = false;
+    table.waiting = false;
+    table.count = 0;
+    table.size = nfds * POLL_QUEUES;
+    table.entries = table.size ? (wait_entry_t *)kmalloc(table.size * sizeof(wait_entry_t)) : NULL;
+
+    poll_table_t *pt = &table.pt;
+    u32 start = jiffies;
+    int count = 0;
+    short always = select ? 0 : (POLLERR | POLLHUP);
+
+    while (true)
+    {
+        table.triggered = false;
+        for (size_t i = 0; i < nfds; i++)
+        {
+            pollfd_t *pfd = &fds[i];
+            pfd->revents = 0;
+            if (pfd->fd < 0)
+                continue;
+
+            file_t *file;
+            if (fd_check(pfd->fd, &file) < EOK)
+            {
+                pfd->revents = POLLNVAL;
+                count++;
+                continue;
+            }
+
+            int mask = file_poll(file, pt) & (pfd->events | always);
+            if (mask)
+            {
+                pfd->revents = mask;
+                count++;
+            }
+        }
+        // 只在第一轮登记等待
+        pt = NULL;
+
+        if (count || timeout == 0)
+            break;
+        if (table.triggered)
+            continue;
+
+        int remain = TIMELESS;
+        if (timeout > 0)
+        {
+            u32 elapsed = (jiffies - start) * jiffy;
+            if (elapsed >= timeout)
+                break;
+            remain = timeout - elapsed;
+        }
+
+        table.waiting = true;
+        int ret = task_block(table.task, NULL, TASK_WAITING, remain);
+        table.waiting = false;
+
+        if (ret == -ETIME)
+            break;
+        if (ret < EOK)
+        {
+            count = ret;
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < table.count; i++)
+    {
+        wait_remove(&table.entries[i]);
+    }
+    if (table.entries)
+        kfree(table.entries);
+    return count;
+}
+
+int sys_poll(pollfd_t *fds, u32 nfds, int timeout)
+{
+    if (nfds > FD_SETSIZE)
+        return -EINVAL;
+    if (nfds && !memory_access(fds, nfds * sizeof(pollfd_t), true, true))
+        return -EFAULT;
+    return do_poll(fds, nfds, timeout, false);
+}
+
+// 用 poll 实现 select，与 linux 相同，读集合关心可读、挂断和错误，
+// 写集合关心可写和错误，异常集合关心紧急数据
+int sys_select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, timeval *tv)
+{
+    if (nfds < 0 || nfds > FD_SETSIZE)
+        return -EINVAL;
+
+    fd_set *sets[3] = {readfds, writefds, exceptfds};
+    int events[3] = {POLLIN | POLLHUP | POLLERR, POLLOUT | POLLERR, POLLPRI};
+    int member[3] = {POLLIN, POLLOUT, POLLPRI}; // 由关心的事件区分原来所在的集合
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        if (sets[i] && !memory_access(sets[i], sizeof(fd_set), true, true))
+            return -EFAULT;
+    }
+
+    int timeout = TIMELESS;
+    if (tv)
+    {
+        if (!memory_access(tv, sizeof(timeval), false, true))
+            return -EFAULT;
+        timeout = tv->tv_sec * 1000 + tv->tv_usec / 1000;
+    }
+
+    // 统计集合中的文件描述符
+    int count = 0;
+    for (fd_t fd = 0; fd < nfds; fd++)
+    {
+        bool set = false;
+        for (size_t i = 0; i < 3; i++)
+        {
+            if (sets[i] && FD_ISSET(fd, sets[i]))
+                set = true;
+        }
+        if (!set)
+            continue;
+
+        file_t *file;
+        if (fd_check(fd, &file) < EOK)
+            return -EBADF;
+        count++;
+    }
+
+    pollfd_t *fds = count ? (pollfd_t *)kmalloc(count * sizeof(pollfd_t)) : NULL;
+    int nr = 0;
+    for (fd_t fd = 0; fd < nfds; fd++)
+    {
+        short mask = 0;
+        for (size_t i = 0; i < 3; i++)
+        {
+            if (sets[i] && FD_ISSET(fd, sets[i]))
+                mask |= events[i];
+        }
+        if (!mask)
+            continue;
+        fds[nr].fd = fd;
+        fds[nr].events = mask;
+        nr++;
+    }
+
+    int ret = do_poll(fds, count, timeout, true);
+    if (ret < EOK)
+        goto rollback;
+
+    // 按就绪事件重新填写集合，返回置位的总数
+    for (size_t i = 0; i < 3; i++)
+    {
+        if (sets[i])
+            memset(sets[i], 0, sizeof(fd_set));
+    }
+
+    ret = 0;
+    for (size_t j = 0; j < count; j++)
+    {
+        for (size_t i = 0; i < 3; i++)
+        {
+            if (!(fds[j].events & member[i]) || !(fds[j].revents & events[i]))
+                continue;
+            FD_SET(fds[j].fd, sets[i]);
+            ret++;
+        }
+    }
+
+rollback:
+    if (fds)
+        kfree(fds);
+    return ret;
+}
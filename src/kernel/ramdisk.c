@@ -11,7 +11,7 @@ typedef struct {
     u32 total_size;   // 总内存大小
 } RamDisk;
 
-static ramdisk_t ramdisks[MAX_RAMDISKS];
+static RamDisk ramdisks[MAX_RAMDISKS];
 
 int handle_ramdisk_ioctl(RamDisk *disk, int command, void *args, int flags)
 {
@@ -46,6 +46,15 @@ int ramdisk_write(RamDisk *disk, void *buffer, u8 sector_count, idx_t lba)
     return EOK;
 }
 
+// 返回扇区在内存中的地址，缓冲直接使用，越界时返回 NULL
+void *ramdisk_mmap(void *dev, idx_t lba, size_t sector_count)
+{
+    RamDisk *disk = (RamDisk *)dev;
+    if ((lba + sector_count) * SECTOR_SIZE > disk->total_size)
+        return NULL;
+    return disk->base_address + lba * SECTOR_SIZE;
+}
+
 void ramdisk_init()
 {
     LOGK("Initializing ramdisks...\n");
@@ -62,8 +71,9 @@ void ramdisk_init()
         ramdisk->total_size = partition_size;
         memset(ramdisk->base_address, 0, ramdisk->total_size);
 
-        snprintf(device_name, sizeof(device_name), "md%c", i + 'a');
-        device_install(DEV_BLOCK, DEV_RAMDISK, ramdisk, device_name, 0,
-                       handle_ramdisk_ioctl, ramdisk_read, ramdisk_write);
+        sprintf(device_name, "md%c", i + 'a');
+        dev_t dev = device_install(DEV_BLOCK, DEV_RAMDISK, ramdisk, device_name, 0,
+                                   handle_ramdisk_ioctl, ramdisk_read, ramdisk_write);
+        device_get(dev)->mmap = ramdisk_mmap;
     }
 }
\ No newline at end of file
@@ -0,0 +1,844 @@
+#include "hyc.h"
+
+#define LOGK(fmt, args...) DEBUGK(fmt, ##args)
+
+extern task_t *task_table[TASK_NR];
+extern u32 volatile jiffies;
+
+// nice 值对应的权重，相邻级别约相差 1.25 倍
+static const u32 nice_to_weight[NICE_WIDTH] = {
+    /* -20 */ 88761, 71755, 56483, 46273, 36291,
+    /* -15 */ 29154, 23254, 18705, 14949, 11916,
+    /* -10 */ 9548, 7620, 6100, 4904, 3906,
+    /*  -5 */ 3121, 2501, 1991, 1586, 1277,
+    /*   0 */ 1024, 820, 655, 526, 423,
+    /*   5 */ 335, 272, 215, 172, 137,
+    /*  10 */ 110, 87, 70, 56, 45,
+    /*  15 */ 36, 29, 23, 18, 15,
+};
+
+// 虚拟时间可能回绕，比较差值的符号
+#define vruntime_before(a, b) ((int)((a) - (b)) < 0)
+
+#define task_entry(ptr) (element_entry(task_t, rbnode, ptr))
+
+// 任务所在处理器的就绪队列
+#define task_rq(task) (&(task)->cpu->rq)
+
+static bool vruntime_less(rbnode_t *a, rbnode_t *b)
+{
+    return vruntime_before(task_entry(a)->vruntime, task_entry(b)->vruntime);
+}
+
+// 执行 ticks 个时间片对应的虚拟时间
+static u32 calc_delta(task_t *task, u32 ticks)
+{
+    return ticks * ((NICE_0_LOAD << NICE_0_SHIFT) / task->weight);
+}
+
+// 更新单调递增的最小虚拟运行时间
+static void update_min_vruntime(runqueue_t *rq, task_t *current)
+{
+    u32 vruntime = rq->min_vruntime;
+    bool valid = false;
+
+    if (current != rq->idle && current->state == TASK_RUNNING)
+    {
+        vruntime = current->vruntime;
+        valid = true;
+    }
+
+    rbnode_t *node = rbtree_first(&rq->tree);
+    if (node)
+    {
+        task_t *task = task_entry(node);
+        if (!valid || vruntime_before(task->vruntime, vruntime))
+            vruntime = task->vruntime;
+    }
+
+    if (vruntime_before(rq->min_vruntime, vruntime))
+        rq->min_vruntime = vruntime;
+}
+
+bool sched_rt_task(task_t *task)
+{
+    return task->prio < MAX_RT_PRIO;
+}
+
+// 实时队列下标，越大优先级越高
+#define rt_level(task) (MAX_RT_PRIO - 1 - (task)->prio)
+
+static bool task_queued(task_t *task)
+{
+    if (sched_rt_task(task))
+        return task->rtnode.next != NULL;
+    return rbnode_linked(&task->rbnode);
+}
+
+// 最高的非空实时优先级，没有则返回 0
+static int rt_highest_prio(runqueue_t *rq)
+{
+    for (int i = 3; i >= 0; i--)
+    {
+        if (rq->rt_bitmap[i])
+            return i * 32 + 31 - __builtin_clz(rq->rt_bitmap[i]);
+    }
+    return 0;
+}
+
+// 实时任务就绪，且带宽没有耗尽
+static bool rt_runnable(runqueue_t *rq)
+{
+    return rq->rt_nr && !rq->rt_throttled;
+}
+
+// 就绪队列中的任务数量，不含正在执行的任务
+static u32 rq_queued(runqueue_t *rq)
+{
+    return rq->rt_nr + rq->tree.count;
+}
+
+// 处理器上可运行的任务数量
+static u32 rq_nr_running(runqueue_t *rq)
+{
+    return rq_queued(rq) + (rq->curr != rq->idle);
+}
+
+// head 为真时插入队首，用于被高优先级抢占的实时任务
+static void enqueue_task(runqueue_t *rq, task_t *task, bool head)
+{
+    assert(task != rq->idle);
+    assert(!task_queued(task));
+
+    if (sched_rt_task(task))
+    {
+        int prio = rt_level(task);
+        if (head)
+            list_push(&rq->rt_queue[prio], &task->rtnode);
+        else
+            list_pushback(&rq->rt_queue[prio], &task->rtnode);
+        rq->rt_bitmap[prio / 32] |= (1 << (prio % 32));
+        rq->rt_nr++;
+        return;
+    }
+
+    rbtree_insert(&rq->tree, &task->rbnode);
+    rq->load += task->weight;
+}
+
+static void dequeue_task(runqueue_t *rq, task_t *task)
+{
+    assert(task_queued(task));
+
+    if (sched_rt_task(task))
+    {
+        int prio = rt_level(task);
+        list_remove(&task->rtnode);
+        if (list_empty(&rq->rt_queue[prio]))
+            rq->rt_bitmap[prio / 32] &= ~(1 << (prio % 32));
+        rq->rt_nr--;
+        return;
+    }
+
+    rbtree_remove(&rq->tree, &task->rbnode);
+    rq->load -= task->weight;
+}
+
+// 判断 task 是否应该抢占 rq 上正在执行的任务
+static bool should_preempt(runqueue_t *rq, task_t *task)
+{
+    task_t *current = rq->curr;
+    if (current == rq->idle)
+        return true;
+
+    if (sched_rt_task(task))
+    {
+        if (rq->rt_throttled)
+            return false;
+        if (!sched_rt_task(current))
+            return true;
+        return task->prio < current->prio;
+    }
+
+    if (sched_rt_task(current))
+        return false;
+
+    // 被唤醒的任务落后当前任务较多，则尽快抢占
+    u32 gran = calc_delta(task, SCHED_GRANULARITY);
+    return vruntime_before(task->vruntime + gran, current->vruntime);
+}
+
+// 通知处理器上正在执行的任务尽快让出
+static void resched_cpu(cpu_t *cpu)
+{
+    cpu->rq.curr->flags |= TASK_NEED_RESCHED;
+    smp_send_reschedule(cpu);
+}
+
+// 将不在就绪队列中的任务迁移到 cpu，保持其相对于最小虚拟时间的位置
+static void migrate_task(task_t *task, cpu_t *cpu)
+{
+    assert(!task_queued(task));
+    if (task->cpu == cpu)
+        return;
+
+    task->vruntime = task->vruntime - task_rq(task)->min_vruntime + cpu->rq.min_vruntime;
+    task->cpu = cpu;
+}
+
+// 为就绪的任务选择处理器，优先选择空闲的处理器，否则留在原处理器，
+// 实时任务则选择正在执行最低优先级任务的处理器
+static cpu_t *select_task_cpu(task_t *task)
+{
+    cpu_t *prev = task->cpu;
+    if (prev->online && rq_nr_running(&prev->rq) == 0)
+        return prev;
+
+    cpu_t *target = prev->online ? prev : &cpus[0];
+    int lowest = task->prio;
+    if (sched_rt_task(task) && target->rq.curr->prio > lowest)
+        lowest = target->rq.curr->prio;
+
+    for (size_t i = 0; i < cpu_count; i++)
+    {
+        cpu_t *cpu = &cpus[i];
+        if (!cpu->online)
+            continue;
+
+        runqueue_t *rq = &cpu->rq;
+        if (rq_nr_running(rq) == 0)
+            return cpu;
+
+        if (sched_rt_task(task) && rq->curr->prio > lowest)
+        {
+            lowest = rq->curr->prio;
+            target = cpu;
+        }
+    }
+    return target;
+}
+
+// 按地址顺序给两个就绪队列加锁，避免两个处理器互相等待
+static void double_rq_lock(runqueue_t *a, runqueue_t *b)
+{
+    if (a < b)
+    {
+        spin_lock(&a->lock);
+        spin_lock(&b->lock);
+    }
+    else
+    {
+        spin_lock(&b->lock);
+        spin_lock(&a->lock);
+    }
+}
+
+static void double_rq_unlock(runqueue_t *a, runqueue_t *b)
+{
+    spin_unlock(&a->lock);
+    spin_unlock(&b->lock);
+}
+
+// 从最繁忙的处理器拉取一个就绪任务到 cpu，返回是否拉取了任务；
+// newidle 表示 cpu 即将空闲，此时不计正在执行的任务
+static bool load_balance(cpu_t *cpu, bool newidle)
+{
+    runqueue_t *this_rq = &cpu->rq;
+    u32 load = newidle ? rq_queued(this_rq) : rq_nr_running(this_rq);
+
+    cpu_t *busiest = NULL;
+    u32 max = 0;
+    for (size_t i = 0; i < cpu_count; i++)
+    {
+        cpu_t *other = &cpus[i];
+        if (other == cpu || !other->online)
+            continue;
+
+        runqueue_t *rq = &other->rq;
+        u32 nr = rq_nr_running(rq);
+        if (rq_queued(rq) && nr > max)
+        {
+            max = nr;
+            busiest = other;
+        }
+    }
+
+    // 至少相差两个任务才迁移，避免任务来回迁移
+    if (!busiest || max < load + 2)
+        return false;
+
+    runqueue_t *src = &busiest->rq;
+    double_rq_lock(this_rq, src);
+
+    // 优先迁移虚拟时间最大的普通任务，它在原处理器上最晚才能执行
+    task_t *task = NULL;
+    rbnode_t *node = rbtree_last(&src->tree);
+    if (node)
+    {
+        task = task_entry(node);
+    }
+    else if (src->rt_nr)
+    {
+        list_t *queue = &src->rt_queue[rt_highest_prio(src)];
+        task = element_entry(task_t, rtnode, queue->head.next);
+    }
+
+    if (task)
+    {
+        dequeue_task(src, task);
+        migrate_task(task, cpu);
+        enqueue_task(this_rq, task, false);
+    }
+
+    double_rq_unlock(this_rq, src);
+    return task != NULL;
+}
+
+void sched_wakeup_new(task_t *task)
+{
+    assert(!get_interrupt_state());
+
+    cpu_t *cpu = select_task_cpu(task);
+    migrate_task(task, cpu);
+
+    runqueue_t *rq = &cpu->rq;
+    spin_lock(&rq->lock);
+
+    // 新任务从当前最小虚拟时间开始，不能继承过去的优势
+    if (vruntime_before(task->vruntime, rq->min_vruntime))
+        task->vruntime = rq->min_vruntime;
+
+    task->ticks = sched_slice(task);
+    enqueue_task(rq, task, false);
+
+    // 新任务放到了其他空闲的处理器上
+    bool resched = cpu != this_cpu() && rq->curr == rq->idle;
+    spin_unlock(&rq->lock);
+
+    if (resched)
+        resched_cpu(cpu);
+}
+
+void sched_wakeup(task_t *task)
+{
+    assert(!get_interrupt_state());
+    if (task_queued(task))
+        return;
+
+    cpu_t *cpu = select_task_cpu(task);
+    migrate_task(task, cpu);
+
+    runqueue_t *rq = &cpu->rq;
+    spin_lock(&rq->lock);
+
+    if (!sched_rt_task(task))
+    {
+        // 睡眠的任务最多补偿 SCHED_WAKEUP_CREDIT 个时间片，防止长时间睡眠后独占 CPU
+        u32 floor = rq->min_vruntime - (SCHED_WAKEUP_CREDIT << NICE_0_SHIFT);
+        if (vruntime_before(task->vruntime, floor))
+            task->vruntime = floor;
+    }
+
+    enqueue_task(rq, task, false);
+
+    bool resched = should_preempt(rq, task);
+    spin_unlock(&rq->lock);
+
+    if (resched)
+        resched_cpu(cpu);
+}
+
+void sched_dequeue(task_t *task)
+{
+    assert(!get_interrupt_state());
+
+    runqueue_t *rq = task_rq(task);
+    spin_lock(&rq->lock);
+    if (task_queued(task))
+        dequeue_task(rq, task);
+    spin_unlock(&rq->lock);
+}
+
+void sched_yield(task_t *task)
+{
+    assert(!get_interrupt_state());
+
+    // 实时任务排到同优先级队列的最后
+    if (sched_rt_task(task))
+    {
+        task->ticks = 0;
+        return;
+    }
+
+    runqueue_t *rq = task_rq(task);
+    spin_lock(&rq->lock);
+
+    // 让出执行权的任务排到就绪队列的最后
+    rbnode_t *node = rbtree_last(&rq->tree);
+    if (node && task != rq->idle)
+    {
+        task_t *last = task_entry(node);
+        if (vruntime_before(task->vruntime, last->vruntime))
+            task->vruntime = last->vruntime;
+    }
+
+    spin_unlock(&rq->lock);
+}
+
+task_t *sched_pick_next(task_t *current)
+{
+    assert(!get_interrupt_state());
+    cpu_t *cpu = this_cpu();
+    runqueue_t *rq = &cpu->rq;
+
+    spin_lock(&rq->lock);
+
+    current->flags &= ~TASK_NEED_RESCHED;
+
+    // 时间片用完的实时任务排到队尾，被抢占的排到队首
+    bool expired = current->ticks <= 0;
+    if (expired)
+        current->ticks = sched_slice(current);
+
+    if (current->state == TASK_READY && current != rq->idle)
+        enqueue_task(rq, current, sched_rt_task(current) && !expired);
+
+    // 本处理器即将空闲，尝试从其他处理器拉取任务
+    if (!rq_queued(rq) && cpu_count > 1)
+    {
+        spin_unlock(&rq->lock);
+        load_balance(cpu, true);
+        spin_lock(&rq->lock);
+    }
+
+    // 实时任务带宽耗尽时，若没有普通任务可运行，也不必让 CPU 空闲
+    task_t *next = rq->idle;
+    if (rt_runnable(rq) || (rq->rt_nr && rbtree_empty(&rq->tree)))
+    {
+        list_t *queue = &rq->rt_queue[rt_highest_prio(rq)];
+        next = element_entry(task_t, rtnode, queue->head.next);
+        dequeue_task(rq, next);
+    }
+    else if (!rbtree_empty(&rq->tree))
+    {
+        next = task_entry(rbtree_first(&rq->tree));
+        dequeue_task(rq, next);
+    }
+
+    rq->curr = next;
+    spin_unlock(&rq->lock);
+    return next;
+}
+
+// 统计实时任务带宽，返回是否需要调度
+static bool rt_update_bandwidth(runqueue_t *rq, task_t *current)
+{
+    if (sched_rt_task(current))
+        rq->rt_time++;
+
+    if (jiffies - rq->rt_period >= RT_PERIOD)
+    {
+        rq->rt_period = jiffies;
+        rq->rt_time = 0;
+        if (rq->rt_throttled)
+        {
+            rq->rt_throttled = false;
+            return rq->rt_nr && !sched_rt_task(current);
+        }
+        return false;
+    }
+
+    if (!rq->rt_throttled && rq->rt_time >= RT_RUNTIME)
+    {
+        rq->rt_throttled = true;
+        LOGK("rt tasks throttled\n");
+        return sched_rt_task(current);
+    }
+    return false;
+}
+
+// 更新当前任务的运行时间，返回是否需要调度
+static bool task_tick(runqueue_t *rq, task_t *current)
+{
+    bool resched = rt_update_bandwidth(rq, current);
+
+    // 空闲任务只要有就绪任务就调度
+    if (current == rq->idle)
+        return rt_runnable(rq) || !rbtree_empty(&rq->tree);
+
+    if (current->flags & TASK_NEED_RESCHED)
+        resched = true;
+
+    if (sched_rt_task(current))
+    {
+        // SCHED_FIFO 没有时间片，只会被更高优先级抢占
+        if (current->policy == SCHED_RR && --current->ticks <= 0)
+            resched = true;
+        return resched;
+    }
+
+    // 有实时任务就绪，立即让出
+    if (rt_runnable(rq))
+        return true;
+
+    current->vruntime += calc_delta(current, 1);
+    current->ticks--;
+    update_min_vruntime(rq, current);
+
+    if (current->ticks <= 0 || resched)
+        return true;
+
+    // 当前任务虚拟时间领先最左任务超过抢占粒度
+    rbnode_t *node = rbtree_first(&rq->tree);
+    if (!node)
+        return false;
+
+    task_t *first = task_entry(node);
+    u32 gran = calc_delta(first, SCHED_GRANULARITY);
+    return vruntime_before(first->vruntime + gran, current->vruntime);
+}
+
+bool sched_tick(task_t *current)
+{
+    assert(!get_interrupt_state());
+    cpu_t *cpu = this_cpu();
+    runqueue_t *rq = &cpu->rq;
+
+    // 周期性地从繁忙的处理器拉取任务
+    if (cpu_count > 1 && jiffies - rq->balance >= SCHED_BALANCE_INTERVAL)
+    {
+        rq->balance = jiffies;
+        load_balance(cpu, false);
+    }
+
+    spin_lock(&rq->lock);
+    bool resched = task_tick(rq, current);
+    spin_unlock(&rq->lock);
+    return resched;
+}
+
+int sched_slice(task_t *task)
+{
+    if (sched_rt_task(task))
+        return RT_RR_SLICE;
+
+    int slice = task->priority * task->weight / NICE_0_LOAD;
+    if (slice < 1)
+        slice = 1;
+    if (slice > SCHED_MAX_SLICE)
+        slice = SCHED_MAX_SLICE;
+    return slice;
+}
+
+int sched_normal_prio(task_t *task)
+{
+    if (task->policy == SCHED_FIFO || task->policy == SCHED_RR)
+        return RT_TO_PRIO(task->rt_priority);
+    return NICE_TO_PRIO(task->nice);
+}
+
+void sched_set_prio(task_t *task, int prio)
+{
+    assert(!get_interrupt_state());
+    assert(prio >= 0 && prio < MAX_PRIO);
+
+    runqueue_t *rq = task_rq(task);
+    spin_lock(&rq->lock);
+
+    bool queued = task_queued(task);
+    if (queued)
+        dequeue_task(rq, task);
+
+    bool was_rt = sched_rt_task(task);
+    int old_prio = task->prio;
+    task->prio = prio;
+
+    if (!sched_rt_task(task))
+    {
+        task->weight = nice_to_weight[prio - MAX_RT_PRIO];
+
+        // 回到普通调度时从当前最小虚拟时间开始
+        if (was_rt && vruntime_before(task->vruntime, rq->min_vruntime))
+            task->vruntime = rq->min_vruntime;
+    }
+
+    bool resched;
+    if (queued)
+    {
+        enqueue_task(rq, task, false);
+        resched = should_preempt(rq, task);
+    }
+    else
+    {
+        // 正在执行的任务优先级降低，可能有更高优先级的任务就绪
+        resched = task == rq->curr && prio > old_prio;
+    }
+
+    spin_unlock(&rq->lock);
+
+    if (resched)
+        resched_cpu(task->cpu);
+}
+
+void sched_set_nice(task_t *task, int nice)
+{
+    if (nice < NICE_MIN)
+        nice = NICE_MIN;
+    if (nice > NICE_MAX)
+        nice = NICE_MAX;
+
+    bool state = interrupt_disable();
+
+    task->nice = nice;
+    task->normal_prio = sched_normal_prio(task);
+    mutex_pi_update(task);
+
+    set_interrupt_state(state);
+}
+
+err_t sched_set_policy(task_t *task, int policy, int priority)
+{
+    if (policy != SCHED_NORMAL && policy != SCHED_FIFO && policy != SCHED_RR)
+        return -EINVAL;
+    if (policy == SCHED_NORMAL && priority != 0)
+        return -EINVAL;
+    if (policy != SCHED_NORMAL && (priority < RT_PRIO_MIN || priority > RT_PRIO_MAX))
+        return -EINVAL;
+
+    bool state = interrupt_disable();
+
+    task->policy = policy;
+    task->rt_priority = priority;
+    task->normal_prio = sched_normal_prio(task);
+
+    // 持有互斥量的任务不能低于等待者的优先级
+    mutex_pi_update(task);
+    task->ticks = sched_slice(task);
+
+    // 正在执行的任务可能被降级
+    if (task_rq(task)->curr == task)
+        resched_cpu(task->cpu);
+
+    set_interrupt_state(state);
+    return EOK;
+}
+
+void sched_set_idle(cpu_t *cpu, task_t *idle)
+{
+    if (task_queued(idle))
+    {
+        runqueue_t *rq = task_rq(idle);
+        spin_lock(&rq->lock);
+        dequeue_task(rq, idle);
+        spin_unlock(&rq->lock);
+    }
+
+    idle->cpu = cpu;
+    cpu->rq.idle = idle;
+
+    // 应用处理器启动后直接进入空闲任务
+    if (cpu != this_cpu())
+        cpu->rq.curr = idle;
+}
+
+// 当前任务是否有权限修改 task 的优先级为 nice
+static err_t sched_nice_permission(task_t *task, int nice)
+{
+    task_t *current = running_task();
+    if (current->uid == KERNEL_USER)
+        return EOK;
+    if (current->uid != task->uid)
+        return -EPERM;
+    // 普通用户只能降低优先级
+    if (nice < task->nice)
+        return -EACCES;
+    return EOK;
+}
+
+// 判断任务是否与 which / who 匹配
+static bool sched_prio_match(task_t *task, int which, int who)
+{
+    task_t *current = running_task();
+    switch (which)
+    {
+    case PRIO_PROCESS:
+        return task->pid == (who ? who : current->pid);
+    case PRIO_PGRP:
+        return task->pgid == (who ? who : current->pgid);
+    case PRIO_USER:
+        return task->uid == (who ? who : current->uid);
+    default:
+        return false;
+    }
+}
+
+// 与 linux 的系统调用一致成功时返回 0，新的 nice 值由 getpriority 取得，
+// 直接返回 nice 值会与错误码混淆
+int sys_nice(int increment)
+{
+    task_t *current = running_task();
+    int nice = current->nice + increment;
+    if (nice < NICE_MIN)
+        nice = NICE_MIN;
+    if (nice > NICE_MAX)
+        nice = NICE_MAX;
+
+    err_t ret = sched_nice_permission(current, nice);
+    if (ret < EOK)
+        return ret;
+
+    sched_set_nice(current, nice);
+    return EOK;
+}
+
+// 与 linux 一致返回 20 - nice，避免与错误码混淆
+int sys_getpriority(int which, int who)
+{
+    if (which < PRIO_PROCESS || which > PRIO_USER)
+        return -EINVAL;
+
+    int nice = NICE_MAX + 1;
+    bool found = false;
+    for (size_t i = 0; i < TASK_NR; i++)
+    {
+        task_t *task = task_table[i];
+        if (!task || task->state == TASK_DIED)
+            continue;
+        if (!sched_prio_match(task, which, who))
+            continue;
+        if (task->nice < nice)
+            nice = task->nice;
+        found = true;
+    }
+    if (!found)
+        return -ESRCH;
+    return 20 - nice;
+}
+
+// 当前任务是否有权限修改 task 的调度策略
+static err_t sched_policy_permission(task_t *task, int policy, int priority)
+{
+    task_t *current = running_task();
+    if (current->uid == KERNEL_USER)
+        return EOK;
+    if (current->uid != task->uid)
+        return -EPERM;
+    if (policy != SCHED_NORMAL && priority > RT_PRIO_USER_MAX)
+        return -EPERM;
+    return EOK;
+}
+
+int sys_sched_setscheduler(pid_t pid, int policy, sched_param_t *param)
+{
+    if (!param)
+        return -EINVAL;
+    if (!memory_access(param, sizeof(sched_param_t), false, true))
+        return -EFAULT;
+
+    task_t *task = pid ? get_task(pid) : running_task();
+    if (!task || task->state == TASK_DIED)
+        return -ESRCH;
+
+    int priority = param->sched_priority;
+    err_t ret = sched_policy_permission(task, policy, priority);
+    if (ret < EOK)
+        return ret;
+
+    return sched_set_policy(task, policy, priority);
+}
+
+int sys_sched_getscheduler(pid_t pid)
+{
+    task_t *task = pid ? get_task(pid) : running_task();
+    if (!task || task->state == TASK_DIED)
+        return -ESRCH;
+    return task->policy;
+}
+
+int sys_sched_setparam(pid_t pid, sched_param_t *param)
+{
+    if (!param)
+        return -EINVAL;
+    if (!memory_access(param, sizeof(sched_param_t), false, true))
+        return -EFAULT;
+
+    task_t *task = pid ? get_task(pid) : running_task();
+    if (!task || task->state == TASK_DIED)
+        return -ESRCH;
+
+    return sys_sched_setscheduler(pid, task->policy, param);
+}
+
+int sys_sched_getparam(pid_t pid, sched_param_t *param)
+{
+    if (!param)
+        return -EINVAL;
+    if (!memory_access(param, sizeof(sched_param_t), true, true))
+        return -EFAULT;
+
+    task_t *task = pid ? get_task(pid) : running_task();
+    if (!task || task->state == TASK_DIED)
+        return -ESRCH;
+
+    param->sched_priority = task->rt_priority;
+    return EOK;
+}
+
+int sys_setpriority(int which, int who, int nice)
+{
+    if (which < PRIO_PROCESS || which > PRIO_USER)
+        return -EINVAL;
+    if (nice < NICE_MIN)
+        nice = NICE_MIN;
+    if (nice > NICE_MAX)
+        nice = NICE_MAX;
+
+    err_t ret = -ESRCH;
+    for (size_t i = 0; i < TASK_NR; i++)
+    {
+        task_t *task = task_table[i];
+        if (!task || task->state == TASK_DIED)
+            continue;
+        if (!sched_prio_match(task, which, who))
+            continue;
+
+        err_t err = sched_nice_permission(task, nice);
+        if (err < EOK)
+        {
+            ret = err;
+            continue;
+        }
+        sched_set_nice(task, nice);
+        if (ret == -ESRCH)
+            ret = EOK;
+    }
+    return ret;
+}
+
+void sched_init()
+{
+    for (size_t i = 0; i < CPU_NR; i++)
+    {
+        runqueue_t *rq = &cpus[i].rq;
+        spin_init(&rq->lock);
+        rq->curr = NULL;
+        rq->balance = 0;
+        rbtree_init(&rq->tree, vruntime_less);
+        rq->min_vruntime = 0;
+        rq->load = 0;
+        rq->idle = NULL;
+
+        for (size_t j = 0; j < RT_PRIO_NR; j++)
+        {
+            list_init(&rq->rt_queue[j]);
+        }
+        memset(rq->rt_bitmap, 0, sizeof(rq->rt_bitmap));
+        rq->rt_nr = 0;
+        rq->rt_time = 0;
+        rq->rt_period = 0;
+        rq->rt_throttled = false;
+    }
+
+    // 启动处理器在切换到第一个任务之前执行的是启动流程
+    cpus[0].rq.curr = running_task();
+}
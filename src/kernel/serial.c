@@ -37,6 +37,7 @@ typedef struct serial_t
     task_t *rx_waiter;    // 读等待任务
     lock_t wlock;         // 写锁
     task_t *tx_waiter;    // 写等待任务
+    wait_queue_t wait;    // 就绪等待队列
 } serial_t;
 
 static serial_t serials[2];
@@ -54,6 +55,7 @@ void recv_data(serial_t *serial)
         task_unblock(serial->rx_waiter, EOK); // 解除阻塞
         serial->rx_waiter = NULL;
     }
+    wake_up(&serial->wait, POLLIN);
 }
 
 // 中断处理函数
@@ -121,6 +123,15 @@ int serial_write(serial_t *serial, char *buf, u32 count)
     return nr;
 }
 
+// 就绪事件，写总是可以进行
+int serial_poll(serial_t *serial, poll_table_t *pt)
+{
+    poll_wait(pt, &serial->wait);
+    if (fifo_empty(&serial->rx_fifo))
+        return POLLOUT;
+    return POLLIN | POLLOUT;
+}
+
 // 初始化串口
 void serial_init()
 {
@@ -132,6 +143,7 @@ void serial_init()
         lock_init(&serial->rlock); // 读锁
         serial->tx_waiter = NULL; // 进程置为空
         lock_init(&serial->wlock); // 写锁
+        wait_queue_init(&serial->wait); // 就绪等待队列
 
         if (i == 0)
         {
@@ -175,9 +187,10 @@ void serial_init()
         char name[16];
         snprintf(name, sizeof(name), "com%d", i + 1);
 
-        device_install(
+        dev_t dev = device_install(
             DEV_CHAR, DEV_SERIAL, serial, name, 0,
             NULL, serial_read, serial_write);
+        device_get(dev)->poll = (void *)serial_poll;
 
         LOGK("Serial 0x%x init...\n", serial->iobase);
     }
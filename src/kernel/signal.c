@@ -15,6 +15,36 @@ typedef struct signal_frame_t
     u32 eip;
 } signal_frame_t;
 
+sighand_t *sighand_alloc()
+{
+    sighand_t *sighand = (sighand_t *)kmalloc(sizeof(sighand_t));
+    sighand->count = 1;
+    for (size_t i = 0; i < MAXSIG; i++)
+    {
+        sigaction_t *action = &sighand->actions[i];
+        action->flags = 0;
+        action->mask = 0;
+        action->handler = SIG_DFL;
+        action->restorer = NULL;
+    }
+    return sighand;
+}
+
+sighand_t *sighand_copy(sighand_t *sighand)
+{
+    sighand_t *copy = (sighand_t *)kmalloc(sizeof(sighand_t));
+    memcpy(copy->actions, sighand->actions, sizeof(copy->actions));
+    copy->count = 1;
+    return copy;
+}
+
+void sighand_put(sighand_t *sighand)
+{
+    assert(sighand->count > 0);
+    if (--sighand->count == 0)
+        kfree(sighand);
+}
+
 // 获取信号屏蔽位图
 int sys_sgetmask()
 {
@@ -43,7 +73,7 @@ int sys_signal(int sig, int handler, int restorer)
         return EOF;
 
     task_t *task = running_task(); // 获取正在运行的任务
-    sigaction_t *ptr = &task->actions[sig - 1]; // 获取信号的处理结构
+    sigaction_t *ptr = &task->sighand->actions[sig - 1]; // 获取信号的处理结构
 
     ptr->mask = 0; // 默认不屏蔽信号
     ptr->handler = (void (*)(int))handler; // 设置处理函数
@@ -60,7 +90,7 @@ int sys_sigaction(int sig, sigaction_t *action, sigaction_t *oldaction)
         return EOF; // 无效信号
 
     task_t *task = running_task(); // 获取正在运行的任务
-    sigaction_t *ptr = &task->actions[sig - 1]; // 获取信号的处理结构
+    sigaction_t *ptr = &task->sighand->actions[sig - 1]; // 获取信号的处理结构
 
     if (oldaction)
         *oldaction = *ptr; // 保存旧的处理结构
@@ -115,7 +145,7 @@ void task_signal()
         }
     }
 
-    sigaction_t *action = &task->actions[sig - 1]; // 获取信号处理结构
+    sigaction_t *action = &task->sighand->actions[sig - 1]; // 获取信号处理结构
     if (action->handler == SIG_IGN)
         return; // 忽略信号
 
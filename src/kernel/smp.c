@@ -0,0 +1,480 @@
+#include "hyc.h"
+
+#define LOGK(fmt, args...) DEBUGK(fmt, ##args)
+
+extern void pit_udelay(u32 us);
+extern void tss_init_cpu(u32 id, tss_t *tss);
+extern void sysenter_cpu_init(tss_t *tss);
+extern void idle_thread();
+
+extern u8 trampoline_start[];
+extern u8 trampoline_end[];
+
+cpu_t cpus[CPU_NR];
+u32 cpu_count = 1;
+
+u32 ap_stack; // 正在启动的应用处理器的栈顶
+
+static spinlock_t kernel_spinlock; // 大内核锁
+
+// MP 浮动指针结构
+typedef struct mp_float_t
+{
+    char signature[4]; // _MP_
+    u32 config;        // 配置表物理地址
+    u8 length;         // 长度，以 16 字节为单位
+    u8 version;        // 规范版本
+    u8 checksum;       // 校验和
+    u8 features[5];    // 特性，features[0] 非零表示使用默认配置
+} _packed mp_float_t;
+
+// MP 配置表头
+typedef struct mp_config_t
+{
+    char signature[4]; // PCMP
+    u16 length;        // 基本表长度
+    u8 version;        // 规范版本
+    u8 checksum;       // 校验和
+    char oem[8];       // OEM 编号
+    char product[12];  // 产品编号
+    u32 oem_table;     // OEM 表地址
+    u16 oem_size;      // OEM 表长度
+    u16 count;         // 表项数量
+    u32 lapic;         // local APIC 物理地址
+    u16 ext_length;    // 扩展表长度
+    u8 ext_checksum;   // 扩展表校验和
+    u8 RESERVED;
+} _packed mp_config_t;
+
+enum
+{
+    MP_PROCESSOR = 0, // 处理器
+    MP_BUS = 1,       // 总线
+    MP_IOAPIC = 2,    // IOAPIC
+    MP_IOINTR = 3,    // IO 中断
+    MP_LINTR = 4,     // 本地中断
+};
+
+// 处理器表项
+typedef struct mp_processor_t
+{
+    u8 type;       // 0
+    u8 apic_id;    // local APIC 编号
+    u8 version;    // local APIC 版本
+    u8 flags;      // 0 位启用，1 位启动处理器
+    u32 signature; // 处理器签名
+    u32 features;  // 处理器特性
+    u32 RESERVED[2];
+} _packed mp_processor_t;
+
+// IOAPIC 表项
+typedef struct mp_ioapic_t
+{
+    u8 type;    // 2
+    u8 id;      // IOAPIC 编号
+    u8 version; // 版本
+    u8 flags;   // 0 位启用
+    u32 addr;   // 物理地址
+} _packed mp_ioapic_t;
+
+// 总线表项
+typedef struct mp_bus_t
+{
+    u8 type;     // 1
+    u8 id;       // 总线编号
+    char name[6]; // 总线类型，以空格填充
+} _packed mp_bus_t;
+
+// IO 中断表项
+typedef struct mp_iointr_t
+{
+    u8 type;      // 3
+    u8 intr_type; // 中断类型，0 为向量中断
+    u16 flags;    // 极性和触发方式
+    u8 src_bus;   // 源总线编号
+    u8 src_irq;   // 源中断，PCI 总线为设备号和引脚
+    u8 dst_apic;  // 目的 IOAPIC 编号
+    u8 dst_pin;   // 目的 IOAPIC 引脚
+} _packed mp_iointr_t;
+
+#define MP_CPU_ENABLED 1
+#define MP_CPU_BSP 2
+
+#define MP_IMCR 0x80 // features[1] 置位表示存在 IMCR，启动时处于 PIC 模式
+
+#define IMCR_ADDR 0x22
+#define IMCR_DATA 0x23
+
+static mp_float_t *mp_float;
+static bool pci_bus[256]; // 总线是否为 PCI 总线
+
+cpu_t *this_cpu()
+{
+    return running_task()->cpu;
+}
+
+static u8 mp_checksum(void *addr, u32 length)
+{
+    u8 sum = 0;
+    u8 *ptr = (u8 *)addr;
+    for (size_t i = 0; i < length; i++)
+    {
+        sum += ptr[i];
+    }
+    return sum;
+}
+
+// 在 [addr, addr + length) 中查找 MP 浮动指针
+static mp_float_t *mp_search_area(u32 addr, u32 length)
+{
+    for (u32 ptr = addr; ptr < addr + length; ptr += 16)
+    {
+        mp_float_t *mp = (mp_float_t *)ptr;
+        if (memcmp(mp->signature, "_MP_", 4))
+            continue;
+        if (mp_checksum(mp, mp->length * 16))
+            continue;
+        return mp;
+    }
+    return NULL;
+}
+
+// 依次查找 EBDA 的第 1K，基本内存的最后 1K 和 BIOS ROM
+static mp_float_t *mp_search()
+{
+    mp_float_t *mp;
+    u32 ebda = (*(u16 *)0x40E) << 4;
+    if (ebda && (mp = mp_search_area(ebda, 1024)))
+        return mp;
+
+    u32 base = ((*(u16 *)0x413) * 1024);
+    if ((mp = mp_search_area(base - 1024, 1024)))
+        return mp;
+
+    return mp_search_area(0xF0000, 0x10000);
+}
+
+// 解析 MP 配置表，获得处理器和 IOAPIC 信息
+static bool mp_parse()
+{
+    mp_float_t *mp = mp_search();
+    if (!mp || !mp->config || mp->features[0])
+    {
+        LOGK("MP configuration table not found\n");
+        return false;
+    }
+
+    mp_config_t *config = (mp_config_t *)mp->config;
+    if (memcmp(config->signature, "PCMP", 4) || mp_checksum(config, config->length))
+    {
+        LOGK("MP configuration table invalid\n");
+        return false;
+    }
+    mp_float = mp;
+
+    lapic_base = config->lapic;
+    cpu_count = 1;
+
+    u8 *entry = (u8 *)(config + 1);
+    for (size_t i = 0; i < config->count; i++)
+    {
+        switch (*entry)
+        {
+        case MP_PROCESSOR:
+        {
+            mp_processor_t *proc = (mp_processor_t *)entry;
+            entry += sizeof(mp_processor_t);
+            if (!(proc->flags & MP_CPU_ENABLED))
+                break;
+            if (proc->flags & MP_CPU_BSP)
+            {
+                cpus[0].apic_id = proc->apic_id;
+                break;
+            }
+            if (cpu_count >= CPU_NR)
+            {
+                LOGK("too many processors, ignore apic %d\n", proc->apic_id);
+                break;
+            }
+            cpus[cpu_count].id = cpu_count;
+            cpus[cpu_count].apic_id = proc->apic_id;
+            cpu_count++;
+            break;
+        }
+        case MP_IOAPIC:
+        {
+            mp_ioapic_t *ioapic = (mp_ioapic_t *)entry;
+            entry += sizeof(mp_ioapic_t);
+            // 只使用第一个 IOAPIC
+            if ((ioapic->flags & 1) && !ioapic_base)
+                ioapic_base = ioapic->addr;
+            break;
+        }
+        case MP_BUS:
+        {
+            mp_bus_t *bus = (mp_bus_t *)entry;
+            entry += sizeof(mp_bus_t);
+            pci_bus[bus->id] = !memcmp(bus->name, "PCI", 3);
+            break;
+        }
+        case MP_IOINTR:
+        case MP_LINTR:
+            entry += 8;
+            break;
+        default:
+            LOGK("unknown MP entry type %d\n", *entry);
+            return true;
+        }
+    }
+    return true;
+}
+
+// 根据 MP 表的 IO 中断表项设置 ISA 中断与 IOAPIC 引脚的对应关系，
+// 例如 IRQ 0 通常连接到引脚 2，PCI 设备连接的引脚为低电平有效的电平触发
+static void mp_setup_irq()
+{
+    mp_config_t *config = (mp_config_t *)mp_float->config;
+    u8 *entry = (u8 *)(config + 1);
+    for (size_t i = 0; i < config->count; i++)
+    {
+        if (*entry == MP_PROCESSOR)
+        {
+            entry += sizeof(mp_processor_t);
+            continue;
+        }
+        if (*entry != MP_IOINTR)
+        {
+            entry += 8;
+            continue;
+        }
+
+        mp_iointr_t *intr = (mp_iointr_t *)entry;
+        entry += sizeof(mp_iointr_t);
+        if (intr->intr_type != 0)
+            continue;
+
+        if (!pci_bus[intr->src_bus])
+        {
+            if (intr->src_irq < 16)
+                ioapic_set_irq(intr->src_irq, intr->dst_pin, intr->flags);
+            continue;
+        }
+
+        // PCI 设备的中断线寄存器即为其连接的引脚
+        if (intr->dst_pin >= 16)
+            continue;
+
+        u16 flags = intr->flags;
+        if (!(flags & 0x3))
+            flags |= 0x3; // 低电平有效
+        if (!(flags & 0xC))
+            flags |= 0xC; // 电平触发
+        ioapic_set_irq(intr->dst_pin, intr->dst_pin, flags);
+    }
+}
+
+void percpu_init()
+{
+    memset(cpus, 0, sizeof(cpus));
+
+    cpu_t *cpu = &cpus[0];
+    cpu->online = true;
+
+    // 启动处理器从内核初始化开始一直持有大内核锁
+    spin_init(&kernel_spinlock);
+    spin_lock(&kernel_spinlock);
+    cpu->lock_depth = 1;
+
+    running_task()->cpu = cpu;
+}
+
+// 获得大内核锁之后处理其他处理器的快表刷新请求
+static void kernel_locked(cpu_t *cpu)
+{
+    if (cpu->tlb_flush)
+    {
+        cpu->tlb_flush = false;
+        set_cr3(get_cr3());
+    }
+}
+
+void kernel_enter()
+{
+    cpu_t *cpu = this_cpu();
+    if (cpu->lock_depth++ == 0)
+    {
+        spin_lock(&kernel_spinlock);
+        kernel_locked(cpu);
+    }
+}
+
+void kernel_exit()
+{
+    cpu_t *cpu = this_cpu();
+    assert(cpu->lock_depth > 0);
+    if (--cpu->lock_depth == 0)
+        spin_unlock(&kernel_spinlock);
+}
+
+int kernel_unlock()
+{
+    assert(!get_interrupt_state());
+    cpu_t *cpu = this_cpu();
+    int depth = cpu->lock_depth;
+    assert(depth > 0);
+    cpu->lock_depth = 0;
+    spin_unlock(&kernel_spinlock);
+    return depth;
+}
+
+void kernel_relock(int depth)
+{
+    assert(!get_interrupt_state());
+    cpu_t *cpu = this_cpu();
+    assert(cpu->lock_depth == 0);
+    spin_lock(&kernel_spinlock);
+    kernel_locked(cpu);
+    cpu->lock_depth = depth;
+}
+
+// 重新调度处理器间中断，需要的标记已由发送方设置，中断返回时调度
+static void reschedule_handler(int vector)
+{
+    assert(vector == LAPIC_RESCHED_VECTOR);
+    lapic_eoi();
+}
+
+void smp_send_reschedule(cpu_t *cpu)
+{
+    if (cpu == this_cpu() || !cpu->online)
+        return;
+    lapic_send_ipi(cpu->apic_id, LAPIC_ICR_FIXED | LAPIC_ICR_ASSERT | LAPIC_RESCHED_VECTOR);
+}
+
+// 其他处理器或在用户态执行，或在等待大内核锁，
+// 借用重新调度中断使其进入内核，获得大内核锁之后刷新快表
+void smp_flush_tlb(u32 pde)
+{
+    if (cpu_count == 1)
+        return;
+
+    cpu_t *self = this_cpu();
+    for (size_t i = 0; i < cpu_count; i++)
+    {
+        cpu_t *cpu = &cpus[i];
+        if (cpu == self || !cpu->online)
+            continue;
+
+        task_t *curr = cpu->rq.curr;
+        if (!curr || curr->pde != pde)
+            continue;
+
+        cpu->tlb_flush = true;
+        smp_send_reschedule(cpu);
+    }
+}
+
+void smp_init()
+{
+    cpu_version_t version;
+    cpu_version(&version);
+
+    if (!version.APIC || !mp_parse())
+    {
+        LOGK("single processor without APIC\n");
+        cpu_count = 1;
+        lapic_base = ioapic_base = 0;
+        return;
+    }
+
+    map_area(lapic_base, PAGE_SIZE);
+    if (ioapic_base)
+        map_area(ioapic_base, PAGE_SIZE);
+
+    lapic_init(true);
+    set_vector_handler(LAPIC_RESCHED_VECTOR, reschedule_handler);
+
+    if (ioapic_base)
+    {
+        ioapic_init();
+        mp_setup_irq();
+
+        // 主板处于 PIC 模式时，通过 IMCR 让 8259 和 NMI 改经 APIC 传递
+        if (mp_float->features[1] & MP_IMCR)
+        {
+            outb(IMCR_ADDR, 0x70);
+            outb(IMCR_DATA, 0x01);
+        }
+        interrupt_apic_init();
+    }
+
+    LOGK("%d processors, BSP apic %d, %s interrupt controller\n",
+         cpu_count, cpus[0].apic_id, ioapic_base ? "IOAPIC" : "8259");
+}
+
+// 应用处理器进入内核
+void ap_main()
+{
+    task_t *idle = running_task();
+    cpu_t *cpu = idle->cpu;
+
+    asm volatile("lidt idt_ptr\n");
+    tss_init_cpu(cpu->id, &cpu->tss);
+    sysenter_cpu_init(&cpu->tss);
+    fpu_cpu_init();
+    lapic_init(false);
+
+    cpu->online = true;
+
+    kernel_relock(1);
+    LOGK("processor %d apic %d online\n", cpu->id, cpu->apic_id);
+
+    lapic_timer_start();
+    idle_thread();
+}
+
+// 按 INIT-STARTUP-STARTUP 序列启动应用处理器
+static bool smp_boot_cpu(cpu_t *cpu)
+{
+    task_t *idle = task_create(idle_thread, "idle", 1, KERNEL_USER);
+    sched_set_idle(cpu, idle);
+    ap_stack = (u32)idle + PAGE_SIZE;
+
+    lapic_send_ipi(cpu->apic_id, LAPIC_ICR_INIT | LAPIC_ICR_ASSERT | LAPIC_ICR_LEVEL);
+    pit_udelay(200);
+    lapic_send_ipi(cpu->apic_id, LAPIC_ICR_INIT | LAPIC_ICR_LEVEL);
+    pit_udelay(10000);
+
+    for (size_t i = 0; i < 2 && !cpu->online; i++)
+    {
+        lapic_send_ipi(cpu->apic_id, LAPIC_ICR_STARTUP | (TRAMPOLINE_ADDR >> 12));
+        pit_udelay(200);
+    }
+
+    // 最多等待 100 毫秒
+    for (size_t i = 0; i < 10 && !cpu->online; i++)
+    {
+        pit_udelay(10000);
+    }
+    return cpu->online;
+}
+
+void smp_boot()
+{
+    if (cpu_count == 1)
+        return;
+
+    assert(!get_interrupt_state());
+    memcpy((void *)TRAMPOLINE_ADDR, trampoline_start, trampoline_end - trampoline_start);
+
+    u32 online = 1;
+    for (size_t i = 1; i < cpu_count; i++)
+    {
+        cpu_t *cpu = &cpus[i];
+        if (smp_boot_cpu(cpu))
+            online++;
+        else
+            LOGK("processor %d apic %d start failure\n", cpu->id, cpu->apic_id);
+    }
+    LOGK("%d of %d processors online\n", online, cpu_count);
+}
@@ -0,0 +1,83 @@
+#include "hyc.h"
+
+#define LOGK(fmt, args...) DEBUGK(fmt, ##args)
+
+static softirq_handler_t softirq_vec[SOFTIRQ_NR];
+static volatile u32 softirq_pending; // 挂起的软中断位图，由大内核锁保护
+
+static task_t *softirqd; // 处理持续到来的软中断
+
+void softirq_open(int nr, softirq_handler_t handler)
+{
+    assert(nr >= 0 && nr < SOFTIRQ_NR);
+    softirq_vec[nr] = handler;
+}
+
+void softirq_raise(int nr)
+{
+    assert(nr >= 0 && nr < SOFTIRQ_NR);
+    bool intr = interrupt_disable();
+    softirq_pending |= (1 << nr);
+    set_interrupt_state(intr);
+}
+
+bool in_softirq()
+{
+    return this_cpu()->in_softirq;
+}
+
+// 由中断出口调用，被中断的上下文允许中断时执行；
+// 执行期间硬件中断可以嵌套，但不会进行调度，也不会重入
+void do_softirq()
+{
+    assert(!get_interrupt_state());
+
+    cpu_t *cpu = this_cpu();
+    if (cpu->in_softirq || !softirq_pending)
+        return;
+
+    cpu->in_softirq = true;
+    for (size_t restart = 0; softirq_pending && restart < SOFTIRQ_RESTART; restart++)
+    {
+        u32 pending = softirq_pending;
+        softirq_pending = 0;
+
+        set_interrupt_state(true);
+        for (int nr = 0; pending; nr++, pending >>= 1)
+        {
+            if ((pending & 1) && softirq_vec[nr])
+                softirq_vec[nr]();
+        }
+        interrupt_disable();
+    }
+    cpu->in_softirq = false;
+
+    // 软中断持续到来，交给内核线程，避免用户程序饿死
+    if (softirq_pending && softirqd && softirqd->state == TASK_WAITING)
+    {
+        task_unblock(softirqd, EOK);
+    }
+}
+
+static void softirqd_thread()
+{
+    while (true)
+    {
+        do_softirq();
+        if (!softirq_pending)
+        {
+            int ret = task_block(softirqd, NULL, TASK_WAITING, TIMELESS);
+            assert(ret == EOK);
+        }
+        else
+        {
+            task_yield();
+        }
+    }
+}
+
+void softirq_init()
+{
+    softirq_pending = 0;
+    softirqd = task_create(softirqd_thread, "softirqd", 5, KERNEL_USER);
+}
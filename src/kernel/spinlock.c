@@ -0,0 +1,55 @@
+#include "hyc.h"
+
+// 原子交换，返回旧值
+static _inline u32 atomic_xchg(volatile u32 *ptr, u32 value)
+{
+    asm volatile(
+        "xchgl %0, %1\n"
+        : "+r"(value), "+m"(*ptr)
+        :
+        : "memory");
+    return value;
+}
+
+void spin_init(spinlock_t *lock)
+{
+    lock->locked = 0;
+}
+
+void spin_lock(spinlock_t *lock)
+{
+    while (atomic_xchg(&lock->locked, 1))
+    {
+        // 只读等待，避免总线上反复争用缓存行
+        while (lock->locked)
+        {
+            asm volatile("pause\n");
+        }
+    }
+}
+
+bool spin_trylock(spinlock_t *lock)
+{
+    return atomic_xchg(&lock->locked, 1) == 0;
+}
+
+void spin_unlock(spinlock_t *lock)
+{
+    assert(lock->locked);
+    // x86 写操作不会与之前的读写重排，只需阻止编译器重排
+    asm volatile("" ::: "memory");
+    lock->locked = 0;
+}
+
+bool spin_lock_irqsave(spinlock_t *lock)
+{
+    bool state = interrupt_disable();
+    spin_lock(lock);
+    return state;
+}
+
+void spin_unlock_irqrestore(spinlock_t *lock, bool state)
+{
+    spin_unlock(lock);
+    set_interrupt_state(state);
+}
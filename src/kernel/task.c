@@ -5,7 +5,6 @@
 extern u32 volatile jiffies;
 extern u32 jiffy;
 extern bitmap_t kernel_map;
-extern tss_t tss;
 extern file_t file_table[];
 
 extern void task_switch(task_t *next);
@@ -14,16 +13,25 @@ task_t *task_table[TASK_NR]; // 任务表
 static list_t block_list;    // 任务默认阻塞链表
 static list_t sleep_list;    // 任务睡眠链表
 
-static task_t *idle_task;
-
 extern int sys_execve();
 extern int init_user_thread();
 
 // 从 task_table 里获得一个空闲的任务
+// 线程退出后没有父进程等待，在分配任务时回收
+static bool task_reclaimable(task_t *task)
+{
+    return task->state == TASK_DIED && task->tgid != task->pid;
+}
+
 static task_t *get_free_task()
 {
     for (size_t i = 0; i < TASK_NR; i++)
     {
+        if (task_table[i] && task_reclaimable(task_table[i]))
+        {
+            free_kpage((u32)task_table[i], 1);
+            task_table[i] = NULL;
+        }
         if (task_table[i] == NULL)
         {
             task_t *task = (task_t *)alloc_kpage(1);
@@ -49,8 +57,15 @@ task_t *get_task(pid_t pid)
     return NULL;
 }
 
-// 获取进程 id
+// 获取进程 id，同一线程组的线程返回相同的值
 pid_t sys_getpid()
+{
+    task_t *task = running_task();
+    return task->tgid;
+}
+
+// 获取线程 id
+pid_t sys_gettid()
 {
     task_t *task = running_task();
     return task->pid;
@@ -63,34 +78,24 @@ pid_t sys_getppid()
     return task->ppid;
 }
 
-// 从任务数组中查找某种状态的任务，自己除外
-static task_t *task_search(task_state_t state)
+// 中断返回前检查是否需要抢占当前任务
+void task_preempt()
 {
     assert(!get_interrupt_state());
-    task_t *task = NULL;
-    task_t *current = running_task();
-
-    for (size_t i = 0; i < TASK_NR; i++)
-    {
-        task_t *ptr = task_table[i];
-        if (ptr && ptr->state == state && ptr != current)
-        {
-            if (task == NULL || task->ticks < ptr->ticks || ptr->jiffies < task->jiffies)
-                task = ptr;
-        }
-    }
-
-    if (task == NULL && state == TASK_READY)
+    task_t *task = running_task();
+    // 软中断执行期间不调度，返回软中断之后再检查
+    if ((task->flags & TASK_NEED_RESCHED) && !in_softirq())
     {
-        task = idle_task;
+        schedule();
     }
-
-    return task;
 }
 
 void task_yield()
 {
+    bool intr = interrupt_disable();
+    sched_yield(running_task());
     schedule();
+    set_interrupt_state(intr);
 }
 
 bool _inline task_leader(task_t *task)
@@ -118,9 +123,13 @@ err_t task_block(task_t *task, list_t *blist, task_state_t state, int timeout_ms
         task->timer = timer_add(timeout_ms, NULL, NULL);
     }
 
+    // 阻塞其他就绪的任务时，先移出就绪队列，否则仍会被调度执行
+    task_t *current = running_task();
+    if (current != task)
+        sched_dequeue(task);
+
     task->state = state;
 
-    task_t *current = running_task();
     if (current == task)
     {
         schedule();
@@ -154,6 +163,7 @@ void task_unblock(task_t *task, int reason)
     assert(task->state != TASK_RUNNING);
     task->status = reason;
     task->state = TASK_READY;
+    sched_wakeup(task);
 }
 
 void task_sleep(u32 ms)
@@ -178,7 +188,7 @@ void task_activate(task_t *task)
 
     if (task->uid != KERNEL_USER)
     {
-        tss.esp0 = (u32)task + PAGE_SIZE;
+        this_cpu()->tss.esp0 = (u32)task + PAGE_SIZE;
     }
 }
 
@@ -194,25 +204,26 @@ void schedule()
     assert(!get_interrupt_state()); // 不可中断
 
     task_t *current = running_task();
-    task_t *next = task_search(TASK_READY);
-
-    assert(next != NULL);
-    assert(next->magic == ONIX_MAGIC);
 
     if (current->state == TASK_RUNNING)
     {
         current->state = TASK_READY;
     }
 
-    if (!current->ticks)
-    {
-        current->ticks = current->priority;
-    }
+    task_t *next = sched_pick_next(current);
+
+    assert(next != NULL);
+    assert(next->magic == ONIX_MAGIC);
 
     next->state = TASK_RUNNING;
     if (next == current)
         return;
 
+    // 大内核锁随处理器转交给下一进程，嵌套深度随进程保存
+    cpu_t *cpu = this_cpu();
+    current->lock_depth = cpu->lock_depth;
+    cpu->lock_depth = next->lock_depth;
+
     fpu_disable(current); // 当前进程禁用 FPU
     task_activate(next);  // 激活下一进程
     task_switch(next);    // 调度到下一进程
@@ -236,9 +247,22 @@ task_t *task_create(target_t target, const char *name, u32 priority, u32 uid)
 
     task->stack = (u32 *)stack;
     task->priority = priority;
-    task->ticks = task->priority;
     task->jiffies = 0;
+    task->nice = 0;
+    task->weight = NICE_0_LOAD;
+    task->vruntime = 0;
+    task->policy = SCHED_NORMAL;
+    task->rt_priority = 0;
+    task->prio = task->normal_prio = NICE_TO_PRIO(0);
+    list_init(&task->pi_mutexes);
+    task->pi_blocked_on = NULL;
+    task->cpu = this_cpu();
+    task->lock_depth = 1; // 内核线程从持有大内核锁开始执行
     task->state = TASK_READY;
+    task->tgid = task->pid;
+    task->threads = 0;
+    task->clear_child_tid = NULL;
+    task->files = task->fdtab;
     task->uid = uid;
     task->gid = 0; // TODO: group
     task->pgid = 0;
@@ -268,20 +292,17 @@ task_t *task_create(target_t target, const char *name, u32 priority, u32 uid)
     // 初始化信号
     task->signal = 0;
     task->blocked = 0;
-    for (size_t i = 0; i < MAXSIG; i++)
-    {
-        sigaction_t *action = &task->actions[i];
-        action->flags = 0;
-        action->mask = 0;
-        action->handler = SIG_DFL;
-        action->restorer = NULL;
-    }
+    task->sighand = sighand_alloc();
 
     task->timer = NULL;
     task->alarm = NULL;
 
     task->magic = ONIX_MAGIC;
 
+    bool intr = interrupt_disable();
+    sched_wakeup_new(task);
+    set_interrupt_state(intr);
+
     return task;
 }
 
@@ -298,6 +319,7 @@ void task_to_user_mode()
 
     // 创建用户进程页表
     task->pde = (u32)copy_pde();
+    vdso_map((page_entry_t *)task->pde, task->tgid);
     set_cr3(task->pde);
 
     u32 addr = (u32)task + PAGE_SIZE;
@@ -341,6 +363,7 @@ void task_to_user_mode()
 }
 
 extern void interrupt_exit();
+extern int futex_wake(u32 *addr, int count);
 
 // 构建任务的内核栈
 static void task_build_stack(task_t *task)
@@ -377,10 +400,19 @@ pid_t task_fork()
     memcpy(child, task, PAGE_SIZE);
 
     child->pid = pid;
-    child->ppid = task->pid;
+    child->ppid = task->tgid;
+    child->tgid = pid;
+    child->threads = 0;
+    child->clear_child_tid = NULL;
 
-    child->ticks = child->priority;
     child->state = TASK_READY;
+    child->flags &= ~(TASK_NEED_RESCHED | TASK_FPU_ENABLED);
+    child->rbnode.color = RB_UNLINKED;
+    child->lock_depth = 1; // 子进程从 interrupt_exit 返回，释放一层大内核锁
+
+    // 子进程不持有互斥量，也不继承父进程被提升的优先级
+    list_init(&child->pi_mutexes);
+    child->pi_blocked_on = NULL;
 
     // 拷贝用户进程虚拟内存位图
     child->vmap = kmalloc(sizeof(bitmap_t));
@@ -391,6 +423,9 @@ pid_t task_fork()
     memcpy(buf, task->vmap->bits, PAGE_SIZE);
     child->vmap->bits = buf;
 
+    // 子进程有自己的信号处理函数表
+    child->sighand = sighand_copy(task->sighand);
+
     // 拷贝 FPU 状态
     if (task->fpu)
     {
@@ -400,6 +435,7 @@ pid_t task_fork()
 
     // 拷贝页目录
     child->pde = (u32)copy_pde();
+    vdso_map((page_entry_t *)child->pde, child->tgid);
 
     // 拷贝 pwd
     child->pwd = (char *)alloc_kpage(1);
@@ -411,6 +447,10 @@ pid_t task_fork()
     if (task->iexec)
         task->iexec->count++;
 
+    // 复制文件表，线程的文件表位于线程组首领中
+    child->files = child->fdtab;
+    memcpy(child->fdtab, task->files, sizeof(child->fdtab));
+
     // 文件引用加一
     for (size_t i = 0; i < TASK_FILE_NR; i++)
     {
@@ -423,9 +463,185 @@ pid_t task_fork()
     task_build_stack(child); // ROP
     // schedule();
 
+    bool intr = interrupt_disable();
+    sched_set_prio(child, child->normal_prio);
+    sched_wakeup_new(child);
+    set_interrupt_state(intr);
+
     return child->pid;
 }
 
+// 创建线程，共享页目录、虚拟内存位图、文件表和工作目录，
+// 内核栈和 PCB 与 fork 相同从当前任务复制，用户栈使用 stack
+pid_t sys_clone(u32 flags, u32 stack, pid_t *ptid, u32 tls, pid_t *ctid)
+{
+    if (!(flags & CLONE_VM))
+        return task_fork();
+
+    // 只支持创建完整共享的线程
+    if ((flags & CLONE_THREAD_FLAGS) != CLONE_THREAD_FLAGS || !stack)
+        return -EINVAL;
+
+    if ((flags & CLONE_PARENT_SETTID) && !memory_access(ptid, sizeof(pid_t), true, true))
+        return -EFAULT;
+    if ((flags & (CLONE_CHILD_SETTID | CLONE_CHILD_CLEARTID)) &&
+        !memory_access(ctid, sizeof(pid_t), true, true))
+        return -EFAULT;
+
+    task_t *task = running_task();
+    assert(task->node.next == NULL && task->node.prev == NULL && task->state == TASK_RUNNING);
+
+    task_t *leader = get_task(task->tgid);
+    assert(leader);
+
+    task_t *child = get_free_task();
+    pid_t pid = child->pid;
+    memcpy(child, task, PAGE_SIZE);
+
+    child->pid = pid;
+    child->ppid = task->ppid;
+    child->tgid = task->tgid;
+    child->threads = 0;
+
+    child->state = TASK_READY;
+    child->flags &= ~(TASK_NEED_RESCHED | TASK_FPU_ENABLED);
+    child->rbnode.color = RB_UNLINKED;
+    child->lock_depth = 1;
+
+    list_init(&child->pi_mutexes);
+    child->pi_blocked_on = NULL;
+
+    // 信号和定时器属于线程自己
+    child->signal = 0;
+    child->alarm = NULL;
+    child->timer = NULL;
+
+    // 信号处理函数由线程组共享
+    child->sighand->count++;
+
+    if (task->fpu)
+    {
+        child->fpu = kmalloc(sizeof(fpu_t));
+        memcpy(child->fpu, task->fpu, sizeof(fpu_t));
+    }
+
+    child->clear_child_tid = (flags & CLONE_CHILD_CLEARTID) ? (u32 *)ctid : NULL;
+    if (flags & CLONE_CHILD_SETTID)
+        *ctid = pid;
+    if (flags & CLONE_PARENT_SETTID)
+        *ptid = pid;
+
+    leader->threads++;
+
+    task_build_stack(child);
+
+    // 子线程从系统调用返回后使用新的用户栈
+    intr_frame_t *iframe = (intr_frame_t *)((u32)child + PAGE_SIZE - sizeof(intr_frame_t));
+    iframe->esp = stack;
+
+    bool intr = interrupt_disable();
+    sched_set_prio(child, child->normal_prio);
+    sched_wakeup_new(child);
+    set_interrupt_state(intr);
+
+    LOGK("task %d clone thread %d\n", task->pid, pid);
+    return pid;
+}
+
+// 代替进程执行可能阻塞的操作，与线程一样共享地址空间和文件表，
+// 可以直接使用进程的文件描述符和用户内存，进程退出时随其他线程一起结束
+task_t *task_create_worker(void (*target)(void *), void *arg, const char *name)
+{
+    task_t *task = running_task();
+    task_t *leader = get_task(task->tgid);
+    assert(leader);
+
+    task_t *child = get_free_task();
+    pid_t pid = child->pid;
+    memcpy(child, task, sizeof(task_t));
+
+    child->pid = pid;
+    child->ppid = task->ppid;
+    child->tgid = task->tgid;
+    child->threads = 0;
+    strncpy(child->name, name, TASK_NAME_LEN - 1);
+    child->name[TASK_NAME_LEN - 1] = 0;
+
+    child->state = TASK_READY;
+    child->flags = 0;
+    child->rbnode.color = RB_UNLINKED;
+    child->lock_depth = 1; // 与内核线程相同，从持有大内核锁开始执行
+
+    list_init(&child->pi_mutexes);
+    child->pi_blocked_on = NULL;
+
+    child->signal = 0;
+    child->alarm = NULL;
+    child->timer = NULL;
+    child->fpu = NULL;
+    child->clear_child_tid = NULL;
+    child->sighand->count++;
+
+    leader->threads++;
+
+    // 构造内核栈，target 的返回地址为空
+    u32 *stack = (u32 *)((u32)child + PAGE_SIZE);
+    *(--stack) = (u32)arg;
+    *(--stack) = 0;
+
+    task_frame_t *frame = (task_frame_t *)stack - 1;
+    frame->ebp = 0xaa55aa55;
+    frame->ebx = 0xaa55aa55;
+    frame->edi = 0xaa55aa55;
+    frame->esi = 0xaa55aa55;
+    frame->eip = (void (*)(void))target;
+    child->stack = (u32 *)frame;
+
+    bool intr = interrupt_disable();
+    sched_set_prio(child, child->normal_prio);
+    sched_wakeup_new(child);
+    set_interrupt_state(intr);
+
+    LOGK("task %d create worker %d\n", task->pid, pid);
+    return child;
+}
+
+bool task_threaded(task_t *task)
+{
+    task_t *leader = get_task(task->tgid);
+    return leader && leader->threads > 0;
+}
+
+void task_sync_brk(task_t *task)
+{
+    for (size_t i = 0; i < TASK_NR; i++)
+    {
+        task_t *ptr = task_table[i];
+        if (ptr && ptr->tgid == task->tgid && ptr->state != TASK_DIED)
+            ptr->brk = task->brk;
+    }
+}
+
+// 线程组首领退出时，结束组内的其他线程
+static void task_kill_threads(task_t *task)
+{
+    for (size_t i = 0; i < TASK_NR; i++)
+    {
+        task_t *ptr = task_table[i];
+        if (!ptr || ptr == task || ptr->tgid != task->tgid)
+            continue;
+        if (ptr->state == TASK_DIED)
+            continue;
+
+        ptr->signal |= SIGMASK(SIGKILL);
+        // 可能无限期阻塞的等待标记为可杀死，也要唤醒，否则线程组无法结束，
+        // 等待设备完成的阻塞不能提前结束
+        bool killable = ptr->state == TASK_BLOCKED && (ptr->flags & TASK_KILLABLE);
+        if (ptr->state == TASK_WAITING || ptr->state == TASK_SLEEPING || killable)
+            task_unblock(ptr, -EINTR);
+    }
+}
+
 // 如果进程是会话首领则向会话中所有进程发送信号 SIGHUP
 static void task_kill_session(task_t *task)
 {
@@ -472,35 +688,16 @@ static void task_tell_father(task_t *task)
     panic("No Parent found!!!");
 }
 
-void task_exit(int status)
+// 释放进程的地址空间、文件表和工作目录，线程组共享这些资源，
+// 由线程组中最后退出的任务调用，task 为线程组首领
+static void task_release(task_t *task)
 {
-    task_t *task = running_task();
-
-    // 当前进程没有阻塞，且正在执行
-    assert(task->node.next == NULL && task->node.prev == NULL && task->state == TASK_RUNNING);
-
-    task->state = TASK_DIED;
-    task->status = status;
-
-    task_kill_session(task);
-    task_tell_father(task);
-    task_free_tty(task);
-
-    timer_remove(task);
-
+    vdso_unmap((page_entry_t *)task->pde);
     free_pde();
 
     free_kpage((u32)task->vmap->bits, 1);
     kfree(task->vmap);
 
-    // 释放 FPU 状态
-    if (task->fpu)
-    {
-        kfree(task->fpu);
-        task->fpu = NULL;
-        task->flags = 0;
-    }
-
     free_kpage((u32)task->pwd, 1);
     iput(task->ipwd);
     iput(task->iroot);
@@ -514,6 +711,12 @@ void task_exit(int status)
             close(i);
         }
     }
+}
+
+// 进程结束，通知父进程，task 为线程组首领
+static void task_notify_parent(task_t *task)
+{
+    task_tell_father(task);
 
     // 将子进程的父进程赋值为自己的父进程
     for (size_t i = 2; i < TASK_NR; i++)
@@ -533,6 +736,74 @@ void task_exit(int status)
     {
         task_unblock(parent, EOK);
     }
+}
+
+// 线程退出，清零 clear_child_tid 并唤醒等待该线程的线程
+static void task_exit_thread(task_t *task, task_t *leader)
+{
+    u32 *tid = task->clear_child_tid;
+    if (tid && memory_access(tid, sizeof(u32), true, true))
+    {
+        *tid = 0;
+        futex_wake(tid, 1);
+    }
+
+    leader->threads--;
+    LOGK("thread %d of task %d exit....\n", task->pid, leader->pid);
+
+    // 线程组首领已经退出，最后一个线程负责释放进程资源
+    if (leader->threads == 0 && leader->state == TASK_DIED)
+    {
+        task_release(leader);
+        task_notify_parent(leader);
+    }
+}
+
+void task_exit(int status)
+{
+    task_t *task = running_task();
+
+    // 当前进程没有阻塞，且正在执行
+    assert(task->node.next == NULL && task->node.prev == NULL && task->state == TASK_RUNNING);
+
+    task_t *leader = get_task(task->tgid);
+    assert(leader);
+
+    task->state = TASK_DIED;
+    task->status = status;
+
+    timer_remove(task);
+
+    // 退出之后不再处理信号
+    sighand_put(task->sighand);
+    task->sighand = NULL;
+
+    // 释放 FPU 状态
+    if (task->fpu)
+    {
+        kfree(task->fpu);
+        task->fpu = NULL;
+        task->flags = 0;
+    }
+
+    if (task != leader)
+    {
+        task_exit_thread(task, leader);
+        schedule();
+    }
+
+    task_kill_session(task);
+    task_free_tty(task);
+
+    // 还有其他线程，进程资源由最后退出的线程释放
+    if (task->threads > 0)
+    {
+        task_kill_threads(task);
+        schedule();
+    }
+
+    task_release(task);
+    task_notify_parent(task);
 
     schedule();
 }
@@ -551,12 +822,16 @@ pid_t task_waitpid(pid_t pid, int32 *status)
             if (!ptr)
                 continue;
 
-            if (ptr->ppid != task->pid)
+            if (ptr->ppid != task->tgid)
                 continue;
             if (pid != ptr->pid && pid != -1)
                 continue;
+            // 线程退出后由 get_free_task 回收
+            if (ptr->tgid != ptr->pid)
+                continue;
 
-            if (ptr->state == TASK_DIED)
+            // 线程组首领在其他线程都退出后才能回收
+            if (ptr->state == TASK_DIED && ptr->threads == 0)
             {
                 child = ptr;
                 task_table[i] = NULL;
@@ -588,7 +863,12 @@ static void task_setup()
 {
     task_t *task = running_task();
     task->magic = ONIX_MAGIC;
+    task->files = task->fdtab;
     task->ticks = 1;
+    task->priority = 1;
+    task->weight = NICE_0_LOAD;
+    task->prio = task->normal_prio = NICE_TO_PRIO(0);
+    list_init(&task->pi_mutexes);
 
     memset(task_table, 0, sizeof(task_table));
 }
@@ -601,8 +881,10 @@ void task_init()
     list_init(&block_list);
     list_init(&sleep_list);
 
+    sched_init();
     task_setup();
 
-    idle_task = task_create(idle_thread, "idle", 1, KERNEL_USER);
+    task_t *idle = task_create(idle_thread, "idle", 1, KERNEL_USER);
+    sched_set_idle(&cpus[0], idle);
     task_create(init_thread, "init", 5, NORMAL_USER); // 创建
 }
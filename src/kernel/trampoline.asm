@@ -0,0 +1,78 @@
+[bits 16]
+; 应用处理器启动代码，运行时被复制到 TRAMPOLINE_ADDR，
+; 处理器收到 STARTUP 处理器间中断后从实模式在此开始执行
+
+TRAMPOLINE_ADDR equ 0x8000
+KERNEL_PAGE_DIR equ 0x1000
+
+code_selector equ (1 << 3)
+data_selector equ (2 << 3)
+
+; 代码被复制后的实际地址
+%define ADDR(label) (label - trampoline_start + TRAMPOLINE_ADDR)
+
+extern gdt_ptr
+extern ap_stack
+extern ap_main
+
+section .text
+
+global trampoline_start
+trampoline_start:
+    cli
+    xor ax, ax
+    mov ds, ax
+
+    ; 加载临时全局描述符表，进入保护模式
+    lgdt [ADDR(trampoline_gdt_ptr)]
+
+    mov eax, cr0
+    or eax, 1
+    mov cr0, eax
+
+    jmp dword code_selector:ADDR(trampoline_protect)
+
+[bits 32]
+trampoline_protect:
+    mov ax, data_selector
+    mov ds, ax
+    mov es, ax
+    mov ss, ax
+
+    ; 使用内核页目录，开启分页
+    mov eax, KERNEL_PAGE_DIR
+    mov cr3, eax
+
+    mov eax, cr0
+    or eax, 0x80000000
+    mov cr0, eax
+
+    ; 加载内核全局描述符表，跳转到内核代码
+    lgdt [gdt_ptr]
+    jmp dword code_selector:ap_start
+
+align 8
+trampoline_gdt:
+    dq 0                  ; 空描述符
+    dq 0x00cf9a000000ffff ; 内核代码段
+    dq 0x00cf92000000ffff ; 内核数据段
+trampoline_gdt_ptr:
+    dw (3 * 8 - 1)
+    dd ADDR(trampoline_gdt)
+
+global trampoline_end
+trampoline_end:
+
+ap_start:
+    mov ax, data_selector
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+
+    ; 使用启动处理器为其准备的空闲任务栈
+    mov esp, [ap_stack]
+    call ap_main
+
+    jmp $; 阻塞
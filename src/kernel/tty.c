@@ -65,6 +65,12 @@ int tty_write(tty_t *tty, char *buf, u32 count)
     return device_write(tty->wdev, buf, count, 0, 0);
 }
 
+// 读取输入设备的就绪事件，输出到控制台总是可以进行
+int tty_poll(tty_t *tty, poll_table_t *pt)
+{
+    return (device_poll(tty->rdev, pt) & POLLIN) | POLLOUT;
+}
+
 int tty_ioctl(tty_t *tty, int cmd, void *args, int flags)
 {
     if (cmd == TIOCSPGRP)
@@ -99,6 +105,7 @@ void tty_init()
     device = device_find(DEV_CONSOLE, 0);
     tty->wdev = device->dev;
 
-    device_install(DEV_CHAR, DEV_TTY, tty, "tty", 0, tty_ioctl, tty_read, tty_write);
+    dev_t dev = device_install(DEV_CHAR, DEV_TTY, tty, "tty", 0, tty_ioctl, tty_read, tty_write);
+    device_get(dev)->poll = (void *)tty_poll;
 }
 
@@ -0,0 +1,69 @@
+#include "hyc.h"
+
+#define LOGK(fmt, args...) DEBUGK(fmt, ##args)
+
+#define VDSO_DIDX (VDSO_ADDR >> 22)
+#define VDSO_TIDX(addr) (((addr) >> 12) & 0x3ff)
+
+extern volatile u32 jiffies;
+extern u32 jiffy;
+extern time_t startup_time;
+
+// 系统数据页，内核直接通过恒等映射写入
+static vdso_data_t *vdso_data;
+
+static void vdso_entry(page_entry_t *entry, u32 page, bool write)
+{
+    *(u32 *)entry = 0;
+    entry->present = true;
+    entry->write = write;
+    entry->user = true;
+    entry->index = page >> 12;
+}
+
+// 共享数据页和进程页都是内核页，不计入 copy_pde / free_pde 的物理页引用，
+// 由进程创建和释放地址空间时单独维护
+void vdso_map(page_entry_t *pde, pid_t pid)
+{
+    page_entry_t *table = (page_entry_t *)alloc_kpage(1);
+    memset(table, 0, PAGE_SIZE);
+
+    vdso_task_t *data = (vdso_task_t *)alloc_kpage(1);
+    memset(data, 0, PAGE_SIZE);
+    data->pid = pid;
+
+    vdso_entry(&table[VDSO_TIDX(VDSO_DATA_ADDR)], (u32)vdso_data, false);
+    vdso_entry(&table[VDSO_TIDX(VDSO_TASK_ADDR)], (u32)data, false);
+
+    // fork 时从父进程拷贝的页目录项在此被替换
+    vdso_entry(&pde[VDSO_DIDX], (u32)table, true);
+}
+
+void vdso_unmap(page_entry_t *pde)
+{
+    page_entry_t *dentry = &pde[VDSO_DIDX];
+    if (!dentry->present)
+        return;
+
+    page_entry_t *table = (page_entry_t *)(dentry->index << 12);
+    free_kpage(table[VDSO_TIDX(VDSO_TASK_ADDR)].index << 12, 1);
+    free_kpage((u32)table, 1);
+
+    dentry->present = false;
+}
+
+void vdso_update()
+{
+    vdso_data->jiffies = jiffies;
+}
+
+void vdso_init()
+{
+    vdso_data = (vdso_data_t *)alloc_kpage(1);
+    memset(vdso_data, 0, PAGE_SIZE);
+
+    vdso_data->jiffy = jiffy;
+    vdso_data->startup_time = startup_time;
+    vdso_data->jiffies = jiffies;
+    LOGK("vdso data page 0x%p\n", vdso_data);
+}
@@ -0,0 +1,190 @@
+#include "hyc.h"
+
+#define LOGK(fmt, args...) DEBUGK(fmt, ##args)
+
+// 传统接口的队列布局：描述符表，可用环和 used_event，
+// 对齐到 4K 之后是已用环和 avail_event
+#define VRING_AVAIL_SIZE(size) (sizeof(vring_avail_t) + sizeof(u16) * ((size) + 1))
+#define VRING_USED_SIZE(size) (sizeof(vring_used_t) + sizeof(vring_used_elem_t) * (size) + sizeof(u16))
+
+// 设备用过 event 之后的缓冲时需要通知，new 和 old 之间跨过 event 返回 true
+static bool vring_need_event(u16 event, u16 new, u16 old)
+{
+    return (u16)(new - event - 1) < (u16)(new - old);
+}
+
+// 可用环后面的 used_event，驱动希望在设备用过这个位置之后中断
+static u16 *vring_used_event(virtqueue_t *vq)
+{
+    return &vq->avail->ring[vq->size];
+}
+
+// 已用环后面的 avail_event，设备希望在驱动放入这个位置之后通知
+static volatile u16 *vring_avail_event(virtqueue_t *vq)
+{
+    return (volatile u16 *)&vq->used->ring[vq->size];
+}
+
+virtqueue_t *virtq_create(u16 iobase, u16 index, u32 features)
+{
+    outw(iobase + VIRTIO_PCI_QUEUE_SEL, index);
+    u16 size = inw(iobase + VIRTIO_PCI_QUEUE_NUM);
+    if (!size || inl(iobase + VIRTIO_PCI_QUEUE_PFN))
+        return NULL;
+
+    u32 used = div_round_up(sizeof(vring_desc_t) * size + VRING_AVAIL_SIZE(size), VIRTIO_PCI_VRING_ALIGN);
+    used *= VIRTIO_PCI_VRING_ALIGN;
+    u32 pages = div_round_up(used + VRING_USED_SIZE(size), PAGE_SIZE);
+
+    // 内核页物理地址连续
+    u32 addr = alloc_kpage(pages);
+    memset((void *)addr, 0, pages * PAGE_SIZE);
+
+    virtqueue_t *vq = (virtqueue_t *)kmalloc(sizeof(virtqueue_t));
+    vq->iobase = iobase;
+    vq->index = index;
+    vq->size = size;
+    vq->indirect = (features & VIRTIO_RING_F_INDIRECT_DESC) != 0;
+    vq->event_idx = (features & VIRTIO_RING_F_EVENT_IDX) != 0;
+    vq->desc = (vring_desc_t *)addr;
+    vq->avail = (vring_avail_t *)(addr + sizeof(vring_desc_t) * size);
+    vq->used = (vring_used_t *)(addr + used);
+    vq->pages = pages;
+    vq->free_head = 0;
+    vq->num_free = size;
+    vq->avail_idx = 0;
+    vq->kicked = 0;
+    vq->last_used = 0;
+    vq->data = (void **)kmalloc(sizeof(void *) * size);
+
+    // 空闲描述符用 next 连成链表
+    for (size_t i = 0; i < size; i++)
+    {
+        vq->desc[i].next = i + 1;
+        vq->data[i] = NULL;
+    }
+
+    outl(iobase + VIRTIO_PCI_QUEUE_PFN, get_paddr(addr) / PAGE_SIZE);
+    LOGK("virtqueue %d size %d pages %d\n", index, size, pages);
+    return vq;
+}
+
+err_t virtq_add(virtqueue_t *vq, vring_desc_t *descs, int count, vring_desc_t *table, void *data)
+{
+    assert(count > 0);
+    u16 head = vq->free_head;
+
+    if (vq->indirect && table)
+    {
+        if (!vq->num_free)
+            return -ENOSPC;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            table[i] = descs[i];
+            table[i].flags &= ~VRING_DESC_F_NEXT;
+            table[i].next = i + 1;
+            if (i + 1 < count)
+                table[i].flags |= VRING_DESC_F_NEXT;
+        }
+
+        vring_desc_t *desc = &vq->desc[head];
+        desc->addr = get_paddr((u32)table);
+        desc->len = count * sizeof(vring_desc_t);
+        desc->flags = VRING_DESC_F_INDIRECT;
+        vq->free_head = desc->next;
+        vq->num_free--;
+    }
+    else
+    {
+        if (vq->num_free < count)
+            return -ENOSPC;
+
+        // 空闲链表中的 next 正好把取出的描述符连起来
+        u16 idx = head;
+        for (size_t i = 0; i < count; i++)
+        {
+            vring_desc_t *desc = &vq->desc[idx];
+            desc->addr = descs[i].addr;
+            desc->len = descs[i].len;
+            desc->flags = descs[i].flags & ~VRING_DESC_F_NEXT;
+            if (i + 1 < count)
+                desc->flags |= VRING_DESC_F_NEXT;
+            idx = desc->next;
+        }
+        vq->free_head = idx;
+        vq->num_free -= count;
+    }
+
+    vq->data[head] = data;
+    vq->avail->ring[vq->avail_idx % vq->size] = head;
+    vq->avail_idx++;
+    return EOK;
+}
+
+void virtq_kick(virtqueue_t *vq)
+{
+    u16 old = vq->kicked;
+    u16 new = vq->avail_idx;
+    if (old == new)
+        return;
+
+    // 描述符和可用环写完之后才能更新 idx
+    virtio_wmb();
+    vq->avail->idx = new;
+    vq->kicked = new;
+
+    // 读取设备的抑制标志之前 idx 必须已经对设备可见
+    virtio_mb();
+
+    bool notify;
+    if (vq->event_idx)
+        notify = vring_need_event(*vring_avail_event(vq), new, old);
+    else
+        notify = !(vq->used->flags & VRING_USED_F_NO_NOTIFY);
+
+    if (notify)
+        outw(vq->iobase + VIRTIO_PCI_QUEUE_NOTIFY, vq->index);
+}
+
+void *virtq_get(virtqueue_t *vq, u32 *len)
+{
+    if (vq->last_used == vq->used->idx)
+        return NULL;
+
+    // 读到 idx 之后再读取已用环中的内容
+    virtio_wmb();
+    volatile vring_used_elem_t *elem = &vq->used->ring[vq->last_used % vq->size];
+    u16 head = elem->id;
+    if (len)
+        *len = elem->len;
+    vq->last_used++;
+
+    // 描述符链放回空闲链表
+    u16 idx = head;
+    u16 count = 1;
+    while (vq->desc[idx].flags & VRING_DESC_F_NEXT)
+    {
+        idx = vq->desc[idx].next;
+        count++;
+    }
+    vq->desc[idx].next = vq->free_head;
+    vq->free_head = head;
+    vq->num_free += count;
+
+    void *data = vq->data[head];
+    vq->data[head] = NULL;
+    return data;
+}
+
+bool virtq_enable_intr(virtqueue_t *vq)
+{
+    if (vq->event_idx)
+        *vring_used_event(vq) = vq->last_used;
+    else
+        vq->avail->flags &= ~VRING_AVAIL_F_NO_INTERRUPT;
+
+    // 设置之后再检查，避免设备在设置之前用过缓冲而不中断
+    virtio_mb();
+    return vq->last_used != vq->used->idx;
+}
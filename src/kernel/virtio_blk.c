@@ -0,0 +1,506 @@
+#include "hyc.h"
+
+#define LOGK(fmt, args...) DEBUGK(fmt, ##args)
+
+// 块设备特性
+#define VIRTIO_BLK_F_SEG_MAX (1 << 2) // 配置中有每个请求最多的数据段数量
+#define VIRTIO_BLK_F_RO (1 << 5)      // 只读设备
+#define VIRTIO_BLK_F_MQ (1 << 12)     // 多个队列
+
+// 驱动使用的特性
+#define VIRTIO_BLK_FEATURES (VIRTIO_BLK_F_SEG_MAX | VIRTIO_BLK_F_RO | VIRTIO_BLK_F_MQ | \
+                             VIRTIO_RING_F_INDIRECT_DESC | VIRTIO_RING_F_EVENT_IDX)
+
+// 块设备配置偏移
+#define VIRTIO_BLK_CONFIG_CAPACITY 0    // 扇区数量，64 位
+#define VIRTIO_BLK_CONFIG_SEG_MAX 12    // 每个请求最多的数据段数量
+#define VIRTIO_BLK_CONFIG_NUM_QUEUES 34 // 队列数量
+
+// 请求类型
+#define VIRTIO_BLK_T_IN 0  // 读
+#define VIRTIO_BLK_T_OUT 1 // 写
+
+// 请求状态
+#define VIRTIO_BLK_S_OK 0     // 成功
+#define VIRTIO_BLK_S_IOERR 1  // 错误
+#define VIRTIO_BLK_S_UNSUPP 2 // 不支持
+
+// 分区文件系统类型定义
+#define PART_FS_EXTENDED 5
+
+static virtio_blk_t disk;
+
+// 放回请求，有了空闲请求，唤醒一个等待的任务
+static void vblk_req_put(virtio_blk_t *blk, virtio_blk_queue_t *queue, virtio_blk_req_t *vreq)
+{
+    vreq->next = queue->free;
+    queue->free = vreq;
+    queue->inflight--;
+
+    if (!list_empty(&blk->wait_list))
+    {
+        task_t *task = element_entry(task_t, node, list_popback(&blk->wait_list));
+        task_unblock(task, EOK);
+    }
+}
+
+// 请求完成，通知请求队列之后放回请求；
+// 同步请求只唤醒等待的任务，由它取得结果之后再放回，以免请求被别的任务取走重置
+static void vblk_req_end(virtio_blk_t *blk, virtio_blk_queue_t *queue, virtio_blk_req_t *vreq)
+{
+    err_t ret = (vreq->status == VIRTIO_BLK_S_OK) ? EOK : -EIO;
+    vreq->ret = ret;
+    vreq->done = true;
+
+    if (vreq->req)
+    {
+        device_complete(vreq->req, ret);
+        vreq->req = NULL;
+        vblk_req_put(blk, queue, vreq);
+    }
+    else if (vreq->waiter)
+    {
+        task_unblock(vreq->waiter, EOK);
+        vreq->waiter = NULL;
+    }
+}
+
+// 中断处理函数，取出所有用过的缓冲，重新打开中断之后再检查一次
+static void vblk_handler(int vector)
+{
+    virtio_blk_t *blk = &disk;
+    assert(vector == blk->vector);
+
+    // 读取中断状态同时清除中断
+    u8 isr = inb(blk->iobase + VIRTIO_PCI_ISR);
+    if (isr & 1)
+    {
+        for (size_t i = 0; i < blk->nr_queues; i++)
+        {
+            virtio_blk_queue_t *queue = &blk->queues[i];
+            do
+            {
+                virtio_blk_req_t *vreq;
+                while ((vreq = (virtio_blk_req_t *)virtq_get(queue->vq, NULL)))
+                    vblk_req_end(blk, queue, vreq);
+            } while (virtq_enable_intr(queue->vq));
+        }
+    }
+    send_eoi(vector);
+}
+
+// 取得空闲请求，选择执行中的请求最少的队列，没有时阻塞等待
+static virtio_blk_req_t *vblk_req_get(virtio_blk_t *blk, virtio_blk_queue_t **result)
+{
+    while (true)
+    {
+        virtio_blk_queue_t *queue = NULL;
+        for (size_t i = 0; i < blk->nr_queues; i++)
+        {
+            virtio_blk_queue_t *ptr = &blk->queues[i];
+            if (!ptr->free)
+                continue;
+            if (!queue || ptr->inflight < queue->inflight)
+                queue = ptr;
+        }
+
+        if (queue)
+        {
+            virtio_blk_req_t *vreq = queue->free;
+            queue->free = vreq->next;
+            queue->inflight++;
+            vreq->req = NULL;
+            vreq->waiter = NULL;
+            vreq->ret = EOK;
+            vreq->done = false;
+            vreq->status = 0xff;
+            *result = queue;
+            return vreq;
+        }
+        task_block(running_task(), &blk->wait_list, TASK_BLOCKED, TIMELESS);
+    }
+}
+
+// 把一段缓冲区按物理页拆分加入数据段，物理地址连续的相邻两段合并，
+// 返回数据段数量，超过 max 或者缓冲区不能 DMA 时返回 -EINVAL
+static int vblk_seg_add(vring_desc_t *segs, int nr, int max, void *buf, u32 size, u16 flags)
+{
+    if (!dma_capable(buf, size))
+        return -EINVAL;
+
+    u32 addr = (u32)buf;
+    while (size)
+    {
+        u32 chars = MIN(size, PAGE_SIZE - (addr & (PAGE_SIZE - 1)));
+        u32 paddr = get_paddr(addr);
+
+        vring_desc_t *prev = nr ? &segs[nr - 1] : NULL;
+        if (prev && (u32)prev->addr + prev->len == paddr)
+        {
+            prev->len += chars;
+        }
+        else
+        {
+            if (nr == max)
+                return -EINVAL;
+            segs[nr].addr = paddr;
+            segs[nr].len = chars;
+            segs[nr].flags = flags;
+            segs[nr].next = 0;
+            nr++;
+        }
+        addr += chars;
+        size -= chars;
+    }
+    return nr;
+}
+
+// 填写请求头和状态，第一个描述符是请求头，最后一个是状态
+static void vblk_req_fill(virtio_blk_req_t *vreq, vring_desc_t *descs, int nr, idx_t lba, u32 type)
+{
+    vreq->hdr.type = (type == REQ_READ) ? VIRTIO_BLK_T_IN : VIRTIO_BLK_T_OUT;
+    vreq->hdr.reserved = 0;
+    vreq->hdr.sector = lba;
+
+    descs[0].addr = get_paddr((u32)&vreq->hdr);
+    descs[0].len = sizeof(virtio_blk_outhdr_t);
+    descs[0].flags = 0;
+
+    descs[nr + 1].addr = get_paddr((u32)&vreq->status);
+    descs[nr + 1].len = sizeof(vreq->status);
+    descs[nr + 1].flags = VRING_DESC_F_WRITE;
+}
+
+// 数据段描述符的标志，读请求由设备写缓冲区
+static u16 vblk_seg_flags(u32 type)
+{
+    return (type == REQ_READ) ? VRING_DESC_F_WRITE : 0;
+}
+
+// 同步读写，iov 中的缓冲区依次对应从 lba 开始的连续扇区
+static int vblk_transfer(virtio_blk_t *blk, iovec_t *iov, int iovcnt, idx_t lba, u32 type)
+{
+    if (type == REQ_WRITE && (blk->features & VIRTIO_BLK_F_RO))
+        return -EROFS;
+
+    vring_desc_t descs[VIRTIO_BLK_SEG_NR + 2];
+    int nr = 0;
+    for (size_t i = 0; i < iovcnt; i++)
+    {
+        nr = vblk_seg_add(descs + 1, nr, blk->seg_max, iov[i].base, iov[i].size, vblk_seg_flags(type));
+        if (nr < EOK)
+            return nr;
+    }
+
+    virtio_blk_queue_t *queue;
+    virtio_blk_req_t *vreq = vblk_req_get(blk, &queue);
+    vblk_req_fill(vreq, descs, nr, lba, type);
+
+    int ret = virtq_add(queue->vq, descs, nr + 2, vreq->table, vreq);
+    if (ret < EOK)
+    {
+        vblk_req_put(blk, queue, vreq);
+        return ret;
+    }
+
+    vreq->waiter = running_task();
+    virtq_kick(queue->vq);
+    while (!vreq->done)
+        task_block(running_task(), NULL, TASK_BLOCKED, TIMELESS);
+
+    ret = vreq->ret;
+    vblk_req_put(blk, queue, vreq);
+    return ret;
+}
+
+// 异步执行请求，请求中每一段直接作为数据段，等到 vblk_kick 再通知设备，
+// 不能 DMA 时返回 -EINVAL 由请求队列中转
+static err_t vblk_queue(virtio_blk_t *blk, request_t *req)
+{
+    if (req->type == REQ_WRITE && (blk->features & VIRTIO_BLK_F_RO))
+        return -EROFS;
+
+    vring_desc_t descs[VIRTIO_BLK_SEG_NR + 2];
+    int nr = 0;
+    for (bio_t *bio = req->bio; bio; bio = bio->next)
+    {
+        nr = vblk_seg_add(descs + 1, nr, blk->seg_max, bio->buf, bio->count * SECTOR_SIZE, vblk_seg_flags(req->type));
+        if (nr < EOK)
+            return nr;
+    }
+
+    virtio_blk_queue_t *queue;
+    virtio_blk_req_t *vreq = vblk_req_get(blk, &queue);
+    vblk_req_fill(vreq, descs, nr, req->idx, req->type);
+
+    int ret = virtq_add(queue->vq, descs, nr + 2, vreq->table, vreq);
+    if (ret < EOK)
+    {
+        vblk_req_put(blk, queue, vreq);
+        return ret;
+    }
+    vreq->req = req;
+    return EOK;
+}
+
+// 一批请求放入之后，每个队列通知设备一次
+static void vblk_kick(virtio_blk_t *blk)
+{
+    for (size_t i = 0; i < blk->nr_queues; i++)
+        virtq_kick(blk->queues[i].vq);
+}
+
+// 磁盘控制
+static int vblk_ioctl(virtio_blk_t *blk, int cmd, void *args, int flags)
+{
+    switch (cmd)
+    {
+    case DEV_CMD_SECTOR_START:
+        return 0;
+    case DEV_CMD_SECTOR_COUNT:
+        return blk->capacity;
+    case DEV_CMD_SECTOR_SIZE:
+        return SECTOR_SIZE;
+    default:
+        panic("Unrecognized device command %d!!!", cmd);
+    }
+}
+
+// 读写一段连续的缓冲区，缓冲区不能 DMA 时（如用户内存）经过内核页中转
+static int vblk_rw(virtio_blk_t *blk, void *buf, u8 count, idx_t lba, u32 type)
+{
+    u32 size = count * SECTOR_SIZE;
+    iovec_t iov = {size, buf};
+    if (dma_capable(buf, size))
+        return vblk_transfer(blk, &iov, 1, lba, type);
+
+    u32 pages = div_round_up(size, PAGE_SIZE);
+    iov.base = (void *)alloc_kpage(pages);
+    if (type == REQ_WRITE)
+        memcpy(iov.base, buf, size);
+
+    int ret = vblk_transfer(blk, &iov, 1, lba, type);
+    if (type == REQ_READ && ret >= EOK)
+        memcpy(buf, iov.base, size);
+
+    free_kpage((u32)iov.base, pages);
+    return ret;
+}
+
+// 读磁盘
+static int vblk_read(virtio_blk_t *blk, void *buf, u8 count, idx_t lba)
+{
+    return vblk_rw(blk, buf, count, lba, REQ_READ);
+}
+
+// 写磁盘
+static int vblk_write(virtio_blk_t *blk, void *buf, u8 count, idx_t lba)
+{
+    return vblk_rw(blk, buf, count, lba, REQ_WRITE);
+}
+
+// 分区控制
+static int vblk_part_ioctl(virtio_blk_part_t *part, int cmd, void *args, int flags)
+{
+    switch (cmd)
+    {
+    case DEV_CMD_SECTOR_START:
+        return part->start;
+    case DEV_CMD_SECTOR_COUNT:
+        return part->count;
+    case DEV_CMD_SECTOR_SIZE:
+        return SECTOR_SIZE;
+    default:
+        panic("Unrecognized device command %d!!!", cmd);
+    }
+}
+
+// 读取分区
+static int vblk_part_read(virtio_blk_part_t *part, void *buf, u8 count, idx_t lba)
+{
+    return vblk_read(part->blk, buf, count, part->start + lba);
+}
+
+// 写入分区
+static int vblk_part_write(virtio_blk_part_t *part, void *buf, u8 count, idx_t lba)
+{
+    return vblk_write(part->blk, buf, count, part->start + lba);
+}
+
+// 读取主引导记录中的主分区
+static void vblk_part_init(virtio_blk_t *blk)
+{
+    void *buf = (void *)alloc_kpage(1);
+    if (vblk_read(blk, buf, 1, 0) < EOK)
+        goto rollback;
+
+    boot_sector_t *boot = (boot_sector_t *)buf;
+    for (size_t i = 0; i < VIRTIO_BLK_PART_NR; i++)
+    {
+        part_entry_t *entry = &boot->entry[i];
+        virtio_blk_part_t *part = &blk->parts[i];
+        if (entry->count == 0)
+            continue;
+
+        sprintf(part->name, "%s%d", blk->name, i + 1);
+        LOGK("Partition %s start %d count %d system 0x%x\n",
+             part->name, entry->start, entry->count, entry->system);
+
+        part->blk = blk;
+        part->count = entry->count;
+        part->system = entry->system;
+        part->start = entry->start;
+
+        if (entry->system == PART_FS_EXTENDED)
+            LOGK("Extended partitions are not supported.\n");
+    }
+
+rollback:
+    free_kpage((u32)buf, 1);
+}
+
+// 初始化队列，每个队列的请求和间接描述符表预先分配
+static err_t vblk_queue_init(virtio_blk_t *blk, virtio_blk_queue_t *queue, u16 index)
+{
+    queue->vq = virtq_create(blk->iobase, index, blk->features);
+    if (!queue->vq)
+        return -EIO;
+
+    // 不使用间接描述符时每个请求占用 seg_max + 2 个描述符
+    queue->slots = MIN(VIRTIO_BLK_SLOT_NR, queue->vq->size);
+    if (!queue->vq->indirect)
+        queue->slots = MAX(1, MIN(queue->slots, queue->vq->size / (blk->seg_max + 2)));
+
+    queue->reqs = (virtio_blk_req_t *)kmalloc(sizeof(virtio_blk_req_t) * queue->slots);
+    queue->free = NULL;
+    queue->inflight = 0;
+    for (size_t i = 0; i < queue->slots; i++)
+    {
+        virtio_blk_req_t *vreq = &queue->reqs[i];
+        vreq->table = NULL;
+        if (queue->vq->indirect)
+            vreq->table = (vring_desc_t *)kmalloc(sizeof(vring_desc_t) * (blk->seg_max + 2));
+        vreq->next = queue->free;
+        queue->free = vreq;
+    }
+    return EOK;
+}
+
+// 设置中断，传统接口只能使用 INTx
+static void vblk_interrupt_init(virtio_blk_t *blk, pci_device_t *device)
+{
+    u32 intr = pci_interrupt(device);
+    LOGK("virtio blk irq 0x%X...\n", intr);
+    blk->vector = IRQ_MASTER_NR + intr;
+
+    set_interrupt_handler(intr, vblk_handler);
+    set_interrupt_mask(intr, true);
+    if (intr >= 8)
+        set_interrupt_mask(IRQ_CASCADE, true);
+}
+
+// 复位设备，协商特性，建立队列
+static err_t vblk_setup(virtio_blk_t *blk)
+{
+    u16 iobase = blk->iobase;
+    outb(iobase + VIRTIO_PCI_STATUS, 0);
+    outb(iobase + VIRTIO_PCI_STATUS, VIRTIO_STATUS_ACKNOWLEDGE);
+    outb(iobase + VIRTIO_PCI_STATUS, VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+
+    blk->features = inl(iobase + VIRTIO_PCI_HOST_FEATURES) & VIRTIO_BLK_FEATURES;
+    outl(iobase + VIRTIO_PCI_GUEST_FEATURES, blk->features);
+
+    // 只能访问 32 位扇区号
+    u32 config = iobase + VIRTIO_PCI_CONFIG;
+    blk->capacity = inl(config + VIRTIO_BLK_CONFIG_CAPACITY);
+    if (inl(config + VIRTIO_BLK_CONFIG_CAPACITY + 4))
+        blk->capacity = 0xFFFFFFFF;
+
+    blk->seg_max = VIRTIO_BLK_SEG_NR;
+    if (blk->features & VIRTIO_BLK_F_SEG_MAX)
+        blk->seg_max = MAX(1, MIN(VIRTIO_BLK_SEG_NR, inl(config + VIRTIO_BLK_CONFIG_SEG_MAX)));
+
+    u32 nr_queues = 1;
+    if (blk->features & VIRTIO_BLK_F_MQ)
+        nr_queues = MAX(1, MIN(VIRTIO_BLK_QUEUE_NR, inw(config + VIRTIO_BLK_CONFIG_NUM_QUEUES)));
+
+    blk->nr_queues = 0;
+    for (size_t i = 0; i < nr_queues; i++)
+    {
+        if (vblk_queue_init(blk, &blk->queues[i], i) < EOK)
+            break;
+        blk->nr_queues++;
+    }
+    if (!blk->nr_queues)
+    {
+        outb(iobase + VIRTIO_PCI_STATUS, VIRTIO_STATUS_FAILED);
+        return -EIO;
+    }
+
+    outb(iobase + VIRTIO_PCI_STATUS,
+         VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER | VIRTIO_STATUS_DRIVER_OK);
+
+    LOGK("virtio blk capacity %d features 0x%x seg_max %d queues %d\n",
+         blk->capacity, blk->features, blk->seg_max, blk->nr_queues);
+    return EOK;
+}
+
+// 注册磁盘和分区，请求队列同时交给设备所有队列的请求
+static void vblk_install(virtio_blk_t *blk)
+{
+    blk->dev = device_install(
+        DEV_BLOCK, DEV_VIRTIO_DISK, blk, blk->name, 0,
+        vblk_ioctl, vblk_read, vblk_write);
+
+    device_t *device = device_get(blk->dev);
+    device->queue = (void *)vblk_queue;
+    device->kick = (void *)vblk_kick;
+    device->slots = 0;
+    for (size_t i = 0; i < blk->nr_queues; i++)
+        device->slots += blk->queues[i].slots;
+
+    for (size_t i = 0; i < VIRTIO_BLK_PART_NR; i++)
+    {
+        virtio_blk_part_t *part = &blk->parts[i];
+        if (part->count == 0)
+            continue;
+
+        device_install(
+            DEV_BLOCK, DEV_VIRTIO_PART, part, part->name, blk->dev,
+            vblk_part_ioctl, vblk_part_read, vblk_part_write);
+    }
+}
+
+// virtio 块设备初始化
+void virtio_blk_init()
+{
+    pci_device_t *device = pci_find_device(VIRTIO_VENDORID, VIRTIO_DEVICEID_BLK);
+    if (!device)
+    {
+        LOGK("PCI virtio block device not exists...\n");
+        return;
+    }
+
+    virtio_blk_t *blk = &disk;
+    memset(blk, 0, sizeof(virtio_blk_t));
+    strcpy(blk->name, "vda");
+    list_init(&blk->wait_list);
+
+    pci_bar_t bar;
+    err_t ret = pci_find_bar(device, &bar, PCI_BAR_TYPE_IO);
+    assert(ret == EOK);
+    blk->iobase = bar.iobase;
+    LOGK("virtio blk iobase 0x%x size %d\n", bar.iobase, bar.size);
+
+    pci_enable_busmastering(device);
+    vblk_interrupt_init(blk, device);
+
+    if (vblk_setup(blk) < EOK)
+    {
+        LOGK("virtio blk setup failed\n");
+        return;
+    }
+
+    vblk_part_init(blk);
+    vblk_install(blk);
+}
@@ -0,0 +1,44 @@
+#include "hyc.h"
+
+#define LOGK(fmt, args...) DEBUGK(fmt, ##args)
+
+void wait_queue_init(wait_queue_t *wq)
+{
+    list_init(&wq->list);
+}
+
+void wait_entry_init(wait_entry_t *entry, wait_func_t func, void *data)
+{
+    entry->node.next = NULL;
+    entry->node.prev = NULL;
+    entry->queue = NULL;
+    entry->func = func;
+    entry->data = data;
+}
+
+void wait_add(wait_queue_t *wq, wait_entry_t *entry)
+{
+    assert(entry->queue == NULL);
+    entry->queue = wq;
+    list_pushback(&wq->list, &entry->node);
+}
+
+void wait_remove(wait_entry_t *entry)
+{
+    if (!entry->queue)
+        return;
+    list_remove(&entry->node);
+    entry->queue = NULL;
+}
+
+void wake_up(wait_queue_t *wq, u32 events)
+{
+    list_t *list = &wq->list;
+    for (list_node_t *node = list->head.next; node != &list->tail;)
+    {
+        wait_entry_t *entry = element_entry(wait_entry_t, node, node);
+        // 回调中可能移除当前项
+        node = node->next;
+        entry->func(entry, events);
+    }
+}
@@ -0,0 +1,181 @@
+#include "hyc.h"
+
+#define LOGK(fmt, args...) DEBUGK(fmt, ##args)
+
+static workqueue_t workqueues[WORKQUEUE_NR];
+
+workqueue_t *system_wq;
+
+// 用于等待工作队列执行到某个位置
+typedef struct wq_barrier_t
+{
+    work_t work;
+    task_t *task; // 等待的任务
+    bool done;    // 已经执行
+} wq_barrier_t;
+
+void work_init(work_t *work, work_func_t func)
+{
+    work->node.next = NULL;
+    work->node.prev = NULL;
+    work->func = func;
+    work->wq = NULL;
+    work->pending = false;
+}
+
+static workqueue_t *find_workqueue(task_t *task)
+{
+    for (size_t i = 0; i < WORKQUEUE_NR; i++)
+    {
+        if (workqueues[i].worker == task)
+            return &workqueues[i];
+    }
+    return NULL;
+}
+
+static void worker_thread()
+{
+    workqueue_t *wq;
+    // 等待创建者设置工作线程
+    while (!(wq = find_workqueue(running_task())))
+    {
+        task_yield();
+    }
+
+    while (true)
+    {
+        if (list_empty(&wq->works))
+        {
+            wq->idle = true;
+            int ret = task_block(wq->worker, NULL, TASK_WAITING, TIMELESS);
+            assert(ret == EOK);
+            continue;
+        }
+
+        work_t *work = element_entry(work_t, node, list_popback(&wq->works));
+        work->pending = false;
+        wq->current = work;
+
+        // 执行之后工作项可能已被释放，不能再访问
+        work->func(work);
+        wq->current = NULL;
+    }
+}
+
+workqueue_t *workqueue_create(const char *name, int policy, int priority)
+{
+    workqueue_t *wq = NULL;
+    for (size_t i = 0; i < WORKQUEUE_NR; i++)
+    {
+        if (!workqueues[i].worker)
+        {
+            wq = &workqueues[i];
+            break;
+        }
+    }
+    if (!wq)
+        panic("no more workqueue!!!");
+
+    strncpy(wq->name, name, WORKQUEUE_NAME_LEN - 1);
+    list_init(&wq->works);
+    wq->current = NULL;
+    wq->idle = false;
+    wq->worker = task_create(worker_thread, wq->name, 5, KERNEL_USER);
+    if (policy != SCHED_NORMAL)
+        sched_set_policy(wq->worker, policy, priority);
+
+    LOGK("workqueue %s created...\n", wq->name);
+    return wq;
+}
+
+bool queue_work(workqueue_t *wq, work_t *work)
+{
+    bool intr = interrupt_disable();
+    bool ret = !work->pending;
+    if (ret)
+    {
+        work->pending = true;
+        work->wq = wq;
+        list_push(&wq->works, &work->node);
+
+        // 工作项自身也可能处于 TASK_WAITING，只唤醒空闲等待的工作线程
+        if (wq->idle)
+        {
+            wq->idle = false;
+            task_unblock(wq->worker, EOK);
+        }
+    }
+    set_interrupt_state(intr);
+    return ret;
+}
+
+bool schedule_work(work_t *work)
+{
+    return queue_work(system_wq, work);
+}
+
+bool cancel_work(work_t *work)
+{
+    bool intr = interrupt_disable();
+    bool ret = work->pending;
+    if (ret)
+    {
+        list_remove(&work->node);
+        work->pending = false;
+    }
+    set_interrupt_state(intr);
+    return ret;
+}
+
+bool cancel_work_sync(work_t *work)
+{
+    bool ret = cancel_work(work);
+    workqueue_t *wq = work->wq;
+    if (wq && wq->current == work && running_task() != wq->worker)
+        flush_workqueue(wq);
+    return ret;
+}
+
+static void wq_barrier_func(work_t *work)
+{
+    wq_barrier_t *barr = element_entry(wq_barrier_t, work, work);
+    barr->done = true;
+    if (barr->task->state == TASK_BLOCKED)
+        task_unblock(barr->task, EOK);
+}
+
+void flush_workqueue(workqueue_t *wq)
+{
+    task_t *task = running_task();
+    // 工作线程等待自己会导致死锁
+    assert(task != wq->worker);
+
+    bool intr = interrupt_disable();
+
+    wq_barrier_t barr;
+    work_init(&barr.work, wq_barrier_func);
+    barr.task = task;
+    barr.done = false;
+    queue_work(wq, &barr.work);
+
+    while (!barr.done)
+    {
+        task_block(task, NULL, TASK_BLOCKED, TIMELESS);
+    }
+    set_interrupt_state(intr);
+}
+
+bool flush_work(work_t *work)
+{
+    workqueue_t *wq = work->wq;
+    if (!wq || (!work->pending && wq->current != work))
+        return false;
+    flush_workqueue(wq);
+    return true;
+}
+
+void workqueue_init()
+{
+    memset(workqueues, 0, sizeof(workqueues));
+    system_wq = workqueue_create("events", SCHED_NORMAL, 0);
+}
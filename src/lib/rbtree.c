@@ -0,0 +1,321 @@
+#include "hyc.h"
+
+#define is_red(node) ((node) != NULL && (node)->color == RB_RED)
+#define is_black(node) ((node) == NULL || (node)->color == RB_BLACK)
+
+// 初始化红黑树
+void rbtree_init(rbtree_t *tree, rbtree_less_t less)
+{
+    tree->root = NULL;
+    tree->leftmost = NULL;
+    tree->less = less;
+    tree->count = 0;
+}
+
+// 用 node 替换 parent 中指向 old 的孩子指针
+static void rbtree_replace_child(rbtree_t *tree, rbnode_t *parent, rbnode_t *old, rbnode_t *node)
+{
+    if (parent == NULL)
+        tree->root = node;
+    else if (parent->left == old)
+        parent->left = node;
+    else
+        parent->right = node;
+}
+
+// 左旋
+static void rbtree_rotate_left(rbtree_t *tree, rbnode_t *node)
+{
+    rbnode_t *right = node->right;
+
+    node->right = right->left;
+    if (right->left)
+        right->left->parent = node;
+
+    right->parent = node->parent;
+    rbtree_replace_child(tree, node->parent, node, right);
+
+    right->left = node;
+    node->parent = right;
+}
+
+// 右旋
+static void rbtree_rotate_right(rbtree_t *tree, rbnode_t *node)
+{
+    rbnode_t *left = node->left;
+
+    node->left = left->right;
+    if (left->right)
+        left->right->parent = node;
+
+    left->parent = node->parent;
+    rbtree_replace_child(tree, node->parent, node, left);
+
+    left->right = node;
+    node->parent = left;
+}
+
+// 插入后修复红黑性质
+static void rbtree_insert_fixup(rbtree_t *tree, rbnode_t *node)
+{
+    while (is_red(node->parent))
+    {
+        rbnode_t *parent = node->parent;
+        rbnode_t *grand = parent->parent;
+
+        if (parent == grand->left)
+        {
+            rbnode_t *uncle = grand->right;
+            if (is_red(uncle))
+            {
+                parent->color = RB_BLACK;
+                uncle->color = RB_BLACK;
+                grand->color = RB_RED;
+                node = grand;
+                continue;
+            }
+            if (node == parent->right)
+            {
+                rbtree_rotate_left(tree, parent);
+                node = parent;
+                parent = node->parent;
+            }
+            parent->color = RB_BLACK;
+            grand->color = RB_RED;
+            rbtree_rotate_right(tree, grand);
+        }
+        else
+        {
+            rbnode_t *uncle = grand->left;
+            if (is_red(uncle))
+            {
+                parent->color = RB_BLACK;
+                uncle->color = RB_BLACK;
+                grand->color = RB_RED;
+                node = grand;
+                continue;
+            }
+            if (node == parent->left)
+            {
+                rbtree_rotate_right(tree, parent);
+                node = parent;
+                parent = node->parent;
+            }
+            parent->color = RB_BLACK;
+            grand->color = RB_RED;
+            rbtree_rotate_left(tree, grand);
+        }
+    }
+    tree->root->color = RB_BLACK;
+}
+
+void rbtree_insert(rbtree_t *tree, rbnode_t *node)
+{
+    assert(node->color == RB_UNLINKED);
+
+    rbnode_t *parent = NULL;
+    rbnode_t **link = &tree->root;
+    bool leftmost = true;
+
+    while (*link)
+    {
+        parent = *link;
+        if (tree->less(node, parent))
+        {
+            link = &parent->left;
+        }
+        else
+        {
+            link = &parent->right;
+            leftmost = false;
+        }
+    }
+
+    node->parent = parent;
+    node->left = NULL;
+    node->right = NULL;
+    node->color = RB_RED;
+    *link = node;
+
+    if (leftmost)
+        tree->leftmost = node;
+
+    tree->count++;
+    rbtree_insert_fixup(tree, node);
+}
+
+// 删除后修复红黑性质，node 可能为空，所以需要 parent
+static void rbtree_remove_fixup(rbtree_t *tree, rbnode_t *node, rbnode_t *parent)
+{
+    while (node != tree->root && is_black(node))
+    {
+        if (node == parent->left)
+        {
+            rbnode_t *sibling = parent->right;
+            if (is_red(sibling))
+            {
+                sibling->color = RB_BLACK;
+                parent->color = RB_RED;
+                rbtree_rotate_left(tree, parent);
+                sibling = parent->right;
+            }
+            if (is_black(sibling->left) && is_black(sibling->right))
+            {
+                sibling->color = RB_RED;
+                node = parent;
+                parent = node->parent;
+                continue;
+            }
+            if (is_black(sibling->right))
+            {
+                sibling->left->color = RB_BLACK;
+                sibling->color = RB_RED;
+                rbtree_rotate_right(tree, sibling);
+                sibling = parent->right;
+            }
+            sibling->color = parent->color;
+            parent->color = RB_BLACK;
+            sibling->right->color = RB_BLACK;
+            rbtree_rotate_left(tree, parent);
+            node = tree->root;
+        }
+        else
+        {
+            rbnode_t *sibling = parent->left;
+            if (is_red(sibling))
+            {
+                sibling->color = RB_BLACK;
+                parent->color = RB_RED;
+                rbtree_rotate_right(tree, parent);
+                sibling = parent->left;
+            }
+            if (is_black(sibling->left) && is_black(sibling->right))
+            {
+                sibling->color = RB_RED;
+                node = parent;
+                parent = node->parent;
+                continue;
+            }
+            if (is_black(sibling->left))
+            {
+                sibling->right->color = RB_BLACK;
+                sibling->color = RB_RED;
+                rbtree_rotate_left(tree, sibling);
+                sibling = parent->left;
+            }
+            sibling->color = parent->color;
+            parent->color = RB_BLACK;
+            sibling->left->color = RB_BLACK;
+            rbtree_rotate_right(tree, parent);
+            node = tree->root;
+        }
+    }
+    if (node)
+        node->color = RB_BLACK;
+}
+
+void rbtree_remove(rbtree_t *tree, rbnode_t *node)
+{
+    assert(node->color != RB_UNLINKED);
+
+    if (tree->leftmost == node)
+        tree->leftmost = rbtree_next(node);
+
+    rbnode_t *child;
+    rbnode_t *parent;
+    u32 color;
+
+    if (node->left == NULL || node->right == NULL)
+    {
+        // 至多一个孩子，直接用孩子替换
+        child = node->left ? node->left : node->right;
+        parent = node->parent;
+        color = node->color;
+
+        if (child)
+            child->parent = parent;
+        rbtree_replace_child(tree, parent, node, child);
+    }
+    else
+    {
+        // 两个孩子，用中序后继替换 node
+        rbnode_t *next = node->right;
+        while (next->left)
+            next = next->left;
+
+        child = next->right;
+        color = next->color;
+
+        if (next->parent == node)
+        {
+            parent = next;
+        }
+        else
+        {
+            parent = next->parent;
+            parent->left = child;
+            if (child)
+                child->parent = parent;
+
+            next->right = node->right;
+            node->right->parent = next;
+        }
+
+        next->left = node->left;
+        node->left->parent = next;
+        next->parent = node->parent;
+        next->color = node->color;
+        rbtree_replace_child(tree, node->parent, node, next);
+    }
+
+    if (color == RB_BLACK)
+        rbtree_remove_fixup(tree, child, parent);
+
+    node->parent = node->left = node->right = NULL;
+    node->color = RB_UNLINKED;
+    tree->count--;
+}
+
+rbnode_t *rbtree_first(rbtree_t *tree)
+{
+    return tree->leftmost;
+}
+
+rbnode_t *rbtree_last(rbtree_t *tree)
+{
+    rbnode_t *node = tree->root;
+    if (node == NULL)
+        return NULL;
+    while (node->right)
+        node = node->right;
+    return node;
+}
+
+rbnode_t *rbtree_next(rbnode_t *node)
+{
+    if (node->right)
+    {
+        node = node->right;
+        while (node->left)
+            node = node->left;
+        return node;
+    }
+
+    rbnode_t *parent = node->parent;
+    while (parent && node == parent->right)
+    {
+        node = parent;
+        parent = parent->parent;
+    }
+    return parent;
+}
+
+bool rbtree_empty(rbtree_t *tree)
+{
+    return tree->root == NULL;
+}
+
+bool rbnode_linked(rbnode_t *node)
+{
+    return node->color != RB_UNLINKED;
+}
@@ -61,6 +61,7 @@ static strerror_t strerror_table[] = {
     {ENOTCONN, "Not connection error"},
     {ERESET, "Reset error"},
     {ECHKSUM, "Chksum error"},
+    {EINPROGRESS, "Operation now in progress"},
 };
 
 const char *strerror(int errno)
@@ -1,8 +1,95 @@
 #include "hyc.h"
 
+// 快速系统调用状态
+enum
+{
+    FAST_SYSCALL_UNKNOWN, // 尚未检测
+    FAST_SYSCALL_SYSENTER, // 使用 sysenter
+    FAST_SYSCALL_NONE,     // 不支持，使用 int 0x80
+};
+
+static int fast_syscall = FAST_SYSCALL_UNKNOWN;
+
+// 由 CPUID 判断处理器是否支持 sysenter，内核和用户程序共用
+bool cpu_has_sep()
+{
+    u32 eflags, toggled;
+
+    // 能否修改 EFLAGS.ID 决定是否支持 CPUID
+    asm volatile(
+        "pushfl\n"
+        "popl %0\n"
+        "movl %0, %1\n"
+        "xorl $0x200000, %1\n"
+        "pushl %1\n"
+        "popfl\n"
+        "pushfl\n"
+        "popl %1\n"
+        "pushl %0\n"
+        "popfl\n"
+        : "=&r"(eflags), "=&r"(toggled));
+    if (!((eflags ^ toggled) & 0x200000))
+        return false;
+
+    u32 eax, ebx, ecx, edx;
+    asm volatile(
+        "cpuid\n"
+        : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+        : "a"(1));
+
+    u32 family = (eax >> 8) & 0xf;
+    u32 model = (eax >> 4) & 0xf;
+    u32 stepping = eax & 0xf;
+
+    // 早期 Pentium Pro 报告 SEP 但并不支持该指令
+    if (family == 6 && model < 3 && stepping < 3)
+        return false;
+    return (edx >> 11) & 1;
+}
+
+// 内核线程也会调用这些函数，需要区分调用者是否处于用户态
+static _inline bool user_mode()
+{
+    u16 cs;
+    asm volatile("movw %%cs, %0\n"
+                 : "=r"(cs));
+    return (cs & 0b11) != 0;
+}
+
+// 是否通过 sysenter 进入内核，sysexit 只能返回用户态，所以内核态仍然使用 int 0x80
+static _inline bool sysenter_usable()
+{
+    if (!user_mode())
+        return false;
+
+    if (fast_syscall == FAST_SYSCALL_UNKNOWN)
+        fast_syscall = cpu_has_sep() ? FAST_SYSCALL_SYSENTER : FAST_SYSCALL_NONE;
+    return fast_syscall == FAST_SYSCALL_SYSENTER;
+}
+
+// sysenter 调用约定：ebp 指向用户栈，栈顶为返回地址，
+// 返回时 sysexit 使用 ecx 和 edx 传递用户栈和返回地址，二者被破坏
+#define SYSENTER           \
+    "pushl %%ebp\n"        \
+    "pushl $1f\n"          \
+    "movl %%esp, %%ebp\n"  \
+    "sysenter\n"           \
+    "1:\n"                 \
+    "addl $4, %%esp\n"     \
+    "popl %%ebp\n"
+
 static _inline u32 _syscall0(u32 nr)
 {
     u32 ret;
+    if (sysenter_usable())
+    {
+        asm volatile(
+            SYSENTER
+            : "=a"(ret)
+            : "a"(nr)
+            : "ecx", "edx");
+        return ret;
+    }
     asm volatile(
         "int $0x80\n"
         : "=a"(ret)
@@ -13,6 +100,15 @@ static _inline u32 _syscall0(u32 nr)
 static _inline u32 _syscall1(u32 nr, u32 arg)
 {
     u32 ret;
+    if (sysenter_usable())
+    {
+        asm volatile(
+            SYSENTER
+            : "=a"(ret)
+            : "a"(nr), "b"(arg)
+            : "ecx", "edx");
+        return ret;
+    }
     asm volatile(
         "int $0x80\n"
         : "=a"(ret)
@@ -23,6 +119,15 @@ static _inline u32 _syscall1(u32 nr, u32 arg)
 static _inline u32 _syscall2(u32 nr, u32 arg1, u32 arg2)
 {
     u32 ret;
+    if (sysenter_usable())
+    {
+        asm volatile(
+            SYSENTER
+            : "=a"(ret), "+c"(arg2)
+            : "a"(nr), "b"(arg1)
+            : "edx");
+        return ret;
+    }
     asm volatile(
         "int $0x80\n"
         : "=a"(ret)
@@ -33,6 +138,14 @@ static _inline u32 _syscall2(u32 nr, u32 arg1, u32 arg2)
 static _inline u32 _syscall3(u32 nr, u32 arg1, u32 arg2, u32 arg3)
 {
     u32 ret;
+    if (sysenter_usable())
+    {
+        asm volatile(
+            SYSENTER
+            : "=a"(ret), "+c"(arg2), "+d"(arg3)
+            : "a"(nr), "b"(arg1));
+        return ret;
+    }
     asm volatile(
         "int $0x80\n"
         : "=a"(ret)
@@ -43,6 +156,14 @@ static _inline u32 _syscall3(u32 nr, u32 arg1, u32 arg2, u32 arg3)
 static _inline u32 _syscall4(u32 nr, u32 arg1, u32 arg2, u32 arg3, u32 arg4)
 {
     u32 ret;
+    if (sysenter_usable())
+    {
+        asm volatile(
+            SYSENTER
+            : "=a"(ret), "+c"(arg2), "+d"(arg3)
+            : "a"(nr), "b"(arg1), "S"(arg4));
+        return ret;
+    }
     asm volatile(
         "int $0x80\n"
         : "=a"(ret)
@@ -53,6 +174,14 @@ static _inline u32 _syscall4(u32 nr, u32 arg1, u32 arg2, u32 arg3, u32 arg4)
 static _inline u32 _syscall5(u32 nr, u32 arg1, u32 arg2, u32 arg3, u32 arg4, u32 arg5)
 {
     u32 ret;
+    if (sysenter_usable())
+    {
+        asm volatile(
+            SYSENTER
+            : "=a"(ret), "+c"(arg2), "+d"(arg3)
+            : "a"(nr), "b"(arg1), "S"(arg4), "D"(arg5));
+        return ret;
+    }
     asm volatile(
         "int $0x80\n"
         : "=a"(ret)
@@ -60,6 +189,7 @@ static _inline u32 _syscall5(u32 nr, u32 arg1, u32 arg2, u32 arg3, u32 arg4, u32
     return ret;
 }
 
+// 6 个参数的系统调用需要 ebp 传递参数，仍然使用 int 0x80
 static _inline u32 _syscall6(u32 nr, u32 arg1, u32 arg2, u32 arg3, u32 arg4, u32 arg5, u32 arg6)
 {
     u32 ret;
@@ -118,8 +248,11 @@ void sleep(u32 ms)
     _syscall1(SYS_NR_SLEEP, ms);
 }
 
+// 用户进程从共享数据页读取，无需系统调用
 pid_t getpid()
 {
+    if (user_mode())
+        return VDSO_TASK->pid;
     return _syscall0(SYS_NR_GETPID);
 }
 
@@ -128,6 +261,81 @@ pid_t getppid()
     return _syscall0(SYS_NR_GETPPID);
 }
 
+pid_t gettid()
+{
+    return _syscall0(SYS_NR_GETTID);
+}
+
+int clone(int (*fn)(void *), void *stack, int flags, void *arg, pid_t *ptid, pid_t *ctid)
+{
+    // 在新栈上准备 fn 和 arg，子线程从系统调用返回后直接使用
+    u32 *sp = (u32 *)((u32)stack & ~0xF);
+    *--sp = (u32)arg;
+    *--sp = (u32)fn;
+
+    int ret;
+    asm volatile(
+        "int $0x80\n"
+        "testl %%eax, %%eax\n"
+        "jnz 1f\n"
+
+        // 子线程：执行 fn(arg)，返回值作为退出状态
+        "popl %%eax\n"
+        "call *%%eax\n"
+        "movl %%eax, %%ebx\n"
+        "movl %2, %%eax\n"
+        "int $0x80\n"
+        "1:\n"
+        : "=a"(ret)
+        : "a"(SYS_NR_CLONE), "i"(SYS_NR_EXIT),
+          "b"(flags), "c"(sp), "d"(ptid), "S"(0), "D"(ctid)
+        : "memory");
+    return ret;
+}
+
+int futex(int *addr, int op, int val, int timeout)
+{
+    return _syscall4(SYS_NR_FUTEX, (u32)addr, (u32)op, (u32)val, (u32)timeout);
+}
+
+int nice(int increment)
+{
+    return _syscall1(SYS_NR_NICE, increment);
+}
+
+int getpriority(int which, int who)
+{
+    int ret = _syscall2(SYS_NR_GETPRIORITY, which, who);
+    if (ret < 0)
+        return ret;
+    return 20 - ret;
+}
+
+int setpriority(int which, int who, int prio)
+{
+    return _syscall3(SYS_NR_SETPRIORITY, which, who, prio);
+}
+
+int sched_setscheduler(pid_t pid, int policy, sched_param_t *param)
+{
+    return _syscall3(SYS_NR_SCHED_SETSCHEDULER, pid, policy, (u32)param);
+}
+
+int sched_getscheduler(pid_t pid)
+{
+    return _syscall1(SYS_NR_SCHED_GETSCHEDULER, pid);
+}
+
+int sched_setparam(pid_t pid, sched_param_t *param)
+{
+    return _syscall2(SYS_NR_SCHED_SETPARAM, pid, (u32)param);
+}
+
+int sched_getparam(pid_t pid, sched_param_t *param)
+{
+    return _syscall2(SYS_NR_SCHED_GETPARAM, pid, (u32)param);
+}
+
 int setpgid(int pid, int pgid)
 {
     return _syscall2(SYS_NR_SETPGID, pid, pgid);
@@ -163,6 +371,11 @@ int ioctl(fd_t fd, int cmd, int args)
     return _syscall3(SYS_NR_IOCTL, fd, cmd, args);
 }
 
+int fcntl(fd_t fd, int cmd, int arg)
+{
+    return _syscall3(SYS_NR_FCNTL, fd, cmd, arg);
+}
+
 int32 brk(void *addr)
 {
     return _syscall1(SYS_NR_BRK, (u32)addr);
@@ -178,6 +391,41 @@ int munmap(void *addr, size_t length)
     return _syscall2(SYS_NR_MUNMAP, (u32)addr, length);
 }
 
+fd_t io_uring_setup(u32 entries, io_uring_params_t *params)
+{
+    return _syscall2(SYS_NR_IO_URING_SETUP, entries, (u32)params);
+}
+
+int io_uring_enter(fd_t fd, u32 to_submit, u32 min_complete, u32 flags)
+{
+    return _syscall4(SYS_NR_IO_URING_ENTER, fd, to_submit, min_complete, flags);
+}
+
+int poll(pollfd_t *fds, u32 nfds, int timeout)
+{
+    return _syscall3(SYS_NR_POLL, (u32)fds, nfds, timeout);
+}
+
+int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, timeval *timeout)
+{
+    return _syscall5(SYS_NR_SELECT, nfds, (u32)readfds, (u32)writefds, (u32)exceptfds, (u32)timeout);
+}
+
+fd_t epoll_create(int size)
+{
+    return _syscall1(SYS_NR_EPOLL_CREATE, size);
+}
+
+int epoll_ctl(fd_t epfd, int op, fd_t fd, epoll_event_t *event)
+{
+    return _syscall4(SYS_NR_EPOLL_CTL, epfd, op, fd, (u32)event);
+}
+
+int epoll_wait(fd_t epfd, epoll_event_t *events, int maxevents, int timeout)
+{
+    return _syscall4(SYS_NR_EPOLL_WAIT, epfd, (u32)events, maxevents, timeout);
+}
+
 fd_t dup(fd_t oldfd)
 {
     return _syscall1(SYS_NR_DUP, oldfd);
@@ -193,6 +441,16 @@ int pipe(fd_t pipefd[2])
     return _syscall1(SYS_NR_PIPE, (u32)pipefd);
 }
 
+int splice(fd_t fd_in, off_t *off_in, fd_t fd_out, off_t *off_out, size_t len, u32 flags)
+{
+    return _syscall6(SYS_NR_SPLICE, fd_in, (u32)off_in, fd_out, (u32)off_out, len, flags);
+}
+
+int tee(fd_t fd_in, fd_t fd_out, size_t len, u32 flags)
+{
+    return _syscall4(SYS_NR_TEE, fd_in, fd_out, len, flags);
+}
+
 fd_t open(char *filename, int flags, int mode)
 {
     return _syscall3(SYS_NR_OPEN, (u32)filename, (u32)flags, (u32)mode);
@@ -218,6 +476,26 @@ int write(fd_t fd, char *buf, int len)
     return _syscall3(SYS_NR_WRITE, fd, (u32)buf, len);
 }
 
+int readv(fd_t fd, iovec_t *iov, int iovlen)
+{
+    return _syscall3(SYS_NR_READV, fd, (u32)iov, iovlen);
+}
+
+int writev(fd_t fd, iovec_t *iov, int iovlen)
+{
+    return _syscall3(SYS_NR_WRITEV, fd, (u32)iov, iovlen);
+}
+
+int pread(fd_t fd, char *buf, int len, off_t offset)
+{
+    return _syscall4(SYS_NR_PREAD, fd, (u32)buf, len, offset);
+}
+
+int pwrite(fd_t fd, char *buf, int len, off_t offset)
+{
+    return _syscall4(SYS_NR_PWRITE, fd, (u32)buf, len, offset);
+}
+
 int lseek(fd_t fd, off_t offset, int whence)
 {
     return _syscall3(SYS_NR_LSEEK, fd, offset, whence);
@@ -228,6 +506,21 @@ int readdir(fd_t fd, void *dir, int count)
     return _syscall3(SYS_NR_READDIR, fd, (u32)dir, (u32)count);
 }
 
+int sync()
+{
+    return _syscall0(SYS_NR_SYNC);
+}
+
+int fsync(fd_t fd)
+{
+    return _syscall1(SYS_NR_FSYNC, fd);
+}
+
+int fdatasync(fd_t fd)
+{
+    return _syscall1(SYS_NR_FDATASYNC, fd);
+}
+
 char *getcwd(char *buf, size_t size)
 {
     return (char *)_syscall2(SYS_NR_GETCWD, (u32)buf, (u32)size);
@@ -280,6 +573,11 @@ int mknod(char *filename, int mode, int dev)
 
 time_t time()
 {
+    if (user_mode())
+    {
+        vdso_data_t *data = VDSO_DATA;
+        return data->startup_time + (data->jiffies * data->jiffy) / 1000;
+    }
     return _syscall0(SYS_NR_TIME);
 }
 
@@ -337,7 +635,12 @@ int listen(int fd, int backlog)
 
 int accept(int fd, sockaddr_t *addr, int *addrlen)
 {
-    return _syscall3(SYS_NR_ACCEPT, fd, (u32)addr, (u32)addrlen);
+    return _syscall4(SYS_NR_ACCEPT, fd, (u32)addr, (u32)addrlen, 0);
+}
+
+int accept4(int fd, sockaddr_t *addr, int *addrlen, int flags)
+{
+    return _syscall4(SYS_NR_ACCEPT, fd, (u32)addr, (u32)addrlen, flags);
 }
 
 int bind(int fd, const sockaddr_t *name, int namelen)
@@ -405,6 +708,11 @@ int sendmsg(int fd, msghdr_t *msg, u32 flags)
     return _syscall3(SYS_NR_SENDMSG, fd, (u32)msg, flags);
 }
 
+int sendfile(int out_fd, fd_t in_fd, off_t *offset, int count)
+{
+    return _syscall4(SYS_NR_SENDFILE, out_fd, in_fd, (u32)offset, count);
+}
+
 int resolv(const char *name, ip_addr_t addr)
 {
     return _syscall2(SYS_NR_RESOLV, (u32)name, (u32)addr);
@@ -1,3 +1,5 @@
+#include "../include/xos/ahci.h"
+#include "../include/xos/apic.h"
 #include "../include/xos/arena.h"
 #include "../include/xos/assert.h"
 #include "../include/xos/bitmap.h"
@@ -24,10 +26,17 @@
 #include "../include/xos/net.h"
 #include "../include/xos/onix.h"
 #include "../include/xos/pci.h"
+#include "../include/xos/pipe.h"
+#include "../include/xos/poll.h"
 #include "../include/xos/printk.h"
+#include "../include/xos/rbtree.h"
 #include "../include/xos/rtc.h"
 #include "../include/xos/sb16.h"
+#include "../include/xos/sched.h"
 #include "../include/xos/signal.h"
+#include "../include/xos/smp.h"
+#include "../include/xos/softirq.h"
+#include "../include/xos/spinlock.h"
 #include "../include/xos/stat.h"
 #include "../include/xos/stdarg.h"
 #include "../include/xos/stdio.h"
@@ -39,7 +48,12 @@
 #include "../include/xos/timer.h"
 #include "../include/xos/tty.h"
 #include "../include/xos/types.h"
+#include "../include/xos/uio.h"
 #include "../include/xos/uname.h"
+#include "../include/xos/vdso.h"
+#include "../include/xos/virtio.h"
+#include "../include/xos/wait.h"
+#include "../include/xos/workqueue.h"
 
 #include "../include/xos/net/addr.h"
 #include "../include/xos/net/arp.h"
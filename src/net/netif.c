@@ -304,4 +304,8 @@ void netif_init()
     list_init(&netif_list);
     neti_task = task_create(neti_thread, "neti", 5, KERNEL_USER);
     neto_task = task_create(neto_thread, "neio", 5, KERNEL_USER);
+
+    // 收发线程使用实时调度，避免计算密集任务造成网络抖动
+    sched_set_policy(neti_task, SCHED_FIFO, RT_PRIO_NET);
+    sched_set_policy(neto_task, SCHED_FIFO, RT_PRIO_NET);
 }
\ No newline at end of file
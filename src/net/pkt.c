@@ -15,6 +15,7 @@ static int pkt_socket(socket_t *s, int domain, int type, int protocol)
     pcb->protocol = protocol;
 
     list_init(&pcb->rx_pbuf_list);
+    wait_queue_init(&pcb->wait);
     list_push(&pkt_pcb_list, &pcb->node);
     return EOK;
 }
@@ -93,6 +94,8 @@ static int pkt_recvmsg(socket_t *s, msghdr_t *msg, u32 flags)
     err_t ret = EOK;
     if (list_empty(&s->pkt->rx_pbuf_list))
     {
+        if (flags & MSG_DONTWAIT)
+            return -EAGAIN;
         s->pkt->rx_waiter = running_task();
         ret = task_block(s->pkt->rx_waiter, NULL, TASK_WAITING, s->rcvtimeo);
         s->pkt->rx_waiter = NULL;
@@ -134,6 +137,14 @@ static int pkt_sendmsg(socket_t *s, msghdr_t *msg, u32 flags)
     return size;
 }
 
+static int pkt_poll(socket_t *s, poll_table_t *pt)
+{
+    poll_wait(pt, &s->pkt->wait);
+    if (list_empty(&s->pkt->rx_pbuf_list))
+        return POLLOUT;
+    return POLLIN | POLLOUT;
+}
+
 static int pkt_recv(pkt_pcb_t *pcb, pbuf_t *pbuf)
 {
     eth_t *eth = pbuf->eth;
@@ -177,6 +188,7 @@ static int pkt_recv(pkt_pcb_t *pcb, pbuf_t *pbuf)
         task_unblock(pcb->rx_waiter, EOK);
         pcb->rx_waiter = NULL;
     }
+    wake_up(&pcb->wait, POLLIN);
     return true;
 }
 
@@ -217,6 +229,8 @@ static socket_op_t pkt_op = {
 
     pkt_recvmsg,
     pkt_sendmsg,
+
+    pkt_poll,
 };
 
 void pkt_init()
@@ -14,6 +14,7 @@ static int raw_socket(socket_t *s, int domain, int type, int protocol)
     raw_pcb_t *pcb = s->raw;
     pcb->protocol = protocol;
     list_init(&pcb->rx_pbuf_list);
+    wait_queue_init(&pcb->wait);
     list_push(&raw_pcb_list, &pcb->node);
 
     return EOK;
@@ -78,6 +79,8 @@ static int raw_recvmsg(socket_t *s, msghdr_t *msg, u32 flags)
     err_t ret = EOK;
     if (list_empty(&s->raw->rx_pbuf_list))
     {
+        if (flags & MSG_DONTWAIT)
+            return -EAGAIN;
         s->raw->rx_waiter = running_task();
         ret = task_block(s->raw->rx_waiter, NULL, TASK_WAITING, s->rcvtimeo);
         s->raw->rx_waiter = NULL;
@@ -128,6 +131,14 @@ static int raw_sendmsg(socket_t *s, msghdr_t *msg, u32 flags)
     return size;
 }
 
+static int raw_poll(socket_t *s, poll_table_t *pt)
+{
+    poll_wait(pt, &s->raw->wait);
+    if (list_empty(&s->raw->rx_pbuf_list))
+        return POLLOUT;
+    return POLLIN | POLLOUT;
+}
+
 static int raw_recv(raw_pcb_t *pcb, pbuf_t *pbuf)
 {
     ip_t *ip = pbuf->eth->ip;
@@ -146,6 +157,7 @@ static int raw_recv(raw_pcb_t *pcb, pbuf_t *pbuf)
         task_unblock(pcb->rx_waiter, EOK);
         pcb->rx_waiter = NULL;
     }
+    wake_up(&pcb->wait, POLLIN);
     return true;
 }
 
@@ -185,6 +197,8 @@ static socket_op_t raw_op = {
 
     raw_recvmsg,
     raw_sendmsg,
+
+    raw_poll,
 };
 
 void raw_init()
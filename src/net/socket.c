@@ -78,6 +78,14 @@ static void socket_close(inode_t *inode)
     LOGK("socket close...\n");
 }
 
+// 非阻塞方式的套接字每次收发都不阻塞
+static u32 socket_msg_flags(socket_t *s, u32 flags)
+{
+    if (s->flags & SOCK_NONBLOCK)
+        flags |= MSG_DONTWAIT;
+    return flags;
+}
+
 static socket_t *socket_get(fd_t fd)
 {
     task_t *task = running_task();
@@ -99,6 +107,9 @@ int sys_socket(int domain, int type, int protocol)
 {
     LOGK("sys_socket...\n");
 
+    int flags = type & SOCK_NONBLOCK;
+    type &= ~SOCK_NONBLOCK;
+
     socktype_t socktype = SOCK_TYPE_NONE;
     switch (domain)
     {
@@ -135,12 +146,13 @@ int sys_socket(int domain, int type, int protocol)
     inode_t *inode = socket_open();
 
     file->inode = inode;
-    file->flags = 0;
+    file->flags = flags ? O_NONBLOCK : 0;
     file->count = 1;
     file->offset = 0;
 
     socket_t *s = (socket_t *)inode->desc;
     s->type = socktype;
+    s->flags = flags;
 
     if (s->type != SOCK_TYPE_NONE)
     {
@@ -162,9 +174,12 @@ int sys_listen(int fd, int backlog)
     return socket_get_op(s->type)->listen(s, backlog);
 }
 
-int sys_accept(int fd, sockaddr_t *addr, int *addrlen)
+int sys_accept4(int fd, sockaddr_t *addr, int *addrlen, int flags)
 {
     LOGK("sys_accept...\n");
+    if (flags & ~SOCK_NONBLOCK)
+        return -EINVAL;
+
     socket_t *s = socket_get(fd);
     if (!s)
         return -EINVAL;
@@ -174,19 +189,30 @@ int sys_accept(int fd, sockaddr_t *addr, int *addrlen)
     if (ret < 0)
         return ret;
 
+    ns->flags = flags;
     inode_t *inode = socket_inode_create();
     inode->desc = ns;
 
     file_t *file;
     fd = fd_get(&file);
+    if (fd < EOK)
+    {
+        socket_close(inode);
+        return fd;
+    }
 
     file->inode = inode;
-    file->flags = 0;
+    file->flags = flags ? O_NONBLOCK : 0;
     file->count = 1;
     file->offset = 0;
     return fd;
 }
 
+int sys_accept(int fd, sockaddr_t *addr, int *addrlen)
+{
+    return sys_accept4(fd, addr, addrlen, 0);
+}
+
 int sys_bind(int fd, const sockaddr_t *name, int namelen)
 {
     if (!name)
@@ -330,7 +356,7 @@ int sys_recvfrom(int fd, void *data, int size, u32 flags, sockaddr_t *from, int
     if (ret < EOK)
         return ret;
 
-    ret = socket_get_op(s->type)->recvmsg(s, &msg, flags);
+    ret = socket_get_op(s->type)->recvmsg(s, &msg, socket_msg_flags(s, flags));
 
     if (fromlen)
         *fromlen = msg.namelen;
@@ -352,7 +378,7 @@ int sys_recvmsg(int fd, msghdr_t *msg, u32 flags)
     if (ret < EOK)
         return ret;
 
-    ret = socket_get_op(s->type)->recvmsg(s, &m, flags);
+    ret = socket_get_op(s->type)->recvmsg(s, &m, socket_msg_flags(s, flags));
 
     kfree(m.iov);
     return ret;
@@ -385,7 +411,7 @@ int sys_sendto(int fd, void *data, int size, u32 flags, sockaddr_t *to, int tole
     if (ret < EOK)
         return ret;
 
-    return socket_get_op(s->type)->sendmsg(s, &msg, flags);
+    return socket_get_op(s->type)->sendmsg(s, &msg, socket_msg_flags(s, flags));
 }
 
 int sys_sendmsg(int fd, msghdr_t *msg, u32 flags)
@@ -402,12 +428,80 @@ int sys_sendmsg(int fd, msghdr_t *msg, u32 flags)
     if (ret < EOK)
         return ret;
 
-    ret = socket_get_op(s->type)->sendmsg(s, &m, flags);
+    ret = socket_get_op(s->type)->sendmsg(s, &m, socket_msg_flags(s, flags));
 
     kfree(m.iov);
     return ret;
 }
 
+int socket_sendpage(socket_t *s, void *data, size_t size, u32 flags)
+{
+    flags = socket_msg_flags(s, flags);
+    socket_op_t *op = socket_get_op(s->type);
+    if (op->sendpage)
+        return op->sendpage(s, data, size, flags);
+    if (!size)
+        return 0;
+
+    msghdr_t msg;
+    iovec_t iov;
+
+    msg.name = NULL;
+    msg.namelen = 0;
+    msg.iov = &iov;
+    msg.iovlen = 1;
+
+    iov.base = data;
+    iov.size = size;
+
+    return op->sendmsg(s, &msg, flags & ~MSG_MORE);
+}
+
+// 文件块缓冲中的数据直接交给套接字
+static int sendfile_actor(void *target, buffer_t *buf, char *ptr, int len)
+{
+    return socket_sendpage((socket_t *)target, ptr, len, MSG_MORE);
+}
+
+int sys_sendfile(fd_t out_fd, fd_t in_fd, off_t *offset, int count)
+{
+    if (count < 0)
+        return -EINVAL;
+
+    file_t *in;
+    file_t *out;
+    if (fd_check(in_fd, &in) < EOK || fd_check(out_fd, &out) < EOK)
+        return -EBADF;
+    if ((in->flags & O_ACCMODE) == O_WRONLY)
+        return -EBADF;
+
+    // 目的只能是套接字，源文件要支持按文件块发送
+    if (!out->inode || out->inode->type != FS_TYPE_SOCKET || !out->inode->desc)
+        return -EINVAL;
+    inode_t *inode = in->inode;
+    if (!inode || !inode->op || !inode->op->sendfile)
+        return -EINVAL;
+
+    if (offset && !memory_access(offset, sizeof(off_t), true, true))
+        return -EFAULT;
+
+    socket_t *s = (socket_t *)out->inode->desc;
+    off_t pos = offset ? *offset : in->offset;
+    file_readahead(inode, &in->ra, pos, count);
+    int ret = inode->op->sendfile(inode, count, pos, sendfile_actor, s);
+    if (ret <= 0)
+        return ret;
+
+    // 推送最后不满一段的数据，阻塞方式下等待全部应答
+    socket_sendpage(s, NULL, 0, 0);
+
+    if (offset)
+        *offset = pos + ret;
+    else
+        in->offset = pos + ret;
+    return ret;
+}
+
 static int socket_read(inode_t *inode, char *data, int size, off_t offset)
 {
     if (!data)
@@ -431,7 +525,7 @@ static int socket_read(inode_t *inode, char *data, int size, off_t offset)
     iov.base = data;
     iov.size = size;
 
-    return socket_get_op(s->type)->recvmsg(s, &msg, 0);
+    return socket_get_op(s->type)->recvmsg(s, &msg, socket_msg_flags(s, 0));
 }
 
 static int socket_write(inode_t *inode, char *data, int size, off_t offset)
@@ -457,11 +551,21 @@ static int socket_write(inode_t *inode, char *data, int size, off_t offset)
     iov.base = data;
     iov.size = size;
 
-    return socket_get_op(s->type)->sendmsg(s, &msg, 0);
+    return socket_get_op(s->type)->sendmsg(s, &msg, socket_msg_flags(s, 0));
 }
 
 static int socket_ioctl(inode_t *inode, int cmd, void *args)
 {
+    if (cmd == FIONBIO)
+    {
+        socket_t *s = (socket_t *)inode->desc;
+        if (args)
+            s->flags |= SOCK_NONBLOCK;
+        else
+            s->flags &= ~SOCK_NONBLOCK;
+        return EOK;
+    }
+
     if (!memory_access(args, sizeof(ifreq_t), true, true))
         return -EINVAL;
 
@@ -491,6 +595,18 @@ static int socket_ioctl(inode_t *inode, int cmd, void *args)
     return netif_ioctl(netif, cmd, args, 0);
 }
 
+static int socket_poll(inode_t *inode, poll_table_t *pt)
+{
+    socket_t *s = (socket_t *)inode->desc;
+    if (!s || s->type == SOCK_TYPE_NONE)
+        return POLLNVAL;
+
+    socket_op_t *op = socket_get_op(s->type);
+    if (!op->poll)
+        return POLLIN | POLLOUT;
+    return op->poll(s, pt);
+}
+
 static fs_op_t socket_op = {
     fs_default_nosys,
     fs_default_nosys,
@@ -513,6 +629,8 @@ static fs_op_t socket_op = {
     fs_default_nosys,
     fs_default_nosys,
     fs_default_nosys,
+
+    socket_poll,
 };
 
 void socket_init()
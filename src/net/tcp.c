@@ -80,22 +80,17 @@ static int tcp_listen(socket_t *s, int backlog)
     return EOK;
 }
 
+// 查找已完成握手的连接，不移出接受列表
 static tcp_pcb_t *tcp_find_npcb(tcp_pcb_t *pcb)
 {
     list_t *list = &pcb->acclist;
-    tcp_pcb_t *npcb = NULL;
-    for (list_node_t *node = list->head.next; node != &list->tail;)
+    for (list_node_t *node = list->head.next; node != &list->tail; node = node->next)
     {
         tcp_pcb_t *ptr = element_entry(tcp_pcb_t, accnode, node);
-        node = node->next;
         if (ptr->state == ESTABLISHED)
-        {
-            npcb = ptr;
-            list_remove(&npcb->accnode);
-            break;
-        }
+            return ptr;
     }
-    return npcb;
+    return NULL;
 }
 
 static int tcp_accept(socket_t *s, sockaddr_t *addr, int *addrlen, socket_t **ns)
@@ -113,6 +108,8 @@ static int tcp_accept(socket_t *s, sockaddr_t *addr, int *addrlen, socket_t **ns
     tcp_pcb_t *npcb = tcp_find_npcb(pcb);
     if (!npcb)
     {
+        if (s->flags & SOCK_NONBLOCK)
+            return -EAGAIN;
         pcb->ac_waiter = running_task();
         ret = task_block(pcb->ac_waiter, NULL, TASK_WAITING, s->rcvtimeo);
         pcb->ac_waiter = NULL;
@@ -122,6 +119,7 @@ static int tcp_accept(socket_t *s, sockaddr_t *addr, int *addrlen, socket_t **ns
         npcb = tcp_find_npcb(pcb);
         assert(npcb);
     }
+    list_remove(&npcb->accnode);
 
     socket_t *sock = socket_create();
     sock->type = SOCK_TYPE_TCP;
@@ -197,6 +195,10 @@ static int tcp_connect(socket_t *s, const sockaddr_t *name, int namelen)
 
     pcb->timers[TCP_TIMER_SYN] = TCP_TO_SYN;
 
+    // 非阻塞方式不等待握手完成，连接建立后可写
+    if (s->flags & SOCK_NONBLOCK)
+        return -EINPROGRESS;
+
     pcb->ac_waiter = running_task();
     int ret = task_block(pcb->ac_waiter, NULL, TASK_WAITING, s->sndtimeo);
     pcb->ac_waiter = NULL;
@@ -286,6 +288,8 @@ static int tcp_recvmsg(socket_t *s, msghdr_t *msg, u32 flags)
 
     if (list_empty(&pcb->recved))
     {
+        if (flags & MSG_DONTWAIT)
+            return -EAGAIN;
         pcb->rx_waiter = running_task();
         ret = task_block(pcb->rx_waiter, NULL, TASK_WAITING, s->rcvtimeo);
         pcb->rx_waiter = NULL;
@@ -344,6 +348,19 @@ static int tcp_recvmsg(socket_t *s, msghdr_t *msg, u32 flags)
     return size - left;
 }
 
+// 等待发送的数据全部应答
+static int tcp_wait_acked(socket_t *s)
+{
+    tcp_pcb_t *pcb = s->tcp;
+    if (list_empty(&pcb->unacked) && list_empty(&pcb->unsent))
+        return EOK;
+
+    pcb->tx_waiter = running_task();
+    int ret = task_block(pcb->tx_waiter, NULL, TASK_WAITING, s->sndtimeo);
+    pcb->tx_waiter = NULL;
+    return ret;
+}
+
 static int tcp_sendmsg(socket_t *s, msghdr_t *msg, u32 flags)
 {
     LOGK("tcp sendmsg...\n");
@@ -356,6 +373,12 @@ static int tcp_sendmsg(socket_t *s, msghdr_t *msg, u32 flags)
     if (size > pcb->snd_wnd)
         return -EMSGSIZE;
 
+    // 非阻塞方式下之前的数据全部应答才能继续发送
+    bool nonblock = flags & MSG_DONTWAIT;
+    flags &= ~MSG_DONTWAIT;
+    if (nonblock && !(list_empty(&pcb->unacked) && list_empty(&pcb->unsent)))
+        return -EAGAIN;
+
     size_t left = size;
 
     iovec_t *iov = msg->iov;
@@ -367,24 +390,100 @@ static int tcp_sendmsg(socket_t *s, msghdr_t *msg, u32 flags)
             continue;
 
         int len = left < iov->size ? left : iov->size;
-        tcp_enqueue(pcb, iov->base, len, flags);
+        if ((ret = tcp_enqueue(pcb, iov->base, len, flags)) < EOK)
+            break;
         left -= len;
     }
     tcp_output(pcb);
 
-    if (list_empty(&pcb->unacked) && list_empty(&pcb->unsent))
+    // 一个字节都没有排队时返回错误，否则返回排队的字节数
+    if (ret < EOK && left == size)
+        return ret;
+    if (ret < EOK)
         return size - left;
 
-    pcb->tx_waiter = running_task();
-    ret = task_block(pcb->tx_waiter, NULL, TASK_WAITING, s->sndtimeo);
-    pcb->tx_waiter = NULL;
+    if (nonblock)
+        return size - left;
 
+    ret = tcp_wait_acked(s);
     if (ret < 0)
         return ret;
 
     return size - left;
 }
 
+// 直接用内核缓冲区（如文件块缓冲）中的数据构造报文段，
+// 排队的数据超过窗口时先发送并等待应答，MSG_MORE 表示后面还有数据，暂不推送
+static int tcp_sendpage(socket_t *s, void *data, size_t size, u32 flags)
+{
+    tcp_pcb_t *pcb = s->tcp;
+    if (pcb->state != ESTABLISHED)
+        return -EINVAL;
+
+    bool nonblock = flags & MSG_DONTWAIT;
+    bool more = flags & MSG_MORE;
+    int ret;
+
+    u32 queued = pcb->snd_nbb - pcb->snd_una;
+    u32 wnd = MIN(pcb->snd_cwnd, pcb->snd_wnd);
+    if (queued && queued + size > wnd)
+    {
+        tcp_push(pcb);
+        tcp_output(pcb);
+        if (nonblock)
+            return -EAGAIN;
+        if ((ret = tcp_wait_acked(s)) < EOK)
+            return ret;
+    }
+
+    if (size > 0 && (ret = tcp_enqueue(pcb, data, size, 0)) < EOK)
+        return ret;
+    if (more)
+        return size;
+
+    tcp_push(pcb);
+    tcp_output(pcb);
+    if (nonblock)
+        return size;
+
+    if ((ret = tcp_wait_acked(s)) < EOK)
+        return ret;
+    return size;
+}
+
+static int tcp_poll(socket_t *s, poll_table_t *pt)
+{
+    tcp_pcb_t *pcb = s->tcp;
+    poll_wait(pt, &pcb->wait);
+
+    int mask = 0;
+    switch (pcb->state)
+    {
+    case LISTEN:
+        if (tcp_find_npcb(pcb))
+            mask |= POLLIN;
+        break;
+    case SYN_SENT:
+    case SYN_RCVD:
+        break;
+    case ESTABLISHED:
+        if (!list_empty(&pcb->recved))
+            mask |= POLLIN;
+        // 发送要等到数据全部应答才返回
+        if (list_empty(&pcb->unacked) && list_empty(&pcb->unsent))
+            mask |= POLLOUT;
+        break;
+    case CLOSE_WAIT:
+        // 对端已关闭连接
+        mask |= POLLIN | POLLHUP;
+        break;
+    default:
+        mask |= POLLHUP;
+        break;
+    }
+    return mask;
+}
+
 static socket_op_t tcp_op = {
     tcp_socket,
     tcp_close,
@@ -401,6 +500,9 @@ static socket_op_t tcp_op = {
 
     tcp_recvmsg,
     tcp_sendmsg,
+
+    tcp_poll,
+    tcp_sendpage,
 };
 
 extern void tcp_pcb_init();
@@ -126,13 +126,8 @@ static void tcp_update_ack(tcp_pcb_t *pcb, pbuf_t *pbuf, tcp_t *tcp)
         }
     }
 
-    if (pcb->snd_buf && pcb->snd_buf->size > 0 && tcp->ackno == pcb->snd_max)
-    {
-        list_insert_sort(
-            &pcb->unsent, &pcb->snd_buf->tcpnode,
-            element_node_offset(pbuf_t, tcpnode, seqno));
-        pcb->snd_buf = NULL;
-    }
+    if (tcp->ackno == pcb->snd_max)
+        tcp_push(pcb);
 
     if (list_empty(&pcb->unacked) && list_empty(&pcb->unsent) && pcb->tx_waiter)
     {
@@ -140,6 +135,8 @@ static void tcp_update_ack(tcp_pcb_t *pcb, pbuf_t *pbuf, tcp_t *tcp)
         pcb->tx_waiter = NULL;
         pcb->timers[TCP_TIMER_REXMIT] = 0;
     }
+    if (list_empty(&pcb->unacked) && list_empty(&pcb->unsent))
+        wake_up(&pcb->wait, POLLOUT);
 }
 
 static void tcp_update_buf(tcp_pcb_t *pcb, pbuf_t *pbuf, tcp_t *tcp)
@@ -202,6 +199,7 @@ static void tcp_update_buf(tcp_pcb_t *pcb, pbuf_t *pbuf, tcp_t *tcp)
         task_unblock(pcb->rx_waiter, EOK);
         pcb->rx_waiter = NULL;
     }
+    wake_up(&pcb->wait, POLLIN);
 }
 
 static err_t tcp_receive(tcp_pcb_t *pcb, pbuf_t *pbuf, tcp_t *tcp)
@@ -241,6 +239,7 @@ static err_t tcp_handle_syn_sent(tcp_pcb_t *pcb, tcp_t *tcp)
         task_unblock(pcb->ac_waiter, EOK);
         pcb->ac_waiter = NULL;
     }
+    wake_up(&pcb->wait, POLLOUT);
 
     LOGK("TCP ESTABLISHED client\n");
     return EOK;
@@ -323,8 +322,9 @@ static err_t tcp_process(tcp_pcb_t *pcb, netif_t *netif, pbuf_t *pbuf, ip_t *ip,
         if (pcb->listen->ac_waiter)
         {
             task_unblock(pcb->listen->ac_waiter, EOK);
-            pcb->listen->ac_waiter;
+            pcb->listen->ac_waiter = NULL;
         }
+        wake_up(&pcb->listen->wait, POLLIN);
         break;
     case CLOSE_WAIT:
     case ESTABLISHED:
@@ -333,6 +333,7 @@ static err_t tcp_process(tcp_pcb_t *pcb, netif_t *netif, pbuf_t *pbuf, ip_t *ip,
             pcb->flags |= TF_ACK_NOW;
             pcb->state = CLOSE_WAIT;
             pcb->rcv_nxt = tcp->seqno + 1;
+            wake_up(&pcb->wait, POLLIN | POLLHUP);
             LOGK("TCP CLOSE_WAIT\n");
         }
         break;
@@ -34,8 +34,12 @@ err_t tcp_output_seg(tcp_pcb_t *pcb, pbuf_t *pbuf)
     return ip_output(netif, pbuf, ip->dst, IP_PROTOCOL_TCP, pbuf->total);
 }
 
+// 数据只能在连接建立之后、本端关闭之前排队，等待期间连接可能已经重置
 err_t tcp_enqueue(tcp_pcb_t *pcb, void *data, size_t size, int flags)
 {
+    if (size > 0 && pcb->state != ESTABLISHED && pcb->state != CLOSE_WAIT)
+        return -ENOTCONN;
+
     int left = size;
     ip_t *ip;
     tcp_t *tcp;
@@ -105,6 +109,17 @@ err_t tcp_enqueue(tcp_pcb_t *pcb, void *data, size_t size, int flags)
     return EOK;
 }
 
+void tcp_push(tcp_pcb_t *pcb)
+{
+    if (!pcb->snd_buf || pcb->snd_buf->size == 0)
+        return;
+
+    list_insert_sort(
+        &pcb->unsent, &pcb->snd_buf->tcpnode,
+        element_node_offset(pbuf_t, tcpnode, seqno));
+    pcb->snd_buf = NULL;
+}
+
 err_t tcp_output(tcp_pcb_t *pcb)
 {
     list_t *list = &pcb->unsent;
@@ -40,6 +40,7 @@ tcp_pcb_t *tcp_pcb_get()
     list_init(&pcb->outseq);
     list_init(&pcb->recved);
     list_init(&pcb->acclist);
+    wait_queue_init(&pcb->wait);
 
     list_push(&tcp_pcb_create_list, &pcb->node);
     return pcb;
@@ -91,6 +92,7 @@ void tcp_pcb_purge(tcp_pcb_t *pcb, err_t reason)
         task_unblock(pcb->tx_waiter, reason);
         pcb->tx_waiter = NULL;
     }
+    wake_up(&pcb->wait, POLLIN | POLLOUT | POLLERR | POLLHUP);
     LOGK("TCP PURGE %#p\n", pcb);
 }
 
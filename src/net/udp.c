@@ -14,6 +14,7 @@ static int udp_socket(socket_t *s, int domain, int type, int protocol)
 
     udp_pcb_t *pcb = s->udp;
     list_init(&pcb->rx_pbuf_list);
+    wait_queue_init(&pcb->wait);
     list_push(&udp_pcb_list, &pcb->node);
     return EOK;
 }
@@ -119,6 +120,8 @@ static int udp_recvmsg(socket_t *s, msghdr_t *msg, u32 flags)
     err_t ret = EOK;
     if (list_empty(&s->udp->rx_pbuf_list))
     {
+        if (flags & MSG_DONTWAIT)
+            return -EAGAIN;
         s->udp->rx_waiter = running_task();
         ret = task_block(s->udp->rx_waiter, NULL, TASK_WAITING, s->rcvtimeo);
         s->udp->rx_waiter = NULL;
@@ -246,10 +249,19 @@ int udp_input(netif_t *netif, pbuf_t *pbuf)
         task_unblock(pcb->rx_waiter, EOK);
         pcb->rx_waiter = NULL;
     }
+    wake_up(&pcb->wait, POLLIN);
 
     return EOK;
 }
 
+static int udp_poll(socket_t *s, poll_table_t *pt)
+{
+    poll_wait(pt, &s->udp->wait);
+    if (list_empty(&s->udp->rx_pbuf_list))
+        return POLLOUT;
+    return POLLIN | POLLOUT;
+}
+
 static socket_op_t udp_op = {
     udp_socket,
     udp_close,
@@ -266,6 +278,8 @@ static socket_op_t udp_op = {
 
     udp_recvmsg,
     udp_sendmsg,
+
+    udp_poll,
 };
 
 void udp_init()
@@ -7,8 +7,11 @@ bochs: $(IMAGES)
 bochsg: $(IMAGES)
 	bochs-gdb -q -f ../bochs/bochsrc.gdb -unlock
 
+CPUS?= 4 # 处理器数量，make qemu CPUS=1 以单处理器运行
+
 QEMU:= qemu-system-i386 # 虚拟机
 QEMU+= -m 32M # 内存
+QEMU+= -smp $(CPUS) # 处理器数量
 QEMU+= -audiodev pa,id=snd # 音频设备
 QEMU+= -machine pcspk-audiodev=snd # pcspeaker 设备
 QEMU+= -device sb16,audiodev=snd # Sound Blaster 16